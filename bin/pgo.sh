@@ -0,0 +1,45 @@
+#!/bin/sh
+#$1: work directory
+#$2: training command; it's run with $PROGRAM set to the profiling binary and
+#    should drive it with representative traffic, passing it
+#    "-v Server.RTTIDirectory=$RTTI_DIR", then stop it
+#rest: hphp arguments, without --output-dir, --program or --rtti-directory
+#
+#Builds twice into the same output directory, so g++'s branch and call edge
+#counters (.gcda files next to the objects) line up with the second build.
+if [ "a$HPHP_HOME" = "a" ]
+then
+echo "please set HPHP_HOME environmental variable"
+exit 1
+fi
+if [ $# -lt 3 ]
+then
+echo "usage: pgo.sh <work dir> <training command> <hphp arguments>"
+exit 1
+fi
+
+WORK=$1
+TRAIN=$2
+shift 2
+mkdir -p $WORK/rtti || exit $?
+rm -rf $WORK/rtti/*
+
+# 1. profiling build: RTTI parameter counters plus g++ instrumentation
+CPP_PROFILE_GENERATE=1 LD_PROFILE_GENERATE=1 \
+  $HPHP_HOME/src/hphp/hphp --output-dir=$WORK/build \
+  -v RTTIOutputFile=$WORK/rtti.meta $* || exit $?
+cp $WORK/build/program $WORK/program.profile || exit $?
+
+# 2. training run
+PROGRAM=$WORK/program.profile RTTI_DIR=$WORK/rtti/ sh -c "$TRAIN" || exit $?
+PROFILE=`ls -d $WORK/rtti/*/ | head -1`
+if [ "a$PROFILE" = "a" ]
+then
+echo "training run didn't write any RTTI profile under $WORK/rtti"
+exit 1
+fi
+
+# 3. optimized build from both profiles
+PROFILE_USE=1 \
+  $HPHP_HOME/src/hphp/hphp --output-dir=$WORK/build \
+  -v RTTIOutputFile=$WORK/rtti.meta --rtti-directory=$PROFILE $* || exit $?
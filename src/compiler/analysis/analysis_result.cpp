@@ -1671,6 +1671,14 @@ void AnalysisResult::outputRTTIMetaData(const char *filename) {
                     Util::safe_strerror(errno).c_str());
   }
   fprintf(f, "%d\n", m_paramRTTICounter);
+  vector<const char *> params(m_paramRTTICounter);
+  for (map<string, int>::const_iterator
+       iter = m_paramRTTIs.begin(); iter != m_paramRTTIs.end(); ++iter) {
+    params[iter->second] = iter->first.c_str();
+  }
+  for (int i = 0; i < m_paramRTTICounter; i++) {
+    fprintf(f, "%s\n", params[i]);
+  }
   for (set<string>::const_iterator
        iter = m_rttiFuncs.begin(); iter != m_rttiFuncs.end(); ++iter) {
     fprintf(f, "%s\n", iter->c_str());
@@ -2090,28 +2098,27 @@ void AnalysisResult::outputCPPDynamicTables(CodeGenerator::Output output) {
       outputCPPEvalInvokeTable(cg, ar);
     } else {
       if (m_funcTableSize > 0) {
-        // initializes the function pointer array
-        cg_printf("static Variant (*funcTable[%d])"
-                  "(const char *, CArrRef, int64, bool);\n", m_funcTableSize);
-        cg_indentBegin("static class FuncTableInitializer {\n");
-        cg_indentBegin("public: FuncTableInitializer() {\n");
-        cg_printf("for (int i = 0; i < %d; i++) "
-                    "funcTable[i] = &invoke_builtin;\n", m_funcTableSize);
-        for (CodeGenerator::MapIntToStringVec::const_iterator it =
-               m_funcTable.begin(); it != m_funcTable.end(); it++) {
+        // constant-initialized, so the table costs no startup code and can
+        // live in read-only data
+        cg_indentBegin("static Variant (* const funcTable[%d])"
+                       "(const char *, CArrRef, int64, bool) = {\n",
+                       m_funcTableSize);
+        for (int i = 0; i < m_funcTableSize; i++) {
+          CodeGenerator::MapIntToStringVec::const_iterator it =
+            m_funcTable.find(i);
           FunctionScopePtr func;
-          if (it->second.size() == 1 &&
-              !(func = findFunction(Util::toLower(it->second[0])))->
-              isRedeclaring()) {
-            cg_printf("funcTable[%d] = &d%s%s;\n", it->first,
+          if (it == m_funcTable.end()) {
+            cg_printf("&invoke_builtin,\n");
+          } else if (it->second.size() == 1 &&
+                     !(func = findFunction(Util::toLower(it->second[0])))->
+                     isRedeclaring()) {
+            cg_printf("&d%s%s,\n",
                       Option::InvokePrefix, func->getId(cg).c_str());
           } else {
-            cg_printf("funcTable[%d] = &invoke_case_%d;\n",
-                      it->first, it->first);
+            cg_printf("&invoke_case_%d,\n", i);
           }
         }
-        cg_indentEnd("}\n");
-        cg_indentEnd("} func_table_initializer;\n");
+        cg_indentEnd("};\n");
       }
 
       cg_indentBegin("Variant invoke(const char *s, CArrRef params,"
@@ -3784,8 +3791,20 @@ void AnalysisResult::addRTTIFunction(const std::string &id) {
   m_rttiFuncs.insert(id);
 }
 
+const char *AnalysisResult::getInvokeAttribute(ClassScopePtr cls,
+                                               FunctionScopePtr func) {
+  if (!Option::UseRTTIProfileData) return "";
+  const string funcId = getFuncId(cls, func);
+  if (RTTIInfo::TheRTTIInfo.exists(funcId.c_str()) &&
+      RTTIInfo::TheRTTIInfo.getCallCount(funcId.c_str()) == 0) {
+    return "ATTRIBUTE_COLD ";
+  }
+  return "";
+}
+
 void AnalysisResult::cloneRTTIFuncs
-(ClassScopePtr cls, const StringToFunctionScopePtrVecMap &functions) {
+(ClassScopePtr cls, const StringToFunctionScopePtrVecMap &functions,
+ CallCountVec &callCounts) {
   for (StringToFunctionScopePtrVecMap::const_iterator iter =
        functions.begin(); iter != functions.end(); ++iter) {
     for (unsigned int j = 0; j < iter->second.size(); j++) {
@@ -3794,18 +3813,52 @@ void AnalysisResult::cloneRTTIFuncs
       if (RTTIInfo::TheRTTIInfo.exists(funcId.c_str())) {
         StatementPtr stmt = func->getStmt();
         func->setStmtCloned(stmt->clone());
+
+        // keyed the same way as Option::FunctionSections
+        string name = func->getOriginalName();
+        if (cls) name = cls->getOriginalName() + "::" + name;
+        callCounts.push_back(make_pair(
+          RTTIInfo::TheRTTIInfo.getCallCount(funcId.c_str()), name));
       }
     }
   }
 }
 
+void AnalysisResult::assignRTTIFunctionSections(CallCountVec &callCounts) {
+  // busiest first
+  sort(callCounts.rbegin(), callCounts.rend());
+  uint64 total = 0;
+  for (unsigned int i = 0; i < callCounts.size(); i++) {
+    total += callCounts[i].first;
+  }
+  uint64 covered = 0;
+  for (unsigned int i = 0; i < callCounts.size(); i++) {
+    unsigned int count = callCounts[i].first;
+    bool hot = count && covered * 100 < total * Option::HotFunctionCoverage;
+    covered += count;
+
+    const string &name = callCounts[i].second;
+    if (Option::FunctionSections.find(name) !=
+        Option::FunctionSections.end()) {
+      continue; // explicitly configured sections win
+    }
+    if (hot) {
+      Option::FunctionSections[name] = "hot";
+    } else if (count == 0) {
+      Option::FunctionSections[name] = "unlikely";
+    }
+  }
+}
+
 void AnalysisResult::cloneRTTIFuncs(const char *RTTIDirectory) {
   RTTIInfo::TheRTTIInfo.loadMetaData(Option::RTTIOutputFile.c_str());
   RTTIInfo::TheRTTIInfo.loadProfData(RTTIDirectory);
 
+  CallCountVec callCounts;
   for (unsigned int i = 0; i < m_fileScopes.size(); i++) {
     // standalone rtti functions
-    cloneRTTIFuncs(ClassScopePtr(), m_fileScopes[i]->getFunctions());
+    cloneRTTIFuncs(ClassScopePtr(), m_fileScopes[i]->getFunctions(),
+                   callCounts);
 
     // class rtti methods
     for (StringToClassScopePtrVecMap::const_iterator iter =
@@ -3813,10 +3866,11 @@ void AnalysisResult::cloneRTTIFuncs(const char *RTTIDirectory) {
          iter != m_fileScopes[i]->getClasses().end(); ++iter) {
       for (unsigned int j = 0; j < iter->second.size(); j++) {
         ClassScopePtr cls = iter->second[j];
-        cloneRTTIFuncs(cls, cls->getFunctions());
+        cloneRTTIFuncs(cls, cls->getFunctions(), callCounts);
       }
     }
   }
+  assignRTTIFunctionSections(callCounts);
 }
 
 void AnalysisResult::outputCPPLiteralStringPrecomputation() {
@@ -366,6 +366,12 @@ public:
   void addRTTIFunction(const std::string &id);
   void cloneRTTIFuncs(const char *RTTIDirectory);
 
+  /**
+   * Attribute to put in front of a dynamic invoke stub: stubs of profiled
+   * functions that were never called go into the cold text section.
+   */
+  const char *getInvokeAttribute(ClassScopePtr cls, FunctionScopePtr func);
+
   std::vector<const char *> &getFuncTableBucket(FunctionScopePtr func);
 
   /**
@@ -571,8 +577,11 @@ private:
   void outputArrayCreateDecl(CodeGenerator &cg);
   void outputArrayCreateImpl(CodeGenerator &cg);
 
+  typedef std::vector<std::pair<unsigned int, std::string> > CallCountVec;
   void cloneRTTIFuncs(ClassScopePtr cls,
-                      const StringToFunctionScopePtrVecMap &functions);
+                      const StringToFunctionScopePtrVecMap &functions,
+                      CallCountVec &callCounts);
+  void assignRTTIFunctionSections(CallCountVec &callCounts);
 
   AnalysisResultPtr shared_from_this() {
     return boost::static_pointer_cast<AnalysisResult>
@@ -95,13 +95,14 @@ void FunctionContainer::outputCPPJumpTableSupport
       if (func->inPseudoMain() || !(systemcpp || func->isDynamic())) continue;
       const char *name = iter->first.c_str();
       if (funcs) funcs->push_back(name);
+      const char *attr = ar->getInvokeAttribute(ClassScopePtr(), func);
 
       if (!systemcpp) {
         vector<const char *> &bucket = ar->getFuncTableBucket(func);
         if (bucket.size() == 1) {
           // no conflict in the function table
-          cg_indentBegin("Variant d%s%s(const char *s, CArrRef params, "
-                         "int64 hash, bool fatal) {\n",
+          cg_indentBegin("%sVariant d%s%s(const char *s, CArrRef params, "
+                         "int64 hash, bool fatal) {\n", attr,
                          Option::InvokePrefix, func->getId(cg).c_str());
           cg_indentBegin("HASH_GUARD(0x%016llXLL, %s) {\n",
                           hash_string_i(name), name);
@@ -116,7 +117,7 @@ void FunctionContainer::outputCPPJumpTableSupport
           }
         }
       }
-      cg_indentBegin("Variant %s%s(CArrRef params) {\n",
+      cg_indentBegin("%sVariant %s%s(CArrRef params) {\n", attr,
                      Option::InvokePrefix, func->getId(cg).c_str());
       if (profile) {
         cg_printf("FUNCTION_INJECTION(%s);\n", name);
@@ -179,8 +180,9 @@ void FunctionContainer::outputCPPJumpTableEvalSupport
       const char *name = iter->first.c_str();
       if (funcs) funcs->push_back(name);
 
-      cg_indentBegin("Variant %s%s(Eval::VariableEnvironment &env, "
+      cg_indentBegin("%sVariant %s%s(Eval::VariableEnvironment &env, "
                      "const Eval::FunctionCallExpression *caller) {\n",
+                     ar->getInvokeAttribute(ClassScopePtr(), func),
                      Option::EvalInvokePrefix, func->getId(cg).c_str());
       func->outputCPPEvalInvoke(cg, ar, funcPrefix,
                                 func->getId(cg).c_str());
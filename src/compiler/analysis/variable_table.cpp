@@ -1637,6 +1637,68 @@ bool VariableTable::outputCPPPrivateSelector(CodeGenerator &cg,
   return true;
 }
 
+/**
+ * Like FlattenInvoke does for methods, o_realPropPublic() looks up the
+ * properties its ancestors declare as well, instead of calling into each
+ * parent's own lookup in turn. "base" is set to the class to fall back to,
+ * past the last ancestor that's compiled with this program.
+ */
+bool VariableTable::outputCPPFlatRealPropTable(CodeGenerator &cg,
+                                               AnalysisResultPtr ar,
+                                               bool varOnly, string &base) {
+  vector<const char *> strings;
+  hphp_const_char_map<bool> typed;
+  ClassScopePtr cls = ar->getClassScope();
+  while (true) {
+    VariableTablePtr variables = cls->getVariables();
+    for (unsigned int i = 0; i < variables->m_symbolVec.size(); i++) {
+      const Symbol *sym = variables->m_symbolVec[i];
+      const string &name = sym->getName();
+      if (sym->isStatic() || sym->isPrivate() ||
+          variables->isInherited(name) ||
+          variables->definedByParent(ar, name)) {
+        continue;
+      }
+      bool isVariant = Type::SameType(sym->getFinalType(), Type::Variant);
+      if (varOnly && !isVariant) continue;
+      if (typed.find(name.c_str()) != typed.end()) continue;
+      typed[name.c_str()] = !isVariant;
+      strings.push_back(name.c_str());
+    }
+
+    ClassScopePtr parent = cls->getParentScope(ar);
+    if (!parent || !parent->isUserClass() || parent->isRedeclaring() ||
+        parent->derivesFromRedeclaring() != ClassScope::FromNormal) {
+      break;
+    }
+    cls = parent;
+  }
+
+  const string &parentName = cls->getParent();
+  if (parentName.empty()) {
+    base = "ObjectData";
+  } else {
+    ClassScopePtr parent = ar->findClass(parentName);
+    base = parent ? parent->getId(cg) : parentName;
+  }
+  if (strings.empty()) return false;
+
+  for (unsigned int i = 0; i < strings.size(); i++) {
+    if (typed[strings[i]]) {
+      cg.printDeclareGlobals();
+      break;
+    }
+  }
+  for (JumpTable jt(cg, strings, false, false, true); jt.ready(); jt.next()) {
+    const char *name = jt.key();
+    cg_printf("HASH_REALPROP_%sSTRING(0x%016llXLL, \"%s\", %d, %s);\n",
+              typed[name] ? "TYPED_" : "", hash_string(name),
+              cg.escapeLabel(name).c_str(), strlen(name),
+              cg.formatLabel(name).c_str());
+  }
+  return true;
+}
+
 void VariableTable::outputCPPPropertyOp
 (CodeGenerator &cg, AnalysisResultPtr ar,
  const char *cls, const char *parent, const char *op, const char *argsDec,
@@ -1665,13 +1727,21 @@ void VariableTable::outputCPPPropertyOp
     cg_indentBegin("%s %s%s::%s%sPublic(CStrRef s%s)%s {\n",
                    ret, Option::ClassPrefix, cls,
                    Option::ObjectPrefix, op, argsDec, cnst ? " const" : "");
-    if (!outputCPPJumpTable(cg, ar, Option::PropertyPrefix, true, varOnly,
-                            NonStatic, type)) {
+    string base = parent;
+    bool found;
+    if (Option::FlattenInvoke && type == JumpRealProp) {
+      found = outputCPPFlatRealPropTable(cg, ar, varOnly, base);
+    } else {
+      found = outputCPPJumpTable(cg, ar, Option::PropertyPrefix, true,
+                                 varOnly, NonStatic, type);
+    }
+    if (!found) {
       // offset 1 based on enum order
       m_emptyJumpTables.insert((JumpTableName)(jtname + 1));
     }
     cg_printf("return %s%s::%s%sPublic(s%s);\n",
-              Option::ClassPrefix, parent, Option::ObjectPrefix, op, args);
+              Option::ClassPrefix, base.c_str(), Option::ObjectPrefix, op,
+              args);
     cg_indentEnd("}\n");
     cg.ifdefEnd("OMIT_JUMP_TABLE_CLASS_%s_PUBLIC_%s", op, cls);
   }
@@ -343,6 +343,8 @@ private:
                           bool *declaredGlobals = NULL);
   bool outputCPPPrivateSelector(CodeGenerator &cg, AnalysisResultPtr ar,
                                 const char *op, const char *args);
+  bool outputCPPFlatRealPropTable(CodeGenerator &cg, AnalysisResultPtr ar,
+                                  bool varOnly, std::string &base);
   void outputCPPPropertyOp(CodeGenerator &cg, AnalysisResultPtr ar,
       const char *cls, const char *parent, const char *op, const char *argsDec,
       const char *args, const char *ret, bool cnst, JumpTableType type,
@@ -47,6 +47,31 @@ void CodeGenerator::BuildJumpTable(const std::vector<const char *> &strings,
   }
 }
 
+int CodeGenerator::FindPerfectTableSize(const std::vector<const char *> &strs,
+                                        int tableSize, int maxSize,
+                                        bool caseInsensitive) {
+  ASSERT(Util::isPowerOfTwo(tableSize));
+  std::vector<int64> hashes;
+  hashes.reserve(strs.size());
+  for (unsigned int i = 0; i < strs.size(); i++) {
+    const char *s = strs[i];
+    hashes.push_back(caseInsensitive ? hash_string_i(s) : hash_string(s));
+  }
+
+  std::vector<bool> used;
+  for (int size = tableSize; size <= maxSize; size <<= 1) {
+    used.assign(size, false);
+    unsigned int i = 0;
+    for (; i < hashes.size(); i++) {
+      int slot = hashes[i] & (size - 1);
+      if (used[slot]) break;
+      used[slot] = true;
+    }
+    if (i == hashes.size()) return size;
+  }
+  return tableSize;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 CodeGenerator::CodeGenerator(std::ostream *primary,
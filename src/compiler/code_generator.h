@@ -94,6 +94,15 @@ public:
                              MapIntToStringVec &out, int tableSize,
                              bool caseInsensitive);
 
+  /**
+   * Smallest power-of-two table size, between tableSize and maxSize, that
+   * puts every string into its own bucket. Returns tableSize if there is
+   * no such size, so callers can always use the result.
+   */
+  static int FindPerfectTableSize(const std::vector<const char *> &strings,
+                                  int tableSize, int maxSize,
+                                  bool caseInsensitive);
+
 public:
   CodeGenerator() {} // only for creating a dummy code generator
   CodeGenerator(std::ostream *primary, Output output = PickledPHP,
@@ -150,6 +150,7 @@ std::string Option::RTTIOutputFile;
 std::string Option::RTTIDirectory;
 bool Option::GenRTTIProfileData = false;
 bool Option::UseRTTIProfileData = false;
+int Option::HotFunctionCoverage = 90;
 
 bool Option::GenerateCPPMacros = true;
 bool Option::GenerateCPPMain = false;
@@ -177,6 +178,8 @@ bool Option::EnableXHP = false;
 int Option::InvokeFewArgsCount = 6;
 bool Option::PrecomputeLiteralStrings = true;
 bool Option::FlattenInvoke = true;
+bool Option::PerfectHashJumpTable = false;
+int Option::PerfectHashMaxTableFactor = 8;
 int Option::InlineFunctionThreshold = -1;
 bool Option::ControlEvalOrder = true;
 bool Option::UseVirtualDispatch = false;
@@ -349,6 +352,7 @@ void Option::Load(Hdf &config) {
   }
   EnableXHP = config["EnableXHP"].getBool();
   RTTIOutputFile = config["RTTIOutputFile"].getString();
+  HotFunctionCoverage = config["HotFunctionCoverage"].getInt32(90);
   EnableEval = (EvalLevel)config["EnableEval"].getByte(0);
   AllDynamic = config["AllDynamic"].getBool(true);
   AllVolatile = config["AllVolatile"].getBool();
@@ -362,6 +366,11 @@ void Option::Load(Hdf &config) {
   StringLoopOpts     = config["StringLoopOpts"].getBool(true);
   AutoInline         = config["AutoInline"].getBool(false);
 
+  PerfectHashJumpTable = config["PerfectHashJumpTable"].getBool(false);
+  PerfectHashMaxTableFactor =
+    config["PerfectHashMaxTableFactor"].getInt32(8);
+  if (PerfectHashMaxTableFactor < 1) PerfectHashMaxTableFactor = 1;
+
   if (m_hookHandler) m_hookHandler(config);
 
   OnLoad();
@@ -133,6 +133,14 @@ public:
   static bool GenRTTIProfileData;
   static bool UseRTTIProfileData;
 
+  /**
+   * When compiling with RTTI profiling data, the busiest functions that
+   * together account for this percentage of profiled calls are placed in
+   * the hot text section; profiled functions never called go to the
+   * unlikely one.
+   */
+  static int HotFunctionCoverage;
+
   /**
    * Generate concatN (n > 6) service routines
    */
@@ -315,6 +323,8 @@ public:
   static int InvokeFewArgsCount;
   static bool PrecomputeLiteralStrings;
   static bool FlattenInvoke;
+  static bool PerfectHashJumpTable;
+  static int PerfectHashMaxTableFactor;
   static int InlineFunctionThreshold;
   static bool ControlEvalOrder;
   static bool UseVirtualDispatch;
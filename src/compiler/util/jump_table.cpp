@@ -67,6 +67,11 @@ JumpTable::JumpTable(CodeGenerator &cg,
     return;
   }
   int tableSize = Util::roundUpToPowerOfTwo(keys.size() * 2);
+  if (Option::PerfectHashJumpTable) {
+    tableSize = CodeGenerator::FindPerfectTableSize
+      (keys, tableSize, tableSize * Option::PerfectHashMaxTableFactor,
+       caseInsensitive);
+  }
   CodeGenerator::BuildJumpTable(keys, m_table, tableSize, caseInsensitive);
   if (hasPrehash) {
     m_cg_printf("if (hash < 0) ");
@@ -841,6 +841,9 @@ int buildTarget(const ProgramOptions &po) {
   if (getenv("RELEASE"))      flags += "RELEASE=1 ";
   if (getenv("SHOW_LINK"))    flags += "SHOW_LINK=1 ";
   if (getenv("SHOW_COMPILE")) flags += "SHOW_COMPILE=1 ";
+  if (getenv("CPP_PROFILE_GENERATE")) flags += "CPP_PROFILE_GENERATE=1 ";
+  if (getenv("LD_PROFILE_GENERATE"))  flags += "LD_PROFILE_GENERATE=1 ";
+  if (getenv("PROFILE_USE"))  flags += "PROFILE_USE=1 ";
   if (po.format == "lib")     flags += "HPHP_BUILD_LIBRARY=1 ";
   if (Option::GenerateFFI)    flags += "HPHP_BUILD_FFI=1 ";
   const char *argv[] = {"", po.outputDir.c_str(),
@@ -264,6 +264,28 @@ DefineFunction(
     ),
   ));
 
+DefineFunction(
+  array(
+    'name'   => "memcache_get_multi",
+    'desc'   => "Fetches many keys at once. Duplicate keys are fetched only once, and keys already fetched through the same object are served from a request-local cache when memcache.local_cache is on. Remaining keys are sent to all their servers before any reply is read.",
+    'flags'  =>  HasDocComment | HipHopSpecific,
+    'return' => array(
+      'type'   => VariantMap,
+      'desc'   => "Returns an array of found key-value pairs.",
+    ),
+    'args'   => array(
+      array(
+        'name'   => "memcache",
+        'type'   => Object,
+      ),
+      array(
+        'name'   => "keys",
+        'type'   => StringVec,
+        'desc'   => "The array of keys to fetch.",
+      ),
+    ),
+  ));
+
 DefineFunction(
   array(
     'name'   => "memcache_delete",
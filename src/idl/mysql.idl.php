@@ -1027,6 +1027,36 @@ DefineFunction(
     ),
   ));
 
+DefineFunction(
+  array(
+    'name'   => "mysql_fetch_all",
+    'desc'   => "Fetches all remaining rows of a result at once. Field names are converted to keys only once and shared by all rows, and string values of unbuffered results are copied into large request-lifetime blocks instead of being allocated one by one.",
+    'flags'  =>  HasDocComment | HipHopSpecific,
+    'return' => array(
+      'type'   => Variant,
+      'desc'   => "Returns an array of rows, each as mysql_fetch_array() would return it. In columnar mode, returns one array of values per column instead, keyed the same way as a row. Returns FALSE on failure.",
+    ),
+    'args'   => array(
+      array(
+        'name'   => "result",
+        'type'   => Variant,
+        'desc'   => "resource that is being evaluated. This result comes from a call to mysql_query().",
+      ),
+      array(
+        'name'   => "result_type",
+        'type'   => Int32,
+        'value'  => "1",
+        'desc'   => "MYSQL_ASSOC, MYSQL_NUM, or MYSQL_BOTH.",
+      ),
+      array(
+        'name'   => "columnar",
+        'type'   => Boolean,
+        'value'  => "false",
+        'desc'   => "Whether to return columns instead of rows.",
+      ),
+    ),
+  ));
+
 DefineFunction(
   array(
     'name'   => "mysql_fetch_lengths",
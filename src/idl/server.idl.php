@@ -119,6 +119,36 @@ DefineFunction(
     ),
   ));
 
+DefineFunction(
+  array(
+    'name'   => "pagelet_server_task_start_multi",
+    'desc'   => "Processes a batch of pagelet server requests. All of them share one copy of the headers, so they are parsed only once.",
+    'flags'  =>  HasDocComment | HipHopSpecific,
+    'return' => array(
+      'type'   => VariantVec,
+      'desc'   => "Task handles keyed the same way as urls, each of them an object that can be used with pagelet_server_task_status(), pagelet_server_task_wait() or pagelet_server_task_result().",
+    ),
+    'args'   => array(
+      array(
+        'name'   => "urls",
+        'type'   => StringVec,
+        'desc'   => "The URLs we're running these pagelets with.",
+      ),
+      array(
+        'name'   => "headers",
+        'type'   => StringMap,
+        'value'  => "null_array",
+        'desc'   => "HTTP headers to send to every pagelet.",
+      ),
+      array(
+        'name'   => "post_data",
+        'type'   => StringVec,
+        'value'  => "null_array",
+        'desc'   => "POST data to send, keyed the same way as urls. Pagelets without an entry are GET requests.",
+      ),
+    ),
+  ));
+
 DefineFunction(
   array(
     'name'   => "pagelet_server_task_status",
@@ -137,6 +167,30 @@ DefineFunction(
     ),
   ));
 
+DefineFunction(
+  array(
+    'name'   => "pagelet_server_task_wait",
+    'desc'   => "Block until one of the pagelet tasks finishes.",
+    'flags'  =>  HasDocComment | HipHopSpecific,
+    'return' => array(
+      'type'   => Variant,
+      'desc'   => "Key of a finished task in tasks, or FALSE if none finished in time.",
+    ),
+    'args'   => array(
+      array(
+        'name'   => "tasks",
+        'type'   => VariantVec,
+        'desc'   => "Pagelet task handles returned from pagelet_server_task_start() or pagelet_server_task_start_multi().",
+      ),
+      array(
+        'name'   => "timeout_ms",
+        'type'   => Int32,
+        'value'  => "-1",
+        'desc'   => "How many milliseconds to wait. Negative waits until a task finishes, and 0 returns right away.",
+      ),
+    ),
+  ));
+
 DefineFunction(
   array(
     'name'   => "pagelet_server_task_result",
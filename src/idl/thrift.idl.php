@@ -107,6 +107,61 @@ DefineFunction(
     ),
   ));
 
+DefineFunction(
+  array(
+    'name'   => "thrift_protocol_write_compact",
+    'desc'   => "Writes a message and its struct with thrift's compact protocol.",
+    'flags'  =>  HasDocComment | HipHopSpecific,
+    'return' => array(
+      'type'   => null,
+    ),
+    'args'   => array(
+      array(
+        'name'   => "transportobj",
+        'type'   => Object,
+        'desc'   => "The protocol object, whose transport is written to.",
+      ),
+      array(
+        'name'   => "method_name",
+        'type'   => String,
+      ),
+      array(
+        'name'   => "msgtype",
+        'type'   => Int64,
+      ),
+      array(
+        'name'   => "request_struct",
+        'type'   => Object,
+      ),
+      array(
+        'name'   => "seqid",
+        'type'   => Int32,
+      ),
+    ),
+  ));
+
+DefineFunction(
+  array(
+    'name'   => "thrift_protocol_read_compact",
+    'desc'   => "Reads a message written with thrift's compact protocol.",
+    'flags'  =>  HasDocComment | HipHopSpecific,
+    'return' => array(
+      'type'   => Variant,
+      'desc'   => "An object of class obj_typename. If the message is an exception, a TApplicationException is thrown instead.",
+    ),
+    'args'   => array(
+      array(
+        'name'   => "transportobj",
+        'type'   => Object,
+        'desc'   => "The protocol object, whose transport is read from.",
+      ),
+      array(
+        'name'   => "obj_typename",
+        'type'   => String,
+      ),
+    ),
+  ));
+
 
 ///////////////////////////////////////////////////////////////////////////////
 // Classes
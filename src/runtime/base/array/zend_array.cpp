@@ -20,6 +20,7 @@
 #include <runtime/base/complex_types.h>
 #include <runtime/base/runtime_option.h>
 #include <runtime/base/runtime_error.h>
+#include <runtime/base/memory/memory_manager.h>
 #include <util/hash.h>
 #include <util/lock.h>
 
@@ -1373,7 +1374,7 @@ void ZendArray::restore(const char *&data) {
 
 void ZendArray::sweep() {
   if (!m_linear && m_arBuckets) {
-    free(m_arBuckets);
+    MemoryManager::TheMemoryManager()->reclaim(m_arBuckets);
     m_arBuckets = NULL;
   }
   m_strongIterators.clear();
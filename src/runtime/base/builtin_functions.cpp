@@ -110,8 +110,10 @@ Variant f_call_user_func_array(CVarRef function, CArrRef params) {
         return classname.toObject()->o_invoke_ex_mil
           (cls.c_str(), method.substr(c+2).c_str(), params, -1, false);
       }
+      // generated invoke tables hash method names the same way StringData
+      // does, so pass the string's cached hash instead of rehashing it
       return classname.toObject()->o_invoke_mil(method.c_str(), params,
-                                                -1, false);
+                                                method->hash(), false);
     } else {
       if (!classname.isString()) {
         throw_invalid_argument("function: classname not string");
@@ -213,6 +213,12 @@ void ExecutionContext::writeStdout(const char *s, int len) {
   }
 }
 
+void ExecutionContext::writeStdout(const ChunkedBuffer &buf) {
+  for (int i = 0; i < buf.chunkCount(); i++) {
+    writeStdout(buf.chunkData(i), buf.chunkSize(i));
+  }
+}
+
 void ExecutionContext::write(const char *s, int len) {
   if (m_out) {
     m_out->append(s, len);
@@ -238,7 +244,7 @@ void ExecutionContext::obStart(CVarRef handler /* = null */) {
 
 String ExecutionContext::obCopyContents() {
   if (!m_buffers.empty()) {
-    StringBuffer &oss = m_buffers.back()->oss;
+    ChunkedBuffer &oss = m_buffers.back()->oss;
     if (!oss.empty()) {
       return oss.copy();
     }
@@ -248,7 +254,7 @@ String ExecutionContext::obCopyContents() {
 
 String ExecutionContext::obDetachContents() {
   if (!m_buffers.empty()) {
-    StringBuffer &oss = m_buffers.back()->oss;
+    ChunkedBuffer &oss = m_buffers.back()->oss;
     if (!oss.empty()) {
       return oss.detach();
     }
@@ -292,7 +298,7 @@ bool ExecutionContext::obFlush() {
       }
       return true;
     }
-    writeStdout(last->oss.data(), last->oss.size());
+    writeStdout(last->oss);
     last->oss.reset();
     return true;
   }
@@ -345,12 +351,17 @@ void ExecutionContext::flush() {
              (m_transport == NULL ||
               (m_transport->getHTTPVersion() == "1.1" &&
                m_transport->getMethod() != Transport::HEAD))) {
-    StringBuffer &oss = m_buffers.front()->oss;
+    ChunkedBuffer &oss = m_buffers.front()->oss;
     if (!oss.empty()) {
       if (m_transport) {
-        m_transport->sendRaw((void*)oss.data(), oss.size(), 200, false, true);
+        for (int i = 0; i < oss.chunkCount(); i++) {
+          if (oss.chunkSize(i)) {
+            m_transport->sendRaw((void*)oss.chunkData(i), oss.chunkSize(i),
+                                 200, false, true);
+          }
+        }
       } else {
-        writeStdout(oss.data(), oss.size());
+        writeStdout(oss);
         fflush(stdout);
       }
       oss.reset();
@@ -23,6 +23,7 @@
 #include <runtime/base/fiber_safe.h>
 #include <runtime/base/debuggable.h>
 #include <runtime/base/util/string_buffer.h>
+#include <runtime/base/util/chunked_buffer.h>
 #include <util/thread_local.h>
 
 namespace HPHP {
@@ -116,6 +117,7 @@ public:
   void write(const char *s, int len);
   void write(const char *s) { write(s, strlen(s));}
   void writeStdout(const char *s, int len);
+  void writeStdout(const ChunkedBuffer &buf);
 
   typedef void (*PFUNC_STDOUT)(const char *s, int len, void *data);
   void setStdout(PFUNC_STDOUT func, void *data);
@@ -203,8 +205,7 @@ public:
 private:
   class OutputBuffer {
   public:
-    OutputBuffer() : oss(8192) {}
-    StringBuffer oss;
+    ChunkedBuffer oss;
     Variant handler;
   };
 
@@ -215,7 +216,7 @@ private:
   String m_cwd;
 
   // output buffering
-  StringBuffer *m_out;                // current output buffer
+  ChunkedBuffer *m_out;               // current output buffer
   std::list<OutputBuffer*> m_buffers; // a stack of output buffers
   bool m_implicitFlush;
   int m_protectedLevel;
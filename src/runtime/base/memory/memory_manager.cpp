@@ -18,22 +18,106 @@
 #include <runtime/base/memory/leak_detectable.h>
 #include <runtime/base/memory/sweepable.h>
 #include <runtime/base/runtime_option.h>
+#include <util/async_func.h>
 
 namespace HPHP {
 ///////////////////////////////////////////////////////////////////////////////
 
+/**
+ * Frees blocks handed over by request threads at rollback time, so that
+ * returning them to malloc is not part of a worker's service time.
+ */
+class MemoryReclaimer : public Synchronizable {
+public:
+  static MemoryReclaimer &GetInstance() {
+    // never deleted, as the thread runs until the process exits
+    static MemoryReclaimer *s_reclaimer = new MemoryReclaimer();
+    return *s_reclaimer;
+  }
+
+  MemoryReclaimer()
+    : m_thread(this, &MemoryReclaimer::threadRun), m_started(false),
+      m_freeing(false), m_freed(0) {
+  }
+
+  /**
+   * Takes over all blocks in the vector, leaving it empty.
+   */
+  void reclaim(std::vector<void*> &blocks) {
+    Lock lock(this);
+    if (!m_started) {
+      m_thread.start();
+      m_started = true;
+    }
+    if (m_pending.empty()) {
+      m_pending.swap(blocks);
+    } else {
+      m_pending.insert(m_pending.end(), blocks.begin(), blocks.end());
+      blocks.clear();
+    }
+    notifyAll();
+  }
+
+  void threadRun() {
+    std::vector<void*> blocks;
+    while (true) {
+      {
+        Lock lock(this);
+        while (m_pending.empty()) {
+          wait();
+        }
+        blocks.swap(m_pending);
+        m_freeing = true;
+      }
+      for (unsigned int i = 0; i < blocks.size(); i++) {
+        free(blocks[i]);
+      }
+      {
+        Lock lock(this);
+        m_freed += blocks.size();
+        m_freeing = false;
+        notifyAll();
+      }
+      blocks.clear();
+    }
+  }
+
+  /**
+   * Blocks until everything handed over so far is freed, then returns how
+   * many blocks have been freed in total.
+   */
+  int64 drain() {
+    Lock lock(this);
+    while (!m_pending.empty() || m_freeing) {
+      wait();
+    }
+    return m_freed;
+  }
+
+private:
+  AsyncFunc<MemoryReclaimer> m_thread;
+  bool m_started;
+  bool m_freeing;
+  int64 m_freed;
+  std::vector<void*> m_pending;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
 IMPLEMENT_THREAD_LOCAL(MemoryManager, MemoryManager::s_singleton);
 
 ThreadLocal<MemoryManager> &MemoryManager::TheMemoryManager() {
   return s_singleton;
 }
 
-MemoryManager::MemoryManager() : m_enabled(false), m_checkpoint(false) {
+MemoryManager::MemoryManager()
+  : m_enabled(false), m_checkpoint(false), m_reclaiming(false) {
   if (RuntimeOption::EnableMemoryManager) {
     m_enabled = true;
   }
   resetStats();
   m_stats.maxBytes = 0;
+  m_lastStats = m_stats;
 }
 
 void MemoryManager::resetStats() {
@@ -102,12 +186,21 @@ void MemoryManager::sweepAll() {
 }
 
 void MemoryManager::rollback() {
+  m_reclaiming = RuntimeOption::BackgroundReclaim;
   m_linearAllocator.beginRestore();
   for (unsigned int i = 0; i < m_smartAllocators.size(); i++) {
     m_smartAllocators[i]->rollbackObjects(m_linearAllocator);
   }
   m_linearAllocator.endRestore();
   protectUnsafePointers();
+  m_reclaiming = false;
+  if (!m_reclaimed.empty()) {
+    MemoryReclaimer::GetInstance().reclaim(m_reclaimed);
+  }
+}
+
+int64 MemoryManager::DrainReclaimed() {
+  return MemoryReclaimer::GetInstance().drain();
 }
 
 void MemoryManager::disableDealloc() {
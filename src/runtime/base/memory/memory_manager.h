@@ -96,6 +96,25 @@ public:
   void sweepAll();
   void rollback();
 
+  /**
+   * Free a malloc-ed block that belonged to the request being rolled back.
+   * With RuntimeOption::BackgroundReclaim, blocks passed in during
+   * rollback() are freed on a background thread instead.
+   */
+  void reclaim(void *p) {
+    if (m_reclaiming) {
+      m_reclaimed.push_back(p);
+    } else {
+      free(p);
+    }
+  }
+
+  /**
+   * Wait for the background thread to free every block handed to it so far.
+   * Returns the number of blocks it has freed since the process started.
+   */
+  static int64 DrainReclaimed();
+
   /**
    * For any objects that need to do extra work during thread shutdown time.
    */
@@ -126,17 +145,27 @@ public:
    */
   void resetStats();
 
+  /**
+   * Stats of the last session as it ended, kept by saveStats() before they
+   * are reset.
+   */
+  const MemoryUsageStats &getLastStats() const { return m_lastStats;}
+  void saveStats() { m_lastStats = m_stats;}
+
 private:
   static DECLARE_THREAD_LOCAL(MemoryManager, s_singleton);
 
   bool m_enabled;
   bool m_checkpoint;
+  bool m_reclaiming;
+  std::vector<void*> m_reclaimed;
 
   std::vector<SmartAllocatorImpl*> m_smartAllocators;
   LinearAllocator m_linearAllocator;
   std::set<UnsafePointer*> m_unsafePointers;
 
   MemoryUsageStats m_stats;
+  MemoryUsageStats m_lastStats;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -342,9 +342,10 @@ void SmartAllocatorImpl::rollbackObjects(LinearAllocator &allocator) {
     ASSERT(m_row == 0);
     ASSERT(m_col == 0);
     ASSERT(m_freelist.size() == 0);
+    MemoryManager *mm = MemoryManager::TheMemoryManager().get();
     for (unsigned int i = m_multiplier; i < m_blocks.size();
          i += m_multiplier) {
-      free(m_blocks[i]);
+      mm->reclaim(m_blocks[i]);
     }
     m_blocks.resize(1);
     if (m_multiplier != newMultiplier) {
@@ -354,9 +355,10 @@ void SmartAllocatorImpl::rollbackObjects(LinearAllocator &allocator) {
     m_multiplier = newMultiplier;
     m_allocatedBlocks = m_multiplier - 1;
   } else {
+    MemoryManager *mm = MemoryManager::TheMemoryManager().get();
     for (unsigned int i = m_backupBlocks.size(); i < m_blocks.size();
          i += m_multiplier) {
-      free(m_blocks[i]);
+      mm->reclaim(m_blocks[i]);
     }
     m_blocks.resize(m_backupBlocks.size());
     copyMemoryBlocks(m_blocks, m_backupBlocks, m_colChecked, m_colMax);
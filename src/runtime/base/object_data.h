@@ -62,6 +62,7 @@ class ObjectData : public Countable {
     UseGet        = 16, // __get()
     UseUnset      = 32, // __unset()
     HasLval       = 64, // defines ___lval
+    IsEvalObject  = 128, // an Eval::EvalObjectData, of an eval'd class
   };
   enum {
     RealPropCreate = 1,   // Property should be created if it doesnt exist
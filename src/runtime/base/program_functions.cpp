@@ -27,6 +27,7 @@
 #include <runtime/base/server/xbox_server.h>
 #include <runtime/base/server/http_server.h>
 #include <runtime/base/server/replay_transport.h>
+#include <runtime/base/server/replay_benchmark.h>
 #include <runtime/base/server/http_request_handler.h>
 #include <runtime/base/server/admin_request_handler.h>
 #include <runtime/base/server/server_stats.h>
@@ -45,6 +46,7 @@
 #include <runtime/ext/ext_json.h>
 #include <runtime/ext/ext_variable.h>
 #include <runtime/ext/ext_apc.h>
+#include <runtime/ext/stack_sampler.h>
 #include <runtime/eval/runtime/code_coverage.h>
 #include <runtime/eval/debugger/debugger.h>
 #include <runtime/eval/debugger/debugger_client.h>
@@ -78,6 +80,7 @@ struct ProgramOptions {
   string     user;
   string     file;
   int        count;
+  int        threads;
   bool       noSafeAccessCheck;
   StringVec  args;
   string     buildId;
@@ -554,7 +557,7 @@ static int execute_program_impl(int argc, char **argv) {
     ("compiler-id", "display the git hash for the compiler id")
 #endif
     ("mode,m", value<string>(&po.mode)->default_value("run"),
-     "run | debug (d) | server (s) | daemon | replay | translate (t)")
+     "run | debug (d) | server (s) | daemon | replay | bench | translate (t)")
     ("config,c", value<string>(&po.config),
      "load specified config file")
     ("config-value,v", value<StringVec >(&po.confStrings)->composing(),
@@ -581,6 +584,8 @@ static int execute_program_impl(int argc, char **argv) {
      "executing specified file")
     ("count", value<int>(&po.count)->default_value(1),
      "how many times to repeat execution")
+    ("threads", value<int>(&po.threads)->default_value(1),
+     "how many threads to replay requests on, in bench mode")
     ("no-safe-access-check",
       value<bool>(&po.noSafeAccessCheck)->default_value(false),
      "whether to ignore safe file access check")
@@ -756,6 +761,23 @@ static int execute_program_impl(int argc, char **argv) {
     return 0;
   }
 
+  if (po.mode == "bench" && !po.args.empty()) {
+    RuntimeOption::RecordInput = false;
+    RuntimeOption::ExecutionMode = "srv";
+    HttpServer server; // so we initialize runtime properly
+    ReplayBenchmark bench(po.threads, po.count);
+    for (unsigned int i = 0; i < po.args.size(); i++) {
+      bench.load(po.args[i]);
+    }
+    if (bench.getRequestCount() == 0) {
+      cerr << "No recorded requests to replay\n";
+      return -1;
+    }
+    bench.run();
+    printf("%s", bench.report().c_str());
+    return 0;
+  }
+
   if (po.mode == "translate" && !po.args.empty()) {
     if (!access(po.args[0].c_str(), F_OK)) {
       translate_rtti(po.args[0].c_str());
@@ -812,6 +834,7 @@ void hphp_process_init() {
 void hphp_session_init() {
   ThreadInfo::s_threadInfo->onSessionInit();
   MemoryManager::TheMemoryManager()->resetStats();
+  StackSampler::OnSessionInit();
 
   if (!s_warmup_state->done) {
     free_global_variables(); // just to be safe
@@ -1001,6 +1024,7 @@ void hphp_session_exit() {
   if (RuntimeOption::EnableStats && RuntimeOption::EnableMemoryStats) {
     mm->logStats();
   }
+  mm->saveStats();
   mm->resetStats();
 
   if (mm->afterCheckpoint()) {
@@ -31,6 +31,7 @@ namespace HPHP {
 ///////////////////////////////////////////////////////////////////////////////
 
 RTTIInfo RTTIInfo::TheRTTIInfo;
+bool RTTIInfo::Enabled = true;
 
 RTTIInfo::RTTIInfo() : m_loaded(false), m_count(0), m_profData(NULL) {
 }
@@ -77,7 +78,9 @@ void RTTIInfo::translate_rtti(const char *rttiDirectory) {
 class RTTICounters : public RequestEventHandler {
 public:
   RTTICounters() : m_data(NULL), m_count(0), m_requests(0) { }
-  RTTICounter *getCounter(int id) { return m_data ? &m_data[id] : NULL; }
+  RTTICounter *getCounter(int id) {
+    return m_data && RTTIInfo::Enabled ? &m_data[id] : NULL;
+  }
   virtual void requestInit() {
     if (!m_data) {
       m_count = RTTIInfo::TheRTTIInfo.getCount();
@@ -151,13 +154,20 @@ void RTTIInfo::loadMetaData(const char *filename) {
   if (fgets(line, sizeof(line), f)) {
     sscanf(line, "%d", &m_count);
   }
+  // the first m_count lines name the parameter counters, the rest are the
+  // functions that carry them
   while (fgets(line, sizeof(line), f)) {
     int len = strlen(line);
     ASSERT(len > 0);
     if (line[len-1] == '\n') line[len-1] = 0;
-    m_functions.insert(line);
+    if ((int)m_id2name.size() < m_count) {
+      m_id2name.push_back(line);
+    } else {
+      m_functions.insert(line);
+    }
   }
   fclose(f);
+  m_loaded = true;
 }
 
 bool RTTIInfo::loadProfData(const char *rttiDirectory) {
@@ -211,6 +221,17 @@ bool RTTIInfo::loadProfData(const char *rttiDirectory) {
   free(counter);
   if (m_profData) free(m_profData);
   m_profData = sum;
+
+  m_callCounts.clear();
+  for (int i = 0; i < m_count && i < (int)m_id2name.size(); i++) {
+    unsigned int total = 0;
+    for (int j = 0; j < MaxNumDataTypes; j++) total += m_profData[i][j];
+    const string &param = m_id2name[i];
+    size_t pos = param.rfind("::");
+    if (pos == string::npos) continue;
+    unsigned int &count = m_callCounts[param.substr(0, pos)];
+    if (total > count) count = total;
+  }
   return true;
 }
 
@@ -218,5 +239,11 @@ bool RTTIInfo::exists(const char *funcName) {
   return m_functions.find(funcName) != m_functions.end();
 }
 
+unsigned int RTTIInfo::getCallCount(const char *funcName) {
+  hphp_string_map<unsigned int>::const_iterator iter =
+    m_callCounts.find(funcName);
+  return iter == m_callCounts.end() ? 0 : iter->second;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 }
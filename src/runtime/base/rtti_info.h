@@ -30,11 +30,25 @@ typedef unsigned int RTTICounter[MaxNumDataTypes];
 class RTTIInfo {
 public:
   static RTTIInfo TheRTTIInfo;
+
+  /**
+   * Main switch for collecting counters in a profiling build, flipped by
+   * the admin server's /rtti-on and /rtti-off.
+   */
+  static bool Enabled;
+
   void translate_rtti(const char *rttiDir);
   void loadMetaData(const char *filename);
   bool loadProfData(const char *rttiDir);
   bool exists(const char *funcName);
 
+  /**
+   * Number of profiled calls seen by a function, taken as the largest
+   * counter total among its parameters. Only meaningful after
+   * loadMetaData() and loadProfData().
+   */
+  unsigned int getCallCount(const char *funcName);
+
 public:
   RTTIInfo();
   ~RTTIInfo() { if (m_profData) free(m_profData);}
@@ -48,6 +62,7 @@ private:
   int m_count;
   std::vector<std::string> m_id2name;
   std::set<std::string> m_functions;
+  hphp_string_map<unsigned int> m_callCounts;
   RTTICounter *m_profData;
 
   void loadParamMap(const char **p);
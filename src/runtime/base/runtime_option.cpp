@@ -23,6 +23,7 @@
 #include <util/stack_trace.h>
 #include <util/process.h>
 #include <util/file_cache.h>
+#include <util/compression.h>
 #include <runtime/base/preg.h>
 #include <runtime/base/server/access_log.h>
 #include <runtime/base/util/extended_logger.h>
@@ -78,7 +79,12 @@ std::string RuntimeOption::ServerIP;
 std::string RuntimeOption::ServerPrimaryIP;
 int RuntimeOption::ServerPort;
 int RuntimeOption::ServerThreadCount = 50;
+int RuntimeOption::ServerReservedThreadCount = 0;
+int RuntimeOption::ServerThreadPriority = 0;
+bool RuntimeOption::ServerSharedThreadPool = false;
 int RuntimeOption::PageletServerThreadCount = 0;
+int RuntimeOption::PageletServerReservedThreadCount = 0;
+int RuntimeOption::PageletServerThreadPriority = 0;
 int RuntimeOption::FiberCount = 0;
 int RuntimeOption::RequestTimeoutSeconds = 0;
 int RuntimeOption::RequestMemoryMaxBytes = -1;
@@ -106,10 +112,13 @@ int RuntimeOption::UploadMaxFileSize;
 std::string RuntimeOption::UploadTmpDir;
 bool RuntimeOption::EnableFileUploads;
 bool RuntimeOption::EnableUploadProgress;
+int RuntimeOption::UploadStreamMinSize = 0;
+int RuntimeOption::UploadStreamBufferSize = 16 * 1024 * 1024;
 int RuntimeOption::Rfc1867Freq;
 std::string RuntimeOption::Rfc1867Prefix;
 std::string RuntimeOption::Rfc1867Name;
 bool RuntimeOption::LibEventSyncSend = true;
+int RuntimeOption::DirectSendMinSize = 65536;
 bool RuntimeOption::ExpiresActive = true;
 int RuntimeOption::ExpiresDefault = 2592000;
 std::string RuntimeOption::DefaultCharsetName = "UTF-8";
@@ -127,6 +136,8 @@ IpBlockMapPtr RuntimeOption::IpBlocks;
 SatelliteServerInfoPtrVec RuntimeOption::SatelliteServerInfos;
 
 int RuntimeOption::XboxServerThreadCount = 0;
+int RuntimeOption::XboxServerReservedThreadCount = 0;
+int RuntimeOption::XboxServerThreadPriority = 0;
 int RuntimeOption::XboxServerPort = 0;
 int RuntimeOption::XboxDefaultLocalTimeoutMilliSeconds = 500;
 int RuntimeOption::XboxDefaultRemoteTimeoutSeconds = 5;
@@ -150,6 +161,8 @@ bool RuntimeOption::EnableStaticContentCache = true;
 bool RuntimeOption::EnableStaticContentFromDisk = true;
 bool RuntimeOption::EnableOnDemandUncompress = true;
 bool RuntimeOption::EnableStaticContentMMap = true;
+bool RuntimeOption::EnableParsedFileCache = true;
+int RuntimeOption::ParsedFileCacheSize = 1000;
 
 std::string RuntimeOption::RTTIDirectory;
 bool RuntimeOption::EnableCliRTTI = false;
@@ -192,6 +205,7 @@ bool RuntimeOption::MySQLKillOnTimeout = false;
 
 int RuntimeOption::HttpDefaultTimeout = 30;
 int RuntimeOption::HttpSlowQueryThreshold = 5000; // ms
+int RuntimeOption::HttpClientThreadCount = 2;
 
 bool RuntimeOption::TranslateLeakStackTrace = false;
 bool RuntimeOption::NativeStackTrace = false;
@@ -227,6 +241,9 @@ bool RuntimeOption::EnableAPCSizeDetail = false;
 bool RuntimeOption::EnableAPCFetchStats = false;
 bool RuntimeOption::APCSizeCountPrime = false;
 
+int RuntimeOption::StackSamplingFrequency = 0;
+int RuntimeOption::StackSamplingTableSize = 8192;
+
 int64 RuntimeOption::MaxRSS = 0;
 int64 RuntimeOption::MaxRSSPollingCycle = 0;
 int64 RuntimeOption::DropCacheCycle = 0;
@@ -238,6 +255,7 @@ int RuntimeOption::SocketDefaultTimeout = 5;
 int RuntimeOption::SocketDefaultLingerTimeout = 60; //1 minutes
 bool RuntimeOption::EnableMemoryManager = true;
 bool RuntimeOption::CheckMemory = false;
+bool RuntimeOption::BackgroundReclaim = false;
 bool RuntimeOption::UseSmallArray = false;
 bool RuntimeOption::UseDirectCopy = false;
 bool RuntimeOption::EnableApc = true;
@@ -273,7 +291,11 @@ bool RuntimeOption::EnableStrict = false;
 int RuntimeOption::StrictLevel = 1; // StrictBasic, cf strict_mode.h
 bool RuntimeOption::StrictFatal = false;
 bool RuntimeOption::RecordCodeCoverage = false;
+int RuntimeOption::CodeCoverageSampleRate = 1;
 std::string RuntimeOption::CodeCoverageOutputFile;
+bool RuntimeOption::BytecodeInterpreter = false;
+bool RuntimeOption::DumpBytecode = false;
+std::string RuntimeOption::BytecodeFilePattern;
 
 bool RuntimeOption::SandboxMode = false;
 std::string RuntimeOption::SandboxPattern;
@@ -297,6 +319,9 @@ std::string RuntimeOption::MailForceExtraParameters;
 int RuntimeOption::PregBacktraceLimit = 100000;
 int RuntimeOption::PregRecursionLimit = 100000;
 
+int RuntimeOption::ZlibParallelThreads = 0;
+int RuntimeOption::ZlibParallelMinSize = 1024 * 1024;
+
 ///////////////////////////////////////////////////////////////////////////////
 // keep this block after all the above static variables, or we will have
 // static variable dependency problems on initialization
@@ -481,6 +506,9 @@ void RuntimeOption::Load(Hdf &config) {
     ServerPrimaryIP = Util::GetPrimaryIP();
     ServerPort = server["Port"].getInt16(80);
     ServerThreadCount = server["ThreadCount"].getInt32(50);
+    ServerReservedThreadCount = server["ReservedThreadCount"].getInt32(0);
+    ServerThreadPriority = server["ThreadPriority"].getInt32(0);
+    ServerSharedThreadPool = server["SharedThreadPool"].getBool(false);
     RequestTimeoutSeconds = server["RequestTimeoutSeconds"].getInt32(0);
     RequestMemoryMaxBytes = server["RequestMemoryMaxBytes"].getInt32(-1);
     ResponseQueueCount = server["ResponseQueueCount"].getInt32(0);
@@ -512,6 +540,7 @@ void RuntimeOption::Load(Hdf &config) {
     MaxPostSize = (server["MaxPostSize"].getInt32(100)) * (1 << 20);
     AlwaysPopulateRawPostData = server["AlwaysPopulateRawPostData"].getBool();
     LibEventSyncSend = server["LibEventSyncSend"].getBool(true);
+    DirectSendMinSize = server["DirectSendMinSize"].getInt32(65536);
     TakeoverFilename = server["TakeoverFilename"].getString();
     ExpiresActive = server["ExpiresActive"].getBool(true);
     ExpiresDefault = server["ExpiresDefault"].getInt32(2592000);
@@ -565,6 +594,8 @@ void RuntimeOption::Load(Hdf &config) {
     if (EnableStaticContentMMap) {
       EnableOnDemandUncompress = true;
     }
+    EnableParsedFileCache = server["EnableParsedFileCache"].getBool(true);
+    ParsedFileCacheSize = server["ParsedFileCacheSize"].getInt32(1000);
     RTTIDirectory = server["RTTIDirectory"].getString("/tmp/");
     if (!RTTIDirectory.empty() &&
         RTTIDirectory[RTTIDirectory.length() - 1] != '/') {
@@ -598,6 +629,7 @@ void RuntimeOption::Load(Hdf &config) {
 
     EnableMemoryManager = server["EnableMemoryManager"].getBool(true);
     CheckMemory = server["CheckMemory"].getBool();
+    BackgroundReclaim = server["BackgroundReclaim"].getBool(false);
     UseSmallArray = server["UseSmallArray"].getBool(false);
     UseDirectCopy = server["UseDirectCopy"].getBool(false);
 
@@ -653,6 +685,9 @@ void RuntimeOption::Load(Hdf &config) {
     RuntimeOption::AllowedDirectories.push_back(UploadTmpDir);
     EnableFileUploads = upload["EnableFileUploads"].getBool(true);
     EnableUploadProgress = upload["EnableUploadProgress"].getBool();
+    UploadStreamMinSize = upload["StreamMinSize"].getInt32(0);
+    UploadStreamBufferSize =
+      upload["StreamBufferSize"].getInt32(16 * 1024 * 1024);
     Rfc1867Freq = upload["Rfc1867Freq"].getInt32(256 * 1024);
     if (Rfc1867Freq < 0) Rfc1867Freq = 256 * 1024;
     Rfc1867Prefix = upload["Rfc1867Prefix"].getString("vupload_");
@@ -710,6 +745,9 @@ void RuntimeOption::Load(Hdf &config) {
   {
     Hdf xbox = config["Xbox"];
     XboxServerThreadCount = xbox["ServerInfo.ThreadCount"].getInt32(0);
+    XboxServerReservedThreadCount =
+      xbox["ServerInfo.ReservedThreadCount"].getInt32(0);
+    XboxServerThreadPriority = xbox["ServerInfo.ThreadPriority"].getInt32(0);
     XboxServerPort = xbox["ServerInfo.Port"].getInt32(0);
     XboxDefaultLocalTimeoutMilliSeconds =
       xbox["DefaultLocalTimeoutMilliSeconds"].getInt32(500);
@@ -724,7 +762,14 @@ void RuntimeOption::Load(Hdf &config) {
       xbox["ProcessMessageFunc"].get("xbox_process_message");
   }
   {
-    PageletServerThreadCount = config["PageletServer.ThreadCount"].getInt32(0);
+    Hdf pagelet = config["PageletServer"];
+    PageletServerThreadCount = pagelet["ThreadCount"].getInt32(0);
+    // Page jobs wait for their pagelets, so when they share threads, one has
+    // to be kept for pagelets, or page jobs may take all and wait forever.
+    PageletServerReservedThreadCount =
+      pagelet["ReservedThreadCount"].getInt32
+      (ServerSharedThreadPool && PageletServerThreadCount > 0 ? 1 : 0);
+    PageletServerThreadPriority = pagelet["ThreadPriority"].getInt32(0);
     FiberCount = config["Fiber.ThreadCount"].getInt32(0);
     if (FiberCount > 0) {
       FiberAsyncFunc::Restart();
@@ -773,6 +818,7 @@ void RuntimeOption::Load(Hdf &config) {
     Hdf http = config["Http"];
     HttpDefaultTimeout = http["DefaultTimeout"].getInt32(30);
     HttpSlowQueryThreshold = http["SlowQueryThreshold"].getInt32(5000);
+    HttpClientThreadCount = http["ClientThreadCount"].getInt32(2);
   }
   {
     Hdf debug = config["Debug"];
@@ -833,6 +879,9 @@ void RuntimeOption::Load(Hdf &config) {
     EnableAPCSizeDetail = stats["EnableAPCSizeDetail"].getBool();
     EnableAPCFetchStats = stats["EnableAPCFetchStats"].getBool();
     APCSizeCountPrime = stats["APCSizeCountPrime"].getBool();
+
+    StackSamplingFrequency = stats["StackSamplingFrequency"].getInt32(0);
+    StackSamplingTableSize = stats["StackSamplingTableSize"].getInt32(8192);
   }
   {
     config["ServerVariables"].get(ServerVariables);
@@ -845,7 +894,12 @@ void RuntimeOption::Load(Hdf &config) {
     StrictLevel = eval["StrictLevel"].getInt32(1); // StrictBasic
     StrictFatal = eval["StrictFatal"].getBool();
     RecordCodeCoverage = eval["RecordCodeCoverage"].getBool();
+    CodeCoverageSampleRate = eval["CodeCoverageSampleRate"].getInt32(1);
     CodeCoverageOutputFile = eval["CodeCoverageOutputFile"].getString();
+    BytecodeInterpreter = eval["BytecodeInterpreter"].getBool();
+    DumpBytecode = eval["DumpBytecode"].getBool();
+    BytecodeFilePattern =
+      format_pattern(eval["BytecodeFilePattern"].getString());
     {
       Hdf debugger = eval["Debugger"];
       EnableDebugger = debugger["EnableDebugger"].getBool();
@@ -878,6 +932,12 @@ void RuntimeOption::Load(Hdf &config) {
     PregBacktraceLimit = preg["BacktraceLimit"].getInt32(100000);
     PregRecursionLimit = preg["RecursionLimit"].getInt32(100000);
   }
+  {
+    Hdf zlib = config["Zlib"];
+    ZlibParallelThreads = zlib["ParallelThreads"].getInt32(0);
+    ZlibParallelMinSize = zlib["ParallelMinSize"].getInt32(1024 * 1024);
+    set_parallel_deflate(ZlibParallelThreads, ZlibParallelMinSize);
+  }
 
   Extension::LoadModules(config);
 }
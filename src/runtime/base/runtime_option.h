@@ -75,7 +75,12 @@ public:
   static std::string ServerPrimaryIP;
   static int ServerPort;
   static int ServerThreadCount;
+  static int ServerReservedThreadCount;
+  static int ServerThreadPriority;
+  static bool ServerSharedThreadPool;
   static int PageletServerThreadCount;
+  static int PageletServerReservedThreadCount;
+  static int PageletServerThreadPriority;
   static int FiberCount;
   static int RequestTimeoutSeconds;
   static int RequestMemoryMaxBytes;
@@ -103,10 +108,13 @@ public:
   static std::string UploadTmpDir;
   static bool EnableFileUploads;
   static bool EnableUploadProgress;
+  static int UploadStreamMinSize;
+  static int UploadStreamBufferSize;
   static int Rfc1867Freq;
   static std::string Rfc1867Prefix;
   static std::string Rfc1867Name;
   static bool LibEventSyncSend;
+  static int DirectSendMinSize;
   static bool ExpiresActive;
   static int ExpiresDefault;
   static std::string DefaultCharsetName;
@@ -125,6 +133,8 @@ public:
   static std::string SSLCertificateKeyFile;
 
   static int XboxServerThreadCount;
+  static int XboxServerReservedThreadCount;
+  static int XboxServerThreadPriority;
   static int XboxServerPort;
   static int XboxDefaultLocalTimeoutMilliSeconds;
   static int XboxDefaultRemoteTimeoutSeconds;
@@ -148,6 +158,8 @@ public:
   static bool EnableStaticContentFromDisk;
   static bool EnableOnDemandUncompress;
   static bool EnableStaticContentMMap;
+  static bool EnableParsedFileCache;
+  static int ParsedFileCacheSize;
 
   static std::string RTTIDirectory;
   static bool EnableCliRTTI;
@@ -190,6 +202,7 @@ public:
 
   static int  HttpDefaultTimeout;
   static int  HttpSlowQueryThreshold;
+  static int  HttpClientThreadCount;
 
   static bool TranslateLeakStackTrace;
   static bool NativeStackTrace;
@@ -225,6 +238,9 @@ public:
   static bool EnableAPCFetchStats;
   static bool APCSizeCountPrime;
 
+  static int StackSamplingFrequency;
+  static int StackSamplingTableSize;
+
   static int64 MaxRSS;
   static int64 MaxRSSPollingCycle;
   static int64 DropCacheCycle;
@@ -234,6 +250,7 @@ public:
   static int  SocketDefaultLingerTimeout;
   static bool EnableMemoryManager;
   static bool CheckMemory;
+  static bool BackgroundReclaim;
   static bool UseSmallArray;
   static bool UseDirectCopy;
   static bool EnableApc;
@@ -281,7 +298,11 @@ public:
   static int StrictLevel;
   static bool StrictFatal;
   static bool RecordCodeCoverage;
+  static int CodeCoverageSampleRate;
   static std::string CodeCoverageOutputFile;
+  static bool BytecodeInterpreter;
+  static bool DumpBytecode;
+  static std::string BytecodeFilePattern;
 
   // Sandbox options
   static bool SandboxMode;
@@ -309,6 +330,10 @@ public:
   static int PregBacktraceLimit;
   static int PregRecursionLimit;
 
+  // zlib options
+  static int ZlibParallelThreads;
+  static int ZlibParallelMinSize;
+
   static bool FastMethodCall;
 };
 
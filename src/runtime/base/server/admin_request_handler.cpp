@@ -19,6 +19,7 @@
 #include <runtime/base/util/http_client.h>
 #include <runtime/base/server/server_stats.h>
 #include <runtime/base/runtime_option.h>
+#include <runtime/base/rtti_info.h>
 #include <util/process.h>
 #include <util/logger.h>
 #include <util/util.h>
@@ -29,6 +30,7 @@
 #include <runtime/base/shared/shared_store.h>
 #include <runtime/base/memory/leak_detectable.h>
 #include <runtime/ext/mysql_stats.h>
+#include <runtime/ext/stack_sampler.h>
 #include <runtime/base/shared/shared_store_stats.h>
 #include <runtime/base/util/alloc.h>
 
@@ -126,6 +128,18 @@ void AdminRequestHandler::handleRequest(Transport *transport) {
         "    keysample     optional, only dump keys that belongs to the same\n"
         "                  group as <keysample>\n"
 
+        "/rtti-on:         resume RTTI profile collection (profiling builds)\n"
+        "/rtti-off:        pause RTTI profile collection\n"
+
+        "/prof-stacks:     sampled PHP stacks, folded for flame graph tools\n"
+        "/prof-stacks-on:  start sampling PHP stacks of request threads\n"
+        "    frequency     optional, samples per CPU second, default 100\n"
+        "/prof-stacks-off: stop sampling PHP stacks\n"
+        "/prof-stacks-clear:\n"
+        "                  forget all sampled stacks\n"
+        "/prof-stacks-status:\n"
+        "                  sampling frequency and counters\n"
+
 #ifdef GOOGLE_CPU_PROFILER
         "/prof-cpu-on:     turn on CPU profiler\n"
         "/prof-cpu-off:    turn off CPU profiler\n"
@@ -534,6 +548,43 @@ bool AdminRequestHandler::handleStatsRequest(const std::string &cmd,
 
 bool AdminRequestHandler::handleProfileRequest(const std::string &cmd,
                                                Transport *transport) {
+  if (cmd == "rtti-on") {
+    RTTIInfo::Enabled = true;
+    transport->sendString("OK\n");
+    return true;
+  }
+  if (cmd == "rtti-off") {
+    RTTIInfo::Enabled = false;
+    transport->sendString("OK\n");
+    return true;
+  }
+  if (cmd == "prof-stacks") {
+    transport->sendString(StackSampler::GetFoldedStacks());
+    return true;
+  }
+  if (cmd == "prof-stacks-on") {
+    int frequency = transport->getIntParam("frequency");
+    if (StackSampler::SetFrequency(frequency > 0 ? frequency : 100)) {
+      transport->sendString("OK\n");
+    } else {
+      transport->sendString("Stack sampling isn't supported.\n", 500);
+    }
+    return true;
+  }
+  if (cmd == "prof-stacks-off") {
+    StackSampler::SetFrequency(0);
+    transport->sendString("OK\n");
+    return true;
+  }
+  if (cmd == "prof-stacks-clear") {
+    StackSampler::Clear();
+    transport->sendString("OK\n");
+    return true;
+  }
+  if (cmd == "prof-stacks-status") {
+    transport->sendString(StackSampler::GetStatus());
+    return true;
+  }
 #ifdef GOOGLE_CPU_PROFILER
   if (handleCPUProfilerRequest(cmd, transport)) {
     return true;
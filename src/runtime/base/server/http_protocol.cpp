@@ -111,7 +111,12 @@ void HttpProtocol::PrepareSystemVariables(Transport *transport,
     bool needDelete = false;
     int size = 0;
     const void *data = transport->getPostData(size);
-    if (data && size) {
+    StreamedUpload *upload = transport->getStreamedUpload();
+    if (upload) {
+      // multipart body that was parsed while it arrived
+      upload->registerVariables(g->gv__POST, g->gv__FILES);
+      CopyParams(request, g->gv__POST);
+    } else if (data && size) {
       ASSERT(((char*)data)[size] == 0); // we need a NULL terminated string
       string boundary;
       int content_length = atoi(contentLength.c_str());
@@ -174,15 +179,27 @@ void HttpProtocol::PrepareSystemVariables(Transport *transport,
   // HTTP_ headers -- we don't exclude headers we handle elsewhere (e.g.,
   // Content-Type, Authorization), since the CGI "spec" merely says the server
   // "may" exclude them; this is not what APE does, but it's harmless.
-  HeaderMap headers;
-  transport->getHeaders(headers);
-  for (HeaderMap::const_iterator iter = headers.begin();
-       iter != headers.end(); ++iter) {
-    const vector<string> &values = iter->second;
-    for (unsigned int i = 0; i < values.size(); i++) {
-      String key = "HTTP_";
-      key += StringUtil::ToUpper(iter->first).replace("-", "_");
-      server.set(key, String(values[i]));
+  const HeaderMap *serverHeaders = transport->getServerHeaders();
+  if (serverHeaders) {
+    for (HeaderMap::const_iterator iter = serverHeaders->begin();
+         iter != serverHeaders->end(); ++iter) {
+      const vector<string> &values = iter->second;
+      String key(iter->first);
+      for (unsigned int i = 0; i < values.size(); i++) {
+        server.set(key, String(values[i]));
+      }
+    }
+  } else {
+    HeaderMap headers;
+    transport->getHeaders(headers);
+    for (HeaderMap::const_iterator iter = headers.begin();
+         iter != headers.end(); ++iter) {
+      const vector<string> &values = iter->second;
+      for (unsigned int i = 0; i < values.size(); i++) {
+        String key = "HTTP_";
+        key += StringUtil::ToUpper(iter->first).replace("-", "_");
+        server.set(key, String(values[i]));
+      }
     }
   }
   string host = transport->getHeader("Host");
@@ -47,11 +47,98 @@ HttpRequestHandler::HttpRequestHandler()
   : m_pathTranslation(true) {
 }
 
-void HttpRequestHandler::sendStaticContent(Transport *transport,
-                                           const char *data, int len,
-                                           time_t mtime,
-                                           bool compressed,
-                                           const std::string &cmd) {
+///////////////////////////////////////////////////////////////////////////////
+// conditional and partial GET
+
+static bool etag_matches(const string &header, const string &etag) {
+  if (etag.empty()) return false;
+  vector<string> tags;
+  Util::split(',', header.c_str(), tags, true);
+  for (unsigned int i = 0; i < tags.size(); i++) {
+    string tag = tags[i];
+    size_t first = tag.find_first_not_of(" \t");
+    if (first == string::npos) continue;
+    tag = tag.substr(first, tag.find_last_not_of(" \t") - first + 1);
+    if (tag == "*") return true;
+    if (tag.size() > 2 && tag[0] == 'W' && tag[1] == '/') {
+      tag = tag.substr(2); // weak comparison is fine for a GET
+    }
+    if (tag == etag) return true;
+  }
+  return false;
+}
+
+static bool is_not_modified(Transport *transport, const string &etag,
+                            time_t mtime) {
+  string header = transport->getHeader("If-None-Match");
+  if (!header.empty()) {
+    // takes precedence over If-Modified-Since
+    return etag_matches(header, etag);
+  }
+  header = transport->getHeader("If-Modified-Since");
+  if (!header.empty() && mtime) {
+    struct tm tm;
+    memset(&tm, 0, sizeof(tm));
+    if (strptime(header.c_str(), "%a, %d %b %Y %H:%M:%S", &tm)) {
+      return timegm(&tm) >= mtime;
+    }
+  }
+  return false;
+}
+
+/**
+ * Parses a single "bytes=first-last" range against content of "len" bytes.
+ * Returns 1 with [start, end] filled, 0 to send all content, for no Range,
+ * multiple ranges, a syntax error or a stale If-Range, and -1 when the range
+ * can't be satisfied.
+ */
+static int parse_range(Transport *transport, const string &etag, int len,
+                       int &start, int &end) {
+  string header = transport->getHeader("Range");
+  if (header.size() <= 6 || strncasecmp(header.c_str(), "bytes=", 6) ||
+      header.find(',') != string::npos) {
+    return 0;
+  }
+  string ifRange = transport->getHeader("If-Range");
+  if (!ifRange.empty() && ifRange != etag) {
+    return 0;
+  }
+
+  const char *p = header.c_str() + 6;
+  while (*p == ' ') p++;
+  char *q;
+  if (*p == '-') {
+    long long suffix = strtoll(p + 1, &q, 10);
+    if (q == p + 1 || *q) return 0;
+    if (suffix <= 0 || len == 0) return -1;
+    start = suffix < len ? len - suffix : 0;
+    end = len - 1;
+    return 1;
+  }
+  if (!isdigit(*p)) return 0;
+  long long first = strtoll(p, &q, 10);
+  if (*q++ != '-') return 0;
+  long long last = len - 1;
+  if (*q) {
+    const char *r = q;
+    last = strtoll(r, &q, 10);
+    if (q == r || *q || last < first) return 0;
+  }
+  if (first >= len) return -1;
+  start = first;
+  end = last < len ? last : len - 1;
+  return 1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+int HttpRequestHandler::sendStaticContent(Transport *transport,
+                                          const char *data, int len,
+                                          time_t mtime,
+                                          bool compressed,
+                                          const std::string &cmd,
+                                          const std::string &etag,
+                                          int fd /* = -1 */) {
   size_t pos = cmd.rfind('.');
   ASSERT(pos != string::npos);
   const char *ext = cmd.c_str() + pos + 1;
@@ -81,6 +168,12 @@ void HttpRequestHandler::sendStaticContent(Transport *transport,
     transport->addHeader
       ("Last-Modified", DateTime(mtime, true).toString(DateTime::HttpHeader));
   }
+  // gzipped content is a different entity from the original
+  string tag;
+  if (!etag.empty()) {
+    tag = "\"" + etag + (compressed ? "-gzip\"" : "\"");
+    transport->addHeader("ETag", tag.c_str());
+  }
   transport->addHeader("Accept-Ranges", "bytes");
 
   for (unsigned int i = 0; i < RuntimeOption::FilesMatches.size(); i++) {
@@ -97,7 +190,35 @@ void HttpRequestHandler::sendStaticContent(Transport *transport,
   // should not attempt to compress it.
   transport->disableCompression();
 
-  transport->sendRaw((void*)data, len, 200, compressed);
+  if (is_not_modified(transport, tag, mtime)) {
+    transport->sendRaw((void*)"", 0, 304);
+    return 304;
+  }
+
+  int code = 200;
+  int start = 0, end = len - 1;
+  int range = compressed ? 0 : parse_range(transport, tag, len, start, end);
+  if (range < 0) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "bytes */%d", len);
+    transport->addHeader("Content-Range", buf);
+    transport->sendString("Requested Range Not Satisfiable", 416);
+    return 416;
+  }
+  if (range > 0) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "bytes %d-%d/%d", start, end, len);
+    transport->addHeader("Content-Range", buf);
+    code = 206;
+  }
+
+  if (data) {
+    transport->sendRaw((void*)(data + start), end - start + 1, code,
+                       compressed);
+  } else {
+    transport->sendFile(fd, start, end - start + 1, code);
+  }
+  return code;
 }
 
 void HttpRequestHandler::handleRequest(Transport *transport) {
@@ -158,8 +279,10 @@ void HttpRequestHandler::handleRequest(Transport *transport) {
   if (ext && strcasecmp(ext, "php") != 0) {
     if (RuntimeOption::EnableStaticContentCache) {
       bool original = compressed;
+      string etag;
       // check against static content cache
-      if (StaticContentCache::TheCache.find(path, data, len, compressed)) {
+      if (StaticContentCache::TheCache.find(path, data, len, compressed,
+                                            etag)) {
         struct stat st;
         st.st_mtime = 0;
         String str;
@@ -175,9 +298,10 @@ void HttpRequestHandler::handleRequest(Transport *transport) {
           compressed = false;
           str.assign(data, len, AttachString);
         }
-        sendStaticContent(transport, data, len, st.st_mtime, compressed, path);
+        int code = sendStaticContent(transport, data, len, st.st_mtime,
+                                     compressed, path, etag);
         StaticContentCache::TheFileCache->adviseOutMemory();
-        ServerStats::LogPage(path, 200);
+        ServerStats::LogPage(path, code);
         return;
       }
     }
@@ -186,15 +310,30 @@ void HttpRequestHandler::handleRequest(Transport *transport) {
         RuntimeOption::StaticFileExtensions.find(ext) !=
         RuntimeOption::StaticFileExtensions.end()) {
       String translated = File::TranslatePath(String(absPath));
-      if (!translated.empty()) {
+      struct stat st;
+      if (!translated.empty() && stat(translated.data(), &st) == 0 &&
+          S_ISREG(st.st_mode)) {
+        string etag = StaticContentCache::MakeETag(st);
+        bool head = transport->getMethod() == Transport::HEAD;
+        if ((head || (RuntimeOption::DirectSendMinSize > 0 &&
+                      st.st_size >= RuntimeOption::DirectSendMinSize)) &&
+            st.st_size <= INT_MAX) {
+          // HEAD needs no content, and big files are not worth reading
+          // into memory
+          int fd = open(translated.data(), O_RDONLY);
+          if (fd >= 0) {
+            int code = sendStaticContent(transport, NULL, st.st_size,
+                                         st.st_mtime, false, path, etag, fd);
+            close(fd);
+            ServerStats::LogPage(path, code);
+            return;
+          }
+        }
         StringBuffer sb(translated.data());
         if (sb.valid()) {
-          struct stat st;
-          st.st_mtime = 0;
-          stat(translated.data(), &st);
-          sendStaticContent(transport, sb.data(), sb.size(), st.st_mtime,
-                            false, path);
-          ServerStats::LogPage(path, 200);
+          int code = sendStaticContent(transport, sb.data(), sb.size(),
+                                       st.st_mtime, false, path, etag);
+          ServerStats::LogPage(path, code);
           return;
         }
       }
@@ -206,8 +345,9 @@ void HttpRequestHandler::handleRequest(Transport *transport) {
       ASSERT(transport->getUrl());
       string key = path + transport->getUrl();
       if (DynamicContentCache::TheCache.find(key, data, len, compressed)) {
-        sendStaticContent(transport, data, len, 0, compressed, path);
-        ServerStats::LogPage(path, 200);
+        int code = sendStaticContent(transport, data, len, 0, compressed,
+                                     path, "");
+        ServerStats::LogPage(path, code);
         return;
       }
     }
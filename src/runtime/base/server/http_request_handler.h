@@ -45,9 +45,15 @@ private:
   bool m_pathTranslation;
 
   bool handleProxyRequest(Transport *transport, bool force);
-  void sendStaticContent(Transport *transport, const char *data, int len,
-                         time_t mtime, bool compressed,
-                         const std::string &cmd);
+  /**
+   * Sends static content from memory when data is not NULL, or else "len"
+   * bytes of file fd. Answers conditional GETs and single Range requests.
+   * Returns the response code.
+   */
+  int sendStaticContent(Transport *transport, const char *data, int len,
+                        time_t mtime, bool compressed,
+                        const std::string &cmd, const std::string &etag,
+                        int fd = -1);
   bool executePHPRequest(Transport *transport, RequestURI &reqURI,
                          SourceRootInfo &sourceRootInfo,
                          bool cachableDynamicContent);
@@ -61,22 +61,30 @@ HttpServer::HttpServer()
   // enabling mutex profiling, but it's not turned on
   LockProfiler::s_pfunc_profile = server_stats_log_mutex;
 
+  // page server's workers are all the shared pool's threads, if there is one
+  SharedThreadPool *pool = Server::GetSharedThreadPool();
+  int threadCount = pool ? pool->getThreadCount() :
+    RuntimeOption::ServerThreadCount;
+
+  LibEventServer *pageServer;
   if (RuntimeOption::TakeoverFilename.empty()) {
-    m_pageServer = ServerPtr
+    pageServer =
       (new TypedServer<LibEventServer, HttpRequestHandler>
        (RuntimeOption::ServerIP, RuntimeOption::ServerPort,
-        RuntimeOption::ServerThreadCount,
-        RuntimeOption::RequestTimeoutSeconds));
+        threadCount, RuntimeOption::RequestTimeoutSeconds));
   } else {
     LibEventServerWithTakeover* server =
       (new TypedServer<LibEventServerWithTakeover, HttpRequestHandler>
        (RuntimeOption::ServerIP, RuntimeOption::ServerPort,
-        RuntimeOption::ServerThreadCount,
-        RuntimeOption::RequestTimeoutSeconds));
+        threadCount, RuntimeOption::RequestTimeoutSeconds));
     server->setTransferFilename(RuntimeOption::TakeoverFilename);
     server->addTakeoverListener(this);
-    m_pageServer = ServerPtr(server);
+    pageServer = server;
+  }
+  if (pool) {
+    pageServer->shareThreadPool(pool, Server::PageServerPool);
   }
+  m_pageServer = ServerPtr(pageServer);
 
   if (RuntimeOption::EnableSSL) {
     SSLInit::init();
@@ -19,6 +19,8 @@
 #include <runtime/base/memory/memory_manager.h>
 #include <runtime/base/server/server_stats.h>
 #include <runtime/base/server/http_protocol.h>
+#include <util/util.h>
+#include <sys/sendfile.h>
 
 ///////////////////////////////////////////////////////////////////////////////
 // static handler
@@ -28,6 +30,11 @@ static void on_request(struct evhttp_request *request, void *obj) {
   ((HPHP::LibEventServer*)obj)->onRequest(request);
 }
 
+static void on_body(struct evhttp_request *request, void *obj) {
+  ASSERT(obj);
+  ((HPHP::LibEventServer*)obj)->onBody(request);
+}
+
 static void on_response(int fd, short what, void *obj) {
   ASSERT(obj);
   ((HPHP::PendingResponseQueue*)obj)->process();
@@ -95,6 +102,9 @@ void LibEventWorker::doJob(LibEventJobPtr job) {
   }
 
   LibEventTransport transport(server, request, m_id);
+  if (job->upload) {
+    transport.setStreamedUpload(job->upload);
+  }
 #ifdef _EVENT_USE_OPENSSL
   if (evhttp_is_connection_ssl(job->request->evcon)) {
     transport.setSSL();
@@ -162,6 +172,9 @@ LibEventServer::LibEventServer(const std::string &address, int port,
   m_server = evhttp_new(m_eventBase);
   m_server_ssl = NULL;
   evhttp_set_gencb(m_server, on_request, this);
+  if (RuntimeOption::UploadStreamMinSize > 0) {
+    evhttp_set_bodycb(m_server, on_body, this);
+  }
 #ifdef EVHTTP_PORTABLE_READ_LIMITING
   evhttp_set_read_limit(m_server, RuntimeOption::RequestBodyReadLimit);
 #endif
@@ -305,6 +318,9 @@ bool LibEventServer::enableSSL(const std::string &certFile,
   }
   m_port_ssl = port;
   evhttp_set_gencb(m_server_ssl, on_request, this);
+  if (RuntimeOption::UploadStreamMinSize > 0) {
+    evhttp_set_bodycb(m_server_ssl, on_body, this);
+  }
   return true;
 #else
   Logger::Error("A SSL enabled libevent is required");
@@ -332,6 +348,62 @@ void LibEventServer::onThreadEnter() {
     (&ThreadInfo::s_threadInfo->m_reqInjectionData);
 }
 
+/**
+ * What onBody() keeps in a request: the upload it feeds, until onRequest()
+ * hands it to the job, and a timer to feed it again while reading is paused
+ * for the upload writer to catch up. Owned by the request, so it goes away
+ * with a dropped connection.
+ */
+class UploadBody {
+public:
+  enum { RetryMicroSeconds = 10000 };
+
+  UploadBody(StreamedUpload *upload) : m_upload(upload), m_paused(false) {}
+  ~UploadBody() {
+    if (m_paused) event_del(&m_timer);
+    delete m_upload;
+  }
+
+  StreamedUpload *getUpload() { return m_upload;}
+  StreamedUpload *takeUpload() {
+    StreamedUpload *upload = m_upload;
+    m_upload = NULL;
+    return upload;
+  }
+
+  /**
+   * Stops reading the request's body, leaving what arrived so far in its
+   * input buffer, and tries again a little later.
+   */
+  void pause(evhttp_request *request, event_base *base) {
+    ASSERT(!m_paused);
+    request->body_paused = 1;
+    evtimer_set(&m_timer, OnTimer, request);
+    event_base_set(base, &m_timer);
+    timeval timeout;
+    timeout.tv_sec = 0;
+    timeout.tv_usec = RetryMicroSeconds;
+    evtimer_add(&m_timer, &timeout);
+    m_paused = true;
+  }
+
+  static void Free(void *body) {
+    delete (UploadBody*)body;
+  }
+
+private:
+  StreamedUpload *m_upload;
+  event m_timer;
+  bool m_paused;
+
+  static void OnTimer(int fd, short events, void *context) {
+    evhttp_request *request = (evhttp_request *)context;
+    ((UploadBody*)request->body_state)->m_paused = false;
+    // calls onBody() again, which may pause once more
+    evhttp_request_resume_body(request);
+  }
+};
+
 void LibEventServer::onRequest(struct evhttp_request *request) {
   if (RuntimeOption::EnableKeepAlive &&
       RuntimeOption::ConnectionTimeoutSeconds > 0) {
@@ -341,12 +413,70 @@ void LibEventServer::onRequest(struct evhttp_request *request) {
                                   RuntimeOption::ConnectionTimeoutSeconds);
   }
   if (getStatus() == RUNNING) {
-    m_dispatcher.enqueue(LibEventJobPtr(new LibEventJob(request)));
+    LibEventJobPtr job(new LibEventJob(request));
+    if (request->body_state) {
+      // the worker takes over what onBody() parsed, temporary files included
+      UploadBody *body = (UploadBody*)request->body_state;
+      job->upload = StreamedUploadPtr(body->takeUpload());
+      delete body;
+      request->body_state = NULL;
+    }
+    m_dispatcher.enqueue(job);
   } else {
     Logger::Error("throwing away one new request while shutting down");
   }
 }
 
+/**
+ * Whether a request's body is a multipart upload to parse as it arrives.
+ * Not with AlwaysPopulateRawPostData, which needs the body in memory, nor
+ * with EnableUploadProgress, which reports on it from the request.
+ */
+static StreamedUpload *new_streamed_upload(evhttp_request *request) {
+  if (request->type != EVHTTP_REQ_POST ||
+      RuntimeOption::AlwaysPopulateRawPostData ||
+      RuntimeOption::EnableUploadProgress) {
+    return NULL;
+  }
+  const char *length =
+    evhttp_find_header(request->input_headers, "Content-Length");
+  const char *type =
+    evhttp_find_header(request->input_headers, "Content-Type");
+  if (length == NULL || type == NULL) return NULL;
+  int size = atoi(length);
+  if (size < RuntimeOption::UploadStreamMinSize ||
+      size > RuntimeOption::MaxPostSize) {
+    return NULL;
+  }
+  std::string boundary;
+  if (!HttpProtocol::IsRfc1867(type, boundary)) return NULL;
+  return new StreamedUpload(boundary);
+}
+
+void LibEventServer::onBody(evhttp_request *request) {
+  if (request->body_state_free == NULL) {
+    // first call, right after the headers
+    request->body_state_free = UploadBody::Free;
+    StreamedUpload *upload = new_streamed_upload(request);
+    if (upload) request->body_state = new UploadBody(upload);
+  }
+  UploadBody *body = (UploadBody*)request->body_state;
+  if (body == NULL) return;
+
+  if (request->ntoread > 0 && StreamedUpload::Backlogged()) {
+    // the rest stays in the socket, so the client waits for the disk
+    body->pause(request, m_eventBase);
+    return;
+  }
+  StreamedUpload *upload = body->getUpload();
+  evbuffer *buf = request->input_buffer;
+  upload->feed((const char *)EVBUFFER_DATA(buf), EVBUFFER_LENGTH(buf));
+  evbuffer_drain(buf, EVBUFFER_LENGTH(buf));
+  if (request->ntoread == 0) {
+    upload->finish();
+  }
+}
+
 void LibEventServer::onResponse(int worker, evhttp_request *request,
                                 int code) {
   int nwritten = 0;
@@ -362,6 +492,126 @@ void LibEventServer::onResponse(int worker, evhttp_request *request,
   m_responseQueue.enqueue(worker, request, code, nwritten);
 }
 
+/**
+ * What's left of a static file that sendfile() couldn't write right away.
+ * It's read into the connection's output buffer a window at a time, as the
+ * event loop drains it, so a slow client never has the whole file sitting in
+ * memory. Owned by the request, so it goes away with a dropped connection.
+ */
+class SendFileWindow {
+public:
+  enum { Size = 65536 };
+
+  SendFileWindow(evbuffer *output, int sock, int fd, off_t offset, int size)
+    : m_output(output), m_sock(sock), m_fd(dup(fd)), m_offset(offset),
+      m_size(size) {
+  }
+  ~SendFileWindow() { stop();}
+
+  /**
+   * Fills the first window, returning false if the file can't be read.
+   */
+  bool start() {
+    if (m_fd == -1 || !fill()) return false;
+    if (m_size > 0) evbuffer_setcb(m_output, OnDrain, this);
+    return true;
+  }
+
+  static void Free(void *window) {
+    delete (SendFileWindow*)window;
+  }
+
+private:
+  evbuffer *m_output;
+  int m_sock;
+  int m_fd;
+  off_t m_offset;
+  int m_size;
+
+  static void OnDrain(evbuffer *buf, size_t oldLen, size_t newLen,
+                      void *window) {
+    if (newLen < oldLen && newLen < Size) {
+      SendFileWindow *w = (SendFileWindow*)window;
+      if (!w->fill()) {
+        // fails the connection on its next write, rather than leaving the
+        // client waiting for the rest of the content
+        shutdown(w->m_sock, SHUT_RDWR);
+      }
+    }
+  }
+
+  bool fill() {
+    char buf[Size];
+    while (m_size > 0 && EVBUFFER_LENGTH(m_output) < Size) {
+      ssize_t n = pread(m_fd, buf, m_size < Size ? m_size : Size, m_offset);
+      if (n <= 0) {
+        Logger::Error("Unable to read static content: %s",
+                      Util::safe_strerror(errno).c_str());
+        stop();
+        return false;
+      }
+      m_offset += n;
+      m_size -= n;
+      evbuffer_add(m_output, buf, n); // calls OnDrain(), which ignores it
+    }
+    if (m_size == 0) stop();
+    return true;
+  }
+
+  void stop() {
+    if (m_fd != -1) {
+      evbuffer_setcb(m_output, NULL, NULL);
+      close(m_fd);
+      m_fd = -1;
+    }
+  }
+};
+
+bool LibEventServer::onDirectResponse(int worker, evhttp_request *request,
+                                      int code, const char *data, int fd,
+                                      off_t offset, int size) {
+  bool skip_sync = !RuntimeOption::LibEventSyncSend;
+#ifdef _EVENT_USE_OPENSSL
+  skip_sync = skip_sync || evhttp_is_connection_ssl(request->evcon);
+#endif
+  if (skip_sync) {
+    return false;
+  }
+
+  const char *reason = HttpProtocol::GetReasonString(code);
+  int nwritten = evhttp_send_reply_sync_begin(request, code, reason, NULL);
+  if (nwritten > 0) {
+    evbuffer *output = evhttp_connection_get_output_buffer(request->evcon);
+    int sock = evhttp_connection_get_fd(request->evcon);
+    if (EVBUFFER_LENGTH(output) == 0) {
+      // headers are out, so the body can go to the socket without a copy
+      while (size > 0) {
+        ssize_t n = data ? write(sock, data + offset, size) :
+          sendfile(sock, fd, &offset, size);
+        if (n <= 0) break; // socket buffer full, or an error to find out later
+        if (data) offset += n;
+        size -= n;
+      }
+    }
+
+    // whatever the socket didn't take is flushed by the event loop
+    if (data) {
+      if (size > 0) evbuffer_add(output, data + offset, size);
+    } else if (size > 0) {
+      SendFileWindow *window =
+        new SendFileWindow(output, sock, fd, offset, size);
+      ASSERT(request->body_state == NULL);
+      request->body_state = window;
+      request->body_state_free = SendFileWindow::Free;
+      if (!window->start()) {
+        nwritten = -1; // drop the connection rather than send short content
+      }
+    }
+  }
+  m_responseQueue.enqueue(worker, request, code, nwritten);
+  return true;
+}
+
 void LibEventServer::onChunkedResponse(int worker, evhttp_request *request,
                                        int code, evbuffer *chunk,
                                        bool firstChunk) {
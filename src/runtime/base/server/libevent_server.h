@@ -37,6 +37,7 @@ public:
   void stopTimer();
 
   evhttp_request *request;
+  StreamedUploadPtr upload; // if the body was parsed while it arrived
 
 private:
 #if defined(__APPLE__)
@@ -141,16 +142,41 @@ public:
 
   void onThreadEnter();
 
+  /**
+   * Runs requests on threads of a shared pool. Must be called before start(),
+   * and the server must have been constructed with as many threads as the
+   * pool has.
+   */
+  void shareThreadPool(SharedThreadPool *pool, int poolId) {
+    m_dispatcher.share(pool, poolId);
+  }
+
   /**
    * Request handler called by evhttp library.
    */
   void onRequest(evhttp_request *request);
   void onChunkedRead();
 
+  /**
+   * Called by evhttp library as a request body arrives, to parse large
+   * multipart uploads right away, see Server.Upload.StreamMinSize. Stops
+   * reading while the upload writer is behind, see Upload.StreamBufferSize.
+   */
+  void onBody(evhttp_request *request);
+
   /**
    * Called by LibEventTransport when a response is fully prepared.
    */
   void onResponse(int worker, evhttp_request *request, int code);
+
+  /**
+   * Called by LibEventTransport to write headers and then a response body
+   * straight to the socket from the worker thread, from memory when data is
+   * not NULL, or else from file fd. Returns false without sending anything
+   * if the response has to go through the event loop.
+   */
+  bool onDirectResponse(int worker, evhttp_request *request, int code,
+                        const char *data, int fd, off_t offset, int size);
   void onChunkedResponse(int worker, evhttp_request *request, int code,
                          evbuffer *chunk, bool firstChunk);
   void onChunkedResponseEnd(int worker, evhttp_request *request);
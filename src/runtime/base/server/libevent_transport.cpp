@@ -250,18 +250,56 @@ void LibEventTransport::sendImpl(const void *data, int size, int code,
                                !m_sendStarted);
   } else {
     if (m_method != HEAD) {
-      evbuffer_add(m_request->output_buffer, data, size);
+      if (!sendDirect((const char *)data, -1, 0, size, code)) {
+        evbuffer_add(m_request->output_buffer, data, size);
+        m_server->onResponse(m_workerId, m_request, code);
+      }
     } else {
-      char buf[11];
-      snprintf(buf, sizeof(buf), "%d", size);
-      addHeaderImpl("Content-Length", buf);
+      sendHeadResponse(size, code);
     }
-    m_server->onResponse(m_workerId, m_request, code);
     m_sendEnded = true;
   }
   m_sendStarted = true;
 }
 
+void LibEventTransport::sendFileImpl(int fd, off_t offset, int size,
+                                     int code) {
+  ASSERT(!m_sendStarted);
+  if (m_method == HEAD) {
+    // headers only, so the file is never read
+    sendHeadResponse(size, code);
+    m_sendStarted = m_sendEnded = true;
+    return;
+  }
+  if (sendDirect(NULL, fd, offset, size, code)) {
+    m_sendStarted = m_sendEnded = true;
+    return;
+  }
+  Transport::sendFileImpl(fd, offset, size, code);
+}
+
+void LibEventTransport::sendHeadResponse(int size, int code) {
+  char buf[11];
+  snprintf(buf, sizeof(buf), "%d", size);
+  addHeaderImpl("Content-Length", buf);
+  m_server->onResponse(m_workerId, m_request, code);
+}
+
+bool LibEventTransport::sendDirect(const char *data, int fd, off_t offset,
+                                   int size, int code) {
+  if (RuntimeOption::DirectSendMinSize <= 0 ||
+      size < RuntimeOption::DirectSendMinSize) {
+    return false;
+  }
+  // the body is not in libevent's buffer for it to count
+  char buf[11];
+  snprintf(buf, sizeof(buf), "%d", size);
+  removeHeaderImpl("Content-Length");
+  addHeaderImpl("Content-Length", buf);
+  return m_server->onDirectResponse(m_workerId, m_request, code, data, fd,
+                                    offset, size);
+}
+
 void LibEventTransport::onSendEndImpl() {
   if (m_chunkedEncoding) {
     m_server->onChunkedResponseEnd(m_workerId, m_request);
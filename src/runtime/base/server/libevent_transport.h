@@ -18,6 +18,7 @@
 #define __HTTP_SERVER_LIB_EVENT_TRANSPORT_H__
 
 #include <runtime/base/server/transport.h>
+#include <runtime/base/server/upload.h>
 #include <evhttp.h>
 
 namespace HPHP {
@@ -37,6 +38,7 @@ public:
   virtual const void *getPostData(int &size);
   virtual bool hasMorePostData();
   virtual const void *getMorePostData(int &size);
+  virtual StreamedUpload *getStreamedUpload() { return m_upload.get();}
   virtual Method getMethod();
   virtual const char *getExtendedMethod();
   virtual std::string getHTTPVersion() const;
@@ -47,10 +49,16 @@ public:
   virtual void addRequestHeaderImpl(const char *name, const char *value);
   virtual void removeRequestHeaderImpl(const char *name);
   virtual void sendImpl(const void *data, int size, int code, bool chunked);
+  virtual void sendFileImpl(int fd, off_t offset, int size, int code);
   virtual void onSendEndImpl();
   virtual bool isServerStopping();
 
+  void setStreamedUpload(StreamedUploadPtr upload) { m_upload = upload;}
+
 private:
+  bool sendDirect(const char *data, int fd, off_t offset, int size, int code);
+  void sendHeadResponse(int size, int code);
+
   LibEventServer *m_server;
   evhttp_request *m_request;
   struct event_base *m_eventBasePostData;
@@ -64,6 +72,7 @@ private:
   HeaderMap m_requestHeaders;
   bool m_sendStarted;
   bool m_sendEnded;
+  StreamedUploadPtr m_upload;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
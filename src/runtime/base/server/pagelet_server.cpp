@@ -17,6 +17,7 @@
 #include <runtime/base/server/pagelet_server.h>
 #include <runtime/base/server/transport.h>
 #include <runtime/base/server/http_request_handler.h>
+#include <runtime/base/server/server.h>
 #include <runtime/base/util/string_buffer.h>
 #include <runtime/base/runtime_option.h>
 #include <runtime/base/resource_data.h>
@@ -29,32 +30,121 @@ using namespace std;
 namespace HPHP {
 ///////////////////////////////////////////////////////////////////////////////
 
-class PageletTransport : public Transport, public Synchronizable {
+/**
+ * Request environment a pagelet runs with: headers parsed once, the $_SERVER
+ * names they turn into, and the caller's remote host. It's immutable after
+ * construction, so all pagelets started together can share one copy.
+ */
+class PageletRequest {
 public:
-  PageletTransport(CStrRef url, CArrRef headers, CStrRef postData,
-                   CStrRef remoteHost)
-    : m_refCount(0), m_done(false), m_code(0) {
-    m_threadType = PageletThread;
-
-    m_url.append(url.data(), url.size());
+  PageletRequest(CArrRef headers, CStrRef remoteHost) : m_refCount(0) {
     m_remoteHost.append(remoteHost.data(), remoteHost.size());
 
     for (ArrayIter iter(headers); iter; ++iter) {
       Variant key = iter.first();
       String header = iter.second();
       if (key.isString() && !key.toString().empty()) {
-        m_requestHeaders[key.toString().data()].push_back(header.data());
+        addHeader(key.toString().data(), header.data());
       } else {
         int pos = header.find(": ");
         if (pos >= 0) {
           string name = header.substr(0, pos).data();
           string value = header.substr(pos + 2).data();
-          m_requestHeaders[name].push_back(value);
+          addHeader(name, value);
         } else {
           Logger::Error("throwing away bad header: %s", header.data());
         }
       }
     }
+  }
+
+  const HeaderMap &getHeaders() const { return m_headers;}
+  const HeaderMap &getServerHeaders() const { return m_serverHeaders;}
+  const string &getRemoteHost() const { return m_remoteHost;}
+
+  // ref counting
+  void incRefCount() {
+    atomic_inc(m_refCount);
+  }
+  void decRefCount() {
+    ASSERT(m_refCount);
+    if (atomic_dec(m_refCount) == 0) {
+      delete this;
+    }
+  }
+
+private:
+  int m_refCount;
+  HeaderMap m_headers;
+  HeaderMap m_serverHeaders;
+  string m_remoteHost;
+
+  void addHeader(const string &name, const string &value) {
+    m_headers[name].push_back(value);
+
+    string key = "HTTP_";
+    key.reserve(key.size() + name.size());
+    for (unsigned int i = 0; i < name.size(); i++) {
+      char ch = name[i];
+      key += ch == '-' ? '_' : toupper(ch);
+    }
+    m_serverHeaders[key].push_back(value);
+  }
+};
+
+/**
+ * What pagelet_server_task_wait() blocks on. Every task it waits for points
+ * back to it until the wait is over, and the first one to finish wakes it up.
+ */
+class PageletWaiter : public Synchronizable {
+public:
+  PageletWaiter() : m_notified(false) {}
+
+  void wake() {
+    Lock lock(this);
+    m_notified = true;
+    notify();
+  }
+
+  /**
+   * Returns false if timed out. Negative timeout waits forever.
+   */
+  bool waitForWake(int timeout_ms) {
+    Lock lock(this);
+    if (timeout_ms < 0) {
+      while (!m_notified) wait();
+      return true;
+    }
+    // a wait can end early without a wake(), so check again until the
+    // deadline has passed
+    int64 deadline = now() + (int64)timeout_ms * 1000;
+    while (!m_notified) {
+      int64 left = deadline - now();
+      if (left <= 0) break;
+      wait(left / 1000000, (left % 1000000) * 1000);
+    }
+    return m_notified;
+  }
+
+private:
+  bool m_notified;
+
+  static int64 now() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (int64)tv.tv_sec * 1000000 + tv.tv_usec;
+  }
+};
+
+class PageletTransport : public Transport, public Synchronizable {
+public:
+  PageletTransport(CStrRef url, PageletRequest *request, CStrRef postData)
+    : m_refCount(0), m_request(request), m_done(false), m_waiter(NULL),
+      m_code(0) {
+    m_threadType = PageletThread;
+
+    m_url.append(url.data(), url.size());
+    m_request->incRefCount();
 
     if (postData.isNull()) {
       m_get = true;
@@ -66,6 +156,10 @@ public:
     disableCompression(); // so we don't have to decompress during sendImpl()
   }
 
+  ~PageletTransport() {
+    m_request->decRefCount();
+  }
+
   /**
    * Implementing Transport...
    */
@@ -73,7 +167,7 @@ public:
     return m_url.c_str();
   }
   virtual const char *getRemoteHost() {
-    return m_remoteHost.c_str();
+    return m_request->getRemoteHost().c_str();
   }
   virtual const void *getPostData(int &size) {
     size = m_postData.size();
@@ -84,14 +178,18 @@ public:
   }
   virtual std::string getHeader(const char *name) {
     ASSERT(name && *name);
-    HeaderMap::const_iterator iter = m_requestHeaders.find(name);
-    if (iter != m_requestHeaders.end()) {
+    const HeaderMap &requestHeaders = m_request->getHeaders();
+    HeaderMap::const_iterator iter = requestHeaders.find(name);
+    if (iter != requestHeaders.end()) {
       return iter->second[0];
     }
     return "";
   }
   virtual void getHeaders(HeaderMap &headers) {
-    headers = m_requestHeaders;
+    headers = m_request->getHeaders();
+  }
+  virtual const HeaderMap *getServerHeaders() {
+    return &m_request->getServerHeaders();
   }
   virtual void addHeaderImpl(const char *name, const char *value) {
     ASSERT(name && *name);
@@ -114,6 +212,9 @@ public:
     Lock lock(this);
     m_done = true;
     notify();
+    if (m_waiter) {
+      m_waiter->wake();
+    }
   }
 
   // task interface
@@ -121,6 +222,19 @@ public:
     return m_done;
   }
 
+  /**
+   * Asks to wake up waiter when this task finishes. Returns false without
+   * registering, if it has finished already. Pass NULL to unregister.
+   */
+  bool setWaiter(PageletWaiter *waiter) {
+    Lock lock(this);
+    if (waiter && m_done) {
+      return false;
+    }
+    m_waiter = waiter;
+    return true;
+  }
+
   String getResults(Array &headers, int &code) {
     {
       Lock lock(this);
@@ -158,12 +272,12 @@ private:
   int m_refCount;
 
   string m_url;
-  HeaderMap m_requestHeaders;
+  PageletRequest *m_request;
   bool m_get;
   string m_postData;
-  string m_remoteHost;
 
   bool m_done;
+  PageletWaiter *m_waiter; // guarded by this
   HeaderMap m_responseHeaders;
   string m_response;
   int m_code;
@@ -189,9 +303,8 @@ class PageletTask : public SweepableResourceData {
 public:
   DECLARE_OBJECT_ALLOCATION(PageletTask)
 
-  PageletTask(CStrRef url, CArrRef headers, CStrRef post_data,
-              CStrRef remote_host) {
-    m_job = new PageletTransport(url, headers, remote_host, post_data);
+  PageletTask(CStrRef url, PageletRequest *request, CStrRef post_data) {
+    m_job = new PageletTransport(url, request, post_data);
     m_job->incRefCount();
   }
 
@@ -230,24 +343,57 @@ void PageletServer::Restart() {
   if (RuntimeOption::PageletServerThreadCount > 0) {
     s_dispatcher = new JobQueueDispatcher<PageletTransport*, PageletWorker>
       (RuntimeOption::PageletServerThreadCount, NULL);
+    SharedThreadPool *pool = Server::GetSharedThreadPool();
+    if (pool) {
+      s_dispatcher->share(pool, Server::PageletServerPool);
+    }
     Logger::Info("pagelet server started");
     s_dispatcher->start();
   }
 }
 
+static Object start_task(CStrRef url, PageletRequest *request,
+                         CStrRef post_data) {
+  PageletTask *task = NEW(PageletTask)(url, request, post_data);
+  Object ret(task);
+  PageletTransport *job = task->getJob();
+  job->incRefCount(); // paired with worker's decRefCount()
+  ASSERT(s_dispatcher);
+  s_dispatcher->enqueue(job);
+  return ret;
+}
+
 Object PageletServer::TaskStart(CStrRef url, CArrRef headers,
                                 CStrRef remote_host,
                                 CStrRef post_data /* = null_string */) {
   if (RuntimeOption::PageletServerThreadCount <= 0) {
     return null_object;
   }
-  PageletTask *task = NEW(PageletTask)(url, headers, remote_host, post_data);
-  Object ret(task);
-  PageletTransport *job = task->getJob();
-  job->incRefCount(); // paired with worker's decRefCount()
-  ASSERT(s_dispatcher);
-  s_dispatcher->enqueue(job);
+  PageletRequest *request = new PageletRequest(headers, remote_host);
+  request->incRefCount();
+  Object ret = start_task(url, request, post_data);
+  request->decRefCount();
+  return ret;
+}
 
+Array PageletServer::TaskStartMulti(CArrRef urls, CArrRef headers,
+                                    CStrRef remote_host,
+                                    CArrRef post_data /* = null_array */) {
+  if (RuntimeOption::PageletServerThreadCount <= 0) {
+    return null_array;
+  }
+  PageletRequest *request = new PageletRequest(headers, remote_host);
+  request->incRefCount();
+  Array ret = Array::Create();
+  for (ArrayIter iter(urls); iter; ++iter) {
+    Variant key = iter.first();
+    String post;
+    if (!post_data.isNull() && post_data.exists(key)) {
+      post = post_data[key].toString();
+    }
+    ret.set(key, start_task(iter.second().toString(), request, post));
+  }
+  request->decRefCount();
   return ret;
 }
 
@@ -256,6 +402,36 @@ bool PageletServer::TaskStatus(CObjRef task) {
   return ptask->getJob()->isDone();
 }
 
+Variant PageletServer::TaskWait(CArrRef tasks, int timeout_ms /* = -1 */) {
+  PageletWaiter waiter;
+  vector<PageletTransport*> registered;
+  registered.reserve(tasks.size());
+  bool done = false;
+  for (ArrayIter iter(tasks); iter; ++iter) {
+    PageletTask *ptask = iter.second().toObject().getTyped<PageletTask>();
+    PageletTransport *job = ptask->getJob();
+    if (!job->setWaiter(&waiter)) {
+      done = true;
+      break;
+    }
+    registered.push_back(job);
+  }
+  if (!done && !registered.empty()) {
+    waiter.waitForWake(timeout_ms);
+  }
+  for (unsigned int i = 0; i < registered.size(); i++) {
+    registered[i]->setWaiter(NULL);
+  }
+
+  for (ArrayIter iter(tasks); iter; ++iter) {
+    PageletTask *ptask = iter.second().toObject().getTyped<PageletTask>();
+    if (ptask->getJob()->isDone()) {
+      return iter.first();
+    }
+  }
+  return false;
+}
+
 String PageletServer::TaskResult(CObjRef task, Array &headers, int &code) {
   PageletTask *ptask = task.getTyped<PageletTask>();
   return ptask->getJob()->getResults(headers, code);
@@ -35,12 +35,29 @@ public:
                           CStrRef remote_host,
                           CStrRef post_data = null_string);
 
+  /**
+   * Create a batch of tasks, one for each URL, sharing one copy of headers
+   * and remote host. post_data, if present, is keyed the same way as urls;
+   * tasks without an entry in it are GET requests. Returns task handles keyed
+   * the same way as urls, or null array if there are no worker threads.
+   */
+  static Array TaskStartMulti(CArrRef urls, CArrRef headers,
+                              CStrRef remote_host,
+                              CArrRef post_data = null_array);
+
   /**
    * Query if a task is finished. This is non-blocking and can be called as
    * many times as desired.
    */
   static bool TaskStatus(CObjRef task);
 
+  /**
+   * Block until one of the tasks finishes, and return its key in tasks, or
+   * false if none finished within timeout_ms. Negative timeout waits forever
+   * and zero doesn't wait at all.
+   */
+  static Variant TaskWait(CArrRef tasks, int timeout_ms = -1);
+
   /**
    * Get results of a task. This is blocking until task is finished.
    *
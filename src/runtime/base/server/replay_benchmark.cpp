@@ -0,0 +1,241 @@
+/*
+   +----------------------------------------------------------------------+
+   | HipHop for PHP                                                       |
+   +----------------------------------------------------------------------+
+   | Copyright (c) 2010 Facebook, Inc. (http://www.facebook.com)          |
+   +----------------------------------------------------------------------+
+   | This source file is subject to version 3.01 of the PHP license,      |
+   | that is bundled with this package in the file LICENSE, and is        |
+   | available through the world-wide-web at the following url:           |
+   | http://www.php.net/license/3_01.txt                                  |
+   | If you did not receive a copy of the PHP license and are unable to   |
+   | obtain it through the world-wide-web, please send a note to          |
+   | license@php.net so we can mail you a copy immediately.               |
+   +----------------------------------------------------------------------+
+*/
+
+
+#include <runtime/base/server/replay_benchmark.h>
+#include <runtime/base/server/replay_transport.h>
+#include <runtime/base/server/http_request_handler.h>
+#include <runtime/base/memory/memory_manager.h>
+#include <runtime/base/util/alloc.h>
+#include <util/job_queue.h>
+#include <util/timer.h>
+#include <util/logger.h>
+#include <dirent.h>
+#include <fstream>
+
+using namespace std;
+
+namespace HPHP {
+///////////////////////////////////////////////////////////////////////////////
+
+class ReplayBenchmarkWorker : public JobQueueWorker<int> {
+public:
+  virtual void doJob(int job) {
+    ((ReplayBenchmark*)m_opaque)->replay(job, &m_handler);
+  }
+  virtual void onThreadExit() {
+    MemoryManager::TheMemoryManager().get()->cleanup();
+  }
+
+private:
+  HttpRequestHandler m_handler;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+ReplayBenchmark::ReplayBenchmark(int threadCount, int count)
+  : m_threadCount(threadCount > 0 ? threadCount : 1),
+    m_count(count > 0 ? count : 1), m_wallUs(0),
+    m_allocatedBefore(-1), m_allocatedAfter(-1), m_mappedAfter(-1) {
+}
+
+bool ReplayBenchmark::load(const std::string &path) {
+  struct stat st;
+  if (stat(path.c_str(), &st) != 0) {
+    Logger::Error("Unable to read %s", path.c_str());
+    return false;
+  }
+  if ((st.st_mode & S_IFMT) != S_IFDIR) {
+    return loadFile(path);
+  }
+
+  DIR *dp = opendir(path.c_str());
+  if (!dp) {
+    Logger::Error("Unable to open directory %s", path.c_str());
+    return false;
+  }
+  vector<string> files;
+  dirent *de;
+  while ((de = readdir(dp))) {
+    string file = path + "/" + de->d_name;
+    if (stat(file.c_str(), &st) == 0 && (st.st_mode & S_IFMT) == S_IFREG) {
+      files.push_back(file);
+    }
+  }
+  closedir(dp);
+
+  sort(files.begin(), files.end());
+  bool loaded = false;
+  for (unsigned int i = 0; i < files.size(); i++) {
+    if (loadFile(files[i])) loaded = true;
+  }
+  return loaded;
+}
+
+bool ReplayBenchmark::loadFile(const std::string &path) {
+  ifstream f(path.c_str());
+  if (!f) {
+    Logger::Error("Unable to read %s", path.c_str());
+    return false;
+  }
+  ostringstream contents;
+  contents << f.rdbuf();
+  try {
+    // so a bad file fails here, instead of in the middle of the run
+    Hdf hdf;
+    hdf.fromString(contents.str().c_str());
+    if (hdf["url"].get("")[0] == '\0') {
+      Logger::Error("%s is not a recorded request", path.c_str());
+      return false;
+    }
+  } catch (const Exception &e) {
+    Logger::Error("Unable to parse %s: %s", path.c_str(), e.getMessage());
+    return false;
+  }
+  m_inputs.push_back(contents.str());
+  return true;
+}
+
+void ReplayBenchmark::run() {
+  int total = getRequestCount();
+  m_results.clear();
+  m_results.resize(total);
+  if (total == 0) return;
+
+  int64 mapped;
+  GetAllocatorStats(m_allocatedBefore, mapped);
+
+  JobQueueDispatcher<int, ReplayBenchmarkWorker> dispatcher
+    (m_threadCount, this);
+  Timer timer(Timer::WallTime);
+  dispatcher.start();
+  for (int i = 0; i < total; i++) {
+    dispatcher.enqueue(i);
+  }
+  dispatcher.stop();
+  m_wallUs = timer.getMicroSeconds();
+
+  GetAllocatorStats(m_allocatedAfter, m_mappedAfter);
+}
+
+void ReplayBenchmark::replay(int job, HttpRequestHandler *handler) {
+  ASSERT(job >= 0 && job < (int)m_results.size());
+  Result &result = m_results[job];
+
+  // parsed on this thread, since Hdf nodes can't be shared between threads
+  Hdf hdf;
+  hdf.fromString(m_inputs[job % m_inputs.size()].c_str());
+  ReplayTransport rt;
+  rt.replayInput(hdf);
+
+  Timer timer(Timer::WallTime);
+  try {
+    handler->handleRequest(&rt);
+  } catch (...) {
+    Logger::Error("HttpRequestHandler leaked exceptions");
+  }
+  result.wallUs = timer.getMicroSeconds();
+  result.code = rt.getResponseCode();
+
+  const MemoryUsageStats &stats =
+    MemoryManager::TheMemoryManager()->getLastStats();
+  result.peakUsage = stats.peakUsage;
+  result.peakAlloc = stats.peakAlloc;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// reporting
+
+static int64 percentile(const vector<int64> &sorted, int pct) {
+  if (sorted.empty()) return 0;
+  unsigned int i = sorted.size() * pct / 100;
+  return sorted[i < sorted.size() ? i : sorted.size() - 1];
+}
+
+static void report_distribution(ostringstream &out, const char *name,
+                                vector<int64> &values) {
+  sort(values.begin(), values.end());
+  int64 sum = 0;
+  for (unsigned int i = 0; i < values.size(); i++) {
+    sum += values[i];
+  }
+  out << name << ".avg: " << (values.empty() ? 0 : sum / values.size())
+      << "\n";
+  out << name << ".p50: " << percentile(values, 50) << "\n";
+  out << name << ".p90: " << percentile(values, 90) << "\n";
+  out << name << ".p99: " << percentile(values, 99) << "\n";
+  out << name << ".max: " << (values.empty() ? 0 : values.back()) << "\n";
+}
+
+std::string ReplayBenchmark::report() const {
+  ostringstream out;
+  int total = m_results.size();
+  out << "inputs: " << m_inputs.size() << "\n";
+  out << "threads: " << m_threadCount << "\n";
+  out << "requests: " << total << "\n";
+  out << "wall_us: " << m_wallUs << "\n";
+  out << "requests_per_sec: "
+      << (m_wallUs ? (double)total * 1000000 / m_wallUs : 0) << "\n";
+
+  map<int, int> codes;
+  vector<int64> latency, peakUsage, peakAlloc;
+  latency.reserve(total);
+  peakUsage.reserve(total);
+  peakAlloc.reserve(total);
+  for (int i = 0; i < total; i++) {
+    const Result &r = m_results[i];
+    codes[r.code]++;
+    latency.push_back(r.wallUs);
+    peakUsage.push_back(r.peakUsage);
+    peakAlloc.push_back(r.peakAlloc);
+  }
+  for (map<int, int>::const_iterator iter = codes.begin();
+       iter != codes.end(); ++iter) {
+    out << "code." << iter->first << ": " << iter->second << "\n";
+  }
+  report_distribution(out, "latency_us", latency);
+  report_distribution(out, "mem.peak_usage", peakUsage);
+  report_distribution(out, "mem.peak_alloc", peakAlloc);
+
+  if (m_allocatedBefore >= 0 && m_allocatedAfter >= 0) {
+    out << "malloc.allocated_before: " << m_allocatedBefore << "\n";
+    out << "malloc.allocated_after: " << m_allocatedAfter << "\n";
+    out << "malloc.mapped_after: " << m_mappedAfter << "\n";
+  }
+  return out.str();
+}
+
+bool ReplayBenchmark::GetAllocatorStats(int64 &allocated, int64 &mapped) {
+#ifndef NO_JEMALLOC
+  if (mallctl) {
+    // Force jemalloc to update stats cached for use by mallctl().
+    uint64_t epoch = 1;
+    mallctl("epoch", NULL, NULL, &epoch, sizeof(epoch));
+    size_t value, sz = sizeof(value);
+    if (mallctl("stats.allocated", &value, &sz, NULL, 0) == 0) {
+      allocated = value;
+      if (mallctl("stats.mapped", &value, &sz, NULL, 0) == 0) {
+        mapped = value;
+      }
+      return true;
+    }
+  }
+#endif
+  return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+}
@@ -0,0 +1,95 @@
+/*
+   +----------------------------------------------------------------------+
+   | HipHop for PHP                                                       |
+   +----------------------------------------------------------------------+
+   | Copyright (c) 2010 Facebook, Inc. (http://www.facebook.com)          |
+   +----------------------------------------------------------------------+
+   | This source file is subject to version 3.01 of the PHP license,      |
+   | that is bundled with this package in the file LICENSE, and is        |
+   | available through the world-wide-web at the following url:           |
+   | http://www.php.net/license/3_01.txt                                  |
+   | If you did not receive a copy of the PHP license and are unable to   |
+   | obtain it through the world-wide-web, please send a note to          |
+   | license@php.net so we can mail you a copy immediately.               |
+   +----------------------------------------------------------------------+
+*/
+
+
+#ifndef __HPHP_REPLAY_BENCHMARK_H__
+#define __HPHP_REPLAY_BENCHMARK_H__
+
+#include <util/base.h>
+
+namespace HPHP {
+///////////////////////////////////////////////////////////////////////////////
+
+class HttpRequestHandler;
+
+/**
+ * Load testing with requests recorded by ReplayTransport (RecordInput = true).
+ * They are replayed against in-process HttpRequestHandlers, one per thread,
+ * without any sockets, and timed one by one:
+ *
+ *   ReplayBenchmark bench(8, 100); // 8 threads, each request 100 times
+ *   bench.load("/tmp/recorded");  // a directory, or a single file
+ *   bench.run();
+ *   printf("%s", bench.report().c_str());
+ *
+ * Runtime has to be initialized as in server mode before run().
+ */
+class ReplayBenchmark {
+public:
+  ReplayBenchmark(int threadCount, int count);
+
+  /**
+   * Adds a recorded request, or every regular file directly under a
+   * directory, in name order. Returns false if nothing could be read.
+   */
+  bool load(const std::string &path);
+
+  int getRequestCount() const { return m_inputs.size() * m_count;}
+
+  /**
+   * Replays each loaded request "count" times, and blocks until they are all
+   * done. All of them are queued at once and taken by whichever thread is
+   * free, so there are no rounds: replays of one input may overlap the next.
+   */
+  void run();
+
+  /**
+   * Throughput, latency and memory numbers, one "name: value" per line.
+   */
+  std::string report() const;
+
+  /**
+   * Called by worker threads.
+   */
+  void replay(int job, HttpRequestHandler *handler);
+
+private:
+  struct Result {
+    int code;
+    int64 wallUs;    // from handleRequest() to its return
+    int64 peakUsage; // MemoryUsageStats of the request when it ended
+    int64 peakAlloc;
+  };
+
+  int m_threadCount;
+  int m_count;
+  std::vector<std::string> m_inputs; // recorded HDF, as text
+  std::vector<Result> m_results;     // one per job, by job number
+  int64 m_wallUs;
+
+  // process-wide allocator stats before and after run(), when available
+  int64 m_allocatedBefore;
+  int64 m_allocatedAfter;
+  int64 m_mappedAfter;
+
+  bool loadFile(const std::string &path);
+  static bool GetAllocatorStats(int64 &allocated, int64 &mapped);
+};
+
+///////////////////////////////////////////////////////////////////////////////
+}
+
+#endif // __HPHP_REPLAY_BENCHMARK_H__
@@ -17,7 +17,10 @@
 #include <runtime/base/complex_types.h>
 #include <runtime/base/server/server.h>
 #include <runtime/base/server/satellite_server.h>
+#include <runtime/base/server/server_stats.h>
+#include <runtime/base/runtime_option.h>
 #include <runtime/base/preg.h>
+#include <util/shared_thread_pool.h>
 #include <signal.h>
 
 using namespace std;
@@ -48,6 +51,32 @@ void Server::InstallStopSignalHandlers(ServerPtr server) {
   AllServers.push_back(server);
 }
 
+static Mutex s_sharedThreadPoolMutex;
+static SharedThreadPool *s_sharedThreadPool;
+
+SharedThreadPool *Server::GetSharedThreadPool() {
+  if (!RuntimeOption::ServerSharedThreadPool) {
+    return NULL;
+  }
+  Lock lock(s_sharedThreadPoolMutex);
+  if (s_sharedThreadPool == NULL) {
+    // in the order of SharedPool
+    SharedThreadPool *pool = new SharedThreadPool();
+    pool->addPool("page", RuntimeOption::ServerThreadCount,
+                  RuntimeOption::ServerReservedThreadCount,
+                  RuntimeOption::ServerThreadPriority);
+    pool->addPool("pagelet", RuntimeOption::PageletServerThreadCount,
+                  RuntimeOption::PageletServerReservedThreadCount,
+                  RuntimeOption::PageletServerThreadPriority);
+    pool->addPool("xbox", RuntimeOption::XboxServerThreadCount,
+                  RuntimeOption::XboxServerReservedThreadCount,
+                  RuntimeOption::XboxServerThreadPriority);
+    SharedThreadPool::s_pfunc_log_wait = server_stats_log_queuing;
+    s_sharedThreadPool = pool;
+  }
+  return s_sharedThreadPool;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 Server::Server(const std::string &address, int port, int threadCount)
@@ -65,6 +65,7 @@ namespace HPHP {
 ///////////////////////////////////////////////////////////////////////////////
 
 DECLARE_BOOST_TYPES(Server);
+class SharedThreadPool;
 
 /**
  * Base class of an HTTP request handler. Defining minimal interface an
@@ -107,6 +108,17 @@ public:
    */
   static void InstallStopSignalHandlers(ServerPtr server);
 
+  /**
+   * Threads that page, pagelet and xbox servers share, if
+   * Server.SharedThreadPool is turned on. NULL otherwise.
+   */
+  enum SharedPool {
+    PageServerPool,
+    PageletServerPool,
+    XboxServerPool,
+  };
+  static SharedThreadPool *GetSharedThreadPool();
+
 public:
   /**
    * Constructor.
@@ -19,6 +19,7 @@
 #include <runtime/base/runtime_option.h>
 #include <runtime/base/memory/memory_manager.h>
 #include <util/json.h>
+#include <util/shared_thread_pool.h>
 #include <runtime/base/preg.h>
 #include <time.h>
 #include <runtime/base/comparisons.h>
@@ -771,6 +772,30 @@ void ServerStats::ReportStatus(std::string &output, Format format) {
     w->writeFooter("thread");
   }
   w->writeFooter("threads");
+
+  SharedThreadPool *pool = Server::GetSharedThreadPool();
+  if (pool) {
+    vector<SharedThreadPool::PoolStats> stats;
+    pool->getStats(stats);
+    w->writeHeader("pools");
+    for (unsigned int i = 0; i < stats.size(); i++) {
+      const SharedThreadPool::PoolStats &ps = stats[i];
+      w->writeHeader("pool");
+      w->writeEntry("name", ps.name);
+      w->writeEntry("threads", (int64)ps.threadCount);
+      w->writeEntry("reserved", (int64)ps.reservedCount);
+      w->writeEntry("priority", (int64)ps.priority);
+      w->writeEntry("queued", (int64)ps.queued);
+      w->writeEntry("running", (int64)ps.running);
+      w->writeEntry("max-queued", (int64)ps.maxQueued);
+      w->writeEntry("jobs", ps.jobs);
+      w->writeEntry("avg-wait-us", ps.jobs ? ps.waitUs / ps.jobs : 0);
+      w->writeEntry("max-wait-us", ps.maxWaitUs);
+      w->writeFooter("pool");
+    }
+    w->writeFooter("pools");
+  }
+
   w->writeFooter("status");
   w->writeFileFooter();
 
@@ -1020,5 +1045,9 @@ void server_stats_log_mutex(const std::string &stack, int64 elapsed_us) {
   ServerStats::Log(string(buf) + "time", elapsed_us);
 }
 
+void server_stats_log_queuing(const std::string &pool, int64 wait_us) {
+  ServerStats::Log("pool." + pool + ".queuing", wait_us);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 }
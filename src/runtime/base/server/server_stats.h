@@ -199,6 +199,11 @@ public:
  */
 void server_stats_log_mutex(const std::string &stack, int64 elapsed_us);
 
+/**
+ * For jobs waiting in a shared thread pool.
+ */
+void server_stats_log_queuing(const std::string &pool, int64 wait_us);
+
 ///////////////////////////////////////////////////////////////////////////////
 }
 
@@ -46,6 +46,10 @@ void StaticContentCache::load() {
       TheFileCache->load(RuntimeOption::FileCache.c_str(),
                          RuntimeOption::EnableOnDemandUncompress, version);
     }
+    struct stat st;
+    if (stat(RuntimeOption::FileCache.c_str(), &st) == 0) {
+      m_fileCacheETag = MakeETag(st);
+    }
     Logger::Info("loaded file cache from %s",
                  RuntimeOption::FileCache.c_str());
     return;
@@ -92,6 +96,10 @@ void StaticContentCache::load() {
       if (sb->valid() && sb->size() > 0) {
         string url = out[i].substr(rootSize + 1);
         f->file = sb;
+        struct stat st;
+        if (stat(out[i].c_str(), &st) == 0) {
+          f->etag = MakeETag(st);
+        }
         m_files[url] = f;
 
         // prepare gzipped content, skipping image and swf files
@@ -116,14 +124,24 @@ void StaticContentCache::load() {
   Logger::Info("loaded %d bytes of static content in total", m_totalSize);
 }
 
+std::string StaticContentCache::MakeETag(const struct stat &st) {
+  char buf[64];
+  snprintf(buf, sizeof(buf), "%lx-%llx-%lx", (unsigned long)st.st_ino,
+           (unsigned long long)st.st_size, (unsigned long)st.st_mtime);
+  return buf;
+}
+
 bool StaticContentCache::find(const std::string &name, const char *&data,
-                              int &len, bool &compressed) const {
+                              int &len, bool &compressed,
+                              std::string &etag) const {
   if (TheFileCache) {
+    etag = m_fileCacheETag;
     return data = TheFileCache->read(name.c_str(), len, compressed);
   }
 
   StringToResourceFilePtrMap::const_iterator iter = m_files.find(name);
   if (iter != m_files.end()) {
+    etag = iter->second->etag;
     if (compressed && iter->second->compressed) {
       data = iter->second->compressed->data();
       len = iter->second->compressed->size();
@@ -19,6 +19,7 @@
 
 #include <runtime/base/util/string_buffer.h>
 #include <util/file_cache.h>
+#include <sys/stat.h>
 
 namespace HPHP {
 ///////////////////////////////////////////////////////////////////////////////
@@ -37,18 +38,26 @@ public:
   void load();
 
   /**
-   * Find a file from cache.
+   * Find a file from cache. "etag" identifies the version of the file that
+   * was loaded, without quotes.
    */
   bool find(const std::string &name, const char *&data, int &len,
-            bool &compressed) const;
+            bool &compressed, std::string &etag) const;
+
+  /**
+   * Apache style entity tag of a file: inode, size and modification time.
+   */
+  static std::string MakeETag(const struct stat &st);
 
 private:
   int m_totalSize;
+  std::string m_fileCacheETag; // every file in the archive changes with it
 
   DECLARE_BOOST_TYPES(ResourceFile);
   struct ResourceFile {
     StringBufferPtr file;
     StringBufferPtr compressed;
+    std::string etag;
   };
 
   StringToResourceFilePtrMap m_files;
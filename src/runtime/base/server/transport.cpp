@@ -629,7 +629,8 @@ void Transport::sendRaw(void *data, int size, int code /* = 200 */,
   ASSERT(size >= 0);
   FiberWriteLock lock(this);
 
-  if (!compressed && RuntimeOption::ForceChunkedEncoding) {
+  // a 304 has no body to chunk
+  if (!compressed && RuntimeOption::ForceChunkedEncoding && code != 304) {
     chunked = true;
   }
   if (m_chunkedEncoding) {
@@ -672,6 +673,75 @@ void Transport::sendRaw(void *data, int size, int code /* = 200 */,
   }
 }
 
+void Transport::sendFile(int fd, off_t offset, int size,
+                         int code /* = 200 */) {
+  ASSERT(fd >= 0);
+  ASSERT(size >= 0);
+  FiberWriteLock lock(this);
+  ASSERT(!m_headerSent);
+
+  if (m_responseCode < 0) {
+    m_responseCode = code;
+  }
+  prepareHeaders(false, NULL, size);
+  m_headerSent = true;
+
+  m_responseSize += size;
+  ServerStats::SetThreadMode(ServerStats::Writing);
+  sendFileImpl(fd, offset, size, m_responseCode);
+  if (m_chunkedEncoding) {
+    // sent in pieces by sendFileImpl(), and static content has no other
+    // caller of onSendEnd() to terminate it
+    onSendEndImpl();
+  }
+  ServerStats::SetThreadMode(ServerStats::Processing);
+
+  ServerStats::LogBytes(size);
+  if (RuntimeOption::EnableStats && RuntimeOption::EnableWebStats) {
+    ServerStats::Log("network.uncompressed", size);
+    ServerStats::Log("network.compressed", size);
+  }
+}
+
+void Transport::sendFileImpl(int fd, off_t offset, int size, int code) {
+  if (getMethod() == HEAD) {
+    sendImpl("", 0, code, false);
+    return;
+  }
+
+  // read in bounded pieces, so a big file is never in memory as a whole;
+  // more than one piece goes out with chunked encoding, and sendFile()
+  // ends the response
+  int bufSize = size < SendFileChunkSize ? size : SendFileChunkSize;
+  bool chunked = size > bufSize;
+  if (chunked) {
+    m_chunkedEncoding = true;
+    // a transport that tried to send it whole may have set it already
+    removeHeaderImpl("Content-Length");
+  }
+  char *buf = (char *)malloc(bufSize + 1);
+  int total = 0;
+  do {
+    int piece = size - total < bufSize ? size - total : bufSize;
+    int len = 0;
+    while (len < piece) {
+      ssize_t n = pread(fd, buf + len, piece - len, offset + total + len);
+      if (n <= 0) break;
+      len += n;
+    }
+    if (len || !chunked) {
+      sendImpl(buf, len, code, chunked);
+    }
+    total += len;
+    if (len < piece) {
+      Logger::Error("Unable to read %d bytes of static content: %s", size,
+                    Util::safe_strerror(errno).c_str());
+      break;
+    }
+  } while (total < size);
+  free(buf);
+}
+
 void Transport::onSendEnd() {
   FiberWriteLock lock(this);
   if (m_compressor && m_chunkedEncoding) {
@@ -33,6 +33,8 @@ namespace HPHP {
 typedef std::map<std::string, std::vector<std::string>, stdltistr> HeaderMap;
 typedef std::map<std::string, std::string, stdltistr> CookieMap;
 
+class StreamedUpload;
+
 /**
  * A class defining an interface that request handler can use to query
  * transport related information.
@@ -72,6 +74,10 @@ public:
     SERVICE_UNAVAILABLE = 503,
   };
 
+  enum {
+    SendFileChunkSize = 64 * 1024, // see sendFileImpl()
+  };
+
   enum ThreadType {
     RequestThread,
     PageletThread,
@@ -99,6 +105,12 @@ public:
   virtual bool hasMorePostData() { return false; }
   virtual const void *getMorePostData(int &size) { size = 0; return NULL; }
 
+  /**
+   * A multipart POST body that was parsed while it arrived, or NULL when
+   * getPostData() has it.
+   */
+  virtual StreamedUpload *getStreamedUpload() { return NULL; }
+
   /**
    * Is this a GET, POST or anything?
    */
@@ -117,6 +129,12 @@ public:
   virtual std::string getHeader(const char *name) = 0;
   virtual void getHeaders(HeaderMap &headers) = 0;
 
+  /**
+   * Request headers already named the way $_SERVER wants them, like
+   * "HTTP_USER_AGENT", if the transport has them prepared. NULL otherwise.
+   */
+  virtual const HeaderMap *getServerHeaders() { return NULL;}
+
   /**
    * Get/set response headers.
    */
@@ -177,6 +195,14 @@ public:
   virtual void sendImpl(const void *data, int size, int code,
                         bool chunked) = 0;
 
+  /**
+   * Send back "size" bytes of file "fd" starting at "offset" as the whole
+   * response body. Caller closes fd. Default implementation reads them
+   * SendFileChunkSize bytes at a time and calls sendImpl() with each piece,
+   * and sends no body at all for a HEAD request.
+   */
+  virtual void sendFileImpl(int fd, off_t offset, int size, int code);
+
   /**
    * Override to implement more send end logic.
    */
@@ -275,6 +301,7 @@ public:
                   bool compressed = false, bool chunked = false) {
     sendRaw((void*)data.c_str(), data.length(), code, compressed, chunked);
   }
+  void sendFile(int fd, off_t offset, int size, int code = 200);
   void redirect(const char *location, int code = 302);
 
   // TODO: support rfc1867
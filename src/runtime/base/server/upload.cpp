@@ -23,6 +23,7 @@
 #include <runtime/base/zend/zend_printf.h>
 #include <runtime/ext/ext_apc.h>
 #include <util/logger.h>
+#include <util/async_func.h>
 #include <runtime/base/string_util.h>
 
 using namespace std;
@@ -413,12 +414,42 @@ static int find_boundary(multipart_buffer *self, char *boundary) {
 }
 
 
+/* add one line of a part's headers to table */
+static void add_header_line(header_list &header,
+                            std::pair<std::string, std::string> &prev_entry,
+                            char *line) {
+  std::pair<std::string, std::string> entry;
+  char *key = line;
+  char *value = NULL;
+
+  /* space in the beginning means same header */
+  if (!isspace(line[0])) {
+    value = strchr(line, ':');
+  }
+
+  if (value) {
+    *value = 0;
+    do { value++; } while(isspace(*value));
+    entry = std::pair<std::string, std::string>(key, value);
+  } else if (!header.empty()) {
+    /* If no ':' on the line, add to previous line */
+    entry = std::pair<std::string, std::string>
+      (prev_entry.first, prev_entry.second + line);
+    header.pop_back();
+  } else {
+    return;
+  }
+
+  header.push_back(entry);
+  prev_entry = entry;
+}
+
+
 /* parse headers */
 static int multipart_buffer_headers(multipart_buffer *self,
                                     header_list &header) {
   char *line;
   std::pair<std::string, std::string> prev_entry;
-  std::pair<std::string, std::string> entry;
 
   /* didn't find boundary, abort */
   if (!find_boundary(self, self->boundary)) {
@@ -429,31 +460,7 @@ static int multipart_buffer_headers(multipart_buffer *self,
 
   while( (line = get_line(self)) && strlen(line) > 0 )
   {
-    /* add header to table */
-
-    char *key = line;
-    char *value = NULL;
-
-    /* space in the beginning means same header */
-    if (!isspace(line[0])) {
-      value = strchr(line, ':');
-    }
-
-    if (value) {
-      *value = 0;
-      do { value++; } while(isspace(*value));
-      entry = std::pair<std::string, std::string>(key, value);
-    } else if (!header.empty()) {
-      /* If no ':' on the line, add to previous line */
-      entry = std::pair<std::string, std::string>
-        (prev_entry.first, prev_entry.second + line);
-      header.pop_back();
-    } else {
-      continue;
-    }
-
-    header.push_back(entry);
-    prev_entry = entry;
+    add_header_line(header, prev_entry, line);
   }
 
   return 1;
@@ -584,6 +591,44 @@ look_for_quote:
 }
 
 
+/* picks name and filename out of a Content-Disposition header */
+static void parse_content_disposition(char *cd, char *&param,
+                                      char *&filename) {
+  char *pair=NULL;
+
+  while (isspace(*cd)) {
+    ++cd;
+  }
+
+  while (*cd && (pair = php_ap_getword(&cd, ';')))
+  {
+    char *key=NULL, *word = pair;
+
+    while (isspace(*cd)) {
+      ++cd;
+    }
+
+    if (strchr(pair, '=')) {
+      key = php_ap_getword(&pair, '=');
+
+      if (!strcasecmp(key, "name")) {
+        if (param) {
+          free(param);
+        }
+        param = php_ap_getword_conf(&pair);
+      } else if (!strcasecmp(key, "filename")) {
+        if (filename) {
+          free(filename);
+        }
+        filename = php_ap_getword_conf(&pair);
+      }
+    }
+    if (key) free(key);
+    free(word);
+  }
+}
+
+
 /*
   search for a string in a fixed-length byte string.
   if partial is true, partial matches are allowed at the end of the buffer.
@@ -683,6 +728,163 @@ static char *multipart_buffer_read_body(multipart_buffer *self,
   return out;
 }
 
+/*
+  registers an uploaded file into $_FILES, and unless it's anonymous, as
+  $foo, $foo_name, $foo_type and $foo_size too.
+*/
+static void register_uploaded_file(Variant &files, char *param,
+                                   char *filename, const char *type,
+                                   const char *temp_filename,
+                                   int cancel_upload, int total_bytes,
+                                   bool is_anonymous) {
+  char *s=NULL, *tmp=NULL, *start_arr=NULL;
+  string array_index, abuf;
+  int is_arr_upload=0, array_len=0;
+  unsigned int llen = strlen(param) + MAX_SIZE_OF_INDEX + 1;
+  char *lbuf = (char *)malloc(llen);
+
+  /* is_arr_upload is true when name of file upload field
+   * ends in [.*]
+   * start_arr is set to point to 1st [
+   */
+  is_arr_upload = (start_arr = strchr(param,'[')) &&
+                  (param[strlen(param)-1] == ']');
+
+  if (is_arr_upload) {
+    array_len = strlen(start_arr);
+    array_index = string(start_arr+1, array_len-2);
+  }
+
+  /* Add $foo_name */
+  if (is_arr_upload) {
+    abuf = string(param, strlen(param)-array_len);
+    snprintf(lbuf, llen, "%s_name[%s]",
+             abuf.c_str(), array_index.c_str());
+  } else {
+    snprintf(lbuf, llen, "%s_name", param);
+  }
+
+  /* The \ check should technically be needed for win32 systems only
+   * where it is a valid path separator. However, IE in all it's wisdom
+   * always sends the full path of the file on the user's filesystem,
+   * which means that unless the user does basename() they get a bogus
+   * file name. Until IE's user base drops to nill or problem is fixed
+   * this code must remain enabled for all systems.
+   */
+  s = strrchr(filename, '\\');
+  if ((tmp = strrchr(filename, '/')) > s) {
+    s = tmp;
+  }
+
+  Variant globals(((Globals*)get_global_variables())->getArrayData());
+  if (!is_anonymous) {
+    if (s && s > filename) {
+      String val(s+1, strlen(s+1), CopyString);
+      safe_php_register_variable(lbuf, val, globals, 0);
+    } else {
+      String val(filename, strlen(filename), CopyString);
+      safe_php_register_variable(lbuf, val, globals, 0);
+    }
+  }
+
+  /* Add $foo[name] */
+  if (is_arr_upload) {
+    snprintf(lbuf, llen, "%s[name][%s]",
+             abuf.c_str(), array_index.c_str());
+  } else {
+    snprintf(lbuf, llen, "%s[name]", param);
+  }
+  if (s && s > filename) {
+    String val(s+1, strlen(s+1), CopyString);
+    safe_php_register_variable(lbuf, val, files, 0);
+  } else {
+    String val(filename, strlen(filename), CopyString);
+    safe_php_register_variable(lbuf, val, files, 0);
+  }
+
+  /* Add $foo_type */
+  if (is_arr_upload) {
+    snprintf(lbuf, llen, "%s_type[%s]",
+             abuf.c_str(), array_index.c_str());
+  } else {
+    snprintf(lbuf, llen, "%s_type", param);
+  }
+  if (!is_anonymous) {
+    String val(type, strlen(type), CopyString);
+    safe_php_register_variable(lbuf, val, globals, 0);
+  }
+
+  /* Add $foo[type] */
+  if (is_arr_upload) {
+    snprintf(lbuf, llen, "%s[type][%s]",
+             abuf.c_str(), array_index.c_str());
+  } else {
+    snprintf(lbuf, llen, "%s[type]", param);
+  }
+  String val(type, strlen(type), CopyString);
+  safe_php_register_variable(lbuf, val, files, 0);
+
+  /* Initialize variables */
+  add_protected_variable(param);
+
+  /* if param is of form xxx[.*] this will cut it to xxx */
+  if (!is_anonymous) {
+    String val(temp_filename, strlen(temp_filename), CopyString);
+    safe_php_register_variable(param, val, globals, 1);
+  }
+
+  /* Add $foo[tmp_name] */
+  if (is_arr_upload) {
+    snprintf(lbuf, llen, "%s[tmp_name][%s]",
+             abuf.c_str(), array_index.c_str());
+  } else {
+    snprintf(lbuf, llen, "%s[tmp_name]", param);
+  }
+  add_protected_variable(lbuf);
+  String tempFileName(temp_filename, strlen(temp_filename), CopyString);
+  safe_php_register_variable(lbuf, tempFileName, files, 1);
+
+  Variant file_size, error_type;
+
+  error_type = cancel_upload;
+
+  /* Add $foo[error] */
+  if (cancel_upload) {
+    file_size = 0;
+  } else {
+    file_size = total_bytes;
+  }
+
+  if (is_arr_upload) {
+    snprintf(lbuf, llen, "%s[error][%s]",
+             abuf.c_str(), array_index.c_str());
+  } else {
+    snprintf(lbuf, llen, "%s[error]", param);
+  }
+  safe_php_register_variable(lbuf, error_type, files, 0);
+
+  /* Add $foo_size */
+  if (is_arr_upload) {
+    snprintf(lbuf, llen, "%s_size[%s]",
+             abuf.c_str(), array_index.c_str());
+  } else {
+    snprintf(lbuf, llen, "%s_size", param);
+  }
+  if (!is_anonymous) {
+    safe_php_register_variable(lbuf, file_size, globals, 0);
+  }
+
+  /* Add $foo[size] */
+  if (is_arr_upload) {
+    snprintf(lbuf, llen, "%s[size][%s]",
+             abuf.c_str(), array_index.c_str());
+  } else {
+    snprintf(lbuf, llen, "%s[size]", param);
+  }
+  safe_php_register_variable(lbuf, file_size, files, 0);
+  free(lbuf);
+}
+
 /*
  * The combined READER/HANDLER
  *
@@ -691,16 +893,13 @@ static char *multipart_buffer_read_body(multipart_buffer *self,
 void rfc1867PostHandler(Transport *transport,
                         Variant &post, Variant &files, int content_length,
                         const void *&data, int &size, const string boundary) {
-  char *s=NULL, *start_arr=NULL;
-  string array_index, abuf;
-  char *temp_filename=NULL, *lbuf=NULL;
-  int total_bytes=0, cancel_upload=0, is_arr_upload=0, array_len=0;
+  char *temp_filename=NULL;
+  int total_bytes=0, cancel_upload=0;
   int max_file_size=0, skip_upload=0, anonindex=0, is_anonymous;
   set<string> &uploaded_files = s_rfc1867_data->rfc1867UploadedFiles;
   multipart_buffer *mbuff;
   int fd=-1;
   void *event_extra_data = NULL;
-  unsigned int llen = 0;
 
   /* Initialize the buffer */
   if (!(mbuff = multipart_buffer_new(transport,
@@ -731,7 +930,7 @@ void rfc1867PostHandler(Transport *transport,
 
   while (!multipart_buffer_eof(mbuff)) {
     char buff[FILLUNIT];
-    char *cd=NULL,*param=NULL,*filename=NULL, *tmp=NULL;
+    char *cd=NULL,*param=NULL,*filename=NULL;
     size_t blen=0, wlen=0;
     off_t offset;
 
@@ -741,39 +940,9 @@ void rfc1867PostHandler(Transport *transport,
     }
 
     if ((cd = php_mime_get_hdr_value(header, "Content-Disposition"))) {
-      char *pair=NULL;
       int end=0;
 
-      while (isspace(*cd)) {
-        ++cd;
-      }
-
-      while (*cd && (pair = php_ap_getword(&cd, ';')))
-      {
-        char *key=NULL, *word = pair;
-
-        while (isspace(*cd)) {
-          ++cd;
-        }
-
-        if (strchr(pair, '=')) {
-          key = php_ap_getword(&pair, '=');
-
-          if (!strcasecmp(key, "name")) {
-            if (param) {
-              free(param);
-            }
-            param = php_ap_getword_conf(&pair);
-          } else if (!strcasecmp(key, "filename")) {
-            if (filename) {
-              free(filename);
-            }
-            filename = php_ap_getword_conf(&pair);
-          }
-        }
-        if (key) free(key);
-        free(word);
-      }
+      parse_content_disposition(cd, param, filename);
 
       /* Normal form variable, safe to read all data into memory */
       if (!filename && param) {
@@ -1004,190 +1173,482 @@ void rfc1867PostHandler(Transport *transport,
         s_rfc1867_data->rfc1867UploadedFiles.insert(temp_filename);
       }
 
-      /* is_arr_upload is true when name of file upload field
-       * ends in [.*]
-       * start_arr is set to point to 1st [
-       */
-      is_arr_upload = (start_arr = strchr(param,'[')) &&
-                      (param[strlen(param)-1] == ']');
-
-      if (is_arr_upload) {
-        array_len = strlen(start_arr);
-        array_index = string(start_arr+1, array_len-2);
+      /* Possible Content-Type: */
+      string type;
+      if (!cancel_upload &&
+          (cd = php_mime_get_hdr_value(header, "Content-Type"))) {
+        /* fix for Opera 6.01 */
+        type = string(cd, strcspn(cd, ";"));
       }
 
-      /* Add $foo_name */
-      if (llen < strlen(param) + MAX_SIZE_OF_INDEX + 1) {
-        llen = strlen(param);
-        lbuf = (char *) realloc(lbuf, llen + MAX_SIZE_OF_INDEX + 1);
-        llen += MAX_SIZE_OF_INDEX + 1;
-      }
+      register_uploaded_file(files, param, filename, type.c_str(),
+                             temp_filename, cancel_upload, total_bytes,
+                             is_anonymous);
+      free(filename);
+      free(param);
+    }
+  }
+fileupload_done:
+  data = mbuff->post_data;
+  size = mbuff->post_size;
+  if (php_rfc1867_callback != NULL) {
+    multipart_event_end event_end;
 
-      if (is_arr_upload) {
-        abuf = string(param, strlen(param)-array_len);
-        snprintf(lbuf, llen, "%s_name[%s]",
-                 abuf.c_str(), array_index.c_str());
-      } else {
-        snprintf(lbuf, llen, "%s_name", param);
-      }
+    event_end.post_bytes_processed = mbuff->read_post_bytes;
+    php_rfc1867_callback(&s_rfc1867_data->rfc1867ApcData,
+                         MULTIPART_EVENT_END, &event_end, &event_extra_data);
+  }
+  s_rfc1867_data->rfc1867ProtectedVariables.clear();
+  if (mbuff->boundary_next) free(mbuff->boundary_next);
+  if (mbuff->boundary) free(mbuff->boundary);
+  if (mbuff->buffer) free(mbuff->buffer);
+  if (mbuff) free(mbuff);
+}
 
-      /* The \ check should technically be needed for win32 systems only
-       * where it is a valid path separator. However, IE in all it's wisdom
-       * always sends the full path of the file on the user's filesystem,
-       * which means that unless the user does basename() they get a bogus
-       * file name. Until IE's user base drops to nill or problem is fixed
-       * this code must remain enabled for all systems.
-       */
-      s = strrchr(filename, '\\');
-      if ((tmp = strrchr(filename, '/')) > s) {
-        s = tmp;
-      }
 
-      Variant globals(((Globals*)get_global_variables())->getArrayData());
-      if (!is_anonymous) {
-        if (s && s > filename) {
-          String val(s+1, strlen(s+1), CopyString);
-          safe_php_register_variable(lbuf, val, globals, 0);
-        } else {
-          String val(filename, strlen(filename), CopyString);
-          safe_php_register_variable(lbuf, val, globals, 0);
+///////////////////////////////////////////////////////////////////////////////
+// StreamedUpload
+
+/**
+ * A streamed upload's temporary file. Only the writer thread touches it,
+ * until wait() says all its operations are done.
+ */
+class UploadFile {
+public:
+  UploadFile() : fd(-1), written(0), error(0), pending(0) {}
+  int fd;
+  std::string tempFile; // until registerVariables() takes it
+  int written;
+  int error;            // UPLOAD_ERROR_E or UPLOAD_ERROR_F
+  int pending;          // operations queued, guarded by the writer's lock
+};
+
+/**
+ * Does streamed uploads' file IO in order, so a slow disk stalls neither
+ * the event loop nor any other connection it serves.
+ */
+class UploadWriter : public Synchronizable {
+public:
+  enum OpKind {
+    Open,    // create the temporary file
+    Write,   // append data to it
+    Close,   // done with it; removed unless it's kept
+    Discard  // remove it, unless registerVariables() took it
+  };
+
+  static UploadWriter &GetInstance() {
+    // never deleted, as the thread runs until the process exits
+    static UploadWriter *s_writer = new UploadWriter();
+    return *s_writer;
+  }
+
+  UploadWriter()
+    : m_thread(this, &UploadWriter::threadRun), m_started(false),
+      m_queued(0) {
+  }
+
+  bool backlogged() {
+    Lock lock(this);
+    return m_queued >= RuntimeOption::UploadStreamBufferSize;
+  }
+
+  void enqueue(OpKind kind, UploadFilePtr file, const char *data = NULL,
+               int size = 0, bool keep = false) {
+    std::string copy;
+    if (size > 0) copy.assign(data, size); // outside the lock
+
+    Lock lock(this);
+    if (!m_started) {
+      m_thread.start();
+      m_started = true;
+    }
+    m_queue.push_back(Op());
+    Op &op = m_queue.back();
+    op.kind = kind;
+    op.file = file;
+    op.data.swap(copy);
+    op.keep = keep;
+    file->pending++;
+    m_queued += size;
+    notifyAll();
+  }
+
+  /**
+   * Blocks until all operations queued for the file are done.
+   */
+  void wait(UploadFilePtr file) {
+    Lock lock(this);
+    while (file->pending) {
+      Synchronizable::wait();
+    }
+  }
+
+  void threadRun() {
+    std::deque<Op> ops;
+    while (true) {
+      {
+        Lock lock(this);
+        while (m_queue.empty()) {
+          Synchronizable::wait();
         }
+        ops.swap(m_queue);
       }
-
-      /* Add $foo[name] */
-      if (is_arr_upload) {
-        snprintf(lbuf, llen, "%s[name][%s]",
-                 abuf.c_str(), array_index.c_str());
-      } else {
-        snprintf(lbuf, llen, "%s[name]", param);
+      for (unsigned int i = 0; i < ops.size(); i++) {
+        run(ops[i]);
       }
-      if (s && s > filename) {
-        String val(s+1, strlen(s+1), CopyString);
-        safe_php_register_variable(lbuf, val, files, 0);
-      } else {
-        String val(filename, strlen(filename), CopyString);
-        safe_php_register_variable(lbuf, val, files, 0);
+      {
+        Lock lock(this);
+        for (unsigned int i = 0; i < ops.size(); i++) {
+          ops[i].file->pending--;
+          m_queued -= ops[i].data.size();
+        }
+        notifyAll();
       }
-      free(filename);
-      s = NULL;
+      ops.clear();
+    }
+  }
 
-      /* Possible Content-Type: */
-      if (cancel_upload ||
-          !(cd = php_mime_get_hdr_value(header, "Content-Type"))) {
-        cd = "";
+private:
+  struct Op {
+    OpKind kind;
+    UploadFilePtr file;
+    std::string data;
+    bool keep;
+  };
+
+  AsyncFunc<UploadWriter> m_thread;
+  bool m_started;
+  std::deque<Op> m_queue;
+  int64 m_queued; // bytes of data not written yet, queued or being written
+
+  static void run(Op &op) {
+    UploadFile &file = *op.file;
+    switch (op.kind) {
+    case Open: {
+      char path[PATH_MAX];
+      snprintf(path, sizeof(path), "%s/XXXXXX",
+               RuntimeOption::UploadTmpDir.c_str());
+      file.fd = mkstemp(path);
+      if (file.fd == -1) {
+        Logger::Warning("Unable to open temporary file");
+        Logger::Warning("File upload error - unable to create a "
+                        "temporary file");
+        file.error = UPLOAD_ERROR_E;
       } else {
-        /* fix for Opera 6.01 */
-        s = strchr(cd, ';');
-        if (s != NULL) {
-          *s = '\0';
-        }
+        file.tempFile = path;
       }
-
-      /* Add $foo_type */
-      if (is_arr_upload) {
-        snprintf(lbuf, llen, "%s_type[%s]",
-                 abuf.c_str(), array_index.c_str());
+      break;
+    }
+    case Write: {
+      if (file.error || file.fd == -1) break;
+      int size = op.data.size();
+      int wlen = write(file.fd, op.data.data(), size);
+      if (wlen < size) {
+        Logger::Verbose("Only %d bytes were written, expected to "
+                        "write %d", wlen, size);
+        file.error = UPLOAD_ERROR_F;
       } else {
-        snprintf(lbuf, llen, "%s_type", param);
+        file.written += wlen;
       }
-      if (!is_anonymous) {
-        String val(cd, strlen(cd), CopyString);
-        safe_php_register_variable(lbuf, val, globals, 0);
+      break;
+    }
+    case Close:
+    case Discard:
+      if (file.fd != -1) {
+        close(file.fd);
+        file.fd = -1;
       }
-
-      /* Add $foo[type] */
-      if (is_arr_upload) {
-        snprintf(lbuf, llen, "%s[type][%s]",
-                 abuf.c_str(), array_index.c_str());
-      } else {
-        snprintf(lbuf, llen, "%s[type]", param);
+      if ((op.kind == Discard || !op.keep || file.error) &&
+          !file.tempFile.empty()) {
+        unlink(file.tempFile.c_str());
+        file.tempFile.clear();
       }
-      String val(cd, strlen(cd), CopyString);
-      safe_php_register_variable(lbuf, val, files, 0);
+      break;
+    }
+  }
+};
 
-      /* Restore Content-Type Header */
-      if (s != NULL) {
-        *s = ';';
-      }
-      s = "";
+StreamedUpload::StreamedUpload(const string &boundary)
+  : m_boundary("--" + boundary), m_boundaryNext("\n--" + boundary),
+    m_state(SeekBoundary), m_part(-1), m_maxFileSize(0), m_anonIndex(0),
+    m_skipUpload(false) {
+}
 
-      /* Initialize variables */
-      add_protected_variable(param);
+bool StreamedUpload::Backlogged() {
+  return UploadWriter::GetInstance().backlogged();
+}
 
-      /* if param is of form xxx[.*] this will cut it to xxx */
-      if (!is_anonymous) {
-        String val(temp_filename, strlen(temp_filename), CopyString);
-        safe_php_register_variable(param, val, globals, 1);
-      }
+StreamedUpload::~StreamedUpload() {
+  for (unsigned int i = 0; i < m_parts.size(); i++) {
+    if (m_parts[i].file) {
+      UploadWriter::GetInstance().enqueue(UploadWriter::Discard,
+                                          m_parts[i].file);
+    }
+  }
+}
 
-      /* Add $foo[tmp_name] */
-      if (is_arr_upload) {
-        snprintf(lbuf, llen, "%s[tmp_name][%s]",
-                 abuf.c_str(), array_index.c_str());
-      } else {
-        snprintf(lbuf, llen, "%s[tmp_name]", param);
-      }
-      add_protected_variable(lbuf);
-      String tempFileName(temp_filename, strlen(temp_filename), CopyString);
-      safe_php_register_variable(lbuf, tempFileName, files, 1);
+void StreamedUpload::feed(const char *data, int size) {
+  m_buffer.append(data, size);
+  int pos = 0;
+  while (m_state == Body ? parseBody(pos, false) : parseLine(pos, false)) {
+  }
+  m_buffer.erase(0, pos);
+}
 
-      Variant file_size, error_type;
+void StreamedUpload::finish() {
+  int pos = 0;
+  while (m_state == Body ? parseBody(pos, true) : parseLine(pos, true)) {
+  }
+  m_buffer.clear();
+  m_state = Done;
+}
 
-      error_type = cancel_upload;
+/*
+  takes the next line off the buffer, the way get_line() does: LF terminated,
+  minus the CRLF, or as much as a multipart_buffer holds if it's that long.
+*/
+bool StreamedUpload::parseLine(int &pos, bool final) {
+  int avail = m_buffer.size() - pos;
+  if (m_state == Done || avail == 0) {
+    pos = m_buffer.size();
+    return false;
+  }
 
-      /* Add $foo[error] */
-      if (cancel_upload) {
-        file_size = 0;
-      } else {
-        file_size = total_bytes;
-      }
+  const char *begin = m_buffer.data() + pos;
+  const char *lf = (const char *)memchr(begin, '\n', avail);
+  int len;
+  if (lf) {
+    len = lf - begin;
+    pos += len + 1;
+    if (len > 0 && begin[len - 1] == '\r') len--;
+  } else {
+    int bufsize = m_boundary.size() + 4;
+    if (bufsize < FILLUNIT) bufsize = FILLUNIT;
+    if (avail < bufsize && !final) return false;
+    len = avail;
+    pos += len;
+  }
 
-      if (is_arr_upload) {
-        snprintf(lbuf, llen, "%s[error][%s]",
-                 abuf.c_str(), array_index.c_str());
-      } else {
-        snprintf(lbuf, llen, "%s[error]", param);
-      }
-      safe_php_register_variable(lbuf, error_type, files, 0);
+  if (m_state == SeekBoundary) {
+    if (m_boundary.compare(0, string::npos, begin, len) == 0) {
+      m_state = Headers;
+      m_headers.clear();
+    }
+  } else if (len == 0) {
+    startPart();
+  } else {
+    m_headers.push_back(string(begin, len));
+  }
+  return true;
+}
 
-      /* Add $foo_size */
-      if (is_arr_upload) {
-        snprintf(lbuf, llen, "%s_size[%s]",
-                 abuf.c_str(), array_index.c_str());
-      } else {
-        snprintf(lbuf, llen, "%s_size", param);
+/*
+  hands a part's data over up to the next boundary, the way
+  multipart_buffer_read() does, holding back what could be the start of it.
+*/
+bool StreamedUpload::parseBody(int &pos, bool final) {
+  char *begin = (char *)m_buffer.data() + pos;
+  int avail = m_buffer.size() - pos;
+  char *bound = php_ap_memstr(begin, avail, (char *)m_boundaryNext.data(),
+                              m_boundaryNext.size(), 0);
+  if (bound) {
+    int len = bound - begin;
+    append(begin, len > 0 && begin[len - 1] == '\r' ? len - 1 : len);
+    pos += len; // the boundary line is found by parseLine()
+    endPart(true);
+    m_state = SeekBoundary;
+    return true;
+  }
+
+  int len = final ? avail : avail - (int)m_boundaryNext.size();
+  if (len > 0) {
+    append(begin, len);
+    pos += len;
+  }
+  if (final) endPart(false);
+  return false;
+}
+
+void StreamedUpload::startPart() {
+  header_list header;
+  std::pair<std::string, std::string> prev_entry;
+  for (unsigned int i = 0; i < m_headers.size(); i++) {
+    add_header_line(header, prev_entry, &m_headers[i][0]);
+  }
+  m_headers.clear();
+  m_state = Body;
+  m_part = -1;
+
+  char *cd = php_mime_get_hdr_value(header, "Content-Disposition");
+  if (!cd) return;
+  char *param = NULL, *filename = NULL;
+  parse_content_disposition(cd, param, filename);
+
+  Part part;
+  if (!filename && param) {
+    part.name = param;
+    free(param);
+    m_parts.push_back(part);
+    m_part = m_parts.size() - 1;
+    return;
+  }
+
+  /* If file_uploads=off, skip the file part */
+  if (!RuntimeOption::EnableFileUploads) {
+    m_skipUpload = true;
+  }
+
+  /* Return with an error if the posted data is garbled */
+  if (!param && !filename) {
+    Logger::Warning("File Upload Mime headers garbled");
+    m_state = Done;
+    return;
+  }
+
+  part.isFile = true;
+  if (!param) {
+    part.isAnonymous = true;
+    param = (char*)malloc(MAX_SIZE_ANONNAME);
+    snprintf(param, MAX_SIZE_ANONNAME, "%u", m_anonIndex++);
+  }
+  part.name = param;
+  part.filename = filename;
+  free(param);
+  free(filename);
+
+  /* New Rule: never repair potential malicious user input */
+  if (!m_skipUpload) {
+    const char *tmp = part.name.c_str();
+    long c = 0;
+
+    while (*tmp) {
+      if (*tmp == '[') {
+        c++;
+      } else if (*tmp == ']') {
+        c--;
+        if (tmp[1] && tmp[1] != '[') {
+          m_skipUpload = true;
+          break;
+        }
       }
-      if (!is_anonymous) {
-        safe_php_register_variable(lbuf, file_size, globals, 0);
+      if (c < 0) {
+        m_skipUpload = true;
+        break;
       }
+      tmp++;
+    }
+  }
+  if (m_skipUpload) return;
 
-      /* Add $foo[size] */
-      if (is_arr_upload) {
-        snprintf(lbuf, llen, "%s[size][%s]",
-                 abuf.c_str(), array_index.c_str());
-      } else {
-        snprintf(lbuf, llen, "%s[size]", param);
-      }
-      safe_php_register_variable(lbuf, file_size, files, 0);
-      free(param);
+  if ((cd = php_mime_get_hdr_value(header, "Content-Type"))) {
+    /* fix for Opera 6.01 */
+    part.type = string(cd, strcspn(cd, ";"));
+  }
+
+  if (part.filename.empty()) {
+    Logger::Verbose("No file uploaded");
+    part.error = UPLOAD_ERROR_D;
+  } else {
+    part.file = UploadFilePtr(new UploadFile());
+    UploadWriter::GetInstance().enqueue(UploadWriter::Open, part.file);
+  }
+  m_parts.push_back(part);
+  m_part = m_parts.size() - 1;
+}
+
+void StreamedUpload::append(const char *data, int size) {
+  if (m_part < 0 || size <= 0) return;
+  Part &part = m_parts[m_part];
+  if (!part.isFile) {
+    part.value.append(data, size);
+    return;
+  }
+  if (part.error) return;
+
+  if (RuntimeOption::UploadMaxFileSize > 0 &&
+      part.size + size > RuntimeOption::UploadMaxFileSize) {
+    Logger::Verbose("upload_max_filesize of %ld bytes exceeded - file "
+                    "[%s=%s] not saved",
+                    RuntimeOption::UploadMaxFileSize,
+                    part.name.c_str(), part.filename.c_str());
+    part.error = UPLOAD_ERROR_A;
+  } else if (m_maxFileSize && part.size + size > m_maxFileSize) {
+    Logger::Verbose("MAX_FILE_SIZE of %ld bytes exceeded - "
+                    "file [%s=%s] not saved",
+                    m_maxFileSize, part.name.c_str(), part.filename.c_str());
+    part.error = UPLOAD_ERROR_B;
+  } else {
+    UploadWriter::GetInstance().enqueue(UploadWriter::Write, part.file,
+                                        data, size);
+    part.size += size;
+  }
+}
+
+void StreamedUpload::endPart(bool complete) {
+  if (m_part < 0) return;
+  Part &part = m_parts[m_part];
+  m_part = -1;
+
+  if (!part.isFile) {
+    if (!strcasecmp(part.name.c_str(), "MAX_FILE_SIZE")) {
+      m_maxFileSize = atol(part.value.c_str());
     }
+    return;
   }
-fileupload_done:
-  data = mbuff->post_data;
-  size = mbuff->post_size;
-  if (php_rfc1867_callback != NULL) {
-    multipart_event_end event_end;
 
-    event_end.post_bytes_processed = mbuff->read_post_bytes;
-    php_rfc1867_callback(&s_rfc1867_data->rfc1867ApcData,
-                         MULTIPART_EVENT_END, &event_end, &event_extra_data);
+  if (!part.error && !complete) {
+    Logger::Verbose("Missing mime boundary at the end of the data for "
+                    "file %s", part.filename.c_str());
+    part.error = UPLOAD_ERROR_C;
+  }
+  if (!part.filename.empty() && part.size == 0 && !part.error) {
+    Logger::Verbose("Uploaded file size 0 - file [%s=%s] not saved",
+                    part.name.c_str(), part.filename.c_str());
+    part.error = 5;
   }
-  if (lbuf) free(lbuf);
+  if (part.file) {
+    UploadWriter::GetInstance().enqueue(UploadWriter::Close, part.file,
+                                        NULL, 0, !part.error);
+  }
+}
+
+void StreamedUpload::registerVariables(Variant &post, Variant &files) {
+  s_rfc1867_data->rfc1867ProtectedVariables.clear();
+  s_rfc1867_data->rfc1867UploadedFiles.clear();
+
+  for (unsigned int i = 0; i < m_parts.size(); i++) {
+    Part &part = m_parts[i];
+    char *param = strdup(part.name.c_str()); // normalized in place
+    if (!part.isFile) {
+      String val(part.value.data(), part.value.size(), CopyString);
+      safe_php_register_variable(param, val, post, 0);
+      free(param);
+      continue;
+    }
+
+    // an error from the writer came first, as it stops taking data
+    int error = part.error;
+    int size = 0;
+    string tempFile;
+    if (part.file) {
+      UploadWriter::GetInstance().wait(part.file);
+      if (part.file->error) error = part.file->error;
+      size = part.file->written;
+      tempFile = part.file->tempFile;
+      // removed at the end of the request from now on
+      part.file->tempFile.clear();
+    }
+    if (!error) {
+      s_rfc1867_data->rfc1867UploadedFiles.insert(tempFile);
+    }
+    register_uploaded_file(files, param, (char *)part.filename.c_str(),
+                           error ? "" : part.type.c_str(),
+                           tempFile.c_str(), error, size,
+                           part.isAnonymous);
+    free(param);
+  }
+
   s_rfc1867_data->rfc1867ProtectedVariables.clear();
-  if (mbuff->boundary_next) free(mbuff->boundary_next);
-  if (mbuff->boundary) free(mbuff->boundary);
-  if (mbuff->buffer) free(mbuff->buffer);
-  if (mbuff) free(mbuff);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -19,6 +19,7 @@
 #define __HPHP_UPLOAD_H__
 
 #include <string>
+#include <vector>
 #include <runtime/base/server/transport.h>
 
 namespace HPHP {
@@ -77,6 +78,83 @@ void rfc1867PostHandler(Transport *transport,
 
 bool is_uploaded_file(const std::string filename);
 
+/**
+ * A multipart/form-data POST body parsed while it arrives, from the server's
+ * event loop, with file parts written to temporary files as they come in.
+ * It follows the same rules as rfc1867PostHandler(), which is run on bodies
+ * already in memory instead.
+ *
+ * File IO never happens on the event loop: creating, writing and removing
+ * temporary files is handed over to a writer thread, with a copy of the data.
+ * What that thread has yet to write is kept under Upload.StreamBufferSize by
+ * the server, which stops reading bodies while Backlogged() says so. Big
+ * uploads therefore never sit in memory, however slow the disk.
+ *
+ * Once the whole body is in, the request's worker thread calls
+ * registerVariables() to fill $_POST and $_FILES and to take over the
+ * temporary files, which waits for the writer to catch up first. Whatever it
+ * didn't take is removed by the writer after the destructor.
+ */
+DECLARE_BOOST_TYPES(UploadFile);
+DECLARE_BOOST_TYPES(StreamedUpload);
+class StreamedUpload {
+public:
+  StreamedUpload(const std::string &boundary);
+  ~StreamedUpload();
+
+  /**
+   * Called with each piece of the body, then once with finish() at its end.
+   */
+  void feed(const char *data, int size);
+  void finish();
+
+  void registerVariables(Variant &post, Variant &files);
+
+  /**
+   * Whether the writer thread has Upload.StreamBufferSize bytes or more to
+   * write, of all uploads, so nothing more should be fed for now.
+   */
+  static bool Backlogged();
+
+private:
+  enum State {
+    SeekBoundary, // skipping lines until "--boundary"
+    Headers,      // reading a part's headers until an empty line
+    Body,         // reading a part's body until "\n--boundary"
+    Done          // garbled headers, nothing more is looked at
+  };
+
+  struct Part {
+    Part() : isFile(false), isAnonymous(false), size(0), error(0) {}
+    bool isFile;
+    bool isAnonymous;
+    std::string name;
+    std::string filename;
+    std::string type;
+    std::string value;    // of a form field
+    UploadFilePtr file;   // temporary file, owned by the writer thread
+    int size;             // handed over for writing
+    int error;            // found while parsing; the writer has its own
+  };
+
+  std::string m_boundary;     // "--boundary"
+  std::string m_boundaryNext; // "\n--boundary"
+  State m_state;
+  std::string m_buffer;       // what hasn't been looked at yet
+  std::vector<std::string> m_headers;
+  std::vector<Part> m_parts;
+  int m_part;                 // the one being read, or -1 to skip a body
+  int m_maxFileSize;          // from a MAX_FILE_SIZE form field
+  int m_anonIndex;
+  bool m_skipUpload;
+
+  bool parseLine(int &pos, bool final);
+  bool parseBody(int &pos, bool final);
+  void startPart();
+  void append(const char *data, int size);
+  void endPart(bool complete);
+};
+
 ///////////////////////////////////////////////////////////////////////////////
 }
 #endif // __HPHP_UPLOAD_H__
@@ -175,6 +175,10 @@ void XboxServer::Restart() {
   if (RuntimeOption::XboxServerThreadCount > 0) {
     s_dispatcher = new JobQueueDispatcher<XboxTransport*, XboxWorker>
       (RuntimeOption::XboxServerThreadCount, NULL);
+    SharedThreadPool *pool = Server::GetSharedThreadPool();
+    if (pool) {
+      s_dispatcher->share(pool, Server::XboxServerPool);
+    }
     Logger::Info("xbox server started");
     s_dispatcher->start();
   }
@@ -196,7 +196,7 @@ public:
 private:
   typedef SharedMemoryMap<SharedMemoryString, StoreValue> SharedMap;
   ProcessSharedVariantLock* getLock(CStrRef key) {
-    ssize_t hash = hash_string(key.data(), key.size());
+    ssize_t hash = key->hash();
     return &m_locks[hash % s_lockCount];
   }
   SharedMap *m_vars;
@@ -381,7 +381,7 @@ protected:
   struct StringHash {
     size_t operator()(StringData *s) const {
       ASSERT(s);
-      return hash_string(s->data(), s->size());
+      return s->hash();
     }
   };
 
@@ -548,7 +548,7 @@ private:
   struct StringHash {
     size_t operator()(StringData *s) const {
       ASSERT(s);
-      return hash_string(s->data(), s->size());
+      return s->hash();
     }
   };
 
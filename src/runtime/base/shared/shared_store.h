@@ -24,7 +24,8 @@
 
 #define SHARED_STORE_APPLICATION_CACHE 0
 #define SHARED_STORE_DNS_CACHE 1
-#define MAX_SHARED_STORE 2
+#define SHARED_STORE_SESSION_CACHE 2
+#define MAX_SHARED_STORE 3
 
 namespace HPHP {
 ///////////////////////////////////////////////////////////////////////////////
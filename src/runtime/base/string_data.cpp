@@ -27,6 +27,7 @@
 #include <runtime/base/runtime_error.h>
 #include <runtime/base/builtin_functions.h>
 #include <runtime/base/tainted_metadata.h>
+#include <runtime/base/memory/memory_manager.h>
 
 namespace HPHP {
 
@@ -276,6 +277,7 @@ void StringData::setChar(int offset, char ch) {
     escalate();
   }
   ((char*)m_data)[offset] = ch;
+  m_hash = 0;
 }
 
 void StringData::removeChar(int offset) {
@@ -306,6 +308,7 @@ void StringData::inc() {
   if (empty()) {
     m_len = (IsLiteral | 1);
     m_data = "1";
+    m_hash = 0;
     return;
   }
   if (isImmutable()) {
@@ -314,6 +317,8 @@ void StringData::inc() {
   char *overflowed = increment_string((char *)m_data, size());
   if (overflowed) {
     assign(overflowed, AttachString);
+  } else {
+    m_hash = 0;
   }
 }
 
@@ -325,6 +330,7 @@ void StringData::negate() {
   for (int i = 0; i < len; i++) {
     buf[i] = ~(buf[i]);
   }
+  m_hash = 0;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -504,6 +510,10 @@ void StringData::restore(const char *&data) {
 }
 
 void StringData::sweep() {
+  if (isMalloced()) {
+    MemoryManager::TheMemoryManager()->reclaim((void*)m_data);
+    m_data = NULL;
+  }
   releaseData();
 }
 
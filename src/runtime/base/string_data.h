@@ -66,12 +66,7 @@ class StringData {
   void setStatic() const {
     _count = (1 << 30);
     ASSERT(!isShared()); // because we are gonna reuse the space!
-    m_hash = hash_string(data(), size());
-    ASSERT(m_hash >= 0);
-    int64 res;
-    if (is_strictly_integer(m_data, (m_len & LenMask), res)) {
-      m_hash |= (1ull << 63);
-    }
+    computeHash();
   }
   bool isStatic() const { return _count == (1 << 30); }
 
@@ -128,7 +123,7 @@ class StringData {
   bool isNumeric() const;
   bool isInteger() const;
   bool isStrictlyInteger(int64 &res) {
-    if (isStatic() && m_hash >= 0) return false;
+    if (!isShared() && m_hash > 0) return false; // see computeHash()
     return is_strictly_integer(m_data, (m_len & LenMask), res);
   }
   bool isZero() const { return size() == 1 && m_data[0] == '0'; }
@@ -171,12 +166,9 @@ class StringData {
   }
 
   int64 hash() const {
-    if (isStatic()) return getPrecomputedHash();
     if (isShared()) return getSharedStringHash();
-    if (m_hash == 0) {
-      m_hash = hash_string(data(), size());
-    }
-    return m_hash;
+    if (m_hash == 0) computeHash();
+    return getPrecomputedHash();
   }
 
   bool same(const StringData *s) const {
@@ -222,7 +214,7 @@ class StringData {
   mutable unsigned int m_len;
   union {
     SharedVariant *m_shared;
-    mutable int64  m_hash;   // precompute hash codes for static strings
+    mutable int64  m_hash;   // cached hash code, 0 until computed
   };
   #ifdef TAINTED
   bitstring m_tainting;
@@ -242,6 +234,24 @@ class StringData {
 
   int64 getSharedStringHash() const;
 
+  /**
+   * Any string that isn't shared caches its hash code, which is reset by
+   * whatever modifies the string. The top bit, which a hash code never has,
+   * is set if the string is an integer, so array lookups and assignments
+   * don't check again whether it should be converted to one. It's stored
+   * only once it's complete, as static strings are read by all threads.
+   */
+  void computeHash() const {
+    ASSERT(!isShared());
+    int64 h = hash_string(data(), size());
+    ASSERT(h >= 0);
+    int64 res;
+    if (is_strictly_integer(m_data, (m_len & LenMask), res)) {
+      h |= (1ull << 63);
+    }
+    m_hash = h;
+  }
+
 #ifdef FAST_REFCOUNT_FOR_VARIANT
  private:
   static void compileTimeAssertions() {
@@ -617,7 +617,13 @@ void String::unserialize(std::istream &in,
   char *buf = (char*)malloc(size + 1);
   in.read(buf, size);
   buf[size] = '\0';
-  SmartPtr<StringData>::operator=(NEW(StringData)(buf, size, AttachString));
+  StringData *sd = StaticString::Lookup(buf, size);
+  if (sd) {
+    free(buf);
+    SmartPtr<StringData>::operator=(sd);
+  } else {
+    SmartPtr<StringData>::operator=(NEW(StringData)(buf, size, AttachString));
+  }
 
   in >> ch;
   if (ch != delimiter1) {
@@ -757,5 +763,87 @@ void StaticString::init(litstr s, int length) {
 
 StringDataSet StaticString::s_stringSet;
 
+///////////////////////////////////////////////////////////////////////////////
+// interned strings
+
+class StaticString::Table {
+public:
+  Table(const Table *old, const StringDataSet &set) {
+    std::vector<StringData *> strings;
+    if (old) {
+      for (unsigned int i = 0; i < old->m_entries.size(); i++) {
+        if (old->m_entries[i].sd) strings.push_back(old->m_entries[i].sd);
+      }
+    }
+    for (StringDataSet::const_iterator iter = set.begin(); iter != set.end();
+         ++iter) {
+      if ((*iter)->size() <= MaxInternLength) strings.push_back(*iter);
+    }
+
+    // at most half full, so probing sequences stay short
+    int capacity = 16;
+    while (capacity < (int)strings.size() * 2) capacity <<= 1;
+    m_mask = capacity - 1;
+    Entry empty = { 0, NULL };
+    m_entries.resize(capacity, empty);
+    for (unsigned int i = 0; i < strings.size(); i++) {
+      StringData *sd = strings[i];
+      int64 hash = hash_string(sd->data(), sd->size());
+      if (find(sd->data(), sd->size(), hash)) continue;
+      int pos = hash & m_mask;
+      while (m_entries[pos].sd) pos = (pos + 1) & m_mask;
+      m_entries[pos].hash = hash;
+      m_entries[pos].sd = sd;
+    }
+  }
+
+  StringData *find(const char *s, int len, int64 hash) const {
+    for (int pos = hash & m_mask; ; pos = (pos + 1) & m_mask) {
+      const Entry &e = m_entries[pos];
+      if (!e.sd) return NULL;
+      if (e.hash == hash && e.sd->size() == len &&
+          memcmp(e.sd->data(), s, len) == 0) {
+        return e.sd;
+      }
+    }
+  }
+
+private:
+  struct Entry {
+    int64 hash;
+    StringData *sd;
+  };
+  std::vector<Entry> m_entries;
+  int m_mask;
+};
+
+StaticString::Table * volatile StaticString::s_table = NULL;
+
+void StaticString::FinishInit() {
+  // Called more than once when more static strings are created after the
+  // generated ones, so earlier tables are merged in. They aren't freed, in
+  // case some other thread is still reading them.
+  Table *table = new Table(s_table, s_stringSet);
+  __sync_synchronize();
+  s_table = table;
+
+  // release the memory
+  StringDataSet empty;
+  s_stringSet.swap(empty);
+}
+
+StringData *StaticString::Lookup(const char *s, int len) {
+  ASSERT(s);
+  Table *table = s_table;
+  if (table == NULL || len > MaxInternLength) return NULL;
+  return table->find(s, len, hash_string(s, len));
+}
+
+String StaticString::Intern(const char *s, int len) {
+  StringData *sd = Lookup(s, len);
+  if (sd) return sd;
+  return String(s, len, CopyString);
+}
+
 //////////////////////////////////////////////////////////////////////////////
 }
@@ -394,16 +394,25 @@ public:
   StaticString& operator=(const StaticString &str);
 
   static StringDataSet &TheStaticStringSet() { return s_stringSet; }
-  static void FinishInit() {
-    // release the memory
-    StringDataSet empty;
-    s_stringSet.swap(empty);
-  }
+  static void FinishInit();
+
+  /**
+   * Short static strings, compiled literals included, are put into a table
+   * by FinishInit(), so strings built at runtime can share them. The table
+   * never changes afterwards, so any thread can look it up without locking.
+   * Lookup() returns NULL if s isn't in there, and Intern() a copy of it.
+   */
+  static const int MaxInternLength = 64;
+  static StringData *Lookup(const char *s, int len);
+  static String Intern(const char *s, int len);
 
 private:
+  class Table;
+
   void init(litstr s, int length);
   StringData m_data;
   static StringDataSet s_stringSet;
+  static Table * volatile s_table;
 };
 
 extern const StaticString empty_string;
@@ -0,0 +1,156 @@
+/*
+   +----------------------------------------------------------------------+
+   | HipHop for PHP                                                       |
+   +----------------------------------------------------------------------+
+   | Copyright (c) 2010 Facebook, Inc. (http://www.facebook.com)          |
+   +----------------------------------------------------------------------+
+   | This source file is subject to version 3.01 of the PHP license,      |
+   | that is bundled with this package in the file LICENSE, and is        |
+   | available through the world-wide-web at the following url:          |
+   | http://www.php.net/license/3_01.txt                                  |
+   | If you did not receive a copy of the PHP license and are unable to   |
+   | obtain it through the world-wide-web, please send a note to          |
+   | license@php.net so we can mail you a copy immediately.               |
+   +----------------------------------------------------------------------+
+*/
+
+#include <runtime/base/util/chunked_buffer.h>
+#include <runtime/base/util/alloc.h>
+#include <util/thread_local.h>
+
+namespace HPHP {
+///////////////////////////////////////////////////////////////////////////////
+
+class ChunkPool {
+public:
+  ~ChunkPool() {
+    for (unsigned int i = 0; i < m_free.size(); i++) {
+      free(m_free[i]);
+    }
+  }
+
+  char *get() {
+    if (m_free.empty()) {
+      return (char *)Util::safe_malloc(ChunkedBuffer::ChunkSize);
+    }
+    char *chunk = m_free.back();
+    m_free.pop_back();
+    return chunk;
+  }
+
+  void put(char *chunk) {
+    if ((int)m_free.size() < ChunkedBuffer::MaxFreeChunks) {
+      m_free.push_back(chunk);
+    } else {
+      free(chunk);
+    }
+  }
+
+private:
+  std::vector<char*> m_free;
+};
+
+static IMPLEMENT_THREAD_LOCAL(ChunkPool, s_chunk_pool);
+
+///////////////////////////////////////////////////////////////////////////////
+
+void ChunkedBuffer::append(const char *s, int len) {
+  ASSERT(len >= 0);
+  m_size += len;
+  while (len > 0) {
+    if (m_chunks.empty() || m_chunks.back().len == ChunkSize - 1) {
+      Chunk c;
+      c.data = s_chunk_pool->get();
+      c.len = 0;
+      m_chunks.push_back(c);
+    }
+    Chunk &c = m_chunks.back();
+    int n = ChunkSize - 1 - c.len;
+    if (n > len) n = len;
+    memcpy(c.data + c.len, s, n);
+    c.len += n;
+    s += n;
+    len -= n;
+  }
+}
+
+void ChunkedBuffer::absorb(ChunkedBuffer &buf) {
+  if (buf.empty()) return;
+  if (empty()) {
+    reset();
+    m_chunks.swap(buf.m_chunks);
+    m_size = buf.m_size;
+    buf.m_size = 0;
+    return;
+  }
+  if (buf.m_chunks.size() == 1 &&
+      buf.m_size <= ChunkSize - 1 - m_chunks.back().len) {
+    // cheaper to copy a little than to leave a gap
+    append(buf.m_chunks[0].data, buf.m_size);
+    buf.reset();
+    return;
+  }
+  for (unsigned int i = 0; i < buf.m_chunks.size(); i++) {
+    if (buf.m_chunks[i].len) {
+      m_chunks.push_back(buf.m_chunks[i]);
+    } else {
+      s_chunk_pool->put(buf.m_chunks[i].data);
+    }
+  }
+  m_size += buf.m_size;
+  buf.m_chunks.clear();
+  buf.m_size = 0;
+}
+
+String ChunkedBuffer::detach() {
+  if (empty()) {
+    reset();
+    return String("");
+  }
+  if (m_chunks.size() == 1 && m_size >= ChunkSize / 4) {
+    // small ones are copied, so a short string won't hold on to a chunk
+    char *data = m_chunks[0].data;
+    data[m_size] = '\0';
+    String ret(data, m_size, AttachString);
+    m_chunks.clear();
+    m_size = 0;
+    return ret;
+  }
+  char *data = (char *)Util::safe_malloc(m_size + 1);
+  copyTo(data);
+  data[m_size] = '\0';
+  String ret(data, m_size, AttachString);
+  reset();
+  return ret;
+}
+
+String ChunkedBuffer::copy() const {
+  if (empty()) {
+    return String("");
+  }
+  if (m_chunks.size() == 1) {
+    return String(m_chunks[0].data, m_size, CopyString);
+  }
+  char *data = (char *)Util::safe_malloc(m_size + 1);
+  copyTo(data);
+  data[m_size] = '\0';
+  return String(data, m_size, AttachString);
+}
+
+void ChunkedBuffer::reset() {
+  for (unsigned int i = 0; i < m_chunks.size(); i++) {
+    s_chunk_pool->put(m_chunks[i].data);
+  }
+  m_chunks.clear();
+  m_size = 0;
+}
+
+void ChunkedBuffer::copyTo(char *buf) const {
+  for (unsigned int i = 0; i < m_chunks.size(); i++) {
+    memcpy(buf, m_chunks[i].data, m_chunks[i].len);
+    buf += m_chunks[i].len;
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+}
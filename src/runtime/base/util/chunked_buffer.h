@@ -0,0 +1,93 @@
+/*
+   +----------------------------------------------------------------------+
+   | HipHop for PHP                                                       |
+   +----------------------------------------------------------------------+
+   | Copyright (c) 2010 Facebook, Inc. (http://www.facebook.com)          |
+   +----------------------------------------------------------------------+
+   | This source file is subject to version 3.01 of the PHP license,      |
+   | that is bundled with this package in the file LICENSE, and is        |
+   | available through the world-wide-web at the following url:          |
+   | http://www.php.net/license/3_01.txt                                  |
+   | If you did not receive a copy of the PHP license and are unable to   |
+   | obtain it through the world-wide-web, please send a note to          |
+   | license@php.net so we can mail you a copy immediately.               |
+   +----------------------------------------------------------------------+
+*/
+
+#ifndef __HPHP_CHUNKED_BUFFER_H__
+#define __HPHP_CHUNKED_BUFFER_H__
+
+#include <runtime/base/types.h>
+#include <runtime/base/complex_types.h>
+
+namespace HPHP {
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * A string buffer made of fixed size chunks, for output buffering. Unlike
+ * StringBuffer, it never reallocates or moves what's been written, and one
+ * buffer can take over another's chunks without copying them.
+ *
+ * Chunks are recycled through a per-thread free list, so a worker thread
+ * stops calling malloc() for output after its first few requests.
+ */
+class ChunkedBuffer {
+public:
+  enum {
+    ChunkSize = 32 * 1024, // including one byte for the trailing NUL
+    MaxFreeChunks = 64,    // per thread
+  };
+
+  ChunkedBuffer() : m_size(0) {}
+  ~ChunkedBuffer() { reset();}
+
+  bool empty() const { return m_size == 0;}
+  int size() const { return m_size;}
+
+  int chunkCount() const { return m_chunks.size();}
+  const char *chunkData(int i) const { return m_chunks[i].data;}
+  int chunkSize(int i) const { return m_chunks[i].len;}
+
+  void append(const char *s, int len);
+  void append(CStrRef s) { append(s.data(), s.size());}
+
+  /**
+   * Move all of buf's chunks to the end of this buffer and reset buf.
+   */
+  void absorb(ChunkedBuffer &buf);
+
+  /**
+   * Yield what's written as a String and reset the buffer. A buffer that
+   * fits in one chunk hands that chunk over, so it isn't copied.
+   */
+  String detach();
+  String copy() const;
+
+  /**
+   * Return all chunks to the free list.
+   */
+  void reset();
+
+private:
+  struct Chunk {
+    char *data;
+    int len;
+  };
+
+  std::vector<Chunk> m_chunks;
+  int m_size;
+
+  // disabling copy constructor and assignment
+  ChunkedBuffer(const ChunkedBuffer &b) { ASSERT(false);}
+  ChunkedBuffer &operator=(const ChunkedBuffer &b) {
+    ASSERT(false);
+    return *this;
+  }
+
+  void copyTo(char *buf) const;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+}
+
+#endif // __HPHP_CHUNKED_BUFFER_H__
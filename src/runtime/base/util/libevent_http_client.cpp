@@ -17,9 +17,11 @@
 #include <runtime/base/util/libevent_http_client.h>
 #include <runtime/base/server/server_stats.h>
 #include <runtime/base/runtime_option.h>
+#include <runtime/base/util/exceptions.h>
+#include <util/async_func.h>
 #include <util/compression.h>
 #include <util/logger.h>
-#include <util/timer.h>
+#include <util/process.h>
 
 using namespace std;
 using namespace boost;
@@ -42,11 +44,115 @@ static void on_connection_closed(struct evhttp_connection *conn, void *obj) {
   ((HPHP::LibEventHttpClient*)obj)->onConnectionClosed();
 }
 
-static void timer_callback(int fd, short events, void *context) {
-  event_base_loopbreak((struct event_base *)context);
+static void on_timeout(int fd, short events, void *obj) {
+  ASSERT(obj);
+  ((HPHP::LibEventHttpClient*)obj)->onTimeout();
 }
 
 namespace HPHP {
+///////////////////////////////////////////////////////////////////////////////
+// event loop threads
+
+/**
+ * An event loop thread that clients make their requests on. Other threads
+ * queue up work and write to a pipe to wake it up, the same way workers hand
+ * responses back to LibEventServer.
+ */
+class LibEventHttpLoop {
+public:
+  LibEventHttpLoop() : m_thread(this, &LibEventHttpLoop::run) {
+    m_eventBase = event_base_new();
+    if (!m_ready.open()) {
+      throw FatalErrorException("unable to create pipe for evhttp client");
+    }
+    event_set(&m_event, m_ready.getOut(), EV_READ|EV_PERSIST, OnReady, this);
+    event_base_set(m_eventBase, &m_event);
+    event_add(&m_event, NULL);
+    m_thread.start();
+  }
+
+  event_base *getEventBase() { return m_eventBase;}
+
+  /**
+   * Have the loop thread call client->sendImpl(), or client->closeImpl().
+   */
+  void post(LibEventHttpClient *client, bool close) {
+    {
+      Lock lock(m_mutex);
+      m_tasks.push_back(Task(client, close));
+    }
+    if (write(m_ready.getIn(), &client, 1) < 0) {
+      // an error occured but nothing we can really do
+    }
+  }
+
+  void run() {
+    event_base_dispatch(m_eventBase);
+  }
+
+  void process() {
+    // clean up the pipe for next signals
+    char buf[512];
+    if (read(m_ready.getOut(), buf, sizeof(buf)) < 0) {
+      // an error occured but nothing we can really do
+    }
+
+    std::deque<Task> tasks;
+    {
+      Lock lock(m_mutex);
+      tasks.swap(m_tasks);
+    }
+    for (unsigned int i = 0; i < tasks.size(); i++) {
+      if (tasks[i].second) {
+        tasks[i].first->closeImpl();
+      } else {
+        tasks[i].first->sendImpl();
+      }
+    }
+  }
+
+  static void OnReady(int fd, short events, void *obj) {
+    ((LibEventHttpLoop*)obj)->process();
+  }
+
+  /**
+   * Picks a loop for a new client, starting them up the first time.
+   */
+  static LibEventHttpLoop *Get() {
+    static Mutex s_mutex;
+    static LibEventHttpLoop ** volatile s_loops = NULL;
+    static int s_count = 0;
+    static int s_next = 0;
+
+    if (s_loops == NULL) {
+      Lock lock(s_mutex);
+      if (s_loops == NULL) {
+        int count = RuntimeOption::HttpClientThreadCount;
+        if (count <= 0) count = 1;
+        LibEventHttpLoop **loops = new LibEventHttpLoop*[count];
+        for (int i = 0; i < count; i++) {
+          loops[i] = new LibEventHttpLoop();
+        }
+        s_count = count;
+        __sync_synchronize();
+        s_loops = loops;
+      }
+    }
+    unsigned int next = __sync_fetch_and_add(&s_next, 1);
+    return s_loops[next % s_count];
+  }
+
+private:
+  typedef std::pair<LibEventHttpClient*, bool> Task;
+
+  event_base *m_eventBase;
+  event m_event;
+  CPipe m_ready;
+  Mutex m_mutex;
+  std::deque<Task> m_tasks;
+  AsyncFunc<LibEventHttpLoop> m_thread;
+};
+
 ///////////////////////////////////////////////////////////////////////////////
 // connection pooling
 
@@ -59,92 +165,144 @@ static std::string get_hash(const std::string &address, int port) {
   return hash;
 }
 
-ReadWriteMutex LibEventHttpClient::ConnectionPoolMutex;
-std::map<std::string, int> LibEventHttpClient::ConnectionPoolConfig;
-std::map<std::string, LibEventHttpClientPtrVec>
-  LibEventHttpClient::ConnectionPool;
+/**
+ * Pooled clients of one address:port. Each slot is claimed and given back
+ * with a compare-and-swap on its state, so Get() and release() never lock.
+ * Only SetCache() takes a mutex, to publish a new copy of the map of pools.
+ * Replaced maps and pools are never freed, as Get() may still be reading
+ * them, but there is at most one per SetCache() call that grows a pool.
+ */
+class LibEventHttpClient::Pool {
+public:
+  enum SlotState {
+    Empty,
+    Free,
+    Busy,
+  };
+
+  struct Slot {
+    Slot() : state(Empty) {}
+    volatile int state;
+    LibEventHttpClientPtr client;
+  };
+
+  Pool(int size) : maxConnection(size), slots(size) {}
+
+  volatile int maxConnection; // can be lowered, never above slots.size()
+  std::vector<Slot> slots;
+
+  typedef hphp_string_map<Pool*> Map;
+  static Mutex s_mutex;
+  static Map * volatile s_pools;
+
+  static Pool *Find(const std::string &hash) {
+    Map *pools = s_pools;
+    if (pools) {
+      Map::const_iterator iter = pools->find(hash);
+      if (iter != pools->end()) {
+        return iter->second;
+      }
+    }
+    return NULL;
+  }
+};
+
+Mutex LibEventHttpClient::Pool::s_mutex;
+LibEventHttpClient::Pool::Map * volatile LibEventHttpClient::Pool::s_pools;
 
 void LibEventHttpClient::SetCache(const std::string &address, int port,
                                   int maxConnection) {
   string hash = get_hash(address, port);
+  if (maxConnection < 0) maxConnection = 0;
 
-  WriteLock lock(ConnectionPoolMutex);
-  if (maxConnection > 0) {
-    ConnectionPoolConfig[hash] = maxConnection;
-  } else {
-    ConnectionPoolConfig.erase(hash);
+  Lock lock(Pool::s_mutex);
+  Pool *pool = Pool::Find(hash);
+  if (pool && maxConnection <= (int)pool->slots.size()) {
+    pool->maxConnection = maxConnection;
+    return;
+  }
+  if (maxConnection == 0) {
+    return;
   }
+
+  Pool::Map *pools =
+    Pool::s_pools ? new Pool::Map(*Pool::s_pools) : new Pool::Map();
+  (*pools)[hash] = new Pool(maxConnection);
+  __sync_synchronize();
+  Pool::s_pools = pools;
 }
 
 LibEventHttpClientPtr LibEventHttpClient::Get(const std::string &address,
                                               int port) {
   string hash = get_hash(address, port);
 
-  int maxConnection = 0;
-  {
-    ReadLock lock(ConnectionPoolMutex);
-    map<string, int>::const_iterator iter = ConnectionPoolConfig.find(hash);
-    if (iter == ConnectionPoolConfig.end()) {
-      // not configured to cache
-      ServerStats::Log("evhttp.skip", 1);
-      ServerStats::Log("evhttp.skip." + hash, 1);
-      return LibEventHttpClientPtr(new LibEventHttpClient(address, port));
-    }
-    maxConnection = iter->second;
+  Pool *pool = Pool::Find(hash);
+  int maxConnection = pool ? pool->maxConnection : 0;
+  if (maxConnection == 0) {
+    // not configured to cache
+    ServerStats::Log("evhttp.skip", 1);
+    ServerStats::Log("evhttp.skip." + hash, 1);
+    return LibEventHttpClientPtr(new LibEventHttpClient(address, port));
   }
 
-  WriteLock lock(ConnectionPoolMutex);
-  LibEventHttpClientPtrVec &pool = ConnectionPool[hash];
-  for (unsigned int i = 0; i < pool.size(); i++) {
-    LibEventHttpClientPtr client = pool[i];
-    if (!client->m_busy) {
-      client->m_busy = true;
+  for (int i = 0; i < maxConnection; i++) {
+    Pool::Slot &slot = pool->slots[i];
+    if (slot.state == Pool::Free &&
+        __sync_bool_compare_and_swap(&slot.state, Pool::Free, Pool::Busy)) {
       ServerStats::Log("evhttp.hit", 1);
       ServerStats::Log("evhttp.hit." + hash, 1);
-      return client;
+      return slot.client;
     }
   }
 
-  LibEventHttpClientPtr ret(new LibEventHttpClient(address, port));
-  if ((int)pool.size() < maxConnection) {
-    if (pool.empty()) {
-      pool.reserve(maxConnection);
-    }
-    pool.push_back(ret);
-  }
   ServerStats::Log("evhttp.miss", 1);
   ServerStats::Log("evhttp.miss." + hash, 1);
-  return ret;
+  for (int i = 0; i < maxConnection; i++) {
+    Pool::Slot &slot = pool->slots[i];
+    if (slot.state == Pool::Empty &&
+        __sync_bool_compare_and_swap(&slot.state, Pool::Empty, Pool::Busy)) {
+      slot.client = LibEventHttpClientPtr
+        (new LibEventHttpClient(address, port, pool, i));
+      return slot.client;
+    }
+  }
+
+  // all pooled connections are in use
+  ServerStats::Log("evhttp.full", 1);
+  ServerStats::Log("evhttp.full." + hash, 1);
+  return LibEventHttpClientPtr(new LibEventHttpClient(address, port));
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 // constructor and destructor
 
-LibEventHttpClient::LibEventHttpClient(const std::string &address, int port)
-  : m_busy(true), m_address(address), m_port(port), m_requests(0),
-    m_conn(NULL), m_thread(NULL), m_code(0), m_response(NULL), m_len(0) {
-  m_eventBase = event_base_new();
+LibEventHttpClient::LibEventHttpClient(const std::string &address, int port,
+                                       Pool *pool /* = NULL */,
+                                       int slot /* = 0 */)
+  : m_pool(pool), m_slot(slot), m_address(address), m_port(port),
+    m_requests(0), m_conn(NULL), m_connected(false), m_connecting(false),
+    m_request(NULL), m_cmd(EVHTTP_REQ_GET), m_timeout(0), m_pending(false),
+    m_sending(false), m_timer(NULL), m_code(0), m_response(NULL), m_len(0) {
+  m_loop = LibEventHttpLoop::Get();
 }
 
 LibEventHttpClient::~LibEventHttpClient() {
   clear();
 
-  // reset all per-connection data structures
+  // the connection belongs to the event loop, so it's freed over there
   if (m_conn) {
-    evhttp_connection_free(m_conn);
-  }
-  if (m_eventBase) {
-    event_base_free(m_eventBase);
+    Lock lock(this);
+    m_pending = true;
+    m_loop->post(this, true);
+    while (m_pending) {
+      wait();
+    }
   }
 }
 
 void LibEventHttpClient::clear() {
   // reset all per-request data structures
-  if (m_thread) {
-    m_thread->waitForEnd();
-    delete m_thread;
-    m_thread = NULL;
-  }
+  waitForResponse();
   m_url.clear();
   m_code = 0;
   m_codeLine.clear();
@@ -158,7 +316,10 @@ void LibEventHttpClient::clear() {
 
 void LibEventHttpClient::release() {
   clear();
-  m_busy = false;
+  if (m_pool) {
+    __sync_bool_compare_and_swap(&m_pool->slots[m_slot].state,
+                                 Pool::Busy, Pool::Free);
+  }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -211,61 +372,110 @@ bool LibEventHttpClient::send(const std::string &url,
     evbuffer_add(request->output_buffer, data, size);
   }
 
-  // url
-  evhttp_cmd_type cmd = data ? EVHTTP_REQ_POST : EVHTTP_REQ_GET;
+  m_request = request;
+  m_cmd = data ? EVHTTP_REQ_POST : EVHTTP_REQ_GET;
+  m_timeout = timeoutSeconds;
+  m_timer = new SlowTimer(RuntimeOption::HttpSlowQueryThreshold, "evhttp",
+                          m_url.c_str());
+  {
+    Lock lock(this);
+    m_pending = true;
+  }
+  m_loop->post(this, false);
 
-  // if we have a cached connection, we need to pump the event loop to clear
-  // any "connection closed" events that may be sitting there patiently.
-  if (m_conn) {
-    event_base_loop(m_eventBase, EVLOOP_NONBLOCK);
+  if (!async) {
+    IOStatusHelper io("libevent_http", m_address.c_str(), m_port);
+    waitForResponse();
+  }
+  return true;
+}
+
+void LibEventHttpClient::waitForResponse() {
+  Lock lock(this);
+  if (m_pending) {
+    Timer timer(Timer::WallTime);
+    do {
+      wait();
+    } while (m_pending);
+    int64 waited = timer.getMicroSeconds();
+    ServerStats::Log("evhttp.wait", waited);
+    ServerStats::Log("evhttp.wait." + get_hash(m_address, m_port), waited);
+  }
+  if (m_connecting) {
+    m_connecting = false;
+    ServerStats::Log("evhttp.connect", 1);
+    ServerStats::Log("evhttp.connect." + get_hash(m_address, m_port), 1);
   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// on the event loop thread
 
-  // even if we had an m_conn immediately above, it may have been cleared out
-  // by onConnectionClosed().
+void LibEventHttpClient::sendImpl() {
   if (m_conn == NULL) {
     m_conn = evhttp_connection_new(m_address.c_str(), m_port);
     evhttp_connection_set_closecb(m_conn, on_connection_closed, this);
-    evhttp_connection_set_base(m_conn, m_eventBase);
+    evhttp_connection_set_base(m_conn, m_loop->getEventBase());
   }
-
-  int ret = evhttp_make_request(m_conn, request, cmd, url.c_str());
+  // evhttp reconnects by itself if the server closed the connection on us
+  m_connecting = !m_connected;
+  m_connected = true;
+  m_sending = true;
+
+  evhttp_request *request = m_request;
+  m_request = NULL;
+  int ret = evhttp_make_request(m_conn, request, m_cmd, m_url.c_str());
   if (ret != 0) {
     Logger::Error("evhttp_make_request failed");
-    return false;
+    // so the request left queued up won't be sent along with the next one
+    evhttp_connection_free(m_conn);
+    m_conn = NULL;
+    onDone();
+    return;
   }
 
-  if (timeoutSeconds > 0) {
+  if (m_timeout > 0) {
     struct timeval timeout;
-    timeout.tv_sec = timeoutSeconds;
+    timeout.tv_sec = m_timeout;
     timeout.tv_usec = 0;
 
-    event_set(&m_eventTimeout, -1, 0, timer_callback, m_eventBase);
-    event_base_set(m_eventBase, &m_eventTimeout);
+    event_set(&m_eventTimeout, -1, 0, on_timeout, this);
+    event_base_set(m_loop->getEventBase(), &m_eventTimeout);
     event_add(&m_eventTimeout, &timeout);
   }
+}
 
-  if (async) {
-    m_thread = new AsyncFunc<LibEventHttpClient>
-      (this, &LibEventHttpClient::sendImpl);
-    m_thread->start();
-  } else {
-    IOStatusHelper io("libevent_http", m_address.c_str(), m_port);
-    sendImpl();
+void LibEventHttpClient::closeImpl() {
+  if (m_conn) {
+    evhttp_connection_free(m_conn);
+    m_conn = NULL;
   }
-  return true;
+  Lock lock(this);
+  m_pending = false;
+  notify();
 }
 
-void LibEventHttpClient::sendImpl() {
-  SlowTimer timer(RuntimeOption::HttpSlowQueryThreshold, "evhttp",
-                  m_url.c_str());
-  event_base_dispatch(m_eventBase);
-  event_del(&m_eventTimeout);
+void LibEventHttpClient::onDone() {
+  if (m_timeout > 0) {
+    event_del(&m_eventTimeout);
+  }
+  m_sending = false;
+  delete m_timer;
+  m_timer = NULL;
+
+  // the caller may free this object as soon as it wakes up
+  Lock lock(this);
+  m_pending = false;
+  notify();
 }
 
 void LibEventHttpClient::onRequestCompleted(evhttp_request* request) {
+  if (!m_sending) {
+    return;
+  }
   if (!request) {
-    // eek -- this is just a clean-up notification because the connection's
-    // been closed, but we already dealt with it in onConnectionClosed
+    // the connection failed before a response came back
+    onDone();
     return;
   }
 
@@ -303,20 +513,26 @@ void LibEventHttpClient::onRequestCompleted(evhttp_request* request) {
   }
 
   ++m_requests;
-  event_base_loopbreak(m_eventBase);
+  onDone();
 }
 
 void LibEventHttpClient::onConnectionClosed() {
-  m_conn = NULL;
+  m_connected = false;
   m_requests = 0;
 }
 
+void LibEventHttpClient::onTimeout() {
+  // evhttp has no way to cancel a request other than dropping its connection
+  evhttp_connection_free(m_conn);
+  m_conn = NULL;
+  onDone();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// caller's thread again
+
 char *LibEventHttpClient::recv(int &len) {
-  if (m_thread) {
-    m_thread->waitForEnd();
-    delete m_thread;
-    m_thread = NULL;
-  }
+  waitForResponse();
 
   char *ret = m_response;
   len = m_len;
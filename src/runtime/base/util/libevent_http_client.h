@@ -18,21 +18,28 @@
 #define __LIBEVENT_HTTP_CLIENT_H__
 
 #include <util/base.h>
-#include <util/async_func.h>
+#include <util/synchronizable.h>
 #include <util/lock.h>
+#include <util/timer.h>
 #include <evhttp.h>
 
 namespace HPHP {
 ///////////////////////////////////////////////////////////////////////////////
 
+class LibEventHttpLoop;
+
 /**
  * Use evhttp as our HTTP client. This isn't the same as HttpClient that's CURL
  * based. HttpClient supports SSL and follows redirections, whereas this class
  * doesn't. But this class allows keep-alive connections to be pooled for
  * repetitively HTTP requests.
+ *
+ * Requests are all made on a few shared event loop threads. A client sticks
+ * to one of them, so its connection is only ever touched by that thread, and
+ * callers just hand requests over and wait for them to complete.
  */
 DECLARE_BOOST_TYPES(LibEventHttpClient);
-class LibEventHttpClient {
+class LibEventHttpClient : public Synchronizable {
 public:
   /**
    * Specify an address:port to be cached. Set to 0 to clear it.
@@ -46,15 +53,10 @@ public:
   static LibEventHttpClientPtr Get(const std::string &address, int port);
 
 private:
-  static ReadWriteMutex ConnectionPoolMutex;
-  static std::map<std::string, LibEventHttpClientPtrVec> ConnectionPool;
-
-  /**
-   * address:port => max connection to pool
-   */
-  static std::map<std::string, int> ConnectionPoolConfig;
+  class Pool;
 
-  LibEventHttpClient(const std::string &address, int port);
+  LibEventHttpClient(const std::string &address, int port,
+                     Pool *pool = NULL, int slot = 0);
 
 public:
   ~LibEventHttpClient();
@@ -87,21 +89,34 @@ public:
   }
 
 public:
+  // called on the event loop thread
+  void sendImpl();
+  void closeImpl();
+
   // libevent callbacks
   void onRequestCompleted(evhttp_request* request);
   void onConnectionClosed();
+  void onTimeout();
 
 private:
-  bool m_busy;               // telling connection pool this object is in use
+  Pool *m_pool;              // connection pool to release to, if any
+  int m_slot;                // where this object is in m_pool
   std::string m_address;     // server address
   unsigned short m_port;     // server port
   int m_requests;            // number of requests we've sent on this conn.
 
-  event_base *m_eventBase;   // event base
+  LibEventHttpLoop *m_loop;  // event loop this object's requests run on
   evhttp_connection *m_conn; // evhttp connection object
+  bool m_connected;          // whether m_conn still has an open socket
+  bool m_connecting;         // whether the last request opened a new one
   event m_eventTimeout;      // for timeout purpose
 
-  AsyncFunc<LibEventHttpClient> *m_thread; // for async GET/POST
+  evhttp_request *m_request; // next request, until it's handed to evhttp
+  evhttp_cmd_type m_cmd;
+  int m_timeout;             // in seconds
+  bool m_pending;            // until the loop is done with the last send()
+  bool m_sending;            // the loop's own view of the same
+  SlowTimer *m_timer;
 
   std::string m_url;         // most recent URL
   int m_code;                // response code
@@ -110,7 +125,8 @@ private:
   int m_len;                 // final response length
   std::vector<std::string> m_responseHeaders;
 
-  void sendImpl();
+  void waitForResponse();
+  void onDone();
   void clear();
 };
 
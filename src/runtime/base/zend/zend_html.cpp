@@ -18,6 +18,7 @@
 #include <runtime/base/zend/zend_html.h>
 #include <runtime/base/complex_types.h>
 #include <util/lock.h>
+#include <util/byte_scanner.h>
 
 namespace HPHP {
 
@@ -346,6 +347,50 @@ static void init_entity_table() {
 
 ///////////////////////////////////////////////////////////////////////////////
 
+// every byte that string_html_encode() may replace, whatever its flags
+static const ByteScanner s_html_special("\"'<>&\xc2\xa0", 7);
+
+/**
+ * Returns the entity replacing the byte at p, or NULL if that byte is copied
+ * as is. "skip" is set to the number of input bytes the entity stands for.
+ */
+inline static const char *html_entity(const char *p, const char *end,
+                                      bool encode_double_quote,
+                                      bool encode_single_quote,
+                                      bool utf8, bool nbsp,
+                                      int &entity_len, int &skip) {
+  skip = 1;
+  switch (*p) {
+  case '"':
+    if (!encode_double_quote) return NULL;
+    entity_len = 6;
+    return "&quot;";
+  case '\'':
+    if (!encode_single_quote) return NULL;
+    entity_len = 6;
+    return "&#039;";
+  case '<':
+    entity_len = 4;
+    return "&lt;";
+  case '>':
+    entity_len = 4;
+    return "&gt;";
+  case '&':
+    entity_len = 5;
+    return "&amp;";
+  case '\xc2':
+    if (!nbsp || !utf8 || p + 1 >= end || p[1] != '\xa0') return NULL;
+    entity_len = 6;
+    skip = 2;
+    return "&nbsp;";
+  case '\xa0':
+    if (!nbsp || utf8) return NULL;
+    entity_len = 6;
+    return "&nbsp;";
+  }
+  return NULL;
+}
+
 char *string_html_encode(const char *input, int &len, bool encode_double_quote,
                          bool encode_single_quote, bool utf8, bool nbsp) {
   ASSERT(input);
@@ -353,73 +398,51 @@ char *string_html_encode(const char *input, int &len, bool encode_double_quote,
     return NULL;
   }
 
+  // like C strings, input stops at the first NUL
+  const char *end = (const char *)memchr(input, '\0', len);
+  if (!end) end = input + len;
+
   /**
-   * Though seems to be wasting memory a lot, we have to realize most of the
-   * time this function is called with small strings, or fragments of HTMLs.
-   * Allocating/deallocating anything less than 1K is trivial these days, and
-   * we want avoid string copying as much as possible. Of course, the return
-   * char * is really sent back at large, occupying unnessary space for
-   * potentially longer time than we need, we have to realize the two closest
-   * solutions are not that much better, either:
-   *
-   * 1. pre-calculate size by iterating through the string once: too time
-   *    consuming;
-   * 2. take a guess and double buffer size when over: still wasting, and
-   *    it may not save that much.
+   * Most input has few or no bytes to escape, so scanning it twice for
+   * them is cheaper than allocating for the worst case of 6 bytes out for
+   * each byte in.
    */
-  char *ret = (char *)malloc(len * 6 + 1);
+  int size = end - input;
+  int entity_len, skip;
+  for (const char *p = s_html_special.find(input, end); p < end;
+       p = s_html_special.find(p + 1, end)) {
+    if (html_entity(p, end, encode_double_quote, encode_single_quote,
+                    utf8, nbsp, entity_len, skip)) {
+      size += entity_len - skip;
+      p += skip - 1;
+    }
+  }
+
+  char *ret = (char *)malloc(size + 1);
   if (!ret) {
     return NULL;
   }
   char *q = ret;
-  for (const char *p = input; *p; p++) {
-    char c = *p;
-    switch (c) {
-    case '"':
-      if (encode_double_quote) {
-        *q++ = '&'; *q++ = 'q'; *q++ = 'u'; *q++ = 'o'; *q++ = 't'; *q++ = ';';
-      } else {
-        *q++ = c;
-      }
-      break;
-    case '\'':
-      if (encode_single_quote) {
-        *q++ = '&'; *q++ = '#'; *q++ = '0'; *q++ = '3'; *q++ = '9'; *q++ = ';';
-      } else {
-        *q++ = c;
-      }
-      break;
-    case '<':
-      *q++ = '&'; *q++ = 'l'; *q++ = 't'; *q++ = ';';
-      break;
-    case '>':
-      *q++ = '&'; *q++ = 'g'; *q++ = 't'; *q++ = ';';
-      break;
-    case '&':
-      *q++ = '&'; *q++ = 'a'; *q++ = 'm'; *q++ = 'p'; *q++ = ';';
-      break;
-    case '\xc2':
-      if (nbsp && utf8 && *(p+1) == '\xa0') {
-        *q++ = '&'; *q++ = 'n'; *q++ = 'b'; *q++ = 's'; *q++ = 'p'; *q++ = ';';
-        p++;
-      } else {
-        *q++ = c;
-      }
-      break;
-    case '\xa0':
-      if (nbsp && !utf8) {
-        *q++ = '&'; *q++ = 'n'; *q++ = 'b'; *q++ = 's'; *q++ = 'p'; *q++ = ';';
-      } else {
-        *q++ = c;
-      }
-      break;
-    default:
-      *q++ = c;
-      break;
+  const char *copied = input;
+  for (const char *p = s_html_special.find(input, end); p < end;
+       p = s_html_special.find(p + 1, end)) {
+    const char *entity = html_entity(p, end, encode_double_quote,
+                                     encode_single_quote, utf8, nbsp,
+                                     entity_len, skip);
+    if (entity) {
+      memcpy(q, copied, p - copied);
+      q += p - copied;
+      memcpy(q, entity, entity_len);
+      q += entity_len;
+      p += skip - 1;
+      copied = p + 1;
     }
   }
+  memcpy(q, copied, end - copied);
+  q += end - copied;
   *q = 0;
   len = q - ret;
+  ASSERT(len == size);
   return ret;
 }
 
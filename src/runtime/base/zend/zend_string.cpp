@@ -21,6 +21,7 @@
 #include <runtime/base/zend/utf8_to_utf16.h>
 
 #include <util/lock.h>
+#include <util/byte_scanner.h>
 #include <math.h>
 #include <monetary.h>
 
@@ -517,10 +518,9 @@ int string_find(const char *input, int len, char ch, int pos,
     if (!string_substr_check(len, pos, l)) {
       return -1;
     }
-    for (int i = pos; i < len; i++) {
-      if (input[i] == ch) {
-        return i;
-      }
+    const char *p = (const char *)memchr(input + pos, ch, len - pos);
+    if (p) {
+      return p - input;
     }
   }
   return -1;
@@ -583,10 +583,13 @@ int string_find(const char *input, int len, const char *s, int s_len,
     if (!string_substr_check(len, pos, l)) {
       return -1;
     }
-    int i_max = len - s_len + 1;
-    for (int i = pos; i < i_max; i++) {
-      if (input[i] == s[0] && memcmp(input+i, s, s_len) == 0) {
-        return i;
+    // memchr() skips to candidate first bytes many bytes at a time
+    const char *end = input + len - s_len + 1;
+    for (const char *p = input + pos; p < end; p++) {
+      p = (const char *)memchr(p, s[0], end - p);
+      if (!p) break;
+      if (memcmp(p, s, s_len) == 0) {
+        return p - input;
       }
     }
   }
@@ -698,6 +701,12 @@ char *string_replace(const char *s, int &len, int start, int length,
   return ret;
 }
 
+static char *string_replace_found(const char *input, int &len,
+                                  const std::vector<int> &founds,
+                                  int len_search,
+                                  const char *replacement, int len_replace,
+                                  int &count);
+
 char *string_replace(const char *input, int &len,
                      const char *search, int len_search,
                      const char *replacement, int len_replace,
@@ -709,6 +718,26 @@ char *string_replace(const char *input, int &len,
     return NULL;
   }
 
+  if (!case_sensitive) {
+    // lower both sides once instead of once per string_find() call, then
+    // copy the unmatched runs from the original input
+    char *lowered = string_to_lower(input, len);
+    char *lowered_search = string_to_lower(search, len_search);
+    std::vector<int> founds;
+    founds.reserve(16);
+    for (int pos = string_find(lowered, len, lowered_search, len_search, 0,
+                               true);
+         pos >= 0;
+         pos = string_find(lowered, len, lowered_search, len_search,
+                           pos + len_search, true)) {
+      founds.push_back(pos);
+    }
+    free(lowered);
+    free(lowered_search);
+    return string_replace_found(input, len, founds, len_search,
+                                replacement, len_replace, count);
+  }
+
   std::vector<int> founds;
   founds.reserve(16);
   if (len_search == 1) {
@@ -727,7 +756,15 @@ char *string_replace(const char *input, int &len,
       founds.push_back(pos);
     }
   }
+  return string_replace_found(input, len, founds, len_search,
+                              replacement, len_replace, count);
+}
 
+static char *string_replace_found(const char *input, int &len,
+                                  const std::vector<int> &founds,
+                                  int len_search,
+                                  const char *replacement, int len_replace,
+                                  int &count) {
   count = founds.size();
   if (count == 0) {
     return NULL; // not found
@@ -1453,34 +1490,34 @@ char *string_stripcslashes(const char *input, int &nlen) {
   return str;
 }
 
+static const ByteScanner s_slashes_special("\0'\"\\", 4);
+
 char *string_addslashes(const char *str, int &length) {
   ASSERT(str);
   if (length == 0) {
     return NULL;
   }
 
-  char *new_str = (char *)malloc((length << 1) + 1);
   const char *source = str;
   const char *end = source + length;
-  char *target = new_str;
 
-  while (source < end) {
-    switch (*source) {
-    case '\0':
-      *target++ = '\\';
-      *target++ = '0';
-      break;
-    case '\'':
-    case '\"':
-    case '\\':
-      *target++ = '\\';
-      /* break is missing *intentionally* */
-    default:
-      *target++ = *source;
-      break;
-    }
+  // every special byte gains exactly one more byte of output
+  int new_length = length;
+  for (const char *p = s_slashes_special.find(source, end); p < end;
+       p = s_slashes_special.find(p + 1, end)) {
+    new_length++;
+  }
 
-    source++;
+  char *new_str = (char *)malloc(new_length + 1);
+  char *target = new_str;
+  while (source < end) {
+    const char *p = s_slashes_special.find(source, end);
+    memcpy(target, source, p - source);
+    target += p - source;
+    if (p == end) break;
+    *target++ = '\\';
+    *target++ = *p ? *p : '0';
+    source = p + 1;
   }
 
   *target = 0;
@@ -16,7 +16,9 @@
 
 #include <runtime/eval/ast/assignment_op_expression.h>
 #include <runtime/eval/ast/lval_expression.h>
+#include <runtime/eval/ast/variable_expression.h>
 #include <runtime/eval/parser/hphp.tab.hpp>
+#include <runtime/eval/bytecode/byte_code_program.h>
 
 namespace HPHP {
 namespace Eval {
@@ -33,6 +35,29 @@ Variant AssignmentOpExpression::eval(VariableEnvironment &env) const {
   return m_lhs->setOp(env, m_op, rhs);
 }
 
+int AssignmentOpExpression::byteCode(ByteCodeProgram &code, int dst) const {
+  const VariableExpression *var =
+    dynamic_cast<const VariableExpression*>(m_lhs.get());
+  if (!var || var->getIdx() == -1) {
+    return Expression::byteCode(code, dst);
+  }
+  int lhs = code.lvalue(var->getIdx());
+  if (m_op == '=') {
+    m_rhs->byteCode(code, lhs);
+    return code.place(lhs, dst);
+  }
+  int rhs = m_rhs->byteCode(code, ByteCodeProgram::AnyReg);
+  ByteCodeProgram::OpCode op;
+  switch (m_op) {
+  case T_PLUS_EQUAL:   op = ByteCodeProgram::AddTo;    break;
+  case T_MINUS_EQUAL:  op = ByteCodeProgram::SubTo;    break;
+  case T_CONCAT_EQUAL: op = ByteCodeProgram::ConcatTo; break;
+  default:             op = ByteCodeProgram::SetOp;    break;
+  }
+  code.emit(op, dst, lhs, rhs, -1, m_lhs.get(), m_op);
+  return dst >= 0 ? dst : lhs;
+}
+
 void AssignmentOpExpression::dump() const {
   m_lhs->dump();
   const char* op = "<bad op>";
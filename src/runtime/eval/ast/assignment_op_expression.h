@@ -32,6 +32,7 @@ public:
                          ExpressionPtr rhs);
   virtual Variant eval(VariableEnvironment &env) const;
   virtual Variant refval(VariableEnvironment &env, int strict = 2) const;
+  virtual int byteCode(ByteCodeProgram &code, int dst) const;
   LvalExpressionPtr getLhs() const { return m_lhs; }
   ExpressionPtr getRhs() const { return m_rhs; }
   virtual void dump() const;
@@ -16,6 +16,7 @@
 
 #include <runtime/eval/ast/binary_op_expression.h>
 #include <runtime/eval/parser/hphp.tab.hpp>
+#include <runtime/eval/bytecode/byte_code_program.h>
 
 namespace HPHP {
 namespace Eval {
@@ -67,6 +68,97 @@ Variant BinaryOpExpression::eval(VariableEnvironment &env) const {
   }
 }
 
+int BinaryOpExpression::byteCode(ByteCodeProgram &code, int dst) const {
+  ByteCodeProgram::OpCode op;
+  switch (m_op) {
+  case T_LOGICAL_OR:
+  case T_BOOLEAN_OR:
+  case T_LOGICAL_AND:
+  case T_BOOLEAN_AND:
+    {
+      int reg = code.target(dst);
+      int falseLabel = code.newLabel();
+      int end = code.newLabel();
+      byteCodeBranch(code, falseLabel, false);
+      code.emit(ByteCodeProgram::Move, reg, code.constant(true));
+      code.emit(ByteCodeProgram::Jump, -1, -1, -1, end);
+      code.bind(falseLabel);
+      code.emit(ByteCodeProgram::Move, reg, code.constant(false));
+      code.bind(end);
+      return reg;
+    }
+  case T_LOGICAL_XOR:         op = ByteCodeProgram::Xor;    break;
+  case '|':                   op = ByteCodeProgram::BitOr;  break;
+  case '&':                   op = ByteCodeProgram::BitAnd; break;
+  case '^':                   op = ByteCodeProgram::BitXor; break;
+  case '.':                   op = ByteCodeProgram::Concat; break;
+  case '+':                   op = ByteCodeProgram::Add;    break;
+  case '-':                   op = ByteCodeProgram::Sub;    break;
+  case '*':                   op = ByteCodeProgram::Mul;    break;
+  case '/':                   op = ByteCodeProgram::Div;    break;
+  case '%':                   op = ByteCodeProgram::Mod;    break;
+  case T_SL:                  op = ByteCodeProgram::Shl;    break;
+  case T_SR:                  op = ByteCodeProgram::Shr;    break;
+  case T_IS_IDENTICAL:        op = ByteCodeProgram::Same;   break;
+  case T_IS_NOT_IDENTICAL:    op = ByteCodeProgram::NSame;  break;
+  case T_IS_EQUAL:            op = ByteCodeProgram::Eq;     break;
+  case T_IS_NOT_EQUAL:        op = ByteCodeProgram::NEq;    break;
+  case '<':                   op = ByteCodeProgram::Lt;     break;
+  case T_IS_SMALLER_OR_EQUAL: op = ByteCodeProgram::Le;     break;
+  case '>':                   op = ByteCodeProgram::Gt;     break;
+  case T_IS_GREATER_OR_EQUAL: op = ByteCodeProgram::Ge;     break;
+  default:
+    return Expression::byteCode(code, dst);
+  }
+  int a = code.stable(m_exp1->byteCode(code, ByteCodeProgram::AnyReg),
+                      m_exp2.get());
+  int b = m_exp2->byteCode(code, ByteCodeProgram::AnyReg);
+  int reg = code.target(dst);
+  code.emit(op, reg, a, b);
+  return reg;
+}
+
+void BinaryOpExpression::byteCodeBranch(ByteCodeProgram &code, int label,
+                                        bool jumpIf) const {
+  ByteCodeProgram::OpCode op;
+  switch (m_op) {
+  case T_LOGICAL_AND:
+  case T_BOOLEAN_AND:
+  case T_LOGICAL_OR:
+  case T_BOOLEAN_OR:
+    {
+      // "a && b" jumps when both are true, or falls through at the first
+      // false one, and "a || b" is the other way around
+      bool isAnd = (m_op == T_LOGICAL_AND || m_op == T_BOOLEAN_AND);
+      if (jumpIf == isAnd) {
+        int skip = code.newLabel();
+        m_exp1->byteCodeBranch(code, skip, !isAnd);
+        m_exp2->byteCodeBranch(code, label, isAnd);
+        code.bind(skip);
+      } else {
+        m_exp1->byteCodeBranch(code, label, jumpIf);
+        m_exp2->byteCodeBranch(code, label, jumpIf);
+      }
+      return;
+    }
+  case T_IS_IDENTICAL:        op = ByteCodeProgram::JumpSame;  break;
+  case T_IS_NOT_IDENTICAL:    op = ByteCodeProgram::JumpNSame; break;
+  case T_IS_EQUAL:            op = ByteCodeProgram::JumpEq;    break;
+  case T_IS_NOT_EQUAL:        op = ByteCodeProgram::JumpNEq;   break;
+  case '<':                   op = ByteCodeProgram::JumpLt;    break;
+  case T_IS_SMALLER_OR_EQUAL: op = ByteCodeProgram::JumpLe;    break;
+  case '>':                   op = ByteCodeProgram::JumpGt;    break;
+  case T_IS_GREATER_OR_EQUAL: op = ByteCodeProgram::JumpGe;    break;
+  default:
+    Expression::byteCodeBranch(code, label, jumpIf);
+    return;
+  }
+  int a = code.stable(m_exp1->byteCode(code, ByteCodeProgram::AnyReg),
+                      m_exp2.get());
+  int b = m_exp2->byteCode(code, ByteCodeProgram::AnyReg);
+  code.emit(op, -1, a, b, label, NULL, jumpIf);
+}
+
 void BinaryOpExpression::dump() const {
   m_exp1->dump();
   const char* op = "<bad op>";
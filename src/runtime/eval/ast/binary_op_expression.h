@@ -30,6 +30,9 @@ public:
   BinaryOpExpression(EXPRESSION_ARGS, ExpressionPtr exp1, int op,
                      ExpressionPtr exp2);
   virtual Variant eval(VariableEnvironment &env) const;
+  virtual int byteCode(ByteCodeProgram &code, int dst) const;
+  virtual void byteCodeBranch(ByteCodeProgram &code, int label,
+                              bool jumpIf) const;
   virtual void dump() const;
 private:
   ExpressionPtr m_exp1;
@@ -15,8 +15,9 @@
 */
 
 #include <runtime/eval/ast/break_statement.h>
-#include <runtime/eval/ast/expression.h>
+#include <runtime/eval/ast/scalar_expression.h>
 #include <runtime/eval/runtime/variable_environment.h>
+#include <runtime/eval/bytecode/byte_code_program.h>
 
 namespace HPHP {
 namespace Eval {
@@ -38,6 +39,21 @@ void BreakStatement::eval(VariableEnvironment &env) const {
   }
 }
 
+void BreakStatement::byteCode(ByteCodeProgram &code) const {
+  int64 level = 1;
+  if (m_level) {
+    const ScalarExpression *s =
+      dynamic_cast<const ScalarExpression*>(m_level.get());
+    if (!s) {
+      Statement::byteCode(code);
+      return;
+    }
+    level = s->getValue().toInt64();
+  }
+  code.emitLine(this);
+  code.emitBreak(level, m_isBreak);
+}
+
 void BreakStatement::dump() const {
   if (m_isBreak) {
     printf("break");
@@ -40,16 +40,6 @@ ClassVariable::ClassVariable(CONSTRUCT_ARGS, const string &name, int modifiers,
     m_modifiers(modifiers), m_value(value), m_docComment(doc), m_cls(cls) {
 }
 
-void ClassVariable::set(VariableEnvironment &env, EvalObjectData *self) const {
-  if (!(m_modifiers & ClassStatement::Static)) {
-    Variant val(m_value ? m_value->eval(env) : null_variant);
-    if (m_modifiers & ClassStatement::Private) {
-      self->o_setPrivate(m_cls->name().c_str(), m_name.c_str(), m_hash, val);
-    } else if (!self->o_exists(m_name.c_str())) {
-      self->o_set(m_name.c_str(), val, true);
-    }
-  }
-}
 void ClassVariable::setStatic(VariableEnvironment &env, LVariableTable &st)
   const {
   if ((m_modifiers & ClassStatement::Static)) {
@@ -287,14 +277,9 @@ Object ClassStatement::create(ClassEvalState &ce, CArrRef params,
 
 void ClassStatement::initializeObject(EvalObjectData *obj) const {
   DummyVariableEnvironment env;
-  for (vector<ClassVariablePtr>::const_iterator it =
-         m_variablesVec.begin();
-       it != m_variablesVec.end(); ++it) {
-    (*it)->set(env, obj);
-  }
-  const ClassStatement *cls = parentStatement();
-  if (cls) {
-    cls->initializeObject(obj);
+  const PropertyLayout &layout = obj->getLayout();
+  for (int i = 0; i < layout.size(); i++) {
+    layout.slot(i).var->eval(env, *obj->getSlot(i));
   }
 }
 
@@ -572,29 +557,19 @@ void ClassStatement::failPropertyAccess(CStrRef prop, const char *context,
       *context ? context : "");
 }
 
-void ClassStatement::toArray(Array &props, Array &vals) const {
-  String zero("\0", 1, AttachLiteral);
+/**
+ * Own properties first, then the parent's, which is how objects list them.
+ */
+void ClassStatement::loadPropertyLayout(PropertyLayout &layout) const {
   for (vector<ClassVariablePtr>::const_iterator it = m_variablesVec.begin();
        it != m_variablesVec.end(); ++it) {
-    ClassVariable *cv = it->get();
-    if ((cv->getModifiers() & Static) == 0) {
-      String pname(cv->name().c_str(), cv->name().size(), AttachLiteral);
-      if (cv->getModifiers() & Private) {
-        String tmp(pname);
-        pname = zero;
-        pname += name().c_str();
-        pname += zero;
-        pname += tmp;
-      }
-      if (vals.exists(pname)) {
-        Variant &p = vals.lvalAt(pname, -1);
-        props.set(pname, p.isReferenced() ? ref(p) : p);
-      }
+    if (((*it)->getModifiers() & Static) == 0) {
+      layout.add(this, it->get());
     }
   }
   const ClassStatement *parent = parentStatement();
   if (parent) {
-    parent->toArray(props, vals);
+    parent->loadPropertyLayout(layout);
   }
 }
 
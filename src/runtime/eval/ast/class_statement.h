@@ -34,12 +34,12 @@ DECLARE_AST_PTR(ClassStatementMarker);
 class EvalObjectData;
 class ClassInfoEvaled;
 class ClassEvalState;
+class PropertyLayout;
 
 class ClassVariable : public Construct {
 public:
   ClassVariable(CONSTRUCT_ARGS, const std::string &name, int modifiers,
       ExpressionPtr value, const std::string &doc, ClassStatement *cls);
-  void set(VariableEnvironment &env, EvalObjectData *self) const;
   void setStatic(VariableEnvironment &env, LVariableTable &statics) const;
   virtual void dump() const;
   const std::string &name() const { return m_name; }
@@ -122,8 +122,8 @@ public:
       int &mods, bool rec = false) const;
   void failPropertyAccess(CStrRef prop, const char *context,
       int mods) const;
-  void toArray(Array &props, Array &vals) const;
   void loadMethodTable(ClassEvalState &ce) const;
+  void loadPropertyLayout(PropertyLayout &layout) const;
   void semanticCheck(const ClassStatement *cls) const;
   ClassStatementMarkerPtr getMarker() const;
   void delayDeclaration() { m_delayDeclaration = true; }
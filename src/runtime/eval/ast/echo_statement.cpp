@@ -16,6 +16,7 @@
 
 #include <runtime/eval/ast/echo_statement.h>
 #include <runtime/eval/ast/expression.h>
+#include <runtime/eval/bytecode/byte_code_program.h>
 
 using namespace std;
 
@@ -35,6 +36,17 @@ void EchoStatement::eval(VariableEnvironment &env) const {
   }
 }
 
+void EchoStatement::byteCode(ByteCodeProgram &code) const {
+  code.emitLine(this);
+  int mark = code.tempMark();
+  for (vector<ExpressionPtr>::const_iterator it = m_args.begin();
+       it != m_args.end(); ++it) {
+    int reg = (*it)->byteCode(code, ByteCodeProgram::AnyReg);
+    code.emit(ByteCodeProgram::Echo, -1, reg);
+  }
+  code.releaseTemps(mark);
+}
+
 void EchoStatement::dump() const {
   printf("echo(");
   dumpVector(m_args, ", ");
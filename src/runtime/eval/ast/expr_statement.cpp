@@ -16,6 +16,7 @@
 
 #include <runtime/eval/ast/expr_statement.h>
 #include <runtime/eval/ast/expression.h>
+#include <runtime/eval/bytecode/byte_code_program.h>
 
 namespace HPHP {
 namespace Eval {
@@ -34,6 +35,13 @@ void ExprStatement::eval(VariableEnvironment &env) const {
   }
 }
 
+void ExprStatement::byteCode(ByteCodeProgram &code) const {
+  code.emitLine(this);
+  int mark = code.tempMark();
+  m_exp->byteCode(code, ByteCodeProgram::NoReg);
+  code.releaseTemps(mark);
+}
+
 void ExprStatement::dump() const {
   m_exp->dump();
   printf(";");
@@ -18,6 +18,7 @@
 #include <runtime/eval/ast/lval_expression.h>
 #include <runtime/eval/ast/name.h>
 #include <runtime/eval/parser/hphp.tab.hpp>
+#include <runtime/eval/bytecode/byte_code_program.h>
 
 namespace HPHP {
 namespace Eval {
@@ -65,6 +66,17 @@ bool Expression::isRefParam() const {
   return false;
 }
 
+int Expression::byteCode(ByteCodeProgram &code, int dst) const {
+  return code.emitExpression(this, dst);
+}
+
+void Expression::byteCodeBranch(ByteCodeProgram &code, int label,
+                                bool jumpIf) const {
+  int reg = byteCode(code, ByteCodeProgram::AnyReg);
+  code.emit(jumpIf ? ByteCodeProgram::JumpNZ : ByteCodeProgram::JumpZ,
+            -1, reg, -1, label);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 }
 }
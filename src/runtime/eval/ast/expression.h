@@ -41,6 +41,9 @@ public:
   virtual Variant evalExist(VariableEnvironment &env) const;
   virtual const LvalExpression *toLval() const;
   virtual bool isRefParam() const;
+  virtual int byteCode(ByteCodeProgram &code, int dst) const;
+  virtual void byteCodeBranch(ByteCodeProgram &code, int label,
+                              bool jumpIf) const;
 
   static Variant evalVector(const std::vector<ExpressionPtr> &v,
                             VariableEnvironment &env);
@@ -17,6 +17,7 @@
 #include <runtime/eval/ast/for_statement.h>
 #include <runtime/eval/ast/expression.h>
 #include <runtime/eval/runtime/variable_environment.h>
+#include <runtime/eval/bytecode/byte_code_program.h>
 
 namespace HPHP {
 namespace Eval {
@@ -41,6 +42,44 @@ void ForStatement::eval(VariableEnvironment &env) const {
   }
 }
 
+void ForStatement::byteCode(ByteCodeProgram &code) const {
+  code.emitLine(this);
+  int mark = code.tempMark();
+  for (unsigned int i = 0; i < m_init.size(); i++) {
+    m_init[i]->byteCode(code, ByteCodeProgram::NoReg);
+  }
+  code.releaseTemps(mark);
+
+  int top = code.newLabel();
+  int next = code.newLabel();
+  int cond = code.newLabel();
+  int end = code.newLabel();
+  code.emit(ByteCodeProgram::Jump, -1, -1, -1, cond);
+  code.bind(top);
+  if (m_body) {
+    code.pushLoop(end, next);
+    m_body->byteCode(code);
+    code.popLoop();
+  }
+  code.bind(next);
+  for (unsigned int i = 0; i < m_next.size(); i++) {
+    m_next[i]->byteCode(code, ByteCodeProgram::NoReg);
+  }
+  code.releaseTemps(mark);
+  code.bind(cond);
+  if (m_cond.empty()) {
+    code.emit(ByteCodeProgram::Jump, -1, -1, -1, top);
+  } else {
+    // only the last one decides, as in evalVector()
+    for (unsigned int i = 0; i < m_cond.size() - 1; i++) {
+      m_cond[i]->byteCode(code, ByteCodeProgram::NoReg);
+    }
+    m_cond.back()->byteCodeBranch(code, top, true);
+  }
+  code.releaseTemps(mark);
+  code.bind(end);
+}
+
 void ForStatement::dump() const {
   printf("for (");
   dumpVector(m_init, ", ");
@@ -28,6 +28,7 @@
 #include <runtime/eval/ast/function_call_expression.h>
 #include <runtime/eval/ast/lval_expression.h>
 #include <runtime/eval/strict_mode.h>
+#include <runtime/eval/bytecode/byte_code_program.h>
 #include <runtime/base/runtime_option.h>
 #include <runtime/base/intercept.h>
 
@@ -156,10 +157,12 @@ void Parameter::dropDefault() {
 FunctionStatement::FunctionStatement(STATEMENT_ARGS, const string &name,
                                      const string &doc)
   : Statement(STATEMENT_PASS), m_name(name),
-    m_lname(Util::toLower(m_name)), m_maybeIntercepted(-1), m_docComment(doc) {
+    m_lname(Util::toLower(m_name)), m_byteCode(NULL), m_maybeIntercepted(-1),
+    m_docComment(doc) {
 }
 FunctionStatement::~FunctionStatement() {
   unregister_intercept_flag(&m_maybeIntercepted);
+  delete m_byteCode;
 }
 
 void FunctionStatement::init(bool ref, const vector<ParameterPtr> params,
@@ -180,6 +183,9 @@ void FunctionStatement::init(bool ref, const vector<ParameterPtr> params,
       m_params[i]->dropDefault();
     }
   }
+
+  // compiled while parsing, so the program is shared like the tree is
+  m_byteCode = ByteCodeProgram::Compile(this);
 }
 
 const string &FunctionStatement::fullName() const {
@@ -265,7 +271,11 @@ Variant FunctionStatement::evalBody(VariableEnvironment &env) const {
   }
 
   if (m_body) {
-    m_body->eval(env);
+    if (m_byteCode) {
+      m_byteCode->execute(env);
+    } else {
+      m_body->eval(env);
+    }
     if (env.isReturning()) {
       if (m_ref) {
         ret.setContagious();
@@ -84,6 +84,7 @@ public:
   bool refReturn() const { return m_ref; }
   const std::vector<ParameterPtr>& getParams() const { return m_params; }
   bool hasBody() const { return m_body;}
+  const StatementListStatementPtr &getBody() const { return m_body;}
 
 protected:
   bool m_ref;
@@ -92,6 +93,7 @@ protected:
   std::vector<ParameterPtr> m_params;
 
   StatementListStatementPtr m_body;
+  ByteCodeProgram *m_byteCode;
   bool m_hasCallToGetArgs;
   mutable char m_maybeIntercepted;
 
@@ -17,6 +17,7 @@
 #include <runtime/eval/ast/if_statement.h>
 #include <runtime/eval/ast/expression.h>
 #include <runtime/eval/runtime/variable_environment.h>
+#include <runtime/eval/bytecode/byte_code_program.h>
 
 namespace HPHP {
 namespace Eval {
@@ -66,6 +67,25 @@ void IfStatement::eval(VariableEnvironment &env) const {
   if (m_else) EVAL_STMT(m_else, env);
 }
 
+void IfStatement::byteCode(ByteCodeProgram &code) const {
+  code.emitLine(this);
+  int end = code.newLabel();
+  for (vector<IfBranchPtr>::const_iterator it = m_branches.begin();
+       it != m_branches.end(); ++it) {
+    int next = code.newLabel();
+    int mark = code.tempMark();
+    (*it)->cond()->byteCodeBranch(code, next, false);
+    code.releaseTemps(mark);
+    if ((*it)->body()) {
+      (*it)->body()->byteCode(code);
+    }
+    code.emit(ByteCodeProgram::Jump, -1, -1, -1, end);
+    code.bind(next);
+  }
+  if (m_else) m_else->byteCode(code);
+  code.bind(end);
+}
+
 void IfStatement::dump() const {
   dumpVector(m_branches, " else ");
   if (m_else) {
@@ -45,6 +45,7 @@ public:
   IfStatement(STATEMENT_ARGS, const std::vector<IfBranchPtr> &branches,
               StatementPtr els);
   virtual void eval(VariableEnvironment &env) const;
+  virtual void byteCode(ByteCodeProgram &code) const;
   virtual void dump() const;
 private:
   std::vector<IfBranchPtr> m_branches;
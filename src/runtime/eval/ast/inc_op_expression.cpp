@@ -16,7 +16,9 @@
 
 #include <runtime/eval/ast/inc_op_expression.h>
 #include <runtime/eval/ast/lval_expression.h>
+#include <runtime/eval/ast/variable_expression.h>
 #include <runtime/eval/parser/hphp.tab.hpp>
+#include <runtime/eval/bytecode/byte_code_program.h>
 
 namespace HPHP {
 namespace Eval {
@@ -40,6 +42,24 @@ Variant IncOpExpression::refval(VariableEnvironment &env,
   }
 }
 
+int IncOpExpression::byteCode(ByteCodeProgram &code, int dst) const {
+  const VariableExpression *var =
+    dynamic_cast<const VariableExpression*>(m_exp.get());
+  if (!var || var->getIdx() == -1) {
+    return Expression::byteCode(code, dst);
+  }
+  int lhs = code.lvalue(var->getIdx());
+  if (m_front || dst == ByteCodeProgram::NoReg) {
+    code.emit(m_inc ? ByteCodeProgram::PreInc : ByteCodeProgram::PreDec,
+              dst, lhs);
+    return dst >= 0 ? dst : lhs;
+  }
+  int reg = code.target(dst);
+  code.emit(m_inc ? ByteCodeProgram::PostInc : ByteCodeProgram::PostDec,
+            reg, lhs);
+  return reg;
+}
+
 void IncOpExpression::dump() const {
   if (m_front) {
     if (m_inc)
@@ -31,6 +31,7 @@ public:
   IncOpExpression(EXPRESSION_ARGS, LvalExpressionPtr exp, bool inc, bool front);
   virtual Variant eval(VariableEnvironment &env) const;
   virtual Variant refval(VariableEnvironment &env, int strict = 2) const;
+  virtual int byteCode(ByteCodeProgram &code, int dst) const;
   virtual void dump() const;
 private:
   LvalExpressionPtr m_exp;
@@ -55,6 +55,10 @@ StringName::StringName(CONSTRUCT_ARGS, const string &name,
   : Name(CONSTRUCT_PASS), m_hash(hash_string(name.c_str(), name.size())),
     m_hashLwr(hash_string_i(name.c_str(), name.size())),
     m_name(name), m_isSp(isSp) {
+  // Only a string that lives as long as the process can be handed out as is:
+  // static strings are kept by pointer, by APC for one, and this node goes
+  // away when its file is reloaded.
+  m_static = StaticString::Lookup(m_name.c_str(), m_name.size());
 }
 
 String StringName::get(VariableEnvironment &env) const {
@@ -62,6 +66,7 @@ String StringName::get(VariableEnvironment &env) const {
 }
 
 String StringName::getStatic() const {
+  if (m_static) return m_static;
   return String(m_name.c_str(), m_name.size(), AttachLiteral);
 }
 
@@ -57,6 +57,7 @@ private:
   int64 m_hashLwr;
   std::string m_name;
   bool m_isSp;
+  StringData *m_static; // an interned string equal to it, or NULL
 };
 
 class ExprName : public Name {
@@ -16,7 +16,11 @@
 
 #include <runtime/eval/ast/object_property_expression.h>
 #include <runtime/eval/ast/name.h>
+#include <runtime/eval/ast/method_statement.h>
 #include <runtime/eval/runtime/variable_environment.h>
+#include <runtime/eval/runtime/eval_object_data.h>
+#include <runtime/eval/runtime/property_layout.h>
+#include <runtime/eval/parser/parser.h>
 #include <runtime/eval/parser/hphp.tab.hpp>
 
 namespace HPHP {
@@ -26,11 +30,52 @@ namespace Eval {
 ObjectPropertyExpression::ObjectPropertyExpression(EXPRESSION_ARGS,
                                                    ExpressionPtr obj,
                                                    NamePtr name)
-  : LvalExpression(EXPRESSION_PASS), m_obj(obj), m_name(name) {
+  : LvalExpression(EXPRESSION_PASS), m_obj(obj), m_name(name),
+    m_cacheable(false), m_slotCache(0) {
+  String s = m_name->getStatic();
+  if (!s.empty() && parser->haveClass() && parser->haveFunc() &&
+      parser->peekFunc()->cast<MethodStatement>()) {
+    m_cacheable = true;
+    m_propName = std::string(s.data(), s.size());
+  }
+}
+
+static const int SlotBits = 24;
+static const int64 SlotMask = (1LL << SlotBits) - 1;
+
+/**
+ * The slot of a declared property, remembered for the layout last seen here.
+ * The class asking for it is the method's, so access checks come out the
+ * same every time. Returns NULL if the object has to look it up by itself.
+ */
+Variant *ObjectPropertyExpression::slot(CVarRef obj) const {
+  if (!m_cacheable || !obj.is(KindOfObject)) return NULL;
+  ObjectData *o = obj.getObjectData();
+  if (!o->getAttribute(ObjectData::IsEvalObject)) return NULL;
+  EvalObjectData *eo = static_cast<EvalObjectData*>(o);
+
+  int64 serial = eo->getLayout().serial();
+  int64 cache = m_slotCache;
+  int i;
+  if ((cache >> SlotBits) == serial) {
+    i = cache & SlotMask;
+  } else {
+    i = eo->findSlot(m_propName.data(), m_propName.size(), m_name->hash(),
+                     FrameInjection::GetClassName(false));
+    if (i < 0 || i > SlotMask) return NULL;
+    m_slotCache = (serial << SlotBits) | i;
+  }
+  Variant *v = eo->getSlot(i);
+  return v->isInitialized() ? v : NULL;
 }
 
 Variant ObjectPropertyExpression::eval(VariableEnvironment &env) const {
   Variant obj(m_obj->eval(env));
+  if (Variant *v = slot(obj)) {
+    env.setThis(false);
+    SET_LINE;
+    return *v;
+  }
   String name(m_name->get(env));
   env.setThis(false);
   SET_LINE;
@@ -51,6 +96,10 @@ Variant &ObjectPropertyExpression::lval(VariableEnvironment &env) const {
   const LvalExpression *lobj = m_obj->toLval();
   if (lobj) {
     Variant &lv = lobj->lval(env);
+    if (Variant *v = slot(lv)) {
+      SET_LINE;
+      return *v;
+    }
     String name(m_name->get(env));
     SET_LINE;
     return lv.o_lval(name, get_globals()->__lvalProxy);
@@ -86,6 +135,11 @@ Variant ObjectPropertyExpression::set(VariableEnvironment &env, CVarRef val)
   const LvalExpression *lobj = m_obj->toLval();
   if (lobj) {
     Variant &lv = lobj->lval(env);
+    if (Variant *v = slot(lv)) {
+      SET_LINE;
+      *v = val;
+      return val;
+    }
     String name(m_name->get(env));
     SET_LINE;
     lv.o_set(name, val);
@@ -43,6 +43,14 @@ public:
 private:
   ExpressionPtr m_obj;
   NamePtr m_name;
+
+  // for properties of eval'd objects, when the name is known and this is
+  // in a method, so it's always looked up from the same class
+  bool m_cacheable;
+  std::string m_propName;
+  mutable int64 m_slotCache; // layout serial << SlotBits | slot
+
+  Variant *slot(CVarRef obj) const;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
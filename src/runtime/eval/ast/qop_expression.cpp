@@ -15,6 +15,7 @@
 */
 
 #include <runtime/eval/ast/qop_expression.h>
+#include <runtime/eval/bytecode/byte_code_program.h>
 
 namespace HPHP {
 namespace Eval {
@@ -33,6 +34,19 @@ Variant QOpExpression::eval(VariableEnvironment &env) const {
   }
 }
 
+int QOpExpression::byteCode(ByteCodeProgram &code, int dst) const {
+  int reg = code.target(dst);
+  int falseLabel = code.newLabel();
+  int end = code.newLabel();
+  m_cond->byteCodeBranch(code, falseLabel, false);
+  m_true->byteCode(code, reg);
+  code.emit(ByteCodeProgram::Jump, -1, -1, -1, end);
+  code.bind(falseLabel);
+  m_false->byteCode(code, reg);
+  code.bind(end);
+  return reg;
+}
+
 void QOpExpression::dump() const {
   m_cond->dump();
   printf(" ? ");
@@ -30,6 +30,7 @@ public:
   QOpExpression(EXPRESSION_ARGS, ExpressionPtr cond, ExpressionPtr t,
                 ExpressionPtr f);
   virtual Variant eval(VariableEnvironment &env) const;
+  virtual int byteCode(ByteCodeProgram &code, int dst) const;
   virtual void dump() const;
 private:
   ExpressionPtr m_cond;
@@ -18,6 +18,7 @@
 #include <runtime/eval/ast/expression.h>
 #include <runtime/eval/ast/lval_expression.h>
 #include <runtime/eval/runtime/variable_environment.h>
+#include <runtime/eval/bytecode/byte_code_program.h>
 
 namespace HPHP {
 namespace Eval {
@@ -39,6 +40,22 @@ void ReturnStatement::eval(VariableEnvironment &env) const {
   env.setRet();
 }
 
+void ReturnStatement::byteCode(ByteCodeProgram &code) const {
+  if (m_value && code.refReturn()) {
+    Statement::byteCode(code);
+    return;
+  }
+  code.emitLine(this);
+  if (m_value) {
+    int mark = code.tempMark();
+    int reg = m_value->byteCode(code, ByteCodeProgram::AnyReg);
+    code.emit(ByteCodeProgram::Return, -1, reg);
+    code.releaseTemps(mark);
+  } else {
+    code.emit(ByteCodeProgram::ReturnVoid);
+  }
+}
+
 void ReturnStatement::dump() const {
   printf("return");
   if (m_value) {
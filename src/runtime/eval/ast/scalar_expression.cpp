@@ -16,6 +16,7 @@
 
 #include <runtime/eval/ast/scalar_expression.h>
 #include <runtime/eval/parser/hphp.tab.hpp>
+#include <runtime/eval/bytecode/byte_code_program.h>
 
 namespace HPHP {
 namespace Eval {
@@ -53,6 +54,7 @@ ScalarExpression::ScalarExpression(EXPRESSION_ARGS, int type,
   default:
     ASSERT(false);
   }
+  if (m_kind == SString) initString();
 }
 
 ScalarExpression::ScalarExpression(EXPRESSION_ARGS)
@@ -62,7 +64,17 @@ ScalarExpression::ScalarExpression(EXPRESSION_ARGS, bool b)
   m_num.num = b ? 1 : 0;
 }
 ScalarExpression::ScalarExpression(EXPRESSION_ARGS, const string &s)
-  : Expression(EXPRESSION_PASS), m_value(s), m_kind(SString) {}
+  : Expression(EXPRESSION_PASS), m_value(s), m_kind(SString) {
+  m_binary = m_value.find('\0') != string::npos;
+  initString();
+}
+
+void ScalarExpression::initString() {
+  int len = m_binary ? m_value.size() : strlen(m_value.c_str());
+  // not a static string of its own: that would be kept by pointer, by APC
+  // for one, after this node goes away when its file is reloaded
+  m_static = StaticString::Lookup(m_value.c_str(), len);
+}
 
 Variant ScalarExpression::eval(VariableEnvironment &env) const {
   return getValue();
@@ -75,7 +87,9 @@ Variant ScalarExpression::getValue() const {
   case SBool:
     return (bool)m_num.num;
   case SString:
-    if (!m_binary) {
+    if (m_static) {
+      return m_static;
+    } else if (!m_binary) {
       return m_value.c_str();
     } else {
       return String(m_value.c_str(), m_value.size(), AttachLiteral);
@@ -90,6 +104,10 @@ Variant ScalarExpression::getValue() const {
   return Variant();
 }
 
+int ScalarExpression::byteCode(ByteCodeProgram &code, int dst) const {
+  return code.place(code.constant(getValue()), dst);
+}
+
 void ScalarExpression::dump() const {
   switch (m_kind) {
   case SNull:
@@ -32,6 +32,7 @@ public:
   ScalarExpression(EXPRESSION_ARGS, const std::string &s);
   ScalarExpression(EXPRESSION_ARGS, int type, const std::string &val);
   virtual Variant eval(VariableEnvironment &env) const;
+  virtual int byteCode(ByteCodeProgram &code, int dst) const;
   Variant getValue() const;
   virtual void dump() const;
 private:
@@ -50,6 +51,9 @@ private:
   Kind m_kind;
   bool m_quoted;
   bool m_binary;
+  StringData *m_static; // an interned string equal to it, or NULL
+
+  void initString();
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -19,6 +19,7 @@
 #include <runtime/ext/ext_misc.h>
 #include <runtime/eval/eval.h>
 #include <runtime/eval/runtime/variable_environment.h>
+#include <runtime/eval/bytecode/byte_code_program.h>
 
 namespace HPHP {
 namespace Eval {
@@ -71,6 +72,44 @@ Variant UnaryOpExpression::refval(VariableEnvironment &env,
   }
 }
 
+int UnaryOpExpression::byteCode(ByteCodeProgram &code, int dst) const {
+  ByteCodeProgram::OpCode op;
+  switch (m_op) {
+  case '(':           return m_exp->byteCode(code, dst);
+  case '+':           op = ByteCodeProgram::Plus;       break;
+  case '-':           op = ByteCodeProgram::Neg;        break;
+  case '!':           op = ByteCodeProgram::Not;        break;
+  case '~':           op = ByteCodeProgram::BitNot;     break;
+  case T_INT_CAST:    op = ByteCodeProgram::CastInt;    break;
+  case T_DOUBLE_CAST: op = ByteCodeProgram::CastDouble; break;
+  case T_STRING_CAST: op = ByteCodeProgram::CastString; break;
+  case T_ARRAY_CAST:  op = ByteCodeProgram::CastArray;  break;
+  case T_BOOL_CAST:   op = ByteCodeProgram::ToBool;     break;
+  default:
+    return Expression::byteCode(code, dst);
+  }
+  int a = m_exp->byteCode(code, ByteCodeProgram::AnyReg);
+  int reg = code.target(dst);
+  code.emit(op, reg, a);
+  return reg;
+}
+
+void UnaryOpExpression::byteCodeBranch(ByteCodeProgram &code, int label,
+                                       bool jumpIf) const {
+  switch (m_op) {
+  case '!':
+    m_exp->byteCodeBranch(code, label, !jumpIf);
+    break;
+  case '(':
+  case T_BOOL_CAST:
+    m_exp->byteCodeBranch(code, label, jumpIf);
+    break;
+  default:
+    Expression::byteCodeBranch(code, label, jumpIf);
+    break;
+  }
+}
+
 void UnaryOpExpression::dump() const {
   if (m_op == '(') {
     printf("(");
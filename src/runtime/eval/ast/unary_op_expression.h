@@ -30,6 +30,9 @@ public:
   UnaryOpExpression(EXPRESSION_ARGS, ExpressionPtr exp, int op, bool front);
   virtual Variant eval(VariableEnvironment &env) const;
   virtual Variant refval(VariableEnvironment &env, int strict = 2) const;
+  virtual int byteCode(ByteCodeProgram &code, int dst) const;
+  virtual void byteCodeBranch(ByteCodeProgram &code, int label,
+                              bool jumpIf) const;
   virtual void dump() const;
 private:
   ExpressionPtr m_exp;
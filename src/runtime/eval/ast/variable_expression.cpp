@@ -19,6 +19,7 @@
 #include <runtime/eval/ast/name.h>
 #include <runtime/base/runtime_option.h>
 #include <runtime/eval/strict_mode.h>
+#include <runtime/eval/bytecode/byte_code_program.h>
 
 namespace HPHP {
 namespace Eval {
@@ -117,6 +118,13 @@ void VariableExpression::unset(VariableEnvironment &env) const {
   env.unset(name, m_name->hash());
 }
 
+int VariableExpression::byteCode(ByteCodeProgram &code, int dst) const {
+  if (m_idx == -1) {
+    return Expression::byteCode(code, dst);
+  }
+  return code.place(code.local(m_idx), dst);
+}
+
 NamePtr VariableExpression::getName() const {
   return m_name;
 }
@@ -36,7 +36,9 @@ public:
   virtual void unset(VariableEnvironment &env) const;
   virtual Variant set(VariableEnvironment &env, CVarRef val) const;
   virtual Variant setOp(VariableEnvironment &env, int op, CVarRef rhs) const;
+  virtual int byteCode(ByteCodeProgram &code, int dst) const;
   NamePtr getName() const;
+  int getIdx() const { return m_idx; }
   virtual void dump() const;
 private:
   NamePtr m_name;
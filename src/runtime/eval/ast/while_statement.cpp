@@ -17,6 +17,7 @@
 #include <runtime/eval/ast/while_statement.h>
 #include <runtime/eval/ast/expression.h>
 #include <runtime/eval/runtime/variable_environment.h>
+#include <runtime/eval/bytecode/byte_code_program.h>
 
 namespace HPHP {
 namespace Eval {
@@ -34,6 +35,25 @@ void WhileStatement::eval(VariableEnvironment &env) const {
   }
 }
 
+void WhileStatement::byteCode(ByteCodeProgram &code) const {
+  code.emitLine(this);
+  int top = code.newLabel();
+  int cond = code.newLabel();
+  int end = code.newLabel();
+  code.emit(ByteCodeProgram::Jump, -1, -1, -1, cond);
+  code.bind(top);
+  if (m_body) {
+    code.pushLoop(end, cond);
+    m_body->byteCode(code);
+    code.popLoop();
+  }
+  code.bind(cond);
+  int mark = code.tempMark();
+  m_cond->byteCodeBranch(code, top, true);
+  code.releaseTemps(mark);
+  code.bind(end);
+}
+
 void WhileStatement::dump() const {
   printf("while (");
   m_cond->dump();
@@ -0,0 +1,617 @@
+/*
+   +----------------------------------------------------------------------+
+   | HipHop for PHP                                                       |
+   +----------------------------------------------------------------------+
+   | Copyright (c) 2010 Facebook, Inc. (http://www.facebook.com)          |
+   +----------------------------------------------------------------------+
+   | This source file is subject to version 3.01 of the PHP license,      |
+   | that is bundled with this package in the file LICENSE, and is        |
+   | available through the world-wide-web at the following url:           |
+   | http://www.php.net/license/3_01.txt                                  |
+   | If you did not receive a copy of the PHP license and are unable to   |
+   | obtain it through the world-wide-web, please send a note to          |
+   | license@php.net so we can mail you a copy immediately.               |
+   +----------------------------------------------------------------------+
+*/
+
+#include <runtime/eval/bytecode/byte_code_program.h>
+#include <runtime/eval/ast/function_statement.h>
+#include <runtime/eval/ast/statement_list_statement.h>
+#include <runtime/eval/ast/scalar_expression.h>
+#include <runtime/eval/ast/variable_expression.h>
+#include <runtime/eval/ast/lval_expression.h>
+#include <runtime/eval/runtime/variable_environment.h>
+#include <runtime/eval/parser/hphp.tab.hpp>
+#include <runtime/base/runtime_option.h>
+#include <runtime/base/preg.h>
+#include <alloca.h>
+
+using namespace std;
+
+namespace HPHP {
+namespace Eval {
+///////////////////////////////////////////////////////////////////////////////
+// registers, as encoded while compiling
+
+static const int RegIndexMask = 0x00ffffff;
+static const int RegTemp      = 0x01000000;
+static const int RegConstant  = 0x02000000;
+static const int RegKindMask  = 0x03000000;
+static const int RegCheck     = 0x04000000; // read of a local
+
+ByteCodeProgram::ByteCodeProgram(const FunctionStatement *func)
+  : m_localCount(0), m_temps(0), m_tempCount(0), m_func(func) {
+  const Block::VariableIndices &vi = func->varIndices();
+  m_localCount = vi.size();
+  m_localNames.resize(m_localCount);
+  for (Block::VariableIndices::const_iterator it = vi.begin();
+       it != vi.end(); ++it) {
+    m_localNames[it->second.idx()] = it->first;
+  }
+}
+
+ByteCodeProgram::~ByteCodeProgram() {
+}
+
+ByteCodeProgram *ByteCodeProgram::Compile(const FunctionStatement *func) {
+  if (!RuntimeOption::BytecodeInterpreter || !func->hasBody() ||
+      RuntimeOption::EnableDebugger || RuntimeOption::EnableStrict) {
+    return NULL;
+  }
+  const string &pattern = RuntimeOption::BytecodeFilePattern;
+  if (!pattern.empty()) {
+    const char *file = func->loc()->file;
+    Variant ret = preg_match(String(pattern.c_str(), pattern.size(),
+                                    AttachLiteral),
+                             String(file, AttachLiteral));
+    if (ret.toInt64() <= 0) {
+      return NULL;
+    }
+  }
+
+  ByteCodeProgram *code = new ByteCodeProgram(func);
+  func->getBody()->byteCode(*code);
+  code->finalize();
+  if (RuntimeOption::DumpBytecode) {
+    printf("%s() at %s:%d\n", func->name().c_str(), func->loc()->file,
+           func->loc()->line0);
+    code->dump();
+  }
+  return code;
+}
+
+int ByteCodeProgram::local(int idx) const {
+  ASSERT(idx >= 0 && idx < m_localCount);
+  return idx | RegCheck;
+}
+
+int ByteCodeProgram::lvalue(int idx) const {
+  ASSERT(idx >= 0 && idx < m_localCount);
+  return idx;
+}
+
+int ByteCodeProgram::constant(CVarRef v) {
+  if (v.isString()) {
+    // Programs are shared by all threads, so strings can't be refcounted.
+    // Static strings live as long as the process; any other one becomes a
+    // literal string made on each call, just like the tree walker does,
+    // since a static one would be kept by APC after the file is reloaded.
+    String s = v.toString();
+    StringData *sd = StaticString::Lookup(s.data(), s.size());
+    if (sd) {
+      m_constants.push_back(sd);
+    } else {
+      m_literals.push_back(Literal(m_constants.size(),
+                                   string(s.data(), s.size())));
+      m_constants.push_back(null);
+    }
+  } else {
+    m_constants.push_back(v);
+  }
+  return RegConstant | (m_constants.size() - 1);
+}
+
+int ByteCodeProgram::temp() {
+  int reg = RegTemp | m_temps++;
+  if (m_temps > m_tempCount) {
+    m_tempCount = m_temps;
+  }
+  return reg;
+}
+
+bool ByteCodeProgram::refReturn() const {
+  return m_func->refReturn();
+}
+
+bool ByteCodeProgram::isLocal(int reg) const {
+  return reg >= 0 && (reg & RegKindMask) == 0;
+}
+
+/**
+ * Makes the result of an expression end up in dst, if it asked for one.
+ */
+int ByteCodeProgram::place(int reg, int dst) {
+  if (dst >= 0 && reg != dst) {
+    emit(Move, dst, reg);
+    return dst;
+  }
+  return reg;
+}
+
+/**
+ * Operands are read when the instruction runs, so a local read before the
+ * next operand is evaluated has to be copied, in case that changes it.
+ */
+int ByteCodeProgram::stable(int reg, const Expression *next) {
+  if (isLocal(reg) &&
+      !dynamic_cast<const ScalarExpression*>(next) &&
+      !dynamic_cast<const VariableExpression*>(next)) {
+    int t = temp();
+    emit(Move, t, reg);
+    return t;
+  }
+  return reg;
+}
+
+int ByteCodeProgram::newLabel() {
+  m_labels.push_back(-1);
+  return m_labels.size() - 1;
+}
+
+void ByteCodeProgram::bind(int label) {
+  m_labels[label] = m_code.size();
+}
+
+void ByteCodeProgram::emit(OpCode op, int dst /* = -1 */, int a /* = -1 */,
+                           int b /* = -1 */, int target /* = -1 */,
+                           const void *aux /* = NULL */, int flag /* = 0 */) {
+  Instruction ins;
+  ins.op = op;
+  ins.check = 0;
+  if (a >= 0 && (a & RegCheck)) {
+    ins.check |= 1;
+    a &= ~RegCheck;
+  }
+  if (b >= 0 && (b & RegCheck)) {
+    ins.check |= 2;
+    b &= ~RegCheck;
+  }
+  ins.flag = flag;
+  ins.dst = dst >= 0 ? (dst & ~RegCheck) : -1;
+  ins.a = a;
+  ins.b = b;
+  ins.target = target;
+  ins.aux = aux;
+  m_code.push_back(ins);
+}
+
+void ByteCodeProgram::emitLine(const Construct *c) {
+  emit(Line, -1, -1, -1, -1, c->loc());
+}
+
+int ByteCodeProgram::emitExpression(const Expression *exp, int dst) {
+  if (dst == NoReg) {
+    emit(EvalExpr, -1, -1, -1, -1, exp);
+    return NoReg;
+  }
+  int reg = target(dst);
+  emit(EvalExpr, reg, -1, -1, -1, exp);
+  return reg;
+}
+
+void ByteCodeProgram::emitStatement(const Statement *stmt) {
+  m_loopStacks.push_back(m_loops);
+  emit(EvalStmt, -1, -1, -1, m_loopStacks.size() - 1, stmt);
+}
+
+void ByteCodeProgram::emitBreak(int level, bool isBreak) {
+  if (level <= 0) return;
+  int depth = m_loops.size();
+  if (level <= depth) {
+    const LoopLabels &loop = m_loops[depth - level];
+    emit(Jump, -1, -1, -1, isBreak ? loop.breakTo : loop.continueTo);
+  } else {
+    level -= depth;
+    emit(Escape, -1, -1, -1, isBreak ? level : -level);
+  }
+}
+
+void ByteCodeProgram::pushLoop(int breakLabel, int continueLabel) {
+  LoopLabels loop;
+  loop.breakTo = breakLabel;
+  loop.continueTo = continueLabel;
+  m_loops.push_back(loop);
+}
+
+void ByteCodeProgram::popLoop() {
+  m_loops.pop_back();
+}
+
+int ByteCodeProgram::decode(int reg) const {
+  if (reg < 0) return reg;
+  int idx = reg & RegIndexMask;
+  switch (reg & RegKindMask) {
+  case RegTemp:     return m_localCount + idx;
+  case RegConstant: return m_localCount + m_tempCount + idx;
+  }
+  return idx;
+}
+
+void ByteCodeProgram::finalize() {
+  ASSERT(m_loops.empty());
+  emit(End);
+  for (unsigned int i = 0; i < m_code.size(); i++) {
+    Instruction &ins = m_code[i];
+    ins.dst = decode(ins.dst);
+    ins.a = decode(ins.a);
+    ins.b = decode(ins.b);
+    if (ins.op >= Jump && ins.op <= JumpGe) {
+      ins.target = m_labels[ins.target];
+      ASSERT(ins.target >= 0);
+    }
+  }
+  for (unsigned int i = 0; i < m_loopStacks.size(); i++) {
+    vector<LoopLabels> &loops = m_loopStacks[i];
+    for (unsigned int j = 0; j < loops.size(); j++) {
+      loops[j].breakTo = m_labels[loops[j].breakTo];
+      loops[j].continueTo = m_labels[loops[j].continueTo];
+    }
+  }
+  m_labels.clear();
+  m_loops.clear();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// execution
+
+void ByteCodeProgram::checkOperands(const Instruction &ins, Variant **r)
+  const {
+  if ((ins.check & 1) && !r[ins.a]->isInitialized()) {
+    raise_notice("Undefined variable: %s", m_localNames[ins.a].c_str());
+  }
+  if ((ins.check & 2) && !r[ins.b]->isInitialized()) {
+    raise_notice("Undefined variable: %s", m_localNames[ins.b].c_str());
+  }
+}
+
+class TempRegisters {
+public:
+  TempRegisters(Variant *temps, int count) : m_temps(temps), m_count(count) {
+    for (int i = 0; i < m_count; i++) {
+      new (&m_temps[i]) Variant();
+    }
+  }
+  ~TempRegisters() {
+    for (int i = 0; i < m_count; i++) {
+      m_temps[i].~Variant();
+    }
+  }
+private:
+  Variant *m_temps;
+  int m_count;
+};
+
+static inline bool both_int(CVarRef v1, CVarRef v2) {
+  DataType t1 = v1.getRawType();
+  DataType t2 = v2.getRawType();
+  return (t1 == KindOfInt64 || t1 == KindOfInt32) &&
+    (t2 == KindOfInt64 || t2 == KindOfInt32);
+}
+
+void ByteCodeProgram::execute(VariableEnvironment &env) const {
+  // in the same order as OpCode
+  static void *labels[] = {
+    &&op_Nop, &&op_Line, &&op_Move,
+    &&op_Add, &&op_Sub, &&op_Mul, &&op_Div, &&op_Mod, &&op_Concat,
+    &&op_BitAnd, &&op_BitOr, &&op_BitXor, &&op_Shl, &&op_Shr, &&op_Xor,
+    &&op_Same, &&op_NSame, &&op_Eq, &&op_NEq,
+    &&op_Lt, &&op_Le, &&op_Gt, &&op_Ge,
+    &&op_ToBool, &&op_Not, &&op_Neg, &&op_Plus, &&op_BitNot,
+    &&op_CastInt, &&op_CastDouble, &&op_CastString, &&op_CastArray,
+    &&op_Jump, &&op_JumpZ, &&op_JumpNZ,
+    &&op_JumpSame, &&op_JumpNSame, &&op_JumpEq, &&op_JumpNEq,
+    &&op_JumpLt, &&op_JumpLe, &&op_JumpGt, &&op_JumpGe,
+    &&op_SetOp, &&op_AddTo, &&op_SubTo, &&op_ConcatTo,
+    &&op_PreInc, &&op_PreDec, &&op_PostInc, &&op_PostDec,
+    &&op_Echo, &&op_Return, &&op_ReturnVoid, &&op_Escape,
+    &&op_EvalExpr, &&op_EvalStmt, &&op_End
+  };
+  CT_ASSERT(sizeof(labels) / sizeof(labels[0]) == OpCodeCount);
+
+  int count = m_localCount + m_tempCount + m_constants.size();
+  Variant **r = (Variant **)alloca(count * sizeof(Variant *));
+  for (int i = 0; i < m_localCount; i++) {
+    r[i] = &env.getIdx(i);
+  }
+  Variant *temps = (Variant *)alloca(m_tempCount * sizeof(Variant));
+  TempRegisters tr(temps, m_tempCount);
+  Variant **tr0 = r + m_localCount;
+  for (int i = 0; i < m_tempCount; i++) {
+    tr0[i] = &temps[i];
+  }
+  Variant **cr0 = tr0 + m_tempCount;
+  for (unsigned int i = 0; i < m_constants.size(); i++) {
+    cr0[i] = const_cast<Variant *>(&m_constants[i]);
+  }
+  int literalCount = m_literals.size();
+  Variant *literals = (Variant *)alloca(literalCount * sizeof(Variant));
+  TempRegisters lr(literals, literalCount);
+  for (int i = 0; i < literalCount; i++) {
+    const string &s = m_literals[i].second;
+    literals[i] = String(s.data(), s.size(), AttachLiteral);
+    cr0[m_literals[i].first] = &literals[i];
+  }
+
+  const Instruction *code = &m_code[0];
+  const Instruction *pc = code;
+
+#define DISPATCH                                                        \
+  if (pc->check) checkOperands(*pc, r);                                 \
+  goto *labels[pc->op]
+#define NEXT ++pc; DISPATCH
+#define JUMP pc = code + pc->target; DISPATCH
+#define A (*r[pc->a])
+#define B (*r[pc->b])
+#define DST (*r[pc->dst])
+
+#define BINARY_OP(name, expr)                                           \
+  op_##name: DST = (expr); NEXT
+#define INT_BINARY_OP(name, iop, expr)                                  \
+  op_##name:                                                            \
+  if (both_int(A, B)) {                                                 \
+    DST = (int64)(A.getNumData() iop B.getNumData());                   \
+  } else {                                                              \
+    DST = (expr);                                                       \
+  }                                                                     \
+  NEXT
+#define COMPARE_OP(name, iop, expr)                                     \
+  op_##name:                                                            \
+  if (both_int(A, B)) {                                                 \
+    DST = (bool)(A.getNumData() iop B.getNumData());                    \
+  } else {                                                              \
+    DST = (bool)(expr);                                                 \
+  }                                                                     \
+  NEXT
+#define COMPARE_JUMP(name, iop, expr)                                   \
+  op_##name:                                                            \
+  if (both_int(A, B) ? (A.getNumData() iop B.getNumData()) == pc->flag  \
+                     : (bool)(expr) == pc->flag) {                      \
+    JUMP;                                                               \
+  }                                                                     \
+  NEXT
+
+  DISPATCH;
+
+op_Nop:
+  NEXT;
+op_Line:
+  {
+    const Location *loc = (const Location *)pc->aux;
+    set_line(loc->line0, loc->char0, loc->line1, loc->char1);
+  }
+  NEXT;
+op_Move:
+  DST = A;
+  NEXT;
+
+  INT_BINARY_OP(Add, +, A + B);
+  INT_BINARY_OP(Sub, -, A - B);
+  INT_BINARY_OP(Mul, *, multiply(A, B));
+  BINARY_OP(Div, divide(A, B));
+  BINARY_OP(Mod, modulo(A, B));
+  BINARY_OP(Concat, concat(A.toString(), B.toString()));
+  BINARY_OP(BitAnd, bitwise_and(A, B));
+  BINARY_OP(BitOr, bitwise_or(A, B));
+  BINARY_OP(BitXor, bitwise_xor(A, B));
+  BINARY_OP(Shl, A.toInt64() << B.toInt64());
+  BINARY_OP(Shr, A.toInt64() >> B.toInt64());
+  BINARY_OP(Xor, logical_xor(A, B));
+  BINARY_OP(Same, same(A, B));
+  BINARY_OP(NSame, !same(A, B));
+  COMPARE_OP(Eq, ==, equal(A, B));
+  COMPARE_OP(NEq, !=, !equal(A, B));
+  COMPARE_OP(Lt, <, less(A, B));
+  COMPARE_OP(Le, <=, not_more(A, B));
+  COMPARE_OP(Gt, >, more(A, B));
+  COMPARE_OP(Ge, >=, not_less(A, B));
+
+  BINARY_OP(ToBool, A.toBoolean());
+  BINARY_OP(Not, !A.toBoolean());
+  BINARY_OP(Neg, negate(A));
+  BINARY_OP(Plus, +A);
+  BINARY_OP(BitNot, ~A);
+  BINARY_OP(CastInt, toInt64(A));
+  BINARY_OP(CastDouble, toDouble(A));
+  BINARY_OP(CastString, toString(A));
+  BINARY_OP(CastArray, toArray(A));
+
+op_Jump:
+  JUMP;
+op_JumpZ:
+  if (!A.toBoolean()) {
+    JUMP;
+  }
+  NEXT;
+op_JumpNZ:
+  if (A.toBoolean()) {
+    JUMP;
+  }
+  NEXT;
+op_JumpSame:
+  if (same(A, B) == (bool)pc->flag) {
+    JUMP;
+  }
+  NEXT;
+op_JumpNSame:
+  if (!same(A, B) == (bool)pc->flag) {
+    JUMP;
+  }
+  NEXT;
+  COMPARE_JUMP(JumpEq, ==, equal(A, B));
+  COMPARE_JUMP(JumpNEq, !=, !equal(A, B));
+  COMPARE_JUMP(JumpLt, <, less(A, B));
+  COMPARE_JUMP(JumpLe, <=, not_more(A, B));
+  COMPARE_JUMP(JumpGt, >, more(A, B));
+  COMPARE_JUMP(JumpGe, >=, not_less(A, B));
+
+op_SetOp:
+  {
+    const LvalExpression *lv = (const LvalExpression *)pc->aux;
+    Variant ret(lv->setOpVariant(A, pc->flag, B));
+    if (pc->dst >= 0) DST = ret;
+  }
+  NEXT;
+op_AddTo:
+  if (both_int(A, B)) {
+    A = (int64)(A.getNumData() + B.getNumData());
+  } else {
+    AssignOp<T_PLUS_EQUAL>::assign(A, B);
+  }
+  if (pc->dst >= 0) DST = A;
+  NEXT;
+op_SubTo:
+  if (both_int(A, B)) {
+    A = (int64)(A.getNumData() - B.getNumData());
+  } else {
+    AssignOp<T_MINUS_EQUAL>::assign(A, B);
+  }
+  if (pc->dst >= 0) DST = A;
+  NEXT;
+op_ConcatTo:
+  AssignOp<T_CONCAT_EQUAL>::assign(A, B);
+  if (pc->dst >= 0) DST = A;
+  NEXT;
+op_PreInc:
+  ++A;
+  if (pc->dst >= 0) DST = A;
+  NEXT;
+op_PreDec:
+  --A;
+  if (pc->dst >= 0) DST = A;
+  NEXT;
+op_PostInc:
+  DST = A++;
+  NEXT;
+op_PostDec:
+  DST = A--;
+  NEXT;
+
+op_Echo:
+  echo(A.toString());
+  NEXT;
+op_Return:
+  env.setRet(A);
+  return;
+op_ReturnVoid:
+  env.setRet();
+  return;
+op_Escape:
+  env.setBreak(pc->target);
+  return;
+
+op_EvalExpr:
+  {
+    const Expression *exp = (const Expression *)pc->aux;
+    if (pc->dst >= 0) {
+      // never let a temporary become a reference
+      Variant v(exp->eval(env));
+      DST = v;
+    } else {
+      exp->eval(env);
+    }
+  }
+  NEXT;
+op_EvalStmt:
+  ((const Statement *)pc->aux)->eval(env);
+  if (env.isEscaping()) {
+    if (env.isReturning()) return;
+    // same as EVAL_STMT_HANDLE_BREAK at each loop this statement is in
+    const vector<LoopLabels> &loops = m_loopStacks[pc->target];
+    for (int i = loops.size() - 1; ; i--) {
+      if (i < 0) return; // out of the function
+      int hb = env.handleBreak();
+      if (hb == 2) {
+        pc = code + loops[i].breakTo;
+        break;
+      }
+      if (hb == 3) {
+        pc = code + loops[i].continueTo;
+        break;
+      }
+    }
+    DISPATCH;
+  }
+  NEXT;
+
+op_End:
+  return;
+
+#undef COMPARE_JUMP
+#undef COMPARE_OP
+#undef INT_BINARY_OP
+#undef BINARY_OP
+#undef DST
+#undef B
+#undef A
+#undef JUMP
+#undef NEXT
+#undef DISPATCH
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+const char *ByteCodeProgram::OpName(int op) {
+  static const char *names[] = {
+    "Nop", "Line", "Move",
+    "Add", "Sub", "Mul", "Div", "Mod", "Concat",
+    "BitAnd", "BitOr", "BitXor", "Shl", "Shr", "Xor",
+    "Same", "NSame", "Eq", "NEq", "Lt", "Le", "Gt", "Ge",
+    "ToBool", "Not", "Neg", "Plus", "BitNot",
+    "CastInt", "CastDouble", "CastString", "CastArray",
+    "Jump", "JumpZ", "JumpNZ",
+    "JumpSame", "JumpNSame", "JumpEq", "JumpNEq",
+    "JumpLt", "JumpLe", "JumpGt", "JumpGe",
+    "SetOp", "AddTo", "SubTo", "ConcatTo",
+    "PreInc", "PreDec", "PostInc", "PostDec",
+    "Echo", "Return", "ReturnVoid", "Escape",
+    "EvalExpr", "EvalStmt", "End"
+  };
+  CT_ASSERT(sizeof(names) / sizeof(names[0]) == OpCodeCount);
+  return names[op];
+}
+
+void ByteCodeProgram::dump() const {
+  int tempStart = m_localCount;
+  int constStart = m_localCount + m_tempCount;
+  for (unsigned int i = 0; i < m_code.size(); i++) {
+    const Instruction &ins = m_code[i];
+    printf("%4d  %-10s", i, OpName(ins.op));
+    int regs[] = { ins.dst, ins.a, ins.b };
+    for (int j = 0; j < 3; j++) {
+      int reg = regs[j];
+      if (reg < 0) continue;
+      if (reg < tempStart) {
+        printf(" $%s", m_localNames[reg].c_str());
+      } else if (reg < constStart) {
+        printf(" t%d", reg - tempStart);
+      } else {
+        int idx = reg - constStart;
+        String s = m_constants[idx].toString();
+        for (unsigned int k = 0; k < m_literals.size(); k++) {
+          if (m_literals[k].first == idx) s = m_literals[k].second;
+        }
+        printf(" %s", s.data());
+      }
+    }
+    if (ins.op >= Jump && ins.op <= JumpGe) {
+      printf(" -> %d", ins.target);
+    } else if (ins.op == Line) {
+      printf(" %d", ((const Location *)ins.aux)->line0);
+    }
+    printf("\n");
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+}
+}
@@ -0,0 +1,167 @@
+/*
+   +----------------------------------------------------------------------+
+   | HipHop for PHP                                                       |
+   +----------------------------------------------------------------------+
+   | Copyright (c) 2010 Facebook, Inc. (http://www.facebook.com)          |
+   +----------------------------------------------------------------------+
+   | This source file is subject to version 3.01 of the PHP license,      |
+   | that is bundled with this package in the file LICENSE, and is        |
+   | available through the world-wide-web at the following url:           |
+   | http://www.php.net/license/3_01.txt                                  |
+   | If you did not receive a copy of the PHP license and are unable to   |
+   | obtain it through the world-wide-web, please send a note to          |
+   | license@php.net so we can mail you a copy immediately.               |
+   +----------------------------------------------------------------------+
+*/
+
+#ifndef __EVAL_BYTE_CODE_PROGRAM_H__
+#define __EVAL_BYTE_CODE_PROGRAM_H__
+
+#include <runtime/eval/base/eval_base.h>
+
+namespace HPHP {
+namespace Eval {
+///////////////////////////////////////////////////////////////////////////////
+
+class Construct;
+class Expression;
+class Statement;
+class FunctionStatement;
+
+/**
+ * A function body lowered into linear code for a register machine. Locals
+ * are registers resolved from the function's VariableIndex table, so the
+ * code reads and writes them in place, next to temporaries and constants.
+ * Statements and expressions without a byteCode() of their own are kept as
+ * single instructions that evaluate their subtree, so a program can always
+ * be built, only more or less of it runs without the tree walker.
+ *
+ * Registers are encoded while compiling, because neither the number of
+ * temporaries nor the number of constants is known before the end:
+ *
+ *   [ locals | temporaries | constants ]
+ */
+class ByteCodeProgram {
+public:
+  enum OpCode {
+    Nop,
+    Line,      // set_line() of aux, a Location
+    Move,      // dst = a
+    // binary operators, dst = a op b
+    Add, Sub, Mul, Div, Mod, Concat, BitAnd, BitOr, BitXor, Shl, Shr, Xor,
+    Same, NSame, Eq, NEq, Lt, Le, Gt, Ge,
+    // unary operators, dst = op a
+    ToBool, Not, Neg, Plus, BitNot, CastInt, CastDouble, CastString,
+    CastArray,
+    // jumps to target, when the condition equals flag
+    Jump, JumpZ, JumpNZ,
+    JumpSame, JumpNSame, JumpEq, JumpNEq, JumpLt, JumpLe, JumpGt, JumpGe,
+    // a op= b on a local, flag is the parser's token, dst is optional
+    SetOp, AddTo, SubTo, ConcatTo,
+    PreInc, PreDec, PostInc, PostDec,
+    Echo,
+    Return, ReturnVoid,
+    Escape,    // break or continue out of the function, level in target
+    EvalExpr,  // dst = aux->eval(env)
+    EvalStmt,  // aux->eval(env), then handles break/continue/return
+    End,
+
+    OpCodeCount
+  };
+
+  // special values of "dst" when compiling an expression
+  enum {
+    AnyReg = -1, // put the result anywhere, it won't be written
+    NoReg  = -2  // the result is not used
+  };
+
+  /**
+   * Returns NULL when the function should stay with the tree walker.
+   */
+  static ByteCodeProgram *Compile(const FunctionStatement *func);
+
+  ~ByteCodeProgram();
+
+  /**
+   * Runs the function body in env, which has to be the function's own
+   * FuncScopeVariableEnvironment.
+   */
+  void execute(VariableEnvironment &env) const;
+
+  void dump() const;
+
+  bool refReturn() const;
+
+  // registers
+  int local(int idx) const;  // for reading, raising undefined notices
+  int lvalue(int idx) const; // for writing
+  int constant(CVarRef v);
+  int temp();
+  int target(int dst) { return dst >= 0 ? dst : temp();}
+  bool isLocal(int reg) const;
+  int place(int reg, int dst);
+  int stable(int reg, const Expression *next);
+
+  // code
+  int newLabel();
+  void bind(int label);
+  void emit(OpCode op, int dst = -1, int a = -1, int b = -1,
+            int target = -1, const void *aux = NULL, int flag = 0);
+  void emitLine(const Construct *c);
+  int emitExpression(const Expression *exp, int dst);
+  void emitStatement(const Statement *stmt);
+  void emitBreak(int level, bool isBreak);
+
+  void pushLoop(int breakLabel, int continueLabel);
+  void popLoop();
+
+  /**
+   * Temporaries are only given back after each statement, so registers
+   * holding parts of an expression are never reused before it's done.
+   */
+  int tempMark() const { return m_temps;}
+  void releaseTemps(int mark) { m_temps = mark;}
+
+private:
+  struct Instruction {
+    unsigned char op;
+    unsigned char check; // 1: a, 2: b are locals to check before reading
+    int flag;
+    int dst;
+    int a;
+    int b;
+    int target;
+    const void *aux;
+  };
+  struct LoopLabels {
+    int breakTo;
+    int continueTo;
+  };
+
+  std::vector<Instruction> m_code;
+  std::vector<Variant> m_constants;
+  // string constants that aren't static: constant index and value
+  typedef std::pair<int, std::string> Literal;
+  std::vector<Literal> m_literals;
+  std::vector<int> m_labels;
+  std::vector<LoopLabels> m_loops;
+  // loops around each EvalStmt, innermost last, for break and continue
+  std::vector<std::vector<LoopLabels> > m_loopStacks;
+  std::vector<std::string> m_localNames;
+  int m_localCount;
+  int m_temps;
+  int m_tempCount;
+  const FunctionStatement *m_func;
+
+  ByteCodeProgram(const FunctionStatement *func);
+  void finalize();
+  int decode(int reg) const;
+  void checkOperands(const Instruction &ins, Variant **r) const;
+  static const char *OpName(int op);
+};
+
+///////////////////////////////////////////////////////////////////////////////
+}
+}
+
+#endif /* __EVAL_BYTE_CODE_PROGRAM_H__ */
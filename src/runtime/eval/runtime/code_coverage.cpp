@@ -16,7 +16,10 @@
 
 #include <runtime/eval/runtime/code_coverage.h>
 #include <runtime/base/complex_types.h>
+#include <runtime/base/runtime_option.h>
+#include <runtime/base/util/request_local.h>
 #include <util/logger.h>
+#include <util/process.h>
 
 using namespace std;
 
@@ -24,47 +27,160 @@ namespace HPHP { namespace Eval {
 ///////////////////////////////////////////////////////////////////////////////
 
 Mutex CodeCoverage::s_mutex;
-CodeCoverage::CodeCoverageMap CodeCoverage::s_hits;
+std::vector<std::vector<int> > CodeCoverage::s_hits;
+ReadWriteMutex CodeCoverage::s_fileIdMutex;
+hphp_string_map<int> CodeCoverage::s_fileIds;
+std::vector<std::string> CodeCoverage::s_fileNames;
+
+int CodeCoverage::GetFileId(const char *filename) {
+  {
+    ReadLock lock(s_fileIdMutex);
+    hphp_string_map<int>::const_iterator iter = s_fileIds.find(filename);
+    if (iter != s_fileIds.end()) {
+      return iter->second;
+    }
+  }
+  WriteLock lock(s_fileIdMutex);
+  hphp_string_map<int>::const_iterator iter = s_fileIds.find(filename);
+  if (iter != s_fileIds.end()) {
+    return iter->second;
+  }
+  int id = s_fileNames.size();
+  s_fileNames.push_back(filename);
+  s_fileIds[filename] = id;
+  return id;
+}
 
-void CodeCoverage::Record(const char *filename, int line0, int line1) {
-  if (!filename || !*filename || line0 <= 0 || line1 <= 0 || line0 > line1) {
-    return;
+///////////////////////////////////////////////////////////////////////////////
+// per-thread counts
+
+class ThreadCoverage : public RequestEventHandler {
+public:
+  ThreadCoverage()
+    : m_sampled(false), m_lastName(NULL), m_lastLines(NULL) {
+    // rand() shares one state, and a lock, among all threads
+    m_seed = (unsigned int)time(NULL) ^ (unsigned int)Process::GetThreadId();
   }
 
-  Lock lock(s_mutex);
+  virtual void requestInit() {
+    int rate = RuntimeOption::CodeCoverageSampleRate;
+    m_sampled = rate <= 1 || rand_r(&m_seed) % rate == 0;
+    // file names are only known to stay put within one request
+    m_fileIds.clear();
+    m_lastName = NULL;
+    m_lastLines = NULL;
+  }
 
-  CodeCoverageMap::iterator iter = s_hits.find(filename);
-  if (iter == s_hits.end()) {
-    vector<int> &lines = s_hits[filename];
-    lines.resize(line1 + 1);
-    for (int i = line0; i <= line1; i++) {
-      lines[i] = 1;
+  virtual void requestShutdown() {
+    flush();
+  }
+
+  void record(const char *filename, int line0, int line1) {
+    if (!m_sampled) return;
+
+    std::vector<int> *lines = m_lastLines;
+    if (filename != m_lastName) {
+      lines = &getLines(filename);
+      m_lastName = filename;
+      m_lastLines = lines;
     }
-  } else {
-    vector<int> &lines = iter->second;
-    if ((int)lines.size() < line1 + 1) {
-      lines.resize(line1 + 1);
+    if ((int)lines->size() < line1 + 1) {
+      lines->resize(line1 + 1);
     }
+    int *counts = &(*lines)[0];
     for (int i = line0; i <= line1; i++) {
-      ++lines[i];
+      ++counts[i];
+    }
+  }
+
+  void flush() {
+    if (m_touched.empty()) return;
+    Lock lock(CodeCoverage::s_mutex);
+    for (unsigned int i = 0; i < m_touched.size(); i++) {
+      int id = m_touched[i];
+      std::vector<int> &lines = m_hits[id];
+      if ((int)CodeCoverage::s_hits.size() <= id) {
+        CodeCoverage::s_hits.resize(id + 1);
+      }
+      std::vector<int> &total = CodeCoverage::s_hits[id];
+      if (total.size() < lines.size()) {
+        total.resize(lines.size());
+      }
+      for (unsigned int j = 0; j < lines.size(); j++) {
+        total[j] += lines[j];
+        lines[j] = 0;
+      }
+      m_dirty[id] = false;
     }
+    m_touched.clear();
+    m_lastName = NULL; // so the next record() marks its file touched again
   }
+
+private:
+  bool m_sampled;
+  unsigned int m_seed;
+  hphp_hash_map<const char *, int, pointer_hash<const char> > m_fileIds;
+  std::vector<std::vector<int> > m_hits; // by file id, kept across requests
+  std::vector<int> m_touched; // file ids with counts not yet flushed
+  std::vector<char> m_dirty;  // whether a file id is in m_touched
+  const char *m_lastName;
+  std::vector<int> *m_lastLines;
+
+  std::vector<int> &getLines(const char *filename) {
+    int id;
+    hphp_hash_map<const char *, int, pointer_hash<const char> >::iterator
+      iter = m_fileIds.find(filename);
+    if (iter != m_fileIds.end()) {
+      id = iter->second;
+    } else {
+      id = CodeCoverage::GetFileId(filename);
+      m_fileIds[filename] = id;
+    }
+    if ((int)m_hits.size() <= id) {
+      m_hits.resize(id + 1);
+      m_dirty.resize(id + 1);
+    }
+    if (!m_dirty[id]) {
+      m_dirty[id] = true;
+      m_touched.push_back(id);
+    }
+    return m_hits[id];
+  }
+};
+IMPLEMENT_STATIC_REQUEST_LOCAL(ThreadCoverage, s_thread_coverage);
+
+///////////////////////////////////////////////////////////////////////////////
+
+void CodeCoverage::Record(const char *filename, int line0, int line1) {
+  if (!filename || !*filename || line0 <= 0 || line1 <= 0 || line0 > line1) {
+    return;
+  }
+  s_thread_coverage->record(filename, line0, line1);
+}
+
+void CodeCoverage::Flush() {
+  s_thread_coverage->flush();
 }
 
 Array CodeCoverage::Report() {
   Lock lock(s_mutex);
+  std::vector<std::string> names;
+  {
+    ReadLock lock(s_fileIdMutex);
+    names = s_fileNames;
+  }
 
   Array ret = Array::Create();
-  for (CodeCoverageMap::const_iterator iter = s_hits.begin();
-       iter != s_hits.end(); ++iter) {
-    const vector<int> &lines = iter->second;
+  for (unsigned int id = 0; id < s_hits.size(); id++) {
+    const vector<int> &lines = s_hits[id];
+    if (lines.empty()) continue;
     Array tmp = Array::Create();
     for (int i = 1; i < (int)lines.size(); i++) {
       if (lines[i]) {
         tmp.set(i, Variant((int64)lines[i]));
       }
     }
-    ret.set(String(iter->first), Variant(tmp));
+    ret.set(String(names[id]), Variant(tmp));
   }
 
   return ret;
@@ -72,6 +188,11 @@ Array CodeCoverage::Report() {
 
 void CodeCoverage::Report(const std::string &filename) {
   Lock lock(s_mutex);
+  std::vector<std::string> names;
+  {
+    ReadLock lock(s_fileIdMutex);
+    names = s_fileNames;
+  }
 
   ofstream f(filename.c_str());
   if (!f) {
@@ -80,10 +201,15 @@ void CodeCoverage::Report(const std::string &filename) {
   }
 
   f << "{\n";
-  for (CodeCoverageMap::const_iterator iter = s_hits.begin();
-       iter != s_hits.end();) {
-    const vector<int> &lines = iter->second;
-    f << "\"" << iter->first << "\": [";
+  bool first = true;
+  for (unsigned int id = 0; id < s_hits.size(); id++) {
+    const vector<int> &lines = s_hits[id];
+    if (lines.empty()) continue;
+    if (!first) {
+      f << ",\n";
+    }
+    first = false;
+    f << "\"" << names[id] << "\": [";
     int count = lines.size();
     for (int i = 0 /* not 1 */; i < count; i++) {
       f << lines[i];
@@ -92,9 +218,8 @@ void CodeCoverage::Report(const std::string &filename) {
       }
     }
     f << "]";
-    if (++iter != s_hits.end()) {
-      f << ",";
-    }
+  }
+  if (!first) {
     f << "\n";
   }
   f << "}\n";
@@ -23,10 +23,21 @@
 namespace HPHP { namespace Eval {
 ///////////////////////////////////////////////////////////////////////////////
 
+/**
+ * Line hits are counted in per-thread tables without any locking, and folded
+ * into the shared ones at the end of each request. A file name is turned into
+ * a file id once per request, so recording a line is just an increment.
+ */
 class CodeCoverage {
 public:
   static void Record(const char *filename, int line0, int line1);
 
+  /**
+   * Fold the current thread's counts into the shared ones, so they show up
+   * in reports before this request ends.
+   */
+  static void Flush();
+
   /**
    * Returns an array in this format,
    *
@@ -44,10 +55,18 @@ public:
   static void Report(const std::string &filename);
 
 private:
-  typedef hphp_const_char_map<std::vector<int> > CodeCoverageMap;
+  friend class ThreadCoverage;
+
+  /**
+   * File ids index both per-thread and shared counts.
+   */
+  static int GetFileId(const char *filename);
 
-  static Mutex s_mutex;
-  static CodeCoverageMap s_hits;
+  static Mutex s_mutex; // guards s_hits
+  static std::vector<std::vector<int> > s_hits;
+  static ReadWriteMutex s_fileIdMutex;
+  static hphp_string_map<int> s_fileIds;
+  static std::vector<std::string> s_fileNames;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
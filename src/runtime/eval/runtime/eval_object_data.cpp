@@ -19,10 +19,71 @@
 #include <runtime/eval/ast/class_statement.h>
 #include <runtime/base/hphp_system.h>
 #include <runtime/eval/runtime/eval_state.h>
+#include <util/thread_local.h>
 
 namespace HPHP {
 namespace Eval {
 
+/////////////////////////////////////////////////////////////////////////////
+// slots
+
+/**
+ * Slots are in request memory, like the objects themselves, so those still
+ * alive when a request ends, in cycles for instance, don't leak them: smart
+ * allocators are reset then, without running any destructor. Slot counts are
+ * rounded up to size classes about 50% apart, each with its own allocator.
+ */
+class SlotAllocator {
+public:
+  static SlotAllocator *Create() { return new SlotAllocator();}
+  static void Delete(SlotAllocator *p) { delete p;}
+  static void OnThreadExit(SlotAllocator *p) { delete p;}
+
+  ~SlotAllocator() {
+    for (unsigned int i = 0; i < m_allocators.size(); i++) {
+      delete m_allocators[i];
+    }
+  }
+
+  Variant *alloc(int count) {
+    ObjectAllocatorBase *a = getAllocator(count);
+    Variant *slots = (Variant *)a->alloc();
+    for (int i = 0; i < count; i++) {
+      new (slots + i) Variant();
+    }
+    return slots;
+  }
+
+  void release(Variant *slots, int count) {
+    for (int i = 0; i < count; i++) {
+      slots[i].~Variant();
+    }
+    getAllocator(count)->release(slots);
+  }
+
+private:
+  std::vector<ObjectAllocatorBase *> m_allocators;
+
+  ObjectAllocatorBase *getAllocator(int count) {
+    unsigned int index = 0;
+    int size = 1;
+    while (size < count) {
+      size += (size + 1) >> 1;
+      index++;
+    }
+    if (index >= m_allocators.size()) {
+      m_allocators.resize(index + 1);
+    }
+    ObjectAllocatorBase *&a = m_allocators[index];
+    if (a == NULL) {
+      a = new ObjectAllocatorBase(size * sizeof(Variant));
+    }
+    return a;
+  }
+};
+
+static ThreadLocalSingleton<SlotAllocator> s_slot_allocator;
+
 /////////////////////////////////////////////////////////////////////////////
 // constructor/destructor
 
@@ -30,18 +91,34 @@ IMPLEMENT_OBJECT_ALLOCATION_CLS(HPHP::Eval,EvalObjectData)
 
 EvalObjectData::EvalObjectData(ClassEvalState &cls, const char* pname,
                                ObjectData* r /* = NULL */)
-: DynamicObjectData(pname, r ? r : this), m_cls(cls) {
+: DynamicObjectData(pname, r ? r : this), m_cls(cls), m_props(NULL) {
   if (pname) setRoot(root); // For ext classes
   if (r == NULL) {
     RequestEvalState::registerObject(this);
   }
   if (getMethodStatement("__get")) setAttribute(UseGet);
   if (getMethodStatement("__set")) setAttribute(UseSet);
+  allocateSlots();
 }
 
 // Only used for cloning and so should not register object
 EvalObjectData::EvalObjectData(ClassEvalState &cls) :
-  DynamicObjectData(NULL, this), m_cls(cls) {
+  DynamicObjectData(NULL, this), m_cls(cls), m_props(NULL) {
+  allocateSlots();
+}
+
+EvalObjectData::~EvalObjectData() {
+  if (m_props) {
+    s_slot_allocator->release(m_props, m_cls.getLayout().size());
+  }
+}
+
+void EvalObjectData::allocateSlots() {
+  setAttribute(IsEvalObject);
+  int count = m_cls.getLayout().size();
+  if (count) {
+    m_props = s_slot_allocator->alloc(count);
+  }
 }
 
 ObjectData *EvalObjectData::dynCreate(CArrRef params, bool ini /* = true */) {
@@ -94,32 +171,41 @@ void EvalObjectData::destruct() {
 }
 
 Array EvalObjectData::o_toArray() const {
-  Array values(DynamicObjectData::o_toArray());
-  Array props(Array::Create());
-  m_cls.getClass()->toArray(props, values);
-  if (!values.empty()) {
-    props += values;
+  if (parent.isNull()) {
+    // o_getArray() lists the slots, before dynamic properties
+    return DynamicObjectData::o_toArray();
   }
+  Array props(Array::Create());
+  getSlotArray(props);
+  props += parent->o_toArray();
   return props;
 }
 
 Variant *EvalObjectData::o_realProp(CStrRef s, int flags,
                                     CStrRef context /* = null_string */) const {
   CStrRef c = context.isNull() ? FrameInjection::GetClassName(false) : context;
-  if (Variant *priv =
-      const_cast<Array&>(m_privates).lvalPtr(c, flags & RealPropWrite, false)) {
-    if (Variant *ret = priv->lvalPtr(s, flags & RealPropWrite, false)) {
-      return ret;
-    }
-  }
-  int mods;
-  if (!(flags & RealPropUnchecked) &&
-      !m_cls.getClass()->attemptPropertyAccess(s, c, mods)) {
+  bool accessible;
+  int slot = m_cls.getLayout().find(s, c, accessible);
+  if (!accessible && !(flags & RealPropUnchecked)) {
     return NULL;
   }
+  if (slot >= 0) {
+    return m_props + slot;
+  }
   return DynamicObjectData::o_realProp(s, flags);
 }
 
+const PropertyLayout &EvalObjectData::getLayout() const {
+  return m_cls.getLayout();
+}
+
+int EvalObjectData::findSlot(const char *prop, int len, int64 hash,
+                             CStrRef context) const {
+  bool accessible;
+  int slot = m_cls.getLayout().find(prop, len, hash, context, accessible);
+  return accessible ? slot : -1;
+}
+
 Variant EvalObjectData::o_getError(CStrRef prop, CStrRef context) {
   CStrRef c = context.isNull() ? FrameInjection::GetClassName(false) : context;
   int mods;
@@ -141,19 +227,28 @@ Variant EvalObjectData::o_setError(CStrRef prop, CStrRef context) {
 }
 
 void EvalObjectData::o_getArray(Array &props) const {
+  getSlotArray(props);
+  DynamicObjectData::o_getArray(props);
+}
+
+void EvalObjectData::getSlotArray(Array &props) const {
+  const PropertyLayout &layout = m_cls.getLayout();
   String zero("\0", 1, AttachLiteral);
-  for (ArrayIter it(m_privates); !it.end(); it.next()) {
-    String prefix(zero);
-    prefix += it.first();
-    prefix += zero;
-    for (ArrayIter it2(it.second()); !it2.end(); it2.next()) {
-      CVarRef v = it2.secondRef();
-      if (v.isInitialized()) {
-        props.set(prefix + it2.first(), v.isReferenced() ? ref(v) : v);
-      }
+  for (int i = 0; i < layout.size(); i++) {
+    CVarRef v = m_props[i];
+    if (!v.isInitialized()) continue;
+    const PropertyLayout::Slot &slot = layout.slot(i);
+    const std::string &name = slot.var->name();
+    String key(name.c_str(), name.size(), AttachLiteral);
+    if (slot.modifiers & ClassStatement::Private) {
+      const std::string &cls = slot.cls->name();
+      String prefix(zero);
+      prefix += String(cls.c_str(), cls.size(), AttachLiteral);
+      prefix += zero;
+      key = prefix + key;
     }
+    props.set(key, v.isReferenced() ? ref(v) : v);
   }
-  DynamicObjectData::o_getArray(props);
 }
 
 void EvalObjectData::o_setArray(CArrRef props) {
@@ -169,11 +264,6 @@ void EvalObjectData::o_setArray(CArrRef props) {
   DynamicObjectData::o_setArray(props);
 }
 
-void EvalObjectData::o_setPrivate(const char *cls, const char *s, int64 hash,
-                                  CVarRef v) {
-  m_privates.lvalAt(cls).set(s, v, hash);
-}
-
 CStrRef EvalObjectData::o_getClassName() const {
   if (m_class_name.isNull()) {
     // an object can never live longer than its class
@@ -458,7 +548,12 @@ ObjectData* EvalObjectData::cloneImpl() {
   } else {
     cloneSet(e);
   }
-  e->m_privates = m_privates;
+  for (int i = 0; i < m_cls.getLayout().size(); i++) {
+    CVarRef v = m_props[i];
+    if (v.isInitialized()) {
+      e->m_props[i] = v.isReferenced() ? ref(v) : v;
+    }
+  }
   // Registration is done here because the clone constructor is not
   // passed root.
   if (root == this) {
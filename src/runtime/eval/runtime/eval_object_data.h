@@ -26,6 +26,7 @@ namespace Eval {
 
 class ClassStatement;
 class ClassEvalState;
+class PropertyLayout;
 
 class EvalObjectData : public DynamicObjectData {
   DECLARE_OBJECT_ALLOCATION(EvalObjectData);
@@ -33,6 +34,7 @@ public:
   EvalObjectData(ClassEvalState &cls, const char* pname,
                  ObjectData *r = NULL);
   EvalObjectData(ClassEvalState &cls);
+  ~EvalObjectData();
   ObjectData *dynCreate(CArrRef params, bool init /* = true */);
   void dynConstruct(CArrRef params);
   void dynConstructFromEval(VariableEnvironment &env,
@@ -46,7 +48,11 @@ public:
   virtual void o_setArray(CArrRef props);
   virtual Variant *o_realProp(CStrRef prop, int flags,
                               CStrRef context = null_string) const;
-  void o_setPrivate(const char *cls, const char *s, int64 hash, CVarRef v);
+
+  // declared properties, in slots laid out by the class
+  const PropertyLayout &getLayout() const;
+  Variant *getSlot(int i) const { return m_props + i;}
+  int findSlot(const char *prop, int len, int64 hash, CStrRef context) const;
 
   virtual Variant o_getError(CStrRef prop, CStrRef context);
   virtual Variant o_setError(CStrRef prop, CStrRef context);
@@ -96,8 +102,11 @@ protected:
 
 private:
   ClassEvalState &m_cls;
-  Array m_privates;
+  Variant *m_props;
   mutable String m_class_name;
+
+  void allocateSlots();
+  void getSlotArray(Array &props) const;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
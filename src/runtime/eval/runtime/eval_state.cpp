@@ -51,6 +51,7 @@ void ClassEvalState::initializeInstance() {
   if (!m_initializedInstance) {
     semanticCheck();
     m_class->loadMethodTable(*this);
+    m_layout.init(m_class);
     m_initializedInstance = true;
   }
 }
@@ -20,6 +20,7 @@
 #include <runtime/eval/base/eval_base.h>
 #include <runtime/base/class_info.h>
 #include <runtime/eval/runtime/variant_stack.h>
+#include <runtime/eval/runtime/property_layout.h>
 #include <util/case_insensitive.h>
 
 namespace HPHP {
@@ -55,6 +56,9 @@ public:
   LVariableTable &getStatics() {
     return m_statics;
   }
+  const PropertyLayout &getLayout() const {
+    return m_layout;
+  }
   void initializeInstance();
   void initializeStatics();
   void semanticCheck();
@@ -62,6 +66,7 @@ private:
   const ClassStatement *m_class;
   hphp_const_char_imap<const MethodStatement*> m_methodTable;
   const MethodStatement *m_constructor;
+  PropertyLayout m_layout;
   LVariableTable m_statics;
   bool m_initializedInstance;
   bool m_initializedStatics;
@@ -0,0 +1,114 @@
+/*
+   +----------------------------------------------------------------------+
+   | HipHop for PHP                                                       |
+   +----------------------------------------------------------------------+
+   | Copyright (c) 2010 Facebook, Inc. (http://www.facebook.com)          |
+   +----------------------------------------------------------------------+
+   | This source file is subject to version 3.01 of the PHP license,      |
+   | that is bundled with this package in the file LICENSE, and is        |
+   | available through the world-wide-web at the following url:           |
+   | http://www.php.net/license/3_01.txt                                  |
+   | If you did not receive a copy of the PHP license and are unable to   |
+   | obtain it through the world-wide-web, please send a note to          |
+   | license@php.net so we can mail you a copy immediately.               |
+   +----------------------------------------------------------------------+
+*/
+
+#include <runtime/eval/runtime/property_layout.h>
+#include <runtime/eval/ast/class_statement.h>
+#include <runtime/base/complex_types.h>
+#include <util/atomic.h>
+
+namespace HPHP {
+namespace Eval {
+///////////////////////////////////////////////////////////////////////////////
+
+int64 PropertyLayout::s_serial = 0;
+
+void PropertyLayout::init(const ClassStatement *cls) {
+  ASSERT(m_slots.empty());
+  m_class = cls;
+  m_serial = atomic_add(s_serial, (int64)1) + 1;
+  cls->loadPropertyLayout(*this);
+}
+
+bool PropertyLayout::sameName(const Slot &s, const char *name,
+                              int len) const {
+  const std::string &n = s.var->name();
+  return (int)n.size() == len && memcmp(n.data(), name, len) == 0;
+}
+
+void PropertyLayout::add(const ClassStatement *cls, const ClassVariable *var) {
+  int mods = var->getModifiers();
+  ASSERT((mods & ClassStatement::Static) == 0);
+  const std::string &name = var->name();
+
+  int head = -1;
+  hphp_hash_map<int64, int, int64_hash>::const_iterator it =
+    m_heads.find(var->getHash());
+  if (it != m_heads.end()) {
+    head = it->second;
+    if (!(mods & ClassStatement::Private)) {
+      // a subclass has redeclared it already
+      for (int i = head; i >= 0; i = m_slots[i].next) {
+        const Slot &s = m_slots[i];
+        if (!(s.modifiers & ClassStatement::Private) &&
+            sameName(s, name.data(), name.size())) {
+          return;
+        }
+      }
+    }
+  }
+
+  Slot s;
+  s.cls = cls;
+  s.var = var;
+  s.modifiers = mods;
+  s.next = head;
+  m_slots.push_back(s);
+  m_heads[var->getHash()] = m_slots.size() - 1;
+}
+
+int PropertyLayout::find(CStrRef name, CStrRef context,
+                         bool &accessible) const {
+  if (name.empty()) {
+    accessible = true;
+    return -1;
+  }
+  return find(name.data(), name.size(), name->hash(), context, accessible);
+}
+
+int PropertyLayout::find(const char *name, int len, int64 hash,
+                         CStrRef context, bool &accessible) const {
+  accessible = true;
+  hphp_hash_map<int64, int, int64_hash>::const_iterator it =
+    m_heads.find(hash);
+  if (it == m_heads.end()) return -1;
+
+  int visible = -1;
+  bool ownPrivate = false;
+  for (int i = it->second; i >= 0; i = m_slots[i].next) {
+    const Slot &s = m_slots[i];
+    if (!sameName(s, name, len)) continue;
+    if (s.modifiers & ClassStatement::Private) {
+      if (strcasecmp(s.cls->name().c_str(), context.data()) == 0) {
+        return i;
+      }
+      if (s.cls == m_class) ownPrivate = true;
+    } else {
+      visible = i;
+    }
+  }
+  if (ownPrivate) {
+    accessible = false;
+  } else if (visible >= 0 &&
+             (m_slots[visible].modifiers & ClassStatement::Protected)) {
+    accessible = m_slots[visible].cls->hasAccess(context.data(),
+                                                 ClassStatement::Protected);
+  }
+  return visible;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+}
+}
@@ -0,0 +1,82 @@
+/*
+   +----------------------------------------------------------------------+
+   | HipHop for PHP                                                       |
+   +----------------------------------------------------------------------+
+   | Copyright (c) 2010 Facebook, Inc. (http://www.facebook.com)          |
+   +----------------------------------------------------------------------+
+   | This source file is subject to version 3.01 of the PHP license,      |
+   | that is bundled with this package in the file LICENSE, and is        |
+   | available through the world-wide-web at the following url:           |
+   | http://www.php.net/license/3_01.txt                                  |
+   | If you did not receive a copy of the PHP license and are unable to   |
+   | obtain it through the world-wide-web, please send a note to          |
+   | license@php.net so we can mail you a copy immediately.               |
+   +----------------------------------------------------------------------+
+*/
+
+#ifndef __HPHP_EVAL_PROPERTY_LAYOUT_H__
+#define __HPHP_EVAL_PROPERTY_LAYOUT_H__
+
+#include <runtime/base/types.h>
+
+namespace HPHP {
+namespace Eval {
+///////////////////////////////////////////////////////////////////////////////
+
+class ClassStatement;
+class ClassVariable;
+
+/**
+ * Where an eval'd class keeps the declared properties of its objects: one
+ * Variant slot each, in the order they are listed by var_dump(), the class's
+ * own first, then its parent's. Public and protected properties redeclared
+ * by a subclass share one slot, while private ones always get their own.
+ * Properties that aren't declared stay in the object's dynamic array.
+ *
+ * A layout is built once per request and class, since parents are only
+ * known when the class is declared. Each one has a serial number unique to
+ * the process, so call sites can cache slots across objects of a class.
+ */
+class PropertyLayout {
+public:
+  struct Slot {
+    const ClassStatement *cls; // where it is declared
+    const ClassVariable *var;
+    int modifiers;
+    int next;                  // another slot whose name has the same hash
+  };
+
+  PropertyLayout() : m_class(NULL), m_serial(0) {}
+
+  void init(const ClassStatement *cls);
+  void add(const ClassStatement *cls, const ClassVariable *var);
+
+  int64 serial() const { return m_serial;}
+  int size() const { return m_slots.size();}
+  const Slot &slot(int i) const { return m_slots[i];}
+
+  /**
+   * Finds the slot of a declared property, as class "context" sees it.
+   * Returns -1 if it's dynamic. "accessible" is false when context isn't
+   * allowed to touch the property.
+   */
+  int find(CStrRef name, CStrRef context, bool &accessible) const;
+  int find(const char *name, int len, int64 hash, CStrRef context,
+           bool &accessible) const;
+
+private:
+  const ClassStatement *m_class;
+  int64 m_serial;
+  std::vector<Slot> m_slots;
+  hphp_hash_map<int64, int, int64_hash> m_heads;
+
+  static int64 s_serial;
+
+  bool sameName(const Slot &s, const char *name, int len) const;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+}
+}
+
+#endif /* __HPHP_EVAL_PROPERTY_LAYOUT_H__ */
@@ -416,7 +416,13 @@ static void utf16_to_utf8(StringBuffer &buf, unsigned short utf16) {
 
 static void object_set(Variant &var, StringBuffer &key, Variant &value,
                        int assoc) {
-  String data = key.detach();
+  String data;
+  if (!key.empty()) {
+    data = StaticString::Lookup(key.data(), key.size());
+  }
+  if (data.isNull()) {
+    data = key.detach();
+  }
   if (!assoc) {
     if (data.empty()) {
       var.toObject()->o_set("_empty_", ref(value));
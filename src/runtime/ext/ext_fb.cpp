@@ -827,6 +827,7 @@ Array f_fb_call_user_func_array_safe(CVarRef function, CArrRef params) {
 
 Variant f_fb_get_code_coverage() {
   if (RuntimeOption::RecordCodeCoverage) {
+    Eval::CodeCoverage::Flush();
     return Eval::CodeCoverage::Report();
   }
   return false;
@@ -26,6 +26,7 @@
 #include <runtime/base/util/http_client.h>
 #include <runtime/base/util/request_local.h>
 #include <runtime/base/server/static_content_cache.h>
+#include <runtime/base/shared/thread_shared_variant.h>
 #include <runtime/base/zend/zend_scanf.h>
 #include <runtime/base/file/pipe.h>
 #include <util/logger.h>
@@ -129,6 +130,84 @@ static Array stat_impl(struct stat *stat_sb) {
   return ret;
 }
 
+/**
+ * Process-wide cache of what parse_ini_file() and parse_hdf_file() return,
+ * kept as immutable ThreadSharedVariants, so a hit is handed out as a
+ * SharedMap without copying. Just like FileRepository does with PHP files,
+ * files are stat-ed on every call and parsed again once their mtime, size,
+ * inode or device changes. Size is compared too, because mtime only has
+ * second granularity. At most RuntimeOption::ParsedFileCacheSize files are
+ * kept, so scripts parsing generated file names can't grow it without bound.
+ */
+class ParsedFileCache {
+public:
+  /**
+   * Stats the file, so to know whether it's a regular file that can be
+   * cached, and to validate or store an entry with the result.
+   */
+  static bool Stat(CStrRef path, struct stat &s) {
+    if (path.empty() || path.find("://") >= 0) return false;
+    return stat(path.data(), &s) == 0 && S_ISREG(s.st_mode);
+  }
+
+  bool get(const std::string &key, const struct stat &s, Variant &ret) {
+    ReadLock lock(m_mutex);
+    EntryMap::const_iterator iter = m_entries.find(key);
+    if (iter == m_entries.end() || iter->second.isChanged(s)) {
+      return false;
+    }
+    ret = iter->second.value->toLocal();
+    return true;
+  }
+
+  void set(const std::string &key, const struct stat &s, CVarRef parsed) {
+    Entry entry;
+    entry.value = new ThreadSharedVariant(parsed, false);
+    entry.mtime = s.st_mtime;
+    entry.size = s.st_size;
+    entry.ino = s.st_ino;
+    entry.dev = s.st_dev;
+
+    WriteLock lock(m_mutex);
+    EntryMap::iterator iter = m_entries.find(key);
+    if (iter != m_entries.end()) {
+      iter->second.value->decRef();
+      iter->second = entry;
+    } else {
+      if ((int)m_entries.size() >= RuntimeOption::ParsedFileCacheSize) {
+        // any entry will do: they are all cheap to parse again
+        iter = m_entries.begin();
+        if (iter == m_entries.end()) {
+          entry.value->decRef();
+          return;
+        }
+        iter->second.value->decRef();
+        m_entries.erase(iter);
+      }
+      m_entries[key] = entry;
+    }
+  }
+
+private:
+  struct Entry {
+    SharedVariant *value;
+    time_t mtime;
+    off_t size;
+    ino_t ino;
+    dev_t dev;
+
+    bool isChanged(const struct stat &s) const {
+      return mtime != s.st_mtime || size != s.st_size ||
+        ino != s.st_ino || dev != s.st_dev;
+    }
+  };
+  typedef hphp_hash_map<std::string, Entry, string_hash> EntryMap;
+
+  ReadWriteMutex m_mutex;
+  EntryMap m_entries;
+};
+static ParsedFileCache s_parsed_file_cache;
+
 ///////////////////////////////////////////////////////////////////////////////
 
 Variant f_fopen(CStrRef filename, CStrRef mode,
@@ -482,10 +561,26 @@ Variant f_parse_ini_file(CStrRef filename, bool process_sections /* = false */,
       }
     }
   }
+
+  struct stat s;
+  string key;
+  bool cacheable = RuntimeOption::EnableParsedFileCache &&
+    ParsedFileCache::Stat(translated, s);
+  if (cacheable) {
+    key = string("ini:") + (process_sections ? "1:" : "0:") +
+      String((int64)scanner_mode).data() + ":" + translated.data();
+    Variant ret;
+    if (s_parsed_file_cache.get(key, s, ret)) return ret;
+  }
+
   Variant content = f_file_get_contents(translated);
   if (same(content, false)) return false;
-  return IniSetting::FromString(content, filename, process_sections,
-                                scanner_mode);
+  Variant ret = IniSetting::FromString(content, filename, process_sections,
+                                       scanner_mode);
+  if (cacheable && ret.isArray()) {
+    s_parsed_file_cache.set(key, s, ret);
+  }
+  return ret;
 }
 
 Variant f_parse_ini_string(CStrRef ini, bool process_sections /* = false */,
@@ -494,9 +589,24 @@ Variant f_parse_ini_string(CStrRef ini, bool process_sections /* = false */,
 }
 
 Variant f_parse_hdf_file(CStrRef filename) {
+  String translated = File::TranslatePath(filename);
+  struct stat s;
+  string key;
+  bool cacheable = RuntimeOption::EnableParsedFileCache &&
+    ParsedFileCache::Stat(translated, s);
+  if (cacheable) {
+    key = string("hdf:") + translated.data();
+    Variant ret;
+    if (s_parsed_file_cache.get(key, s, ret)) return ret;
+  }
+
   Variant content = f_file_get_contents(filename);
   if (same(content, false)) return false;
-  return f_parse_hdf_string(content);
+  Variant ret = f_parse_hdf_string(content);
+  if (cacheable && ret.isArray()) {
+    s_parsed_file_cache.set(key, s, ret);
+  }
+  return ret;
 }
 
 Variant f_parse_hdf_string(CStrRef input) {
@@ -16,7 +16,10 @@
 */
 
 #include <runtime/ext/ext_fb.h>
+#include <runtime/ext/stack_sampler.h>
 #include <runtime/base/memory/memory_manager.h>
+#include <runtime/base/frame_injection.h>
+#include <runtime/base/runtime_option.h>
 #include <runtime/base/util/request_local.h>
 #include <runtime/base/zend/zend_math.h>
 
@@ -53,13 +56,19 @@
 #include <iostream>
 #include <fstream>
 #include <zlib.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/syscall.h>
+#include <util/lock.h>
+#include <util/logger.h>
+#include <util/util.h>
+#include <util/hash.h>
 
 // Append the delimiter
 #define HP_STACK_DELIM        "==>"
 #define HP_STACK_DELIM_LEN    (sizeof(HP_STACK_DELIM) - 1)
 
 namespace HPHP {
-IMPLEMENT_DEFAULT_EXTENSION(hotprofiler);
 ///////////////////////////////////////////////////////////////////////////////
 // helpers
 
@@ -1269,6 +1278,374 @@ private:
   }
 };
 
+///////////////////////////////////////////////////////////////////////////////
+// stack sampler
+
+#ifdef __linux__
+
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+
+/**
+ * Stacks sampled on one thread, as a tree of nodes in an open addressing
+ * table keyed by caller's slot and function name pointer. Only the owning
+ * thread adds nodes, from its signal handler, and a node's name is written
+ * last, so other threads can read the table while it grows.
+ */
+class SampleTable {
+public:
+  static const int MaxDepth = 128;
+
+  static const int AverageNameSize = 32;
+
+  /**
+   * Function names from FrameInjection may live in an eval'd file's AST,
+   * which is freed when the file is reloaded, so each node keeps its own
+   * copy of the name. The signal handler can't malloc(), so copies come
+   * from a buffer allocated with the table.
+   */
+  struct Node {
+    const char *key;  // FrameInjection's name pointer, NULL if slot is free
+    const char *name; // copy of what key pointed to when recorded
+    int parent;       // slot of the caller, or -1
+    int count;        // samples with this function on top of the stack
+  };
+
+  SampleTable(int size) : m_info(NULL), m_inUse(true), m_generation(0) {
+    int capacity = 64;
+    while (capacity < size) capacity <<= 1;
+    m_mask = capacity - 1;
+    m_maxUsed = capacity / 4 * 3;
+    m_nodes = (Node*)calloc(capacity, sizeof(Node));
+    m_namesSize = m_maxUsed * AverageNameSize;
+    m_names = (char*)malloc(m_namesSize);
+    clear();
+  }
+
+  ~SampleTable() {
+    free(m_nodes);
+    free(m_names);
+  }
+
+  void clear() {
+    memset(m_nodes, 0, (m_mask + 1) * sizeof(Node));
+    m_used = 0;
+    m_namesUsed = 0;
+    m_samples = m_idle = m_dropped = 0;
+  }
+
+  /**
+   * Called from the signal handler.
+   */
+  void sample() {
+    FrameInjection *top = m_info ? m_info->m_top : NULL;
+    if (top == NULL) {
+      m_idle++;
+      return;
+    }
+    const char *frames[MaxDepth];
+    int depth = 0;
+    FrameInjection *frame;
+    for (frame = top; frame && depth < MaxDepth; frame = frame->getPrev()) {
+      frames[depth++] = frame->getFunction();
+    }
+    int parent = -1;
+    if (frame) { // deeper than MaxDepth
+      parent = find(-1, "(truncated)");
+      if (parent < 0) {
+        m_dropped++; // table is full
+        return;
+      }
+    }
+    while (depth > 0) {
+      parent = find(parent, frames[--depth]);
+      if (parent < 0) {
+        m_dropped++;
+        return;
+      }
+    }
+    m_nodes[parent].count++;
+    m_samples++;
+  }
+
+  ThreadInfo *m_info;
+  bool m_inUse;
+  int m_generation;
+
+  Node *m_nodes;
+  int m_mask;
+  int m_used;
+  int m_maxUsed;
+  int64 m_samples;
+  int64 m_idle;
+  int64 m_dropped;
+
+private:
+  char *m_names;
+  int m_namesSize;
+  int m_namesUsed;
+
+  int find(int parent, const char *name) {
+    uint64 h = hash_int64((int64)name ^ ((int64)parent << 32));
+    for (int slot = h & m_mask; ; slot = (slot + 1) & m_mask) {
+      Node &node = m_nodes[slot];
+      // the same address may hold another name after a reload
+      if (node.key == name && node.parent == parent &&
+          strcmp(node.name, name) == 0) {
+        return slot;
+      }
+      if (node.key == NULL) {
+        if (m_used >= m_maxUsed) return -1;
+        int len = strlen(name) + 1;
+        if (m_namesUsed + len > m_namesSize) return -1;
+        char *copy = m_names + m_namesUsed;
+        memcpy(copy, name, len);
+        m_namesUsed += len;
+        node.name = copy;
+        node.parent = parent;
+        node.count = 0;
+        __sync_synchronize();
+        node.key = name;
+        m_used++;
+        return slot;
+      }
+    }
+  }
+};
+
+static Mutex s_sampler_mutex;
+static vector<SampleTable*> s_sample_tables;
+static bool s_sampler_installed = false;
+static volatile int s_sample_frequency = 0;
+static volatile int s_sample_generation = 0;
+
+// what the signal handler works on, NULL if this thread isn't sampled
+static __attribute__((tls_model ("initial-exec"))) __thread
+  SampleTable *s_sample_table = NULL;
+
+static void on_sigprof(int sig) {
+  SampleTable *table = s_sample_table;
+  if (table) {
+    table->sample();
+  }
+}
+
+/**
+ * A thread's timer and table. It's created after ThreadInfo, so it's deleted
+ * before ThreadInfo on thread exit.
+ */
+class SamplerThread {
+public:
+  SamplerThread() : m_table(NULL), m_hasTimer(false), m_frequency(0) {}
+
+  ~SamplerThread() {
+    s_sample_table = NULL;
+    if (m_hasTimer) {
+      timer_delete(m_timer);
+    }
+    if (m_table) {
+      Lock lock(s_sampler_mutex);
+      m_table->m_info = NULL;
+      m_table->m_inUse = false;
+    }
+  }
+
+  void update(int frequency) {
+    if (frequency && m_table == NULL) {
+      attachTable();
+    }
+    if (m_table && m_table->m_generation != s_sample_generation) {
+      // so our own signal handler doesn't see a half cleared table
+      sigset_t mask, old;
+      sigemptyset(&mask);
+      sigaddset(&mask, SIGPROF);
+      pthread_sigmask(SIG_BLOCK, &mask, &old);
+      m_table->clear();
+      m_table->m_generation = s_sample_generation;
+      pthread_sigmask(SIG_SETMASK, &old, NULL);
+    }
+    if (frequency != m_frequency) {
+      arm(frequency);
+    }
+  }
+
+private:
+  SampleTable *m_table;
+  timer_t m_timer;
+  bool m_hasTimer;
+  int m_frequency;
+
+  void attachTable() {
+    {
+      Lock lock(s_sampler_mutex);
+      // tables of exited threads are taken over with their samples
+      for (unsigned int i = 0; i < s_sample_tables.size(); i++) {
+        if (!s_sample_tables[i]->m_inUse) {
+          m_table = s_sample_tables[i];
+          m_table->m_inUse = true;
+          break;
+        }
+      }
+      if (m_table == NULL) {
+        m_table = new SampleTable(RuntimeOption::StackSamplingTableSize);
+        m_table->m_generation = s_sample_generation;
+        s_sample_tables.push_back(m_table);
+      }
+      m_table->m_info = ThreadInfo::s_threadInfo.get();
+    }
+    s_sample_table = m_table;
+  }
+
+  void arm(int frequency) {
+    if (!m_hasTimer) {
+      struct sigevent sev;
+      memset(&sev, 0, sizeof(sev));
+      sev.sigev_notify = SIGEV_THREAD_ID;
+      sev.sigev_signo = SIGPROF;
+      sev.sigev_notify_thread_id = syscall(SYS_gettid);
+      if (timer_create(CLOCK_THREAD_CPUTIME_ID, &sev, &m_timer)) {
+        Logger::Warning("Unable to create sampling timer: %s",
+                        Util::safe_strerror(errno).c_str());
+        return;
+      }
+      m_hasTimer = true;
+    }
+    struct itimerspec its;
+    memset(&its, 0, sizeof(its));
+    if (frequency > 0) {
+      int64 ns = 1000000000LL / frequency;
+      its.it_interval.tv_sec = ns / 1000000000LL;
+      its.it_interval.tv_nsec = ns % 1000000000LL;
+      its.it_value = its.it_interval;
+    }
+    timer_settime(m_timer, 0, &its, NULL);
+    m_frequency = frequency;
+  }
+};
+
+static IMPLEMENT_THREAD_LOCAL(SamplerThread, s_sampler_thread);
+
+bool StackSampler::SetFrequency(int frequency) {
+  if (frequency < 0) frequency = 0;
+  if (frequency > 1000) frequency = 1000;
+  Lock lock(s_sampler_mutex);
+  if (frequency && !s_sampler_installed) {
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_sigprof;
+    sa.sa_flags = SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    if (sigaction(SIGPROF, &sa, NULL)) {
+      Logger::Error("Unable to install SIGPROF handler: %s",
+                    Util::safe_strerror(errno).c_str());
+      return false;
+    }
+    s_sampler_installed = true;
+  }
+  s_sample_frequency = frequency;
+  return true;
+}
+
+void StackSampler::OnSessionInit() {
+  int frequency = s_sample_frequency;
+  if (frequency || s_sample_table) {
+    s_sampler_thread->update(frequency);
+  }
+}
+
+void StackSampler::Clear() {
+  Lock lock(s_sampler_mutex);
+  s_sample_generation++;
+}
+
+std::string StackSampler::GetFoldedStacks() {
+  map<string, int64> stacks;
+  vector<const char *> names;
+  Lock lock(s_sampler_mutex);
+  for (unsigned int i = 0; i < s_sample_tables.size(); i++) {
+    SampleTable *table = s_sample_tables[i];
+    if (table->m_generation != s_sample_generation) continue; // not cleared
+    for (int slot = 0; slot <= table->m_mask; slot++) {
+      const SampleTable::Node &node = table->m_nodes[slot];
+      if (node.key == NULL || node.count == 0) continue;
+      int count = node.count;
+      names.clear();
+      for (int p = slot; p >= 0 && p <= table->m_mask &&
+             (int)names.size() <= SampleTable::MaxDepth;
+           p = table->m_nodes[p].parent) {
+        if (table->m_nodes[p].key == NULL) break;
+        names.push_back(table->m_nodes[p].name);
+      }
+      string stack;
+      for (int j = names.size() - 1; j >= 0; j--) {
+        stack += names[j];
+        if (j) stack += ';';
+      }
+      stacks[stack] += count;
+    }
+  }
+
+  ostringstream out;
+  for (map<string, int64>::const_iterator iter = stacks.begin();
+       iter != stacks.end(); ++iter) {
+    out << iter->first << ' ' << iter->second << '\n';
+  }
+  return out.str();
+}
+
+std::string StackSampler::GetStatus() {
+  int64 samples = 0, idle = 0, dropped = 0, nodes = 0;
+  int threads = 0;
+  Lock lock(s_sampler_mutex);
+  for (unsigned int i = 0; i < s_sample_tables.size(); i++) {
+    SampleTable *table = s_sample_tables[i];
+    if (table->m_inUse) threads++;
+    if (table->m_generation != s_sample_generation) continue;
+    samples += table->m_samples;
+    idle += table->m_idle;
+    dropped += table->m_dropped;
+    nodes += table->m_used;
+  }
+  ostringstream out;
+  out << "frequency: " << s_sample_frequency << "\n";
+  out << "threads: " << threads << "\n";
+  out << "samples: " << samples << "\n";
+  out << "idle: " << idle << "\n";
+  out << "dropped: " << dropped << "\n";
+  out << "nodes: " << nodes << "\n";
+  return out.str();
+}
+
+#else // __linux__
+
+bool StackSampler::SetFrequency(int frequency) { return frequency == 0;}
+void StackSampler::OnSessionInit() {}
+void StackSampler::Clear() {}
+std::string StackSampler::GetFoldedStacks() { return "";}
+std::string StackSampler::GetStatus() { return "frequency: 0\n";}
+
+#endif // __linux__
+
+int StackSampler::GetFrequency() {
+#ifdef __linux__
+  return s_sample_frequency;
+#else
+  return 0;
+#endif
+}
+
+static class hotprofilerExtension : public Extension {
+public:
+  hotprofilerExtension() : Extension("hotprofiler") {}
+  virtual void moduleInit() {
+    if (RuntimeOption::StackSamplingFrequency > 0 &&
+        !StackSampler::SetFrequency(RuntimeOption::StackSamplingFrequency)) {
+      Logger::Warning("Stack sampling isn't supported on this platform");
+    }
+  }
+} s_hotprofiler_extension;
+
 ///////////////////////////////////////////////////////////////////////////////
 
 class ProfilerFactory : public RequestEventHandler {
@@ -18,6 +18,8 @@
 #include <runtime/ext/ext_memcache.h>
 #include <runtime/base/util/request_local.h>
 #include <runtime/base/ini_setting.h>
+#include <runtime/base/runtime_option.h>
+#include <runtime/base/server/server_stats.h>
 
 #define MMC_SERIALIZED 1
 #define MMC_COMPRESSED 2
@@ -32,17 +34,21 @@ class MEMCACHEGlobals : public RequestEventHandler {
 public:
   std::string hash_strategy;
   std::string hash_function;
+  bool local_cache;
 
-  MEMCACHEGlobals() {}
+  MEMCACHEGlobals() : local_cache(false) {}
 
   virtual void requestInit() {
     hash_strategy = "standard";
     hash_function = "crc32";
+    local_cache = false;
 
     IniSetting::Bind("memcache.hash_strategy",     "standard",
                      ini_on_update_hash_strategy,  &hash_strategy);
     IniSetting::Bind("memcache.hash_function",     "crc32",
                      ini_on_update_hash_function,  &hash_function);
+    IniSetting::Bind("memcache.local_cache",       "0",
+                     ini_on_update_bool,           &local_cache);
   }
 
   virtual void requestShutdown() {
@@ -161,6 +167,42 @@ Variant static memcache_fetch_from_storage(const char *payload,
   return ret;
 }
 
+static inline bool memcache_stats_enabled() {
+  return RuntimeOption::EnableStats && RuntimeOption::EnableMemcacheStats;
+}
+
+bool c_Memcache::getLocal(CStrRef key, Variant &value) {
+  if (!MEMCACHEG(local_cache)) return false;
+
+  LocalCache::const_iterator iter =
+    m_local_cache.find(std::string(key.data(), key.size()));
+  if (iter == m_local_cache.end()) {
+    if (memcache_stats_enabled()) ServerStats::Log("memcache.local_miss", 1);
+    return false;
+  }
+  if (memcache_stats_enabled()) ServerStats::Log("memcache.local_hit", 1);
+  value = memcache_fetch_from_storage(iter->second.payload.data(),
+                                      iter->second.payload.size(),
+                                      iter->second.flags);
+  return true;
+}
+
+void c_Memcache::setLocal(const char *key, size_t key_len,
+                          const char *payload, size_t payload_len,
+                          uint32_t flags) {
+  if (!MEMCACHEG(local_cache)) return;
+
+  LocalItem &item = m_local_cache[std::string(key, key_len)];
+  item.payload.assign(payload, payload_len);
+  item.flags = flags;
+}
+
+void c_Memcache::invalidateLocal(CStrRef key) {
+  if (!m_local_cache.empty()) {
+    m_local_cache.erase(std::string(key.data(), key.size()));
+  }
+}
+
 bool c_Memcache::t_add(CStrRef key, CVarRef var, int flag /*= 0*/,
                        int expire /*= 0*/) {
   INSTANCE_METHOD_INJECTION_BUILTIN(Memcache, Memcache::add);
@@ -171,6 +213,7 @@ bool c_Memcache::t_add(CStrRef key, CVarRef var, int flag /*= 0*/,
 
   String serialized = memcache_prepare_for_storage(var, flag);
 
+  invalidateLocal(key);
   memcached_return_t ret = memcached_add(&m_memcache,
                                         key.c_str(), key.length(),
                                         serialized.c_str(),
@@ -190,6 +233,7 @@ bool c_Memcache::t_set(CStrRef key, CVarRef var, int flag /*= 0*/,
 
   String serialized = memcache_prepare_for_storage(var, flag);
 
+  invalidateLocal(key);
   memcached_return_t ret = memcached_set(&m_memcache,
                                         key.c_str(), key.length(),
                                         serialized.c_str(),
@@ -213,6 +257,7 @@ bool c_Memcache::t_replace(CStrRef key, CVarRef var, int flag /*= 0*/,
 
   String serialized = memcache_prepare_for_storage(var, flag);
 
+  invalidateLocal(key);
   memcached_return_t ret = memcached_replace(&m_memcache,
                                              key.c_str(), key.length(),
                                              serialized.c_str(),
@@ -224,52 +269,7 @@ bool c_Memcache::t_replace(CStrRef key, CVarRef var, int flag /*= 0*/,
 Variant c_Memcache::t_get(CVarRef key, Variant flags /*= null*/) {
   INSTANCE_METHOD_INJECTION_BUILTIN(Memcache, Memcache::get);
   if (key.is(KindOfArray)) {
-    std::vector<const char *> real_keys;
-    std::vector<size_t> key_len;
-    Array keyArr = key.toArray();
-
-    real_keys.reserve(keyArr.size());
-    key_len.reserve(keyArr.size());
-
-    for (ArrayIter iter(keyArr); iter; ++iter) {
-      real_keys.push_back(const_cast<char *>(iter.second().toString().c_str()));
-      key_len.push_back(iter.second().toString().length());
-    }
-
-    if (!real_keys.empty()) {
-      const char *payload = NULL;
-      size_t payload_len = 0;
-      uint32_t flags = 0;
-      const char *res_key = NULL;
-      size_t res_key_len = 0;
-
-      memcached_result_st result;
-
-      memcached_return_t ret = memcached_mget(&m_memcache, &real_keys[0],
-                                              &key_len[0], real_keys.size());
-      memcached_result_create(&m_memcache, &result);
-      Array return_val;
-
-      while ((memcached_fetch_result(&m_memcache, &result, &ret)) != NULL) {
-        if (ret != MEMCACHED_SUCCESS) {
-          // should probably notify about errors
-          continue;
-        }
-
-        payload     = memcached_result_value(&result);
-        payload_len = memcached_result_length(&result);
-        flags       = memcached_result_flags(&result);
-        res_key     = memcached_result_key_value(&result);
-        res_key_len = memcached_result_key_length(&result);
-
-        return_val.set(String(res_key, res_key_len, CopyString),
-                       memcache_fetch_from_storage(payload,
-                                                   payload_len, flags));
-      }
-      memcached_result_free(&result);
-
-      return return_val;
-    }
+    return getMulti(key.toArray());
   } else if (key.isString()) {
     char *payload = NULL;
     size_t payload_len = 0;
@@ -277,6 +277,12 @@ Variant c_Memcache::t_get(CVarRef key, Variant flags /*= null*/) {
 
     memcached_return_t ret;
     String skey = key.toString();
+
+    Variant retval;
+    if (getLocal(skey, retval)) {
+      return retval;
+    }
+
     payload = memcached_get(&m_memcache, skey.c_str(), skey.length(),
                             &payload_len, &flags, &ret);
 
@@ -289,7 +295,10 @@ Variant c_Memcache::t_get(CVarRef key, Variant flags /*= null*/) {
       return false;
     }
 
-    Variant retval = memcache_fetch_from_storage(payload, payload_len, flags);
+    if (ret == MEMCACHED_SUCCESS) {
+      setLocal(skey.data(), skey.size(), payload, payload_len, flags);
+    }
+    retval = memcache_fetch_from_storage(payload, payload_len, flags);
     free(payload);
 
     return retval;
@@ -298,6 +307,77 @@ Variant c_Memcache::t_get(CVarRef key, Variant flags /*= null*/) {
   return false;
 }
 
+Array c_Memcache::getMulti(CArrRef keys) {
+  std::vector<String> keep_alive;
+  std::vector<const char *> real_keys;
+  std::vector<size_t> key_len;
+  hphp_string_set seen;
+  Array return_val = Array::Create();
+
+  keep_alive.reserve(keys.size());
+  real_keys.reserve(keys.size());
+  key_len.reserve(keys.size());
+
+  for (ArrayIter iter(keys); iter; ++iter) {
+    String skey = iter.second().toString();
+    if (skey.empty() ||
+        !seen.insert(std::string(skey.data(), skey.size())).second) {
+      continue;
+    }
+
+    Variant value;
+    if (getLocal(skey, value)) {
+      return_val.set(skey, value);
+      continue;
+    }
+
+    keep_alive.push_back(skey);
+    real_keys.push_back(skey.data());
+    key_len.push_back(skey.size());
+  }
+
+  if (real_keys.empty()) {
+    return return_val;
+  }
+
+  if (memcache_stats_enabled()) {
+    ServerStats::Log("memcache.mget", 1);
+    ServerStats::Log("memcache.mget_keys", real_keys.size());
+  }
+
+  // libmemcached hashes every key to its server and writes all the get
+  // commands out before reading any reply, so a single mget is fanned out
+  // to all servers involved at once rather than one round trip per server.
+  memcached_return_t ret = memcached_mget(&m_memcache, &real_keys[0],
+                                          &key_len[0], real_keys.size());
+  if (ret != MEMCACHED_SUCCESS) {
+    return return_val;
+  }
+
+  memcached_result_st result;
+  memcached_result_create(&m_memcache, &result);
+
+  while ((memcached_fetch_result(&m_memcache, &result, &ret)) != NULL) {
+    if (ret != MEMCACHED_SUCCESS) {
+      // should probably notify about errors
+      continue;
+    }
+
+    const char *payload = memcached_result_value(&result);
+    size_t payload_len  = memcached_result_length(&result);
+    uint32_t flags      = memcached_result_flags(&result);
+    const char *res_key = memcached_result_key_value(&result);
+    size_t res_key_len  = memcached_result_key_length(&result);
+
+    setLocal(res_key, res_key_len, payload, payload_len, flags);
+    return_val.set(String(res_key, res_key_len, CopyString),
+                   memcache_fetch_from_storage(payload, payload_len, flags));
+  }
+  memcached_result_free(&result);
+
+  return return_val;
+}
+
 bool c_Memcache::t_delete(CStrRef key, int expire /*= 0*/) {
   INSTANCE_METHOD_INJECTION_BUILTIN(Memcache, Memcache::delete);
   if (key.empty()) {
@@ -305,6 +385,7 @@ bool c_Memcache::t_delete(CStrRef key, int expire /*= 0*/) {
     return false;
   }
 
+  invalidateLocal(key);
   memcached_return_t ret = memcached_delete(&m_memcache,
                                             key.c_str(), key.length(),
                                             expire);
@@ -318,6 +399,7 @@ int64 c_Memcache::t_increment(CStrRef key, int offset /*= 1*/) {
     return false;
   }
 
+  invalidateLocal(key);
   uint64_t value;
   memcached_return_t ret = memcached_increment(&m_memcache, key.c_str(),
                                               key.length(), offset, &value);
@@ -336,6 +418,7 @@ int64 c_Memcache::t_decrement(CStrRef key, int offset /*= 1*/) {
     return false;
   }
 
+  invalidateLocal(key);
   uint64_t value;
   memcached_return_t ret = memcached_decrement(&m_memcache, key.c_str(),
                                               key.length(), offset, &value);
@@ -349,6 +432,7 @@ int64 c_Memcache::t_decrement(CStrRef key, int offset /*= 1*/) {
 
 bool c_Memcache::t_close() {
   INSTANCE_METHOD_INJECTION_BUILTIN(Memcache, Memcache::close);
+  m_local_cache.clear();
   memcached_quit(&m_memcache);
   return true;
 }
@@ -382,6 +466,7 @@ Variant c_Memcache::t_getversion() {
 
 bool c_Memcache::t_flush(int expire /*= 0*/) {
   INSTANCE_METHOD_INJECTION_BUILTIN(Memcache, Memcache::flush);
+  m_local_cache.clear();
   return memcached_flush(&m_memcache, expire) == MEMCACHED_SUCCESS;
 }
 
@@ -602,6 +687,11 @@ Variant f_memcache_get(CObjRef memcache, CVarRef key,
   return memcache_obj->t_get(key, flags);
 }
 
+Array f_memcache_get_multi(CObjRef memcache, CArrRef keys) {
+  c_Memcache *memcache_obj = memcache.getTyped<c_Memcache>();
+  return memcache_obj->getMulti(keys);
+}
+
 bool f_memcache_delete(CObjRef memcache, CStrRef key, int expire /* = 0 */) {
   c_Memcache *memcache_obj = memcache.getTyped<c_Memcache>();
   return memcache_obj->t_delete(key, expire);
@@ -31,6 +31,7 @@ bool f_memcache_add(CObjRef memcache, CStrRef key, CVarRef var, int flag = 0, in
 bool f_memcache_set(CObjRef memcache, CStrRef key, CVarRef var, int flag = 0, int expire = 0);
 bool f_memcache_replace(CObjRef memcache, CStrRef key, CVarRef var, int flag = 0, int expire = 0);
 Variant f_memcache_get(CObjRef memcache, CVarRef key, Variant flags = null);
+Array f_memcache_get_multi(CObjRef memcache, CArrRef keys);
 bool f_memcache_delete(CObjRef memcache, CStrRef key, int expire = 0);
 int64 f_memcache_increment(CObjRef memcache, CStrRef key, int offset = 1);
 int64 f_memcache_decrement(CObjRef memcache, CStrRef key, int offset = 1);
@@ -90,10 +91,35 @@ class c_Memcache : public ExtObjectData, public Sweepable {
                                     const Eval::FunctionCallExpression *call);
   public: virtual void destruct();
 
+  /**
+   * Batched get for memcache_get_multi() and Memcache::get() with an array
+   * of keys. Duplicate keys are fetched once and keys already in the local
+   * cache are not sent to any server.
+   */
+  public: Array getMulti(CArrRef keys);
+
  private:
   memcached_st m_memcache;
   int m_compress_threshold;
   double m_min_compress_savings;
+
+  /**
+   * Read-through cache of raw payloads fetched through this object, enabled
+   * by "memcache.local_cache". Since the object never outlives its request,
+   * neither does the cache. Raw payloads are kept instead of values, so every
+   * hit still returns a fresh copy of unserialized objects.
+   */
+  struct LocalItem {
+    std::string payload;
+    uint32_t flags;
+  };
+  typedef hphp_string_map<LocalItem> LocalCache;
+  LocalCache m_local_cache;
+
+  bool getLocal(CStrRef key, Variant &value);
+  void setLocal(const char *key, size_t key_len, const char *payload,
+                size_t payload_len, uint32_t flags);
+  void invalidateLocal(CStrRef key);
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -100,22 +100,74 @@ public:
 };
 static MySQLStaticInitializer s_mysql_initializer;
 
+/**
+ * Backing store for row strings of mysql_fetch_all() on unbuffered results:
+ * values are copied into large chunks and handed out as literal strings,
+ * instead of one allocation per value. They are referenced by PHP arrays
+ * that may live till the end of the request, so chunks are freed in
+ * requestShutdown(), after shutdown functions ran and objects were destroyed.
+ * Literal strings are copied when stored into APC, so nothing outlives that.
+ */
+class MySQLStringArena {
+public:
+  MySQLStringArena() : m_pos(0), m_end(0) {}
+  ~MySQLStringArena() { reset();}
+
+  String copy(const char *data, int len) {
+    if (m_end - m_pos < len + 1) {
+      int size = len + 1 > ChunkSize ? len + 1 : ChunkSize;
+      char *chunk = (char*)malloc(size);
+      m_chunks.push_back(chunk);
+      if (size > ChunkSize) {
+        // too large to share, and keeps the current chunk in use
+        memcpy(chunk, data, len);
+        chunk[len] = '\0';
+        return String(chunk, len, AttachLiteral);
+      }
+      m_pos = chunk;
+      m_end = chunk + size;
+    }
+    char *s = m_pos;
+    memcpy(s, data, len);
+    s[len] = '\0';
+    m_pos += len + 1;
+    return String(s, len, AttachLiteral);
+  }
+
+  void reset() {
+    for (unsigned int i = 0; i < m_chunks.size(); i++) {
+      free(m_chunks[i]);
+    }
+    m_chunks.clear();
+    m_pos = m_end = 0;
+  }
+
+private:
+  static const int ChunkSize = 64 * 1024;
+  std::vector<char*> m_chunks;
+  char *m_pos;
+  char *m_end;
+};
+
 class MySQLRequestData : public RequestEventHandler {
 public:
   virtual void requestInit() {
     defaultConn.reset();
+    arena.reset();
     readTimeout = RuntimeOption::MySQLReadTimeout;
     totalRowCount = 0;
   }
 
   virtual void requestShutdown() {
     defaultConn.reset();
+    arena.reset();
     totalRowCount = 0;
   }
 
   Object defaultConn;
   int readTimeout;
   int totalRowCount; // from all queries in current request
+  MySQLStringArena arena; // kept until the request ends
 };
 IMPLEMENT_STATIC_REQUEST_LOCAL(MySQLRequestData, s_mysql_data);
 
@@ -711,6 +763,17 @@ static Variant mysql_makevalue(CStrRef data, MYSQL_FIELD *mysql_field) {
   return data;
 }
 
+static Variant mysql_makevalue(const char *data, unsigned long len,
+                               MYSQL_FIELD *mysql_field,
+                               MySQLStringArena &arena) {
+  Variant value = mysql_makevalue(String(data, len, AttachLiteral),
+                                  mysql_field);
+  if (value.isString()) {
+    return arena.copy(data, len);
+  }
+  return value;
+}
+
 extern "C" {
 struct MEM_ROOT;
 unsigned long cli_safe_read(MYSQL *);
@@ -1036,7 +1099,8 @@ static Variant php_mysql_fetch_hash(CVarRef result, int result_type) {
       ret.set(i, data);
     }
     if (result_type & MYSQL_ASSOC) {
-      ret.set(String(mysql_field->name, CopyString), data);
+      ret.set(StaticString::Intern(mysql_field->name,
+                                   mysql_field->name_length), data);
     }
   }
   return ret;
@@ -1054,6 +1118,101 @@ Variant f_mysql_fetch_array(CVarRef result, int result_type /* = 3 */) {
   return php_mysql_fetch_hash(result, result_type);
 }
 
+Variant f_mysql_fetch_all(CVarRef result, int result_type /* = 1 */,
+                          bool columnar /* = false */) {
+  if ((result_type & MYSQL_BOTH) == 0) {
+    throw_invalid_argument("result_type: %d", result_type);
+    return false;
+  }
+
+  MySQLResult *res = get_result(result);
+  if (res == NULL) return false;
+
+  // Keys are converted once and shared by all rows. With MYSQL_BOTH each
+  // field has two keys, both in "keys", numeric ones first.
+  int fields = res->getFieldCount();
+  vector<Variant> keys;
+  vector<int> keyFields;
+  if (result_type & MYSQL_NUM) {
+    for (int i = 0; i < fields; i++) {
+      keys.push_back(i);
+      keyFields.push_back(i);
+    }
+  }
+  if (result_type & MYSQL_ASSOC) {
+    for (int i = 0; i < fields; i++) {
+      MySQLFieldInfo *info = res->getFieldInfo(i);
+      if (info == NULL) return false;
+      keys.push_back(info->name->toString().toKey());
+      keyFields.push_back(i);
+    }
+  }
+
+  int64 rowCount = res->getRowCount();
+  vector<Array> columns;
+  if (columnar) {
+    columns.resize(fields);
+    for (int i = 0; i < fields; i++) {
+      columns[i] = rowCount > 0 ? Array(ArrayInit(rowCount, true).create())
+                                : Array::Create();
+    }
+  }
+
+  Array ret = rowCount > 0 && !columnar ?
+    Array(ArrayInit(rowCount, true).create()) : Array::Create();
+  vector<Variant> values(fields);
+  if (res->isLocalized()) {
+    while (res->fetchRow()) {
+      for (int i = 0; i < fields; i++) {
+        values[i] = res->getField(i);
+      }
+      if (columnar) {
+        for (int i = 0; i < fields; i++) columns[i].append(values[i]);
+        continue;
+      }
+      ArrayInit row(keys.size(), false);
+      for (unsigned int k = 0; k < keys.size(); k++) {
+        row.set(keys[k], values[keyFields[k]], true);
+      }
+      ret.append(row.create());
+    }
+  } else {
+    MYSQL_RES *mysql_result = res->get();
+    MYSQL_FIELD *mysql_fields = mysql_fetch_fields(mysql_result);
+    MySQLStringArena &arena = s_mysql_data->arena;
+    MYSQL_ROW mysql_row;
+    while ((mysql_row = mysql_fetch_row(mysql_result))) {
+      unsigned long *mysql_row_lengths = mysql_fetch_lengths(mysql_result);
+      if (!mysql_row_lengths) break;
+      for (int i = 0; i < fields; i++) {
+        if (mysql_row[i]) {
+          values[i] = mysql_makevalue(mysql_row[i], mysql_row_lengths[i],
+                                      mysql_fields + i, arena);
+        } else {
+          values[i].unset();
+        }
+      }
+      if (columnar) {
+        for (int i = 0; i < fields; i++) columns[i].append(values[i]);
+        continue;
+      }
+      ArrayInit row(keys.size(), false);
+      for (unsigned int k = 0; k < keys.size(); k++) {
+        row.set(keys[k], values[keyFields[k]], true);
+      }
+      ret.append(row.create());
+    }
+  }
+
+  if (columnar) {
+    // with MYSQL_BOTH, a column is shared by its numeric and name keys
+    for (unsigned int k = 0; k < keys.size(); k++) {
+      ret.set(keys[k], columns[keyFields[k]]);
+    }
+  }
+  return ret;
+}
+
 Variant f_mysql_fetch_object(CVarRef result,
                              CStrRef class_name /* = "stdClass" */,
                              CArrRef params /* = null */) {
@@ -1290,7 +1449,8 @@ void MySQLResult::setFieldCount(int64 fields) {
 
 void MySQLResult::setFieldInfo(int64 f, MYSQL_FIELD *field) {
   MySQLFieldInfo &info = m_fields[f];
-  info.name = NEW(Variant)(String(field->name, CopyString));
+  info.name = NEW(Variant)(StaticString::Intern(field->name,
+                                                field->name_length));
   info.table = NEW(Variant)(String(field->table, CopyString));
   info.def = NEW(Variant)(String(field->def, CopyString));
   info.max_length = (int64)field->max_length;
@@ -367,6 +367,9 @@ Variant f_mysql_fetch_assoc(CVarRef result);
 
 Variant f_mysql_fetch_array(CVarRef result, int result_type = 3);
 
+Variant f_mysql_fetch_all(CVarRef result, int result_type = 1,
+                          bool columnar = false);
+
 Variant f_mysql_fetch_lengths(CVarRef result);
 
 Variant f_mysql_fetch_object(CVarRef result, CStrRef class_name = "stdClass",
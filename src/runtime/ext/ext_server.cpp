@@ -121,10 +121,25 @@ Object f_pagelet_server_task_start(CStrRef url,
   return PageletServer::TaskStart(url, headers, remote_host, post_data);
 }
 
+Array f_pagelet_server_task_start_multi(CArrRef urls,
+                                       CArrRef headers /* = null_array */,
+                                       CArrRef post_data /* = null_array */) {
+  String remote_host;
+  Transport *transport = g_context->getTransport();
+  if (transport) {
+    remote_host = transport->getRemoteHost();
+  }
+  return PageletServer::TaskStartMulti(urls, headers, remote_host, post_data);
+}
+
 bool f_pagelet_server_task_status(CObjRef task) {
   return PageletServer::TaskStatus(task);
 }
 
+Variant f_pagelet_server_task_wait(CArrRef tasks, int timeout_ms /* = -1 */) {
+  return PageletServer::TaskWait(tasks, timeout_ms);
+}
+
 String f_pagelet_server_task_result(CObjRef task, Variant headers,
                                     Variant code) {
   Array rheaders;
@@ -29,7 +29,9 @@ bool f_dangling_server_proxy_old_request();
 bool f_dangling_server_proxy_new_request(CStrRef host);
 bool f_pagelet_server_is_enabled();
 Object f_pagelet_server_task_start(CStrRef url, CArrRef headers = null_array, CStrRef post_data = null_string);
+Array f_pagelet_server_task_start_multi(CArrRef urls, CArrRef headers = null_array, CArrRef post_data = null_array);
 bool f_pagelet_server_task_status(CObjRef task);
+Variant f_pagelet_server_task_wait(CArrRef tasks, int timeout_ms = -1);
 String f_pagelet_server_task_result(CObjRef task, Variant headers, Variant code);
 bool f_xbox_send_message(CStrRef msg, Variant ret, int64 timeout_ms, CStrRef host = "localhost");
 bool f_xbox_post_message(CStrRef msg, CStrRef host = "localhost");
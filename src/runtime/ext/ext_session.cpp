@@ -26,6 +26,7 @@
 #include <runtime/base/ini_setting.h>
 #include <runtime/base/time/datetime.h>
 #include <runtime/base/variable_unserializer.h>
+#include <runtime/base/shared/shared_store.h>
 #include <util/lock.h>
 #include <util/compatibility.h>
 #include <sys/types.h>
@@ -88,6 +89,7 @@ public:
   SessionSerializer *m_serializer;
 
   bool m_auto_start;
+  bool m_lazy_write;
   bool m_use_cookies;
   bool m_use_only_cookies;
   bool m_use_trans_sid;   // contains the INI value of whether to use trans-sid
@@ -106,8 +108,8 @@ public:
       m_cookie_httponly(false), m_mod(NULL), m_session_status(None),
       m_gc_probability(0), m_gc_divisor(0), m_gc_maxlifetime(0),
       m_module_number(0), m_cache_expire(0), m_serializer(NULL),
-      m_auto_start(false), m_use_cookies(false), m_use_only_cookies(false),
-      m_use_trans_sid(false), m_apply_trans_sid(false),
+      m_auto_start(false), m_lazy_write(false), m_use_cookies(false),
+      m_use_only_cookies(false), m_use_trans_sid(false), m_apply_trans_sid(false),
       m_hash_bits_per_character(0), m_send_cookie(0), m_define_sid(0),
       m_invalid_session_id(false) {
   }
@@ -145,6 +147,8 @@ public:
                      ini_on_update_save_handler);
     IniSetting::Bind("session.auto_start",         "0",
                      ini_on_update_bool,           &m_auto_start);
+    IniSetting::Bind("session.lazy_write",         "1",
+                     ini_on_update_bool,           &m_lazy_write);
     IniSetting::Bind("session.gc_probability",     "1",
                      ini_on_update_long,           &m_gc_probability);
     IniSetting::Bind("session.gc_divisor",         "100",
@@ -753,6 +757,148 @@ public:
 };
 static UserSessionModule s_user_session_module;
 
+///////////////////////////////////////////////////////////////////////////////
+// MemorySessionModule
+
+/**
+ * Keeps sessions in a table of the APC store, so reading one is a hash lookup
+ * instead of opening, locking and reading a file. Like flock() on a session
+ * file, a request holds a lock on its session from read() to close(), but
+ * that's one of a fixed number of mutexes picked by hashing the session id.
+ *
+ * Each entry is array(time written, data), stored with a TTL of one and a
+ * half gc_maxlifetime. With session.lazy_write, unchanged data is only
+ * written again once it's older than half of that, which still keeps it for
+ * at least gc_maxlifetime since last access. Expired sessions are dropped by
+ * the store itself, so gc() has nothing to do.
+ *
+ * The lock is released at the end of the request even if close() is never
+ * called, as when session_module_name() switches modules mid-request.
+ */
+#define SESSION_LOCK_COUNT 1024
+
+class MemorySessionData : public RequestEventHandler {
+public:
+  MemorySessionData() : m_lock(NULL), m_written(0) {}
+
+  virtual void requestInit() {
+  }
+
+  virtual void requestShutdown() {
+    close();
+  }
+
+  // after SessionRequestData, which may still write the session
+  virtual int priority() const { return 1;}
+
+  bool open(const char *save_path, const char *session_name) {
+    m_prefix = save_path;
+    m_prefix += ':';
+    return true;
+  }
+
+  bool close() {
+    unlock();
+    m_value.reset();
+    m_written = 0;
+    return true;
+  }
+
+  bool read(const char *key, String &value) {
+    lock(key);
+    m_value.reset();
+    m_written = 0;
+
+    Variant entry;
+    if (s_apc_store[SHARED_STORE_SESSION_CACHE].get(m_key, entry)) {
+      m_written = entry[0].toInt64();
+      m_value = entry[1].toString();
+    }
+    value = m_value.isNull() ? String("") : m_value;
+    return true;
+  }
+
+  bool write(const char *key, CStrRef value) {
+    lock(key);
+    int64 ttl = PS(gc_maxlifetime) + PS(gc_maxlifetime) / 2;
+    time_t now = time(NULL);
+    if (PS(lazy_write) && !m_value.isNull() &&
+        m_value.size() == value.size() &&
+        memcmp(m_value.data(), value.data(), value.size()) == 0 &&
+        now - m_written < ttl / 2) {
+      return true;
+    }
+    s_apc_store[SHARED_STORE_SESSION_CACHE].store
+      (m_key, CREATE_VECTOR2((int64)now, value), ttl);
+    m_value = value;
+    m_written = now;
+    return true;
+  }
+
+  bool destroy(const char *key) {
+    lock(key);
+    s_apc_store[SHARED_STORE_SESSION_CACHE].erase(m_key);
+    m_value.reset();
+    m_written = 0;
+    return true;
+  }
+
+private:
+  static Mutex s_locks[SESSION_LOCK_COUNT];
+
+  std::string m_prefix;
+  String m_key;
+  Mutex *m_lock;
+  String m_value;   // what's in the store, as far as this request knows
+  int64 m_written;
+
+  void lock(const char *key) {
+    String skey(m_prefix + key);
+    if (m_lock && skey == m_key) return;
+    unlock();
+    m_key = skey;
+    uint64 hash = hash_string(m_key.data(), m_key.size());
+    m_lock = &s_locks[hash % SESSION_LOCK_COUNT];
+    m_lock->lock();
+  }
+
+  void unlock() {
+    if (m_lock) {
+      m_lock->unlock();
+      m_lock = NULL;
+    }
+    m_key.reset();
+  }
+};
+Mutex MemorySessionData::s_locks[SESSION_LOCK_COUNT];
+
+IMPLEMENT_STATIC_REQUEST_LOCAL(MemorySessionData, s_memory_session_data);
+
+class MemorySessionModule : public SessionModule {
+public:
+  MemorySessionModule() : SessionModule("memory") {
+  }
+  virtual bool open(const char *save_path, const char *session_name) {
+    return s_memory_session_data->open(save_path, session_name);
+  }
+  virtual bool close() {
+    return s_memory_session_data->close();
+  }
+  virtual bool read(const char *key, String &value) {
+    return s_memory_session_data->read(key, value);
+  }
+  virtual bool write(const char *key, CStrRef value) {
+    return s_memory_session_data->write(key, value);
+  }
+  virtual bool destroy(const char *key) {
+    return s_memory_session_data->destroy(key);
+  }
+  virtual bool gc(int maxlifetime, int *nrdels) {
+    return true;
+  }
+};
+static MemorySessionModule s_memory_session_module;
+
 ///////////////////////////////////////////////////////////////////////////////
 // session serializers
 
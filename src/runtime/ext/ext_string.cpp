@@ -24,6 +24,9 @@
 #include <runtime/base/util/request_local.h>
 #include <util/lock.h>
 #include <locale.h>
+#include <algorithm>
+#include <deque>
+#include <map>
 #include <runtime/base/server/http_request_handler.h>
 #include <runtime/base/server/http_protocol.h>
 
@@ -579,6 +582,191 @@ Variant f_str_word_count(CStrRef str, int64 format /* = 0 */,
   return ret;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// strtr() with an array of replacement pairs
+
+/**
+ * A trie over all "from" strings of a pair array, so each input position
+ * costs a walk of at most maxlen bytes instead of up to maxlen hash lookups.
+ * The root has a full 256-way table, so positions that cannot start any
+ * match are skipped with one load; inner nodes keep sorted edge lists.
+ * Replacements are kept as std::string, so matchers built from static
+ * arrays can be shared across requests.
+ */
+class StrtrMatcher {
+public:
+  StrtrMatcher(CArrRef pairs) {
+    std::vector<std::map<unsigned char, int> > children(1);
+    std::vector<int> values(1, -1);
+    for (ArrayIter iter(pairs); iter; ++iter) {
+      String search = iter.first().toString();
+      int node = 0;
+      for (int i = 0; i < search.size(); i++) {
+        unsigned char c = search.data()[i];
+        std::map<unsigned char, int>::const_iterator it =
+          children[node].find(c);
+        if (it != children[node].end()) {
+          node = it->second;
+        } else {
+          int child = children.size();
+          children[node][c] = child;
+          children.push_back(std::map<unsigned char, int>());
+          values.push_back(-1);
+          node = child;
+        }
+      }
+      values[node] = m_values.size();
+      String replace = iter.second().toString();
+      m_values.push_back(std::string(replace.data(), replace.size()));
+    }
+
+    for (int c = 0; c < 256; c++) m_root[c] = -1;
+    m_nodes.resize(children.size());
+    for (unsigned int i = 0; i < children.size(); i++) {
+      Node &node = m_nodes[i];
+      node.edges = m_edgeChars.size();
+      node.edgeCount = children[i].size();
+      node.value = values[i];
+      for (std::map<unsigned char, int>::const_iterator it =
+             children[i].begin(); it != children[i].end(); ++it) {
+        m_edgeChars.push_back(it->first);
+        m_edgeNodes.push_back(it->second);
+        if (i == 0) m_root[it->first] = it->second;
+      }
+    }
+  }
+
+  void translate(StringBuffer &out, const char *s, int len) const {
+    int copied = 0;
+    for (int pos = 0; pos < len; ) {
+      int node = m_root[(unsigned char)s[pos]];
+      if (node < 0) {
+        pos++;
+        continue;
+      }
+      // longest match starting at pos
+      int value = -1;
+      int end = pos;
+      for (int i = pos + 1; ; i++) {
+        const Node &n = m_nodes[node];
+        if (n.value >= 0) {
+          value = n.value;
+          end = i;
+        }
+        if (i >= len || (node = findEdge(n, s[i])) < 0) break;
+      }
+      if (value < 0) {
+        pos++;
+        continue;
+      }
+      if (pos > copied) out.append(s + copied, pos - copied);
+      out.append(m_values[value]);
+      pos = copied = end;
+    }
+    if (len > copied) out.append(s + copied, len - copied);
+  }
+
+private:
+  struct Node {
+    int edges;     // index of the first edge in m_edgeChars/m_edgeNodes
+    int edgeCount;
+    int value;     // index into m_values, -1 if no key ends here
+  };
+
+  int m_root[256];
+  std::vector<Node> m_nodes;
+  std::vector<unsigned char> m_edgeChars;
+  std::vector<int> m_edgeNodes;
+  std::vector<std::string> m_values;
+
+  int findEdge(const Node &n, char c) const {
+    const unsigned char *begin = &m_edgeChars[0] + n.edges;
+    const unsigned char *end = begin + n.edgeCount;
+    const unsigned char *p = std::lower_bound(begin, end, (unsigned char)c);
+    if (p == end || *p != (unsigned char)c) return -1;
+    return m_edgeNodes[p - &m_edgeChars[0]];
+  }
+};
+
+/**
+ * Matchers of static (scalar) arrays live as long as the process does.
+ */
+typedef hphp_hash_map<const ArrayData*, StrtrMatcher*,
+                      pointer_hash<ArrayData> > StrtrMatcherMap;
+static StrtrMatcherMap s_static_strtr_matchers;
+static ReadWriteMutex s_static_strtr_mutex;
+
+/**
+ * Matchers of other arrays are cached for the rest of the request. Each
+ * entry keeps a reference to its array, so the array cannot be modified
+ * in place while cached: any write copies it first.
+ */
+class StrtrCache : public RequestEventHandler {
+public:
+  static const unsigned int MaxEntries = 8;
+
+  struct Entry {
+    Array pairs;
+    StrtrMatcher *matcher;
+  };
+  std::deque<Entry> entries;
+
+  StrtrMatcher *find(const ArrayData *pairs) {
+    for (unsigned int i = 0; i < entries.size(); i++) {
+      if (entries[i].pairs.get() == pairs) return entries[i].matcher;
+    }
+    return NULL;
+  }
+
+  void add(CArrRef pairs, StrtrMatcher *matcher) {
+    if (entries.size() >= MaxEntries) {
+      delete entries.front().matcher;
+      entries.pop_front();
+    }
+    Entry entry;
+    entry.pairs = pairs;
+    entry.matcher = matcher;
+    entries.push_back(entry);
+  }
+
+  virtual void requestInit() {
+    ASSERT(entries.empty());
+  }
+  virtual void requestShutdown() {
+    for (unsigned int i = 0; i < entries.size(); i++) {
+      delete entries[i].matcher;
+    }
+    entries.clear();
+  }
+};
+IMPLEMENT_STATIC_REQUEST_LOCAL(StrtrCache, s_strtr_cache);
+
+static StrtrMatcher *get_strtr_matcher(CArrRef arr, int64 slen, int maxlen,
+                                       int minlen, int64 keylen) {
+  ArrayData *data = arr.get();
+  if (data->isStatic()) {
+    {
+      ReadLock lock(s_static_strtr_mutex);
+      StrtrMatcherMap::const_iterator iter =
+        s_static_strtr_matchers.find(data);
+      if (iter != s_static_strtr_matchers.end()) return iter->second;
+    }
+    WriteLock lock(s_static_strtr_mutex);
+    StrtrMatcher *&matcher = s_static_strtr_matchers[data];
+    if (!matcher) matcher = new StrtrMatcher(arr);
+    return matcher;
+  }
+
+  StrtrMatcher *matcher = s_strtr_cache->find(data);
+  if (matcher) return matcher;
+  // only worth building when the plain scan would do more lookups than it
+  // takes to insert all keys
+  if (slen * (maxlen - minlen + 1) <= keylen) return NULL;
+  matcher = new StrtrMatcher(arr);
+  s_strtr_cache->add(arr, matcher);
+  return matcher;
+}
+
 Variant f_strtr(CStrRef str, CVarRef from, CVarRef to /* = null_variant */) {
   if (str.empty()) {
     return str;
@@ -595,17 +783,30 @@ Variant f_strtr(CStrRef str, CVarRef from, CVarRef to /* = null_variant */) {
 
   int maxlen = 0;
   int minlen = -1;
+  int64 keylen = 0;
   Array arr = from.toArray();
+  if (arr.empty()) {
+    return str;
+  }
   for (ArrayIter iter(arr); iter; ++iter) {
     String search = iter.first();
     int len = search.size();
     if (len < 1) return false;
     if (maxlen < len) maxlen = len;
     if (minlen == -1 || minlen > len) minlen = len;
+    keylen += len;
   }
 
   const char *s = str.data();
   int slen = str.size();
+
+  StrtrMatcher *matcher = get_strtr_matcher(arr, slen, maxlen, minlen, keylen);
+  if (matcher) {
+    StringBuffer result(slen);
+    matcher->translate(result, s, slen);
+    return result.detach();
+  }
+
   char *key = (char *)malloc(maxlen+1);
 
   StringBuffer result(slen);
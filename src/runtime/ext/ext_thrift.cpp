@@ -17,6 +17,9 @@
 
 #include <runtime/ext/ext_thrift.h>
 #include <runtime/ext/ext_class.h>
+#include <runtime/base/class_info.h>
+#include <runtime/base/util/request_local.h>
+#include <util/lock.h>
 
 #include <sys/types.h>
 #include <netinet/in.h>
@@ -281,11 +284,6 @@ protected:
 
 };
 
-void binary_deserialize_spec(CObjRef zthis, PHPInputTransport& transport, CArrRef spec);
-void binary_serialize_spec(CObjRef zthis, PHPOutputTransport& transport, CArrRef spec);
-void binary_serialize(int8_t thrift_typeID, PHPOutputTransport& transport, CVarRef value, CArrRef fieldspec);
-void skip_element(long thrift_typeID, PHPInputTransport& transport);
-
 // Create a PHP object given a typename and call the ctor, optionally passing up to 2 arguments
 Object createObject(CStrRef obj_typename, int nargs = 0,
                     CVarRef arg1 = null_variant, CVarRef arg2 = null_variant) {
@@ -308,264 +306,323 @@ void throw_tprotocolexception(CStrRef what, long errorcode) {
   throw ex;
 }
 
-Variant binary_deserialize(int8_t thrift_typeID, PHPInputTransport& transport,
-                           CArrRef fieldspec) {
-  Variant ret;
-  switch (thrift_typeID) {
-    case T_STOP:
-    case T_VOID:
-      return null;
-    case T_STRUCT: {
-      Variant val;
-      if ((val = fieldspec.rvalAt(s_class)).isNull()) {
-        throw_tprotocolexception("no class type in spec", INVALID_DATA);
-        skip_element(T_STRUCT, transport);
-        return null;
-      }
-      String structType = val.toString();
-      ret = createObject(structType);
-      if (ret.isNull()) {
-        // unable to create class entry
-        skip_element(T_STRUCT, transport);
-        return null;
-      }
-      Variant spec = get_static_property(structType, "_TSPEC");
-      if (!spec.is(KindOfArray)) {
-        char errbuf[128];
-        snprintf(errbuf, 128, "spec for %s is wrong type: %d\n",
-                 structType.data(), ret.getType());
-        throw_tprotocolexception(String(errbuf, CopyString), INVALID_DATA);
-        return null;
-      }
-      binary_deserialize_spec(ret, transport, spec.toArray());
-      return ret;
-    } break;
-    case T_BOOL: {
-      uint8_t c;
-      transport.readBytes(&c, 1);
-      return c != 0;
-    }
-  //case T_I08: // same numeric value as T_BYTE
-    case T_BYTE: {
-      uint8_t c;
-      transport.readBytes(&c, 1);
-      return c;
-    }
-    case T_I16: {
-      uint16_t c;
-      transport.readBytes(&c, 2);
-      return ntohs(c);
-    }
-    case T_I32: {
-      uint32_t c;
-      transport.readBytes(&c, 4);
-      return Variant((int)ntohl(c));
+static void throw_unknown_type(int type) {
+  char errbuf[128];
+  sprintf(errbuf, "Unknown thrift typeID %d", type);
+  throw_tprotocolexception(String(errbuf, CopyString), INVALID_DATA);
+}
+
+inline bool ttype_is_int(int8_t t) {
+  return ((t == T_BYTE) || ((t >= T_I16)  && (t <= T_I64)));
+}
+
+inline bool ttype_is_string(int8_t t) {
+  return t == T_STRING || t == T_UTF8 || t == T_UTF16;
+}
+
+inline bool ttypes_are_compatible(int8_t t1, int8_t t2) {
+  // Integer types of different widths are considered compatible;
+  // otherwise the typeID must match.
+  return ((t1 == t2) || (ttype_is_int(t1) && ttype_is_int(t2)));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// compiled $_TSPEC
+
+class ThriftStructSpec;
+
+/**
+ * One value described by a $_TSPEC: a field of a struct, or the key, value
+ * or elements of a container. Everything is looked up in the spec array
+ * once, so encoding and decoding never go back to it.
+ */
+struct ThriftFieldSpec {
+  ThriftFieldSpec()
+    : id(0), type(T_STOP), ktype(T_STOP), vtype(T_STOP), etype(T_STOP),
+      key(NULL), val(NULL), elem(NULL), classDefined(false),
+      structSpec(NULL) {}
+  ~ThriftFieldSpec() {
+    delete key;
+    delete val;
+    delete elem;
+  }
+
+  int64 id;           // field number, for fields of a struct
+  String var;         // property name, for fields of a struct
+  int8_t type;
+  int8_t ktype;       // T_MAP
+  int8_t vtype;       // T_MAP
+  int8_t etype;       // T_LIST and T_SET
+  ThriftFieldSpec *key;
+  ThriftFieldSpec *val;
+  ThriftFieldSpec *elem;
+
+  String className;   // T_STRUCT
+  bool classDefined;  // className is a compiled class that always exists
+  mutable const ThriftStructSpec *structSpec; // className's, once resolved
+};
+
+static const ThriftFieldSpec s_noFieldSpec;
+
+inline const ThriftFieldSpec &child_spec(const ThriftFieldSpec *spec) {
+  return spec ? *spec : s_noFieldSpec;
+}
+
+/**
+ * The fields of a struct, in $_TSPEC order, with a table from field number
+ * to field for decoding.
+ */
+class ThriftStructSpec {
+public:
+  ThriftStructSpec() : m_persistent(true), m_badKey(false) {}
+  ThriftStructSpec(CArrRef spec, bool persistent);
+  ~ThriftStructSpec();
+
+  /**
+   * Compiled from a static array, and kept for the life of the process.
+   */
+  bool isPersistent() const { return m_persistent;}
+
+  /**
+   * Whether $_TSPEC has a key that isn't a field number, which is only an
+   * error when writing.
+   */
+  bool hasBadKey() const { return m_badKey;}
+
+  int size() const { return m_fields.size();}
+  const ThriftFieldSpec &field(int i) const { return *m_fields[i];}
+  const ThriftFieldSpec *find(int64 id) const;
+
+private:
+  static const int DenseIds = 256;
+
+  bool m_persistent;
+  bool m_badKey;
+  std::vector<ThriftFieldSpec *> m_fields;
+  std::vector<int> m_denseIds; // field number -> index + 1
+  hphp_hash_map<int64, int, int64_hash> m_sparseIds;
+};
+
+static const ThriftStructSpec s_emptySpec;
+
+/**
+ * Strings of a persistent spec have to outlive the request.
+ */
+static String spec_string(CVarRef v, bool persistent) {
+  String s = v.toString();
+  if (!persistent || s.get() == NULL || s->isStatic()) return s;
+  StringData *sd = new StringData(s.data(), s.size(), CopyString);
+  sd->setStatic();
+  return sd;
+}
+
+static ThriftFieldSpec *compile_field_spec(CArrRef spec, bool persistent) {
+  ThriftFieldSpec *ret = new ThriftFieldSpec();
+  ret->var = spec_string(spec.rvalAt(s_var), persistent);
+  ret->type = spec.rvalAt(s_type).toByte();
+  ret->ktype = spec.rvalAt(s_ktype).toByte();
+  ret->vtype = spec.rvalAt(s_vtype).toByte();
+  ret->etype = spec.rvalAt(s_etype).toByte();
+
+  Variant v;
+  if (!(v = spec.rvalAt(s_key)).isNull()) {
+    ret->key = compile_field_spec(v.toArray(), persistent);
+  }
+  if (!(v = spec.rvalAt(s_val)).isNull()) {
+    ret->val = compile_field_spec(v.toArray(), persistent);
+  }
+  if (!(v = spec.rvalAt(s_elem)).isNull()) {
+    ret->elem = compile_field_spec(v.toArray(), persistent);
+  }
+  if (!(v = spec.rvalAt(s_class)).isNull()) {
+    ret->className = spec_string(v, persistent);
+    if (persistent) {
+      const ClassInfo *cls = ClassInfo::FindClass(ret->className.data());
+      ret->classDefined = cls &&
+        !(cls->getAttribute() &
+          (ClassInfo::IsVolatile | ClassInfo::IsRedeclared));
     }
-    case T_U64:
-    case T_I64: {
-      uint64_t c;
-      transport.readBytes(&c, 8);
-      return Variant((int64)ntohll(c));
-    }
-    case T_DOUBLE: {
-      union {
-        uint64_t c;
-        double d;
-      } a;
-      transport.readBytes(&(a.c), 8);
-      a.c = ntohll(a.c);
-      return a.d;
+  }
+  return ret;
+}
+
+ThriftStructSpec::ThriftStructSpec(CArrRef spec, bool persistent)
+  : m_persistent(persistent), m_badKey(false) {
+  for (ArrayIter iter = spec.begin(); !iter.end(); ++iter) {
+    Variant key = iter.first();
+    if (!key.isInteger()) {
+      m_badKey = true;
+      continue;
     }
-    //case T_UTF7: // aliases T_STRING
-    case T_UTF8:
-    case T_UTF16:
-    case T_STRING: {
-      uint32_t size = transport.readU32();
-      if (size && (size + 1)) {
-        char* strbuf = (char*) malloc(size + 1);
-        transport.readBytes(strbuf, size);
-        strbuf[size] = '\0';
-        return String(strbuf, size, AttachString);
-      } else {
-        return "";
+    Variant fieldspec = iter.second();
+    if (fieldspec.isNull()) continue;
+
+    ThriftFieldSpec *field = compile_field_spec(fieldspec.toArray(),
+                                                persistent);
+    field->id = key.toInt64();
+    if (field->id >= 0 && field->id < DenseIds) {
+      if ((int)m_denseIds.size() <= field->id) {
+        m_denseIds.resize(field->id + 1);
       }
+      m_denseIds[field->id] = m_fields.size() + 1;
+    } else {
+      m_sparseIds[field->id] = m_fields.size();
     }
-    case T_MAP: { // array of key -> value
-      uint8_t types[2];
-      transport.readBytes(types, 2);
-      uint32_t size = transport.readU32();
+    m_fields.push_back(field);
+  }
+}
 
-      Array keyspec = fieldspec.rvalAt(s_key, -1).toArray();
-      Array valspec = fieldspec.rvalAt(s_val, -1).toArray();
-      ret = Array::Create();
+ThriftStructSpec::~ThriftStructSpec() {
+  for (unsigned int i = 0; i < m_fields.size(); i++) {
+    delete m_fields[i];
+  }
+}
 
-      for (uint32_t s = 0; s < size; ++s) {
-        Variant key = binary_deserialize(types[0], transport, keyspec);
-        Variant value = binary_deserialize(types[1], transport, valspec);
-        ret.set(key, value);
-      }
-      return ret; // return_value already populated
-    }
-    case T_LIST: { // array with autogenerated numeric keys
-      int8_t type = transport.readI8();
-      uint32_t size = transport.readU32();
-      Variant elemvar = fieldspec.rvalAt(s_elem, -1);
-      Array elemspec = elemvar.toArray();
-      ret = Array::Create();
+const ThriftFieldSpec *ThriftStructSpec::find(int64 id) const {
+  if (id >= 0 && id < (int64)m_denseIds.size()) {
+    int index = m_denseIds[id];
+    return index ? m_fields[index - 1] : NULL;
+  }
+  hphp_hash_map<int64, int, int64_hash>::const_iterator iter =
+    m_sparseIds.find(id);
+  return iter == m_sparseIds.end() ? NULL : m_fields[iter->second];
+}
 
-      for (uint32_t s = 0; s < size; ++s) {
-        Variant value = binary_deserialize(type, transport, elemspec);
-        ret.append(value);
-      }
-      return ret;
+typedef hphp_hash_map<const ArrayData *, const ThriftStructSpec *,
+                      pointer_hash<ArrayData> > ThriftSpecMap;
+
+// $_TSPEC of compiled classes are static arrays, compiled once per process
+static Mutex s_specMutex;
+static ThriftSpecMap s_specs;
+
+class ThriftRequestData : public RequestEventHandler {
+public:
+  virtual void requestInit() {}
+
+  virtual void requestShutdown() {
+    for (ThriftSpecMap::const_iterator iter = m_requestSpecs.begin();
+         iter != m_requestSpecs.end(); ++iter) {
+      delete iter->second;
     }
-    case T_SET: { // array of key -> TRUE
-      uint8_t type;
-      uint32_t size;
-      transport.readBytes(&type, 1);
-      transport.readBytes(&size, 4);
-      size = ntohl(size);
-      Variant elemvar = fieldspec.rvalAt(s_elem, -1);
-      Array elemspec = elemvar.toArray();
-      ret = Array::Create();
+    m_requestSpecs.clear();
+    m_requestArrays.clear();
+  }
 
-      for (uint32_t s = 0; s < size; ++s) {
-        Variant key = binary_deserialize(type, transport, elemspec);
+  const ThriftStructSpec *getSpec(CArrRef spec);
 
-        if (key.isInteger()) {
-          ret.set(key, true);
-        } else {
-          ret.set(key.toString(), true);
-        }
+private:
+  ThriftSpecMap m_staticSpecs;         // this thread's copy of s_specs
+  ThriftSpecMap m_requestSpecs;        // of arrays built during the request
+  std::vector<Array> m_requestArrays;  // so their addresses aren't reused
+};
+IMPLEMENT_STATIC_REQUEST_LOCAL(ThriftRequestData, s_thrift_data);
+
+const ThriftStructSpec *ThriftRequestData::getSpec(CArrRef spec) {
+  ArrayData *arr = spec.get();
+  if (arr == NULL) return &s_emptySpec;
+
+  if (arr->isStatic()) {
+    ThriftSpecMap::const_iterator iter = m_staticSpecs.find(arr);
+    if (iter != m_staticSpecs.end()) return iter->second;
+
+    const ThriftStructSpec *ret;
+    {
+      Lock lock(s_specMutex);
+      iter = s_specs.find(arr);
+      if (iter != s_specs.end()) {
+        ret = iter->second;
+      } else {
+        ret = s_specs[arr] = new ThriftStructSpec(spec, true);
       }
-      return ret;
     }
-  };
+    m_staticSpecs[arr] = ret;
+    return ret;
+  }
 
-  char errbuf[128];
-  sprintf(errbuf, "Unknown thrift typeID %d", thrift_typeID);
-  throw_tprotocolexception(String(errbuf, CopyString), INVALID_DATA);
-  return null;
+  ThriftSpecMap::const_iterator iter = m_requestSpecs.find(arr);
+  if (iter != m_requestSpecs.end()) return iter->second;
+  const ThriftStructSpec *ret = new ThriftStructSpec(spec, false);
+  m_requestSpecs[arr] = ret;
+  m_requestArrays.push_back(spec);
+  return ret;
 }
 
-void skip_element(long thrift_typeID, PHPInputTransport& transport) {
-  switch (thrift_typeID) {
-    case T_STOP:
-    case T_VOID:
-      return;
-    case T_STRUCT:
-      while (true) {
-        int8_t ttype = transport.readI8(); // get field type
-        if (ttype == T_STOP) break;
-        transport.skip(2); // skip field number, I16
-        skip_element(ttype, transport); // skip field payload
-      }
-      return;
-    case T_BOOL:
-    case T_BYTE:
-      transport.skip(1);
-      return;
-    case T_I16:
-      transport.skip(2);
-      return;
-    case T_I32:
-      transport.skip(4);
-      return;
-    case T_U64:
-    case T_I64:
-    case T_DOUBLE:
-      transport.skip(8);
-      return;
-    //case T_UTF7: // aliases T_STRING
-    case T_UTF8:
-    case T_UTF16:
-    case T_STRING: {
-      uint32_t len = transport.readU32();
-      transport.skip(len);
-      } return;
-    case T_MAP: {
-      int8_t keytype = transport.readI8();
-      int8_t valtype = transport.readI8();
-      uint32_t size = transport.readU32();
-      for (uint32_t i = 0; i < size; ++i) {
-        skip_element(keytype, transport);
-        skip_element(valtype, transport);
-      }
-    } return;
-    case T_LIST:
-    case T_SET: {
-      int8_t valtype = transport.readI8();
-      uint32_t size = transport.readU32();
-      for (uint32_t i = 0; i < size; ++i) {
-        skip_element(valtype, transport);
-      }
-    } return;
-  };
-
-  char errbuf[128];
-  sprintf(errbuf, "Unknown thrift typeID %ld", thrift_typeID);
-  throw_tprotocolexception(String(errbuf, CopyString), INVALID_DATA);
+/**
+ * A class's compiled $_TSPEC, or NULL if it isn't an array.
+ */
+static const ThriftStructSpec *class_spec(CStrRef className) {
+  Variant spec = get_static_property(className, "_TSPEC");
+  if (!spec.is(KindOfArray)) return NULL;
+  return s_thrift_data->getSpec(spec.toArray());
 }
 
-void binary_serialize_hashtable_key(int8_t keytype, PHPOutputTransport& transport,
-                                    Variant key) {
-  bool keytype_is_numeric = (!((keytype == T_STRING) || (keytype == T_UTF8) ||
-                               (keytype == T_UTF16)));
+static const ThriftStructSpec &class_spec_or_empty(CStrRef className) {
+  const ThriftStructSpec *spec = class_spec(className);
+  return spec ? *spec : s_emptySpec;
+}
 
-  if (keytype_is_numeric) {
-    key = key.toInt64();
-  } else {
-    key = key.toString();
+/**
+ * The spec of a T_STRUCT field's class. When both come from compiled code,
+ * it can't change, as generated thrift classes never assign to $_TSPEC, so
+ * it's remembered on the field.
+ */
+static const ThriftStructSpec *struct_spec(const ThriftFieldSpec &field) {
+  if (field.structSpec) return field.structSpec;
+  const ThriftStructSpec *spec = class_spec(field.className);
+  if (spec && spec->isPersistent() && field.classDefined) {
+    field.structSpec = spec;
   }
-  binary_serialize(keytype, transport, key, Array());
+  return spec;
 }
 
-inline bool ttype_is_int(int8_t t) {
-  return ((t == T_BYTE) || ((t >= T_I16)  && (t <= T_I64)));
+static Object create_struct(const ThriftFieldSpec &field) {
+  if (field.classDefined) {
+    return create_object(field.className.data(), Array());
+  }
+  return createObject(field.className);
 }
 
-inline bool ttypes_are_compatible(int8_t t1, int8_t t2) {
-  // Integer types of different widths are considered compatible;
-  // otherwise the typeID must match.
-  return ((t1 == t2) || (ttype_is_int(t1) && ttype_is_int(t2)));
-}
+///////////////////////////////////////////////////////////////////////////////
+// encoding and decoding, for any protocol
 
-void binary_deserialize_spec(CObjRef zthis, PHPInputTransport& transport,
-                             CArrRef spec) {
-  // SET and LIST have 'elem' => array('type', [optional] 'class')
-  // MAP has 'val' => array('type', [optiona] 'class')
-  while (true) {
-    Variant val;
-
-    int8_t ttype = transport.readI8();
-    if (ttype == T_STOP) return;
-    int16_t fieldno = transport.readI16();
-    if (!(val = spec.rvalAt(fieldno)).isNull()) {
-      Array fieldspec = val.toArray();
-      // pull the field name
-      // zend hash tables use the null at the end in the length... so strlen(hash key) + 1.
-      String varname = fieldspec.rvalAt(s_var).toString();
-
-      // and the type
-      int8_t expected_ttype = fieldspec.rvalAt(s_type).toInt64();
-
-      if (ttypes_are_compatible(ttype, expected_ttype)) {
-        Variant rv = binary_deserialize(ttype, transport, fieldspec);
-        zthis->set(varname, rv);
-      } else {
-        skip_element(ttype, transport);
-      }
-    } else {
-      skip_element(ttype, transport);
+template<class Writer>
+void write_value(Writer &writer, int8_t type, CVarRef value,
+                 const ThriftFieldSpec &spec);
+
+template<class Writer>
+void write_struct(Writer &writer, CObjRef obj, const ThriftStructSpec &spec) {
+  if (spec.hasBadKey()) {
+    throw_tprotocolexception("Bad keytype in TSPEC (expected 'long')",
+                             INVALID_DATA);
+  }
+  writer.writeStructBegin();
+  for (int i = 0; i < spec.size(); i++) {
+    const ThriftFieldSpec &field = spec.field(i);
+    Variant prop = obj->o_get(field.var);
+    if (!prop.isNull()) {
+      writer.writeFieldBegin(field.type, field.id);
+      write_value(writer, field.type, prop, field);
     }
   }
+  writer.writeFieldStop();
+  writer.writeStructEnd();
+}
+
+template<class Writer>
+void write_key(Writer &writer, int8_t type, CVarRef key) {
+  if (ttype_is_string(type)) {
+    write_value(writer, type, key.toString(), s_noFieldSpec);
+  } else {
+    write_value(writer, type, key.toInt64(), s_noFieldSpec);
+  }
 }
 
-void binary_serialize(int8_t thrift_typeID, PHPOutputTransport& transport,
-                      CVarRef value, CArrRef fieldspec) {
+template<class Writer>
+void write_value(Writer &writer, int8_t type, CVarRef value,
+                 const ThriftFieldSpec &spec) {
   // At this point the typeID (and field num, if applicable) should've already
   // been written to the output so all we need to do is write the payload.
-  switch (thrift_typeID) {
+  switch (type) {
     case T_STOP:
     case T_VOID:
       return;
@@ -574,114 +631,390 @@ void binary_serialize(int8_t thrift_typeID, PHPOutputTransport& transport,
         throw_tprotocolexception("Attempt to send non-object "
                                  "type as a T_STRUCT", INVALID_DATA);
       }
-      binary_serialize_spec(value, transport,
-                            get_static_property(toObject(value)->
-                                                o_getClassName(),
-                                                "_TSPEC").toArray());
+      Object obj = value.toObject();
+      CStrRef className = obj->o_getClassName();
+      const ThriftStructSpec *structSpec =
+        className.same(spec.className) ? struct_spec(spec) :
+        class_spec(className);
+      write_struct(writer, obj, structSpec ? *structSpec : s_emptySpec);
     } return;
     case T_BOOL:
-      transport.writeI8(value.toBoolean() ? 1 : 0);
+      writer.writeBool(value.toBoolean());
       return;
     case T_BYTE:
-      transport.writeI8(value.toByte());
+      writer.writeByte(value.toByte());
       return;
     case T_I16:
-      transport.writeI16(value.toInt16());
+      writer.writeI16(value.toInt16());
       return;
     case T_I32:
-      transport.writeI32(value.toInt32());
+      writer.writeI32(value.toInt32());
       return;
     case T_I64:
     case T_U64:
-      transport.writeI64(value.toInt64());
+      writer.writeI64(value.toInt64());
+      return;
+    case T_DOUBLE:
+      writer.writeDouble(value.toDouble());
       return;
-    case T_DOUBLE: {
-      union {
-        int64_t c;
-        double d;
-      } a;
-      a.d = value.toDouble();
-      transport.writeI64(a.c);
-    } return;
     //case T_UTF7:
     case T_UTF8:
     case T_UTF16:
     case T_STRING: {
-        String sv = value.toString();
-        transport.writeString(sv, sv.size());
+      String sv = value.toString();
+      writer.writeString(sv.data(), sv.size());
     } return;
     case T_MAP: {
       Array ht = value.toArray();
-      uint8_t keytype = fieldspec.rvalAt(s_ktype, -1).toByte();
-      transport.writeI8(keytype);
-      uint8_t valtype = fieldspec.rvalAt(s_vtype, -1).toByte();
-      transport.writeI8(valtype);
-
-      Array valspec = fieldspec.rvalAt(s_val, -1).toArray();
-
-      transport.writeI32(ht.size());
-      for (ArrayIter key_ptr = ht.begin(); !key_ptr.end(); ++key_ptr) {
-        binary_serialize_hashtable_key(keytype, transport, key_ptr.first());
-        binary_serialize(valtype, transport, key_ptr.second(), valspec);
+      const ThriftFieldSpec &valspec = child_spec(spec.val);
+      writer.writeMapBegin(spec.ktype, spec.vtype, ht.size());
+      for (ArrayIter iter = ht.begin(); !iter.end(); ++iter) {
+        write_key(writer, spec.ktype, iter.first());
+        write_value(writer, spec.vtype, iter.second(), valspec);
       }
     } return;
     case T_LIST: {
       Array ht = value.toArray();
-      Variant val;
-
-      uint8_t valtype = fieldspec.rvalAt(s_etype, -1).toInt64();
-      transport.writeI8(valtype);
-      Array valspec = fieldspec.rvalAt(s_elem, -1).toArray();
-      transport.writeI32(ht.size());
-      for (ArrayIter key_ptr = ht.begin(); !key_ptr.end(); ++key_ptr) {
-        binary_serialize(valtype, transport, key_ptr.second(), valspec);
+      const ThriftFieldSpec &elemspec = child_spec(spec.elem);
+      writer.writeListBegin(spec.etype, ht.size());
+      for (ArrayIter iter = ht.begin(); !iter.end(); ++iter) {
+        write_value(writer, spec.etype, iter.second(), elemspec);
       }
     } return;
     case T_SET: {
       Array ht = value.toArray();
+      writer.writeSetBegin(spec.etype, ht.size());
+      for (ArrayIter iter = ht.begin(); !iter.end(); ++iter) {
+        write_key(writer, spec.etype, iter.first());
+      }
+    } return;
+  };
+  throw_unknown_type(type);
+}
 
-      uint8_t keytype = fieldspec.rvalAt(s_etype, -1).toByte();
-      transport.writeI8(keytype);
-
-      transport.writeI32(ht.size());
-      for (ArrayIter key_ptr = ht.begin(); !key_ptr.end(); ++key_ptr) {
-        binary_serialize_hashtable_key(keytype, transport, key_ptr.first());
+template<class Reader>
+void skip_value(Reader &reader, int8_t type) {
+  switch (type) {
+    case T_STOP:
+    case T_VOID:
+      return;
+    case T_STRUCT: {
+      int8_t ftype;
+      int16_t fieldno;
+      reader.readStructBegin();
+      while (reader.readFieldBegin(ftype, fieldno)) {
+        skip_value(reader, ftype);
+      }
+      reader.readStructEnd();
+    } return;
+    case T_BOOL:
+      reader.readBool();
+      return;
+    case T_BYTE:
+      reader.readByte();
+      return;
+    case T_I16:
+      reader.readI16();
+      return;
+    case T_I32:
+      reader.readI32();
+      return;
+    case T_U64:
+    case T_I64:
+      reader.readI64();
+      return;
+    case T_DOUBLE:
+      reader.readDouble();
+      return;
+    //case T_UTF7: // aliases T_STRING
+    case T_UTF8:
+    case T_UTF16:
+    case T_STRING:
+      reader.skipString();
+      return;
+    case T_MAP: {
+      int8_t keytype, valtype;
+      uint32_t size;
+      reader.readMapBegin(keytype, valtype, size);
+      for (uint32_t i = 0; i < size; ++i) {
+        skip_value(reader, keytype);
+        skip_value(reader, valtype);
+      }
+    } return;
+    case T_LIST:
+    case T_SET: {
+      int8_t valtype;
+      uint32_t size;
+      reader.readListBegin(valtype, size);
+      for (uint32_t i = 0; i < size; ++i) {
+        skip_value(reader, valtype);
       }
     } return;
   };
-  char errbuf[128];
-  sprintf(errbuf, "Unknown thrift typeID %d", thrift_typeID);
-  throw_tprotocolexception(String(errbuf, CopyString), INVALID_DATA);
+  throw_unknown_type(type);
 }
 
+template<class Reader>
+void read_struct(Reader &reader, CObjRef obj, const ThriftStructSpec &spec);
 
-void binary_serialize_spec(CObjRef zthis, PHPOutputTransport& transport,
-                           CArrRef spec) {
-  for (ArrayIter key_ptr = spec.begin(); !key_ptr.end(); ++key_ptr) {
-    Variant key = key_ptr.first();
-    if (!key.isInteger()) {
-      throw_tprotocolexception("Bad keytype in TSPEC (expected 'long')", INVALID_DATA);
-      return;
+template<class Reader>
+Variant read_value(Reader &reader, int8_t type, const ThriftFieldSpec &spec) {
+  switch (type) {
+    case T_STOP:
+    case T_VOID:
+      return null;
+    case T_STRUCT: {
+      if (spec.className.isNull()) {
+        throw_tprotocolexception("no class type in spec", INVALID_DATA);
+      }
+      Object obj = create_struct(spec);
+      if (obj.isNull()) {
+        // unable to create class entry
+        skip_value(reader, T_STRUCT);
+        return null;
+      }
+      const ThriftStructSpec *structSpec = struct_spec(spec);
+      if (structSpec == NULL) {
+        char errbuf[128];
+        snprintf(errbuf, 128, "spec for %s is wrong type\n",
+                 spec.className.data());
+        throw_tprotocolexception(String(errbuf, CopyString), INVALID_DATA);
+      }
+      read_struct(reader, obj, *structSpec);
+      return obj;
+    }
+    case T_BOOL:
+      return reader.readBool();
+  //case T_I08: // same numeric value as T_BYTE
+    case T_BYTE:
+      return reader.readByte();
+    case T_I16:
+      return reader.readI16();
+    case T_I32:
+      return reader.readI32();
+    case T_U64:
+    case T_I64:
+      return reader.readI64();
+    case T_DOUBLE:
+      return reader.readDouble();
+    //case T_UTF7: // aliases T_STRING
+    case T_UTF8:
+    case T_UTF16:
+    case T_STRING:
+      return reader.readString();
+    case T_MAP: { // array of key -> value
+      int8_t keytype, valtype;
+      uint32_t size;
+      reader.readMapBegin(keytype, valtype, size);
+      const ThriftFieldSpec &keyspec = child_spec(spec.key);
+      const ThriftFieldSpec &valspec = child_spec(spec.val);
+      Array ret = Array::Create();
+      for (uint32_t s = 0; s < size; ++s) {
+        Variant key = read_value(reader, keytype, keyspec);
+        Variant value = read_value(reader, valtype, valspec);
+        ret.set(key, value);
+      }
+      return ret;
+    }
+    case T_LIST: { // array with autogenerated numeric keys
+      int8_t elemtype;
+      uint32_t size;
+      reader.readListBegin(elemtype, size);
+      const ThriftFieldSpec &elemspec = child_spec(spec.elem);
+      Array ret = Array::Create();
+      for (uint32_t s = 0; s < size; ++s) {
+        ret.append(read_value(reader, elemtype, elemspec));
+      }
+      return ret;
+    }
+    case T_SET: { // array of key -> TRUE
+      int8_t elemtype;
+      uint32_t size;
+      reader.readSetBegin(elemtype, size);
+      const ThriftFieldSpec &elemspec = child_spec(spec.elem);
+      Array ret = Array::Create();
+      for (uint32_t s = 0; s < size; ++s) {
+        Variant key = read_value(reader, elemtype, elemspec);
+        if (key.isInteger()) {
+          ret.set(key, true);
+        } else {
+          ret.set(key.toString(), true);
+        }
+      }
+      return ret;
     }
-    unsigned long fieldno = key.toInt64();
-    Array fieldspec = key_ptr.second().toArray();
+  };
+  throw_unknown_type(type);
+  return null;
+}
 
-    // field name
-    String varname = fieldspec.rvalAt(s_var, -1).toString();
+template<class Reader>
+void read_struct(Reader &reader, CObjRef obj, const ThriftStructSpec &spec) {
+  int8_t type;
+  int16_t fieldno;
+  reader.readStructBegin();
+  while (reader.readFieldBegin(type, fieldno)) {
+    const ThriftFieldSpec *field = spec.find(fieldno);
+    if (field && Reader::Compatible(type, field->type)) {
+      Variant value = read_value(reader, type, *field);
+      obj->set(field->var, value);
+    } else {
+      skip_value(reader, type);
+    }
+  }
+  reader.readStructEnd();
+}
 
-    // thrift type
-    int8_t ttype = fieldspec.rvalAt(s_type, -1).toByte();
+template<class Reader>
+Variant read_message(Reader &reader, int8_t messageType,
+                     CStrRef obj_typename) {
+  if (messageType == T_EXCEPTION) {
+    Object ex = createObject("TApplicationException");
+    read_struct(reader, ex, class_spec_or_empty("TApplicationException"));
+    throw ex;
+  }
 
-    Variant prop = zthis->o_get(varname);
-    if (!prop.isNull()) {
-      transport.writeI8(ttype);
-      transport.writeI16(fieldno);
-      binary_serialize(ttype, transport, prop, fieldspec);
-    }
+  Object ret_val = createObject(obj_typename);
+  if (ret_val.isNull()) {
+    skip_value(reader, T_STRUCT);
+    return null;
   }
-  transport.writeI8(T_STOP); // struct end
+  read_struct(reader, ret_val, class_spec_or_empty(obj_typename));
+  return ret_val;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// binary protocol
+
+class BinaryWriter {
+public:
+  BinaryWriter(PHPOutputTransport &transport) : m_transport(transport) {}
+
+  void writeStructBegin() {}
+  void writeStructEnd() {}
+  void writeFieldBegin(int8_t type, int16_t fieldno) {
+    m_transport.writeI8(type);
+    m_transport.writeI16(fieldno);
+  }
+  void writeFieldStop() {
+    m_transport.writeI8(T_STOP);
+  }
+  void writeMapBegin(int8_t keytype, int8_t valtype, uint32_t size) {
+    m_transport.writeI8(keytype);
+    m_transport.writeI8(valtype);
+    m_transport.writeI32(size);
+  }
+  void writeListBegin(int8_t elemtype, uint32_t size) {
+    m_transport.writeI8(elemtype);
+    m_transport.writeI32(size);
+  }
+  void writeSetBegin(int8_t elemtype, uint32_t size) {
+    writeListBegin(elemtype, size);
+  }
+
+  void writeBool(bool value) { m_transport.writeI8(value ? 1 : 0);}
+  void writeByte(int8_t value) { m_transport.writeI8(value);}
+  void writeI16(int16_t value) { m_transport.writeI16(value);}
+  void writeI32(int32_t value) { m_transport.writeI32(value);}
+  void writeI64(int64_t value) { m_transport.writeI64(value);}
+  void writeDouble(double value) {
+    union {
+      int64_t c;
+      double d;
+    } a;
+    a.d = value;
+    m_transport.writeI64(a.c);
+  }
+  void writeString(const char *data, size_t len) {
+    m_transport.writeString(data, len);
+  }
+
+private:
+  PHPOutputTransport &m_transport;
+};
+
+class BinaryReader {
+public:
+  BinaryReader(PHPInputTransport &transport) : m_transport(transport) {}
+
+  static bool Compatible(int8_t type, int8_t expected) {
+    return ttypes_are_compatible(type, expected);
+  }
+
+  void readStructBegin() {}
+  void readStructEnd() {}
+  bool readFieldBegin(int8_t &type, int16_t &fieldno) {
+    type = m_transport.readI8();
+    if (type == T_STOP) return false;
+    fieldno = m_transport.readI16();
+    return true;
+  }
+  void readMapBegin(int8_t &keytype, int8_t &valtype, uint32_t &size) {
+    uint8_t types[2];
+    m_transport.readBytes(types, 2);
+    keytype = types[0];
+    valtype = types[1];
+    size = m_transport.readU32();
+  }
+  void readListBegin(int8_t &elemtype, uint32_t &size) {
+    elemtype = m_transport.readI8();
+    size = m_transport.readU32();
+  }
+  void readSetBegin(int8_t &elemtype, uint32_t &size) {
+    readListBegin(elemtype, size);
+  }
+
+  bool readBool() {
+    uint8_t c;
+    m_transport.readBytes(&c, 1);
+    return c != 0;
+  }
+  int64 readByte() {
+    uint8_t c;
+    m_transport.readBytes(&c, 1);
+    return c;
+  }
+  int64 readI16() {
+    uint16_t c;
+    m_transport.readBytes(&c, 2);
+    return ntohs(c);
+  }
+  int readI32() {
+    return m_transport.readI32();
+  }
+  int64 readI64() {
+    uint64_t c;
+    m_transport.readBytes(&c, 8);
+    return (int64)ntohll(c);
+  }
+  double readDouble() {
+    union {
+      uint64_t c;
+      double d;
+    } a;
+    m_transport.readBytes(&(a.c), 8);
+    a.c = ntohll(a.c);
+    return a.d;
+  }
+  String readString() {
+    uint32_t size = m_transport.readU32();
+    if (size && (size + 1)) {
+      char* strbuf = (char*) malloc(size + 1);
+      m_transport.readBytes(strbuf, size);
+      strbuf[size] = '\0';
+      return String(strbuf, size, AttachString);
+    }
+    return empty_string;
+  }
+  void skipString() {
+    uint32_t len = m_transport.readU32();
+    m_transport.skip(len);
+  }
+
+private:
+  PHPInputTransport &m_transport;
+};
+
 void f_thrift_protocol_write_binary(CObjRef transportobj, CStrRef method_name,
                                     int64 msgtype, CObjRef request_struct,
                                     int seqid, bool strict_write) {
@@ -699,9 +1032,9 @@ void f_thrift_protocol_write_binary(CObjRef transportobj, CStrRef method_name,
     transport.writeI32(seqid);
   }
 
-  Variant spec = get_static_property(request_struct->o_getClassName(),
-                                     "_TSPEC");
-  binary_serialize_spec(request_struct, transport, spec.toArray());
+  BinaryWriter writer(transport);
+  write_struct(writer, request_struct,
+               class_spec_or_empty(request_struct->o_getClassName()));
 }
 
 Variant f_thrift_protocol_read_binary(CObjRef transportobj,
@@ -732,17 +1065,342 @@ Variant f_thrift_protocol_read_binary(CObjRef transportobj,
     }
   }
 
-  if (messageType == T_EXCEPTION) {
-    Object ex = createObject("TApplicationException");
-    Variant spec = get_static_property("TApplicationException", "_TSPEC");
-    binary_deserialize_spec(ex, transport, spec.toArray());
-    throw ex;
+  BinaryReader reader(transport);
+  return read_message(reader, messageType, obj_typename);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// compact protocol
+
+const uint8_t COMPACT_PROTOCOL_ID = 0x82;
+const uint8_t COMPACT_VERSION = 1;
+const uint8_t COMPACT_VERSION_MASK = 0x1f;
+const uint8_t COMPACT_TYPE_MASK = 0xe0;
+const int COMPACT_TYPE_SHIFT = 5;
+
+enum CType {
+  CT_STOP          = 0x00,
+  CT_BOOLEAN_TRUE  = 0x01,
+  CT_BOOLEAN_FALSE = 0x02,
+  CT_BYTE          = 0x03,
+  CT_I16           = 0x04,
+  CT_I32           = 0x05,
+  CT_I64           = 0x06,
+  CT_DOUBLE        = 0x07,
+  CT_BINARY        = 0x08,
+  CT_LIST          = 0x09,
+  CT_SET           = 0x0A,
+  CT_MAP           = 0x0B,
+  CT_STRUCT        = 0x0C
+};
+
+static uint8_t ctype_of(int8_t type) {
+  switch (type) {
+    case T_BOOL:   return CT_BOOLEAN_TRUE;
+    case T_BYTE:   return CT_BYTE;
+    case T_I16:    return CT_I16;
+    case T_I32:    return CT_I32;
+    case T_U64:
+    case T_I64:    return CT_I64;
+    case T_DOUBLE: return CT_DOUBLE;
+    case T_UTF8:
+    case T_UTF16:
+    case T_STRING: return CT_BINARY;
+    case T_LIST:   return CT_LIST;
+    case T_SET:    return CT_SET;
+    case T_MAP:    return CT_MAP;
+    case T_STRUCT: return CT_STRUCT;
   }
+  throw_unknown_type(type);
+  return CT_STOP;
+}
 
-  Object ret_val = createObject(obj_typename);
-  Variant spec = get_static_property(obj_typename, "_TSPEC");
-  binary_deserialize_spec(ret_val, transport, spec.toArray());
-  return ret_val;
+static int8_t ttype_of(uint8_t ctype) {
+  switch (ctype) {
+    case CT_STOP:          return T_STOP;
+    case CT_BOOLEAN_TRUE:
+    case CT_BOOLEAN_FALSE: return T_BOOL;
+    case CT_BYTE:          return T_BYTE;
+    case CT_I16:           return T_I16;
+    case CT_I32:           return T_I32;
+    case CT_I64:           return T_I64;
+    case CT_DOUBLE:        return T_DOUBLE;
+    case CT_BINARY:        return T_STRING;
+    case CT_LIST:          return T_LIST;
+    case CT_SET:           return T_SET;
+    case CT_MAP:           return T_MAP;
+    case CT_STRUCT:        return T_STRUCT;
+  }
+  char errbuf[128];
+  sprintf(errbuf, "Unknown compact type %d", ctype);
+  throw_tprotocolexception(String(errbuf, CopyString), INVALID_DATA);
+  return T_STOP;
+}
+
+inline uint64_t zigzag(int64_t n) {
+  return ((uint64_t)n << 1) ^ (uint64_t)(n >> 63);
+}
+
+inline int64_t unzigzag(uint64_t n) {
+  return (int64_t)(n >> 1) ^ -(int64_t)(n & 1);
+}
+
+/**
+ * Field numbers are written as deltas from the previous field of the same
+ * struct, and bool fields carry their value in the field header.
+ */
+class CompactWriter {
+public:
+  CompactWriter(PHPOutputTransport &transport)
+    : m_transport(transport), m_lastFieldId(0), m_boolFieldId(0),
+      m_boolPending(false) {}
+
+  void writeMessageBegin(CStrRef name, int8_t type, int32_t seqid) {
+    m_transport.writeI8(COMPACT_PROTOCOL_ID);
+    m_transport.writeI8((COMPACT_VERSION & COMPACT_VERSION_MASK) |
+                        ((type << COMPACT_TYPE_SHIFT) & COMPACT_TYPE_MASK));
+    writeVarint((uint32_t)seqid);
+    writeString(name.data(), name.size());
+  }
+
+  void writeStructBegin() {
+    m_lastFieldIds.push_back(m_lastFieldId);
+    m_lastFieldId = 0;
+  }
+  void writeStructEnd() {
+    m_lastFieldId = m_lastFieldIds.back();
+    m_lastFieldIds.pop_back();
+  }
+  void writeFieldBegin(int8_t type, int16_t fieldno) {
+    if (type == T_BOOL) {
+      m_boolFieldId = fieldno; // written with the value
+      m_boolPending = true;
+    } else {
+      writeFieldHeader(ctype_of(type), fieldno);
+    }
+  }
+  void writeFieldStop() {
+    m_transport.writeI8(CT_STOP);
+  }
+  void writeMapBegin(int8_t keytype, int8_t valtype, uint32_t size) {
+    if (size == 0) {
+      m_transport.writeI8(0);
+    } else {
+      writeVarint(size);
+      m_transport.writeI8((ctype_of(keytype) << 4) | ctype_of(valtype));
+    }
+  }
+  void writeListBegin(int8_t elemtype, uint32_t size) {
+    if (size <= 14) {
+      m_transport.writeI8((size << 4) | ctype_of(elemtype));
+    } else {
+      m_transport.writeI8(0xf0 | ctype_of(elemtype));
+      writeVarint(size);
+    }
+  }
+  void writeSetBegin(int8_t elemtype, uint32_t size) {
+    writeListBegin(elemtype, size);
+  }
+
+  void writeBool(bool value) {
+    uint8_t ctype = value ? CT_BOOLEAN_TRUE : CT_BOOLEAN_FALSE;
+    if (m_boolPending) {
+      writeFieldHeader(ctype, m_boolFieldId);
+      m_boolPending = false;
+    } else {
+      m_transport.writeI8(ctype);
+    }
+  }
+  void writeByte(int8_t value) { m_transport.writeI8(value);}
+  void writeI16(int16_t value) { writeVarint(zigzag(value));}
+  void writeI32(int32_t value) { writeVarint(zigzag(value));}
+  void writeI64(int64_t value) { writeVarint(zigzag(value));}
+  void writeDouble(double value) {
+    union {
+      uint64_t c;
+      double d;
+    } a;
+    a.d = value;
+    char buf[8];
+    for (int i = 0; i < 8; i++) {
+      buf[i] = (char)(a.c >> (i * 8));
+    }
+    m_transport.write(buf, 8);
+  }
+  void writeString(const char *data, size_t len) {
+    writeVarint(len);
+    m_transport.write(data, len);
+  }
+
+private:
+  PHPOutputTransport &m_transport;
+  int16_t m_lastFieldId;
+  std::vector<int16_t> m_lastFieldIds;
+  int16_t m_boolFieldId;
+  bool m_boolPending;
+
+  void writeFieldHeader(uint8_t ctype, int16_t fieldno) {
+    int delta = fieldno - m_lastFieldId;
+    if (delta > 0 && delta <= 15) {
+      m_transport.writeI8((delta << 4) | ctype);
+    } else {
+      m_transport.writeI8(ctype);
+      writeI16(fieldno);
+    }
+    m_lastFieldId = fieldno;
+  }
+
+  void writeVarint(uint64_t n) {
+    char buf[10];
+    int len = 0;
+    while (n > 0x7f) {
+      buf[len++] = (char)((n & 0x7f) | 0x80);
+      n >>= 7;
+    }
+    buf[len++] = (char)n;
+    m_transport.write(buf, len);
+  }
+};
+
+class CompactReader {
+public:
+  CompactReader(PHPInputTransport &transport)
+    : m_transport(transport), m_lastFieldId(0), m_boolValue(-1) {}
+
+  static bool Compatible(int8_t type, int8_t expected) {
+    // strings of any kind are all CT_BINARY on the wire
+    return ttypes_are_compatible(type, expected) ||
+      (ttype_is_string(type) && ttype_is_string(expected));
+  }
+
+  int8_t readMessageBegin() {
+    if ((uint8_t)m_transport.readI8() != COMPACT_PROTOCOL_ID) {
+      throw_tprotocolexception("Bad protocol identifier", BAD_VERSION);
+    }
+    uint8_t versionAndType = m_transport.readI8();
+    if ((versionAndType & COMPACT_VERSION_MASK) != COMPACT_VERSION) {
+      throw_tprotocolexception("Bad version identifier", BAD_VERSION);
+    }
+    // skip the sequence ID and the name, we don't care about those
+    readVarint();
+    skipString();
+    return (versionAndType & COMPACT_TYPE_MASK) >> COMPACT_TYPE_SHIFT;
+  }
+
+  void readStructBegin() {
+    m_lastFieldIds.push_back(m_lastFieldId);
+    m_lastFieldId = 0;
+  }
+  void readStructEnd() {
+    m_lastFieldId = m_lastFieldIds.back();
+    m_lastFieldIds.pop_back();
+  }
+  bool readFieldBegin(int8_t &type, int16_t &fieldno) {
+    uint8_t header = m_transport.readI8();
+    uint8_t ctype = header & 0x0f;
+    if (ctype == CT_STOP) {
+      type = T_STOP;
+      return false;
+    }
+    int16_t delta = header >> 4;
+    fieldno = delta ? m_lastFieldId + delta : (int16_t)unzigzag(readVarint());
+    type = ttype_of(ctype);
+    if (type == T_BOOL) {
+      m_boolValue = (ctype == CT_BOOLEAN_TRUE);
+    }
+    m_lastFieldId = fieldno;
+    return true;
+  }
+  void readMapBegin(int8_t &keytype, int8_t &valtype, uint32_t &size) {
+    size = readVarint();
+    uint8_t types = size ? m_transport.readI8() : 0;
+    keytype = ttype_of(types >> 4);
+    valtype = ttype_of(types & 0x0f);
+  }
+  void readListBegin(int8_t &elemtype, uint32_t &size) {
+    uint8_t header = m_transport.readI8();
+    size = header >> 4;
+    if (size == 15) {
+      size = readVarint();
+    }
+    elemtype = ttype_of(header & 0x0f);
+  }
+  void readSetBegin(int8_t &elemtype, uint32_t &size) {
+    readListBegin(elemtype, size);
+  }
+
+  bool readBool() {
+    if (m_boolValue >= 0) {
+      bool value = m_boolValue;
+      m_boolValue = -1;
+      return value;
+    }
+    return m_transport.readI8() == CT_BOOLEAN_TRUE;
+  }
+  int64 readByte() { return m_transport.readI8();}
+  int64 readI16() { return (int16_t)unzigzag(readVarint());}
+  int readI32() { return (int32_t)unzigzag(readVarint());}
+  int64 readI64() { return unzigzag(readVarint());}
+  double readDouble() {
+    uint8_t buf[8];
+    m_transport.readBytes(buf, 8);
+    union {
+      uint64_t c;
+      double d;
+    } a;
+    a.c = 0;
+    for (int i = 0; i < 8; i++) {
+      a.c |= (uint64_t)buf[i] << (i * 8);
+    }
+    return a.d;
+  }
+  String readString() {
+    uint32_t size = readVarint();
+    if (size == 0) return empty_string;
+    char* strbuf = (char*) malloc(size + 1);
+    m_transport.readBytes(strbuf, size);
+    strbuf[size] = '\0';
+    return String(strbuf, size, AttachString);
+  }
+  void skipString() {
+    m_transport.skip((uint32_t)readVarint());
+  }
+
+private:
+  PHPInputTransport &m_transport;
+  int16_t m_lastFieldId;
+  std::vector<int16_t> m_lastFieldIds;
+  int m_boolValue; // of the current bool field, or -1
+
+  uint64_t readVarint() {
+    uint64_t ret = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      uint8_t b = m_transport.readI8();
+      ret |= (uint64_t)(b & 0x7f) << shift;
+      if (!(b & 0x80)) return ret;
+    }
+    throw_tprotocolexception("Variable-length int over 10 bytes",
+                             INVALID_DATA);
+    return 0;
+  }
+};
+
+void f_thrift_protocol_write_compact(CObjRef transportobj,
+                                     CStrRef method_name, int64 msgtype,
+                                     CObjRef request_struct, int seqid) {
+  PHPOutputTransport transport(transportobj);
+  CompactWriter writer(transport);
+  writer.writeMessageBegin(method_name, msgtype, seqid);
+  write_struct(writer, request_struct,
+               class_spec_or_empty(request_struct->o_getClassName()));
+}
+
+Variant f_thrift_protocol_read_compact(CObjRef transportobj,
+                                       CStrRef obj_typename) {
+  PHPInputTransport transport(transportobj);
+  CompactReader reader(transport);
+  int8_t messageType = reader.readMessageBegin();
+  return read_message(reader, messageType, obj_typename);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -55,6 +55,11 @@ inline Variant x_memcache_get(CObjRef memcache, CVarRef key, CVarRef flags = nul
   return f_memcache_get(memcache, key, flags);
 }
 
+inline Array x_memcache_get_multi(CObjRef memcache, CArrRef keys) {
+  FUNCTION_INJECTION_BUILTIN(memcache_get_multi);
+  return f_memcache_get_multi(memcache, keys);
+}
+
 inline bool x_memcache_delete(CObjRef memcache, CStrRef key, int expire = 0) {
   FUNCTION_INJECTION_BUILTIN(memcache_delete);
   return f_memcache_delete(memcache, key, expire);
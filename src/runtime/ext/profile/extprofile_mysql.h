@@ -230,6 +230,12 @@ inline Variant x_mysql_fetch_array(CVarRef result, int result_type = 3) {
   return f_mysql_fetch_array(result, result_type);
 }
 
+inline Variant x_mysql_fetch_all(CVarRef result, int result_type = 1,
+                                 bool columnar = false) {
+  FUNCTION_INJECTION_BUILTIN(mysql_fetch_all);
+  return f_mysql_fetch_all(result, result_type, columnar);
+}
+
 inline Variant x_mysql_fetch_lengths(CVarRef result) {
   FUNCTION_INJECTION_BUILTIN(mysql_fetch_lengths);
   return f_mysql_fetch_lengths(result);
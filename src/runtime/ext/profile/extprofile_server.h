@@ -45,11 +45,21 @@ inline Object x_pagelet_server_task_start(CStrRef url, CArrRef headers = null_ar
   return f_pagelet_server_task_start(url, headers, post_data);
 }
 
+inline Array x_pagelet_server_task_start_multi(CArrRef urls, CArrRef headers = null_array, CArrRef post_data = null_array) {
+  FUNCTION_INJECTION_BUILTIN(pagelet_server_task_start_multi);
+  return f_pagelet_server_task_start_multi(urls, headers, post_data);
+}
+
 inline bool x_pagelet_server_task_status(CObjRef task) {
   FUNCTION_INJECTION_BUILTIN(pagelet_server_task_status);
   return f_pagelet_server_task_status(task);
 }
 
+inline Variant x_pagelet_server_task_wait(CArrRef tasks, int timeout_ms = -1) {
+  FUNCTION_INJECTION_BUILTIN(pagelet_server_task_wait);
+  return f_pagelet_server_task_wait(tasks, timeout_ms);
+}
+
 inline String x_pagelet_server_task_result(CObjRef task, CVarRef headers, CVarRef code) {
   FUNCTION_INJECTION_BUILTIN(pagelet_server_task_result);
   return f_pagelet_server_task_result(task, headers, code);
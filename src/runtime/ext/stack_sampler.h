@@ -0,0 +1,77 @@
+/*
+   +----------------------------------------------------------------------+
+   | HipHop for PHP                                                       |
+   +----------------------------------------------------------------------+
+   | Copyright (c) 2010 Facebook, Inc. (http://www.facebook.com)          |
+   | Copyright (c) 1997-2010 The PHP Group                                |
+   +----------------------------------------------------------------------+
+   | This source file is subject to version 3.01 of the PHP license,      |
+   | that is bundled with this package in the file LICENSE, and is        |
+   | available through the world-wide-web at the following url:           |
+   | http://www.php.net/license/3_01.txt                                  |
+   | If you did not receive a copy of the PHP license and are unable to   |
+   | obtain it through the world-wide-web, please send a note to          |
+   | license@php.net so we can mail you a copy immediately.               |
+   +----------------------------------------------------------------------+
+*/
+
+#ifndef __HPHP_STACK_SAMPLER_H__
+#define __HPHP_STACK_SAMPLER_H__
+
+#include <util/base.h>
+
+namespace HPHP {
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Always-on sampling profiler, cheap enough to leave running on production.
+ * Each request thread has a CPU time timer that sends it SIGPROF at a fixed
+ * frequency. The signal handler walks FrameInjection frames of the thread,
+ * and counts the stack in a fixed-size table owned by the thread, without
+ * allocating or locking. Stacks are stored as a tree of (parent, function)
+ * nodes, so a sample of a stack seen before only increments a counter.
+ *
+ * Results are reported in "folded" format, one stack per line, functions
+ * separated by ';' from the outermost one, followed by a space and a count,
+ * which is what flame graph tools take as input.
+ *
+ * Implemented in runtime/ext/ext_hotprofiler.cpp.
+ */
+class StackSampler {
+public:
+  /**
+   * Samples per second of CPU time on each thread, or 0 to stop sampling.
+   * Threads pick up a change when they start their next request. Returns
+   * false if sampling isn't supported on this platform.
+   */
+  static bool SetFrequency(int frequency);
+  static int GetFrequency();
+
+  /**
+   * Called when a request starts, to arm or disarm this thread's timer.
+   */
+  static void OnSessionInit();
+
+  /**
+   * Forgets all samples. Each thread clears its table as it starts its
+   * next request.
+   */
+  static void Clear();
+
+  /**
+   * All stacks sampled so far, merged across threads, in folded format.
+   */
+  static std::string GetFoldedStacks();
+
+  /**
+   * Counters: samples taken, samples without any PHP frame, samples dropped
+   * because a table was full, and threads with a table, as "name: value"
+   * lines.
+   */
+  static std::string GetStatus();
+};
+
+///////////////////////////////////////////////////////////////////////////////
+}
+
+#endif // __HPHP_STACK_SAMPLER_H__
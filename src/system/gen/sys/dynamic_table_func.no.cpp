@@ -24582,6 +24582,88 @@ Variant i_fb_call_user_func_array_safe(CArrRef params) {
     return (f_fb_call_user_func_array_safe(arg0, arg1));
   }
 }
+Variant i_memcache_get_multi(CArrRef params) {
+  FUNCTION_INJECTION(memcache_get_multi);
+  int count __attribute__((__unused__)) = params.size();
+  if (count != 2) return throw_wrong_arguments("memcache_get_multi", count, 2, 2, 1);
+  {
+    ArrayData *ad(params.get());
+    ssize_t pos = ad ? ad->iter_begin() : ArrayData::invalid_index;
+    CVarRef arg0((ad->getValue(pos)));
+    CVarRef arg1((ad->getValue(pos = ad->iter_advance(pos))));
+    return (f_memcache_get_multi(arg0, arg1));
+  }
+}
+Variant i_pagelet_server_task_start_multi(CArrRef params) {
+  FUNCTION_INJECTION(pagelet_server_task_start_multi);
+  int count __attribute__((__unused__)) = params.size();
+  if (count < 1 || count > 3) return throw_wrong_arguments("pagelet_server_task_start_multi", count, 1, 3, 1);
+  {
+    ArrayData *ad(params.get());
+    ssize_t pos = ad ? ad->iter_begin() : ArrayData::invalid_index;
+    CVarRef arg0((ad->getValue(pos)));
+    if (count <= 1) return (f_pagelet_server_task_start_multi(arg0));
+    CVarRef arg1((ad->getValue(pos = ad->iter_advance(pos))));
+    if (count == 2) return (f_pagelet_server_task_start_multi(arg0, arg1));
+    CVarRef arg2((ad->getValue(pos = ad->iter_advance(pos))));
+    return (f_pagelet_server_task_start_multi(arg0, arg1, arg2));
+  }
+}
+Variant i_pagelet_server_task_wait(CArrRef params) {
+  FUNCTION_INJECTION(pagelet_server_task_wait);
+  int count __attribute__((__unused__)) = params.size();
+  if (count < 1 || count > 2) return throw_wrong_arguments("pagelet_server_task_wait", count, 1, 2, 1);
+  {
+    ArrayData *ad(params.get());
+    ssize_t pos = ad ? ad->iter_begin() : ArrayData::invalid_index;
+    CVarRef arg0((ad->getValue(pos)));
+    if (count <= 1) return (f_pagelet_server_task_wait(arg0));
+    CVarRef arg1((ad->getValue(pos = ad->iter_advance(pos))));
+    return (f_pagelet_server_task_wait(arg0, arg1));
+  }
+}
+Variant i_mysql_fetch_all(CArrRef params) {
+  FUNCTION_INJECTION(mysql_fetch_all);
+  int count __attribute__((__unused__)) = params.size();
+  if (count < 1 || count > 3) return throw_wrong_arguments("mysql_fetch_all", count, 1, 3, 1);
+  {
+    ArrayData *ad(params.get());
+    ssize_t pos = ad ? ad->iter_begin() : ArrayData::invalid_index;
+    CVarRef arg0((ad->getValue(pos)));
+    if (count <= 1) return (f_mysql_fetch_all(arg0));
+    CVarRef arg1((ad->getValue(pos = ad->iter_advance(pos))));
+    if (count == 2) return (f_mysql_fetch_all(arg0, arg1));
+    CVarRef arg2((ad->getValue(pos = ad->iter_advance(pos))));
+    return (f_mysql_fetch_all(arg0, arg1, arg2));
+  }
+}
+Variant i_thrift_protocol_write_compact(CArrRef params) {
+  FUNCTION_INJECTION(thrift_protocol_write_compact);
+  int count __attribute__((__unused__)) = params.size();
+  if (count != 5) return throw_wrong_arguments("thrift_protocol_write_compact", count, 5, 5, 1);
+  {
+    ArrayData *ad(params.get());
+    ssize_t pos = ad ? ad->iter_begin() : ArrayData::invalid_index;
+    CVarRef arg0((ad->getValue(pos)));
+    CVarRef arg1((ad->getValue(pos = ad->iter_advance(pos))));
+    CVarRef arg2((ad->getValue(pos = ad->iter_advance(pos))));
+    CVarRef arg3((ad->getValue(pos = ad->iter_advance(pos))));
+    CVarRef arg4((ad->getValue(pos = ad->iter_advance(pos))));
+    return (f_thrift_protocol_write_compact(arg0, arg1, arg2, arg3, arg4), null);
+  }
+}
+Variant i_thrift_protocol_read_compact(CArrRef params) {
+  FUNCTION_INJECTION(thrift_protocol_read_compact);
+  int count __attribute__((__unused__)) = params.size();
+  if (count != 2) return throw_wrong_arguments("thrift_protocol_read_compact", count, 2, 2, 1);
+  {
+    ArrayData *ad(params.get());
+    ssize_t pos = ad ? ad->iter_begin() : ArrayData::invalid_index;
+    CVarRef arg0((ad->getValue(pos)));
+    CVarRef arg1((ad->getValue(pos = ad->iter_advance(pos))));
+    return (f_thrift_protocol_read_compact(arg0, arg1));
+  }
+}
 Variant invoke_builtin(const char *s, CArrRef params, int64 hash, bool fatal) {
   if (hash < 0) hash = hash_string(s);
   switch (hash & 4095) {
@@ -25447,6 +25529,9 @@ Variant invoke_builtin(const char *s, CArrRef params, int64 hash, bool fatal) {
     case 698:
       HASH_INVOKE(0x4A3D2113D3DFD2BALL, newpixelwandarray);
       break;
+    case 699:
+      HASH_INVOKE(0x083291F5D08082BBLL, memcache_get_multi);
+      break;
     case 700:
       HASH_INVOKE(0x33E08846F3EB42BCLL, ldap_get_values);
       HASH_INVOKE(0x41F7E2214DDE12BCLL, mcrypt_enc_self_test);
@@ -26713,6 +26798,7 @@ Variant invoke_builtin(const char *s, CArrRef params, int64 hash, bool fatal) {
       HASH_INVOKE(0x798B4197212456B5LL, bcpowmod);
       HASH_INVOKE(0x623CE67C41A9E6B5LL, ldap_next_attribute);
       HASH_INVOKE(0x7E773A36449576B5LL, imagecharup);
+      HASH_INVOKE(0x3B81B5A6BE3ED6B5LL, thrift_protocol_write_compact);
       break;
     case 1719:
       HASH_INVOKE(0x0C44E5EEB9C646B7LL, memcache_connect);
@@ -27036,6 +27122,9 @@ Variant invoke_builtin(const char *s, CArrRef params, int64 hash, bool fatal) {
     case 1967:
       HASH_INVOKE(0x16CB9891EF26D7AFLL, drawgetstrokedashoffset);
       break;
+    case 1973:
+      HASH_INVOKE(0x4AE7BD155D5B27B5LL, pagelet_server_task_start_multi);
+      break;
     case 1977:
       HASH_INVOKE(0x1FC9406FD7FCD7B9LL, strrpos);
       HASH_INVOKE(0x1B6467AD87E167B9LL, log1p);
@@ -28285,6 +28374,9 @@ Variant invoke_builtin(const char *s, CArrRef params, int64 hash, bool fatal) {
     case 2958:
       HASH_INVOKE(0x62A4D7A03F7C3B8ELL, ceil);
       break;
+    case 2961:
+      HASH_INVOKE(0x0538D73928468B91LL, mysql_fetch_all);
+      break;
     case 2967:
       HASH_INVOKE(0x09837A82A928AB97LL, is_null);
       break;
@@ -29576,6 +29668,9 @@ Variant invoke_builtin(const char *s, CArrRef params, int64 hash, bool fatal) {
     case 3943:
       HASH_INVOKE(0x319407AC92912F67LL, ereg);
       break;
+    case 3944:
+      HASH_INVOKE(0x4E6C2C8AE7845F68LL, pagelet_server_task_wait);
+      break;
     case 3946:
       HASH_INVOKE(0x1670096FDE27AF6ALL, rewind);
       break;
@@ -29747,6 +29842,9 @@ Variant invoke_builtin(const char *s, CArrRef params, int64 hash, bool fatal) {
       HASH_INVOKE(0x7F5FC3CAF8CE9FDELL, gzcompress);
       HASH_INVOKE(0x72925D2DF7E61FDELL, drawpathcurvetoquadraticbeziersmoothrelative);
       break;
+    case 4069:
+      HASH_INVOKE(0x43BA2CB702E68FE5LL, thrift_protocol_read_compact);
+      break;
     case 4071:
       HASH_INVOKE(0x217067889854CFE7LL, xmlwriter_start_dtd);
       break;
@@ -71160,6 +71258,151 @@ Variant ei_fb_call_user_func_array_safe(Eval::VariableEnvironment &env, const Ev
   }
   return (x_fb_call_user_func_array_safe(a0, a1));
 }
+Variant ei_memcache_get_multi(Eval::VariableEnvironment &env, const Eval::FunctionCallExpression *caller) {
+  Variant a0;
+  Variant a1;
+  const std::vector<Eval::ExpressionPtr> &params = caller->params();
+  int count __attribute__((__unused__)) = params.size();
+  if (count != 2) return throw_wrong_arguments("memcache_get_multi", count, 2, 2, 1);
+  std::vector<Eval::ExpressionPtr>::const_iterator it = params.begin();
+  do {
+    if (it == params.end()) break;
+    a0 = (*it)->eval(env);
+    it++;
+    if (it == params.end()) break;
+    a1 = (*it)->eval(env);
+    it++;
+  } while(false);
+  for (; it != params.end(); ++it) {
+    (*it)->eval(env);
+  }
+  return (x_memcache_get_multi(a0, a1));
+}
+Variant ei_pagelet_server_task_start_multi(Eval::VariableEnvironment &env, const Eval::FunctionCallExpression *caller) {
+  Variant a0;
+  Variant a1;
+  Variant a2;
+  const std::vector<Eval::ExpressionPtr> &params = caller->params();
+  int count __attribute__((__unused__)) = params.size();
+  if (count < 1 || count > 3) return throw_wrong_arguments("pagelet_server_task_start_multi", count, 1, 3, 1);
+  std::vector<Eval::ExpressionPtr>::const_iterator it = params.begin();
+  do {
+    if (it == params.end()) break;
+    a0 = (*it)->eval(env);
+    it++;
+    if (it == params.end()) break;
+    a1 = (*it)->eval(env);
+    it++;
+    if (it == params.end()) break;
+    a2 = (*it)->eval(env);
+    it++;
+  } while(false);
+  for (; it != params.end(); ++it) {
+    (*it)->eval(env);
+  }
+  if (count <= 1) return (x_pagelet_server_task_start_multi(a0));
+  else if (count == 2) return (x_pagelet_server_task_start_multi(a0, a1));
+  else return (x_pagelet_server_task_start_multi(a0, a1, a2));
+}
+Variant ei_pagelet_server_task_wait(Eval::VariableEnvironment &env, const Eval::FunctionCallExpression *caller) {
+  Variant a0;
+  Variant a1;
+  const std::vector<Eval::ExpressionPtr> &params = caller->params();
+  int count __attribute__((__unused__)) = params.size();
+  if (count < 1 || count > 2) return throw_wrong_arguments("pagelet_server_task_wait", count, 1, 2, 1);
+  std::vector<Eval::ExpressionPtr>::const_iterator it = params.begin();
+  do {
+    if (it == params.end()) break;
+    a0 = (*it)->eval(env);
+    it++;
+    if (it == params.end()) break;
+    a1 = (*it)->eval(env);
+    it++;
+  } while(false);
+  for (; it != params.end(); ++it) {
+    (*it)->eval(env);
+  }
+  if (count <= 1) return (x_pagelet_server_task_wait(a0));
+  else return (x_pagelet_server_task_wait(a0, a1));
+}
+Variant ei_mysql_fetch_all(Eval::VariableEnvironment &env, const Eval::FunctionCallExpression *caller) {
+  Variant a0;
+  Variant a1;
+  Variant a2;
+  const std::vector<Eval::ExpressionPtr> &params = caller->params();
+  int count __attribute__((__unused__)) = params.size();
+  if (count < 1 || count > 3) return throw_wrong_arguments("mysql_fetch_all", count, 1, 3, 1);
+  std::vector<Eval::ExpressionPtr>::const_iterator it = params.begin();
+  do {
+    if (it == params.end()) break;
+    a0 = (*it)->eval(env);
+    it++;
+    if (it == params.end()) break;
+    a1 = (*it)->eval(env);
+    it++;
+    if (it == params.end()) break;
+    a2 = (*it)->eval(env);
+    it++;
+  } while(false);
+  for (; it != params.end(); ++it) {
+    (*it)->eval(env);
+  }
+  if (count <= 1) return (x_mysql_fetch_all(a0));
+  else if (count == 2) return (x_mysql_fetch_all(a0, a1));
+  else return (x_mysql_fetch_all(a0, a1, a2));
+}
+Variant ei_thrift_protocol_write_compact(Eval::VariableEnvironment &env, const Eval::FunctionCallExpression *caller) {
+  Variant a0;
+  Variant a1;
+  Variant a2;
+  Variant a3;
+  Variant a4;
+  const std::vector<Eval::ExpressionPtr> &params = caller->params();
+  int count __attribute__((__unused__)) = params.size();
+  if (count != 5) return throw_wrong_arguments("thrift_protocol_write_compact", count, 5, 5, 1);
+  std::vector<Eval::ExpressionPtr>::const_iterator it = params.begin();
+  do {
+    if (it == params.end()) break;
+    a0 = (*it)->eval(env);
+    it++;
+    if (it == params.end()) break;
+    a1 = (*it)->eval(env);
+    it++;
+    if (it == params.end()) break;
+    a2 = (*it)->eval(env);
+    it++;
+    if (it == params.end()) break;
+    a3 = (*it)->eval(env);
+    it++;
+    if (it == params.end()) break;
+    a4 = (*it)->eval(env);
+    it++;
+  } while(false);
+  for (; it != params.end(); ++it) {
+    (*it)->eval(env);
+  }
+  return (x_thrift_protocol_write_compact(a0, a1, a2, a3, a4), null);
+}
+Variant ei_thrift_protocol_read_compact(Eval::VariableEnvironment &env, const Eval::FunctionCallExpression *caller) {
+  Variant a0;
+  Variant a1;
+  const std::vector<Eval::ExpressionPtr> &params = caller->params();
+  int count __attribute__((__unused__)) = params.size();
+  if (count != 2) return throw_wrong_arguments("thrift_protocol_read_compact", count, 2, 2, 1);
+  std::vector<Eval::ExpressionPtr>::const_iterator it = params.begin();
+  do {
+    if (it == params.end()) break;
+    a0 = (*it)->eval(env);
+    it++;
+    if (it == params.end()) break;
+    a1 = (*it)->eval(env);
+    it++;
+  } while(false);
+  for (; it != params.end(); ++it) {
+    (*it)->eval(env);
+  }
+  return (x_thrift_protocol_read_compact(a0, a1));
+}
 Variant Eval::invoke_from_eval_builtin(const char *s, Eval::VariableEnvironment &env, const Eval::FunctionCallExpression *caller, int64 hash, bool fatal) {
   if (hash < 0) hash = hash_string(s);
   switch (hash & 4095) {
@@ -72025,6 +72268,9 @@ Variant Eval::invoke_from_eval_builtin(const char *s, Eval::VariableEnvironment
     case 698:
       HASH_INVOKE_FROM_EVAL(0x4A3D2113D3DFD2BALL, newpixelwandarray);
       break;
+    case 699:
+      HASH_INVOKE_FROM_EVAL(0x083291F5D08082BBLL, memcache_get_multi);
+      break;
     case 700:
       HASH_INVOKE_FROM_EVAL(0x33E08846F3EB42BCLL, ldap_get_values);
       HASH_INVOKE_FROM_EVAL(0x41F7E2214DDE12BCLL, mcrypt_enc_self_test);
@@ -73291,6 +73537,7 @@ Variant Eval::invoke_from_eval_builtin(const char *s, Eval::VariableEnvironment
       HASH_INVOKE_FROM_EVAL(0x798B4197212456B5LL, bcpowmod);
       HASH_INVOKE_FROM_EVAL(0x623CE67C41A9E6B5LL, ldap_next_attribute);
       HASH_INVOKE_FROM_EVAL(0x7E773A36449576B5LL, imagecharup);
+      HASH_INVOKE_FROM_EVAL(0x3B81B5A6BE3ED6B5LL, thrift_protocol_write_compact);
       break;
     case 1719:
       HASH_INVOKE_FROM_EVAL(0x0C44E5EEB9C646B7LL, memcache_connect);
@@ -73614,6 +73861,9 @@ Variant Eval::invoke_from_eval_builtin(const char *s, Eval::VariableEnvironment
     case 1967:
       HASH_INVOKE_FROM_EVAL(0x16CB9891EF26D7AFLL, drawgetstrokedashoffset);
       break;
+    case 1973:
+      HASH_INVOKE_FROM_EVAL(0x4AE7BD155D5B27B5LL, pagelet_server_task_start_multi);
+      break;
     case 1977:
       HASH_INVOKE_FROM_EVAL(0x1FC9406FD7FCD7B9LL, strrpos);
       HASH_INVOKE_FROM_EVAL(0x1B6467AD87E167B9LL, log1p);
@@ -74863,6 +75113,9 @@ Variant Eval::invoke_from_eval_builtin(const char *s, Eval::VariableEnvironment
     case 2958:
       HASH_INVOKE_FROM_EVAL(0x62A4D7A03F7C3B8ELL, ceil);
       break;
+    case 2961:
+      HASH_INVOKE_FROM_EVAL(0x0538D73928468B91LL, mysql_fetch_all);
+      break;
     case 2967:
       HASH_INVOKE_FROM_EVAL(0x09837A82A928AB97LL, is_null);
       break;
@@ -76154,6 +76407,9 @@ Variant Eval::invoke_from_eval_builtin(const char *s, Eval::VariableEnvironment
     case 3943:
       HASH_INVOKE_FROM_EVAL(0x319407AC92912F67LL, ereg);
       break;
+    case 3944:
+      HASH_INVOKE_FROM_EVAL(0x4E6C2C8AE7845F68LL, pagelet_server_task_wait);
+      break;
     case 3946:
       HASH_INVOKE_FROM_EVAL(0x1670096FDE27AF6ALL, rewind);
       break;
@@ -76325,6 +76581,9 @@ Variant Eval::invoke_from_eval_builtin(const char *s, Eval::VariableEnvironment
       HASH_INVOKE_FROM_EVAL(0x7F5FC3CAF8CE9FDELL, gzcompress);
       HASH_INVOKE_FROM_EVAL(0x72925D2DF7E61FDELL, drawpathcurvetoquadraticbeziersmoothrelative);
       break;
+    case 4069:
+      HASH_INVOKE_FROM_EVAL(0x43BA2CB702E68FE5LL, thrift_protocol_read_compact);
+      break;
     case 4071:
       HASH_INVOKE_FROM_EVAL(0x217067889854CFE7LL, xmlwriter_start_dtd);
       break;
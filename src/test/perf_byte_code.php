@@ -0,0 +1,98 @@
+<?php
+
+// Benchmarks for hphpi's bytecode interpreter. Each one prints its name, a
+// result to compare between runs, and how long it took in ms.
+
+function timing_get_cpu_time() {
+  $rusage = getrusage();
+  return ($rusage['ru_utime.tv_sec']*1000*1000 +
+          $rusage['ru_utime.tv_usec'] +
+          $rusage['ru_stime.tv_sec']*1000*1000 +
+          $rusage['ru_stime.tv_usec']);
+}
+
+function bench_loop($n) {
+  for ($i = 0; $i < $n; $i++) {}
+  return $i;
+}
+
+function bench_arith($n) {
+  $sum = 0;
+  for ($i = 0; $i < $n; $i++) {
+    $sum += $i * 3 - ($i % 7);
+    if ($sum > 1000000) $sum -= 1000000;
+  }
+  return $sum;
+}
+
+function bench_double($n) {
+  $x = 0.5;
+  $i = 0;
+  while ($i++ < $n) {
+    $x = $x * 1.000001 + 0.25 / ($i + 1);
+  }
+  return (int)$x;
+}
+
+function bench_branches($n) {
+  $a = 0; $b = 0; $c = 0;
+  for ($i = 0; $i < $n; ++$i) {
+    if ($i % 3 == 0 && $i % 5 == 0) {
+      $a++;
+    } else if ($i % 3 == 0 || $i % 5 == 0) {
+      $b++;
+    } else {
+      $c = $c ? $c - 1 : $i;
+    }
+  }
+  return "$a/$b/$c";
+}
+
+function bench_nested($n) {
+  $count = 0;
+  for ($i = 0; $i < $n / 100; $i++) {
+    for ($j = 0; $j < 100; $j++) {
+      if ($j == $i) continue;
+      if ($j > 90) break;
+      $count++;
+    }
+  }
+  return $count;
+}
+
+function bench_concat($n) {
+  $s = '';
+  for ($i = 0; $i < $n; $i++) {
+    $s .= 'x';
+    if ($i % 1000 == 0) $s = (string)$i;
+  }
+  return strlen($s);
+}
+
+function fib($n) {
+  return $n < 2 ? $n : fib($n - 1) + fib($n - 2);
+}
+
+function bench_calls($n) {
+  return fib(20);
+}
+
+function bench_fallback($n) {
+  $a = array();
+  for ($i = 0; $i < $n / 10; $i++) {
+    $a[$i % 100] = $i;
+    foreach ($a as $k => $v) {
+      if ($k > 2) break;
+    }
+  }
+  return count($a);
+}
+
+$n = 1000000;
+foreach (array('loop', 'arith', 'double', 'branches', 'nested', 'concat',
+               'calls', 'fallback') as $name) {
+  $start = timing_get_cpu_time();
+  $ret = call_user_func('bench_'.$name, $n);
+  $end = timing_get_cpu_time();
+  echo $name, ' ', $ret, ' ', (int)(($end - $start) / 1000), "\n";
+}
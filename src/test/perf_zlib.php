@@ -0,0 +1,41 @@
+<?php
+
+// Benchmarks gzencode(), gzcompress() and gzdeflate() on inputs from 1KB up
+// to 1GB, or to the size in bytes given as first argument. Run it with and
+// without Zlib.ParallelThreads to compare. Each line prints the function,
+// input size, output size and how long it took in ms.
+
+function timing_get_wall_time() {
+  list($usec, $sec) = explode(' ', microtime());
+  return ((int)$sec * 1000000 + (int)($usec * 1000000));
+}
+
+// somewhat compressible, unlike random bytes or one repeated string
+function make_input($size) {
+  $words = array('hiphop', 'php', 'zlib', 'deflate', 'block', 'thread',
+                 'request', 'server', 'buffer', 'string', "\n", '1234');
+  $chunk = '';
+  mt_srand(1);
+  while (strlen($chunk) < 65536) {
+    $chunk .= $words[mt_rand(0, count($words) - 1)].' ';
+  }
+  if ($size <= strlen($chunk)) {
+    return substr($chunk, 0, $size);
+  }
+  return substr(str_repeat($chunk, (int)($size / strlen($chunk)) + 1),
+                0, $size);
+}
+
+$max = isset($argv[1]) ? (int)$argv[1] : 1024 * 1024 * 1024;
+for ($size = 1024; $size <= $max; $size *= 4) {
+  $input = make_input($size);
+  foreach (array('gzencode', 'gzcompress', 'gzdeflate') as $func) {
+    $start = timing_get_wall_time();
+    $output = $func($input);
+    $end = timing_get_wall_time();
+    echo $func, ' ', $size, ' ', strlen($output), ' ',
+      (int)(($end - $start) / 1000), "\n";
+    unset($output);
+  }
+  unset($input);
+}
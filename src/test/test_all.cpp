@@ -39,6 +39,13 @@ void Test::RunTestsImpl(bool &allPassed, std::string &suite,
     RUN_TESTSUITE(TestCodeRun);
     return;
   }
+  if (suite == "TestCodeRunByteCode") {
+    suite = "TestCodeRun";
+    Option::EnableEval = Option::FullEval;
+    TestCodeRun::ByteCodeMode = true;
+    RUN_TESTSUITE(TestCodeRun);
+    return;
+  }
   if (suite == "TestServer") {
     RUN_TESTSUITE(TestServer);
     return;
@@ -32,6 +32,9 @@ using namespace std;
 // By default, use shared linking for faster testing.
 bool TestCodeRun::FastMode = true;
 
+// Whether hphpi runs functions with its bytecode interpreter.
+bool TestCodeRun::ByteCodeMode = false;
+
 TestCodeRun::TestCodeRun() : m_perfMode(false) {
   Option::GenerateCPPMain = true;
   Option::GenerateCPPMetaInfo = true;
@@ -246,6 +249,8 @@ static bool verify_result(const char *input, const char *output, bool perfMode,
       const char *argv[] = {"", filearg.c_str(),
                             "--config=test/config.hdf",
                             "-v Fiber.ThreadCount = 0",
+                            TestCodeRun::ByteCodeMode ?
+                            "-v Eval.BytecodeInterpreter = true" : NULL,
                             NULL};
       Process::Exec("hphpi/hphpi", argv, NULL, actual, &err);
     }
@@ -421,6 +426,7 @@ bool TestCodeRun::RunTests(const std::string &which) {
   RUN_TEST(TestRenameFunction);
   //RUN_TEST(TestIntercept); // requires ENABLE_INTERCEPT
   RUN_TEST(TestDynamicMethods);
+  RUN_TEST(TestPerfectHashJumpTable);
   RUN_TEST(TestVolatile);
   RUN_TEST(TestHereDoc);
   RUN_TEST(TestProgramFunctions);
@@ -3564,6 +3570,61 @@ bool TestCodeRun::TestObjectProperty() {
        "var_dump(isset($x->pub_var));"
        "var_dump(empty($x->pub_var));");
 
+  MVCR("<?php\n"
+       "class A {\n"
+       "  private $p = 'A::p';\n"
+       "  protected $q = 'A::q';\n"
+       "  public $r;\n"
+       "  function getA() { return array($this->p, $this->q, $this->r); }\n"
+       "  function setA($v) { $this->p = $v; $this->q = $v; }\n"
+       "}\n"
+       "class B extends A {\n"
+       "  private $p = 'B::p';\n"
+       "  public $q = 'B::q';\n"
+       "  public $s = 's';\n"
+       "  function getB() { return array($this->p, $this->q, $this->r); }\n"
+       "}\n"
+       "$b = new B;\n"
+       "for ($i = 0; $i < 3; $i++) {\n"
+       "  var_dump($b->getA(), $b->getB());\n"
+       "}\n"
+       "$b->setA('x');\n"
+       "$b->r = 'r';\n"
+       "$b->dyn = 'dyn';\n"
+       "var_dump($b, $b->getA(), $b->getB());\n"
+       "unset($b->s);\n"
+       "$c = clone $b;\n"
+       "$c->s = 'back';\n"
+       "var_dump($c, $c->getA());\n"
+       "var_dump(unserialize(serialize($b)));\n"
+       "var_dump((array)new A);\n");
+
+  // cycles outlive the request, with slots of a few size classes
+  MVCR("<?php\n"
+       "class Node {\n"
+       "  public $next;\n"
+       "  public $name;\n"
+       "  function __construct($name) { $this->name = $name; }\n"
+       "}\n"
+       "class BigNode extends Node {\n"
+       "  public $a = 1, $b = 2, $c = 3, $d = 4, $e = 5, $f = 6, $g = 7;\n"
+       "  private $h = 8;\n"
+       "  function sum() {\n"
+       "    return $this->a + $this->b + $this->c + $this->d + $this->e +\n"
+       "      $this->f + $this->g + $this->h;\n"
+       "  }\n"
+       "}\n"
+       "for ($i = 0; $i < 1000; $i++) {\n"
+       "  $x = new Node('x' . $i);\n"
+       "  $y = new BigNode('y' . $i);\n"
+       "  $x->next = $y;\n"
+       "  $y->next = $x;\n"
+       "}\n"
+       "var_dump($x->next->next->name, $y->next->next->sum());\n"
+       "$z = new BigNode('z');\n"
+       "$z->next = $z;\n"
+       "var_dump($z->next->next->name, $z->next->sum());\n");
+
   return true;
 }
 
@@ -10577,6 +10638,68 @@ bool TestCodeRun::TestThrift() {
       "  var_dump(thrift_protocol_read_binary($p, 'TestStruct', true));"
       "}"
       "test();");
+
+  MVCRO("<?php "
+        "class DummyProtocol {"
+        "  public $t;"
+        "  function __construct() {"
+        "    $this->t = new DummyTransport();"
+        "  }"
+        "  function getTransport() {"
+        "    return $this->t;"
+        "  }"
+        "}"
+        "class DummyTransport {"
+        "  public $buff = '';"
+        "  public $pos = 0;"
+        "  function flush() { }"
+        "  function write($buff) {"
+        "    $this->buff .= $buff;"
+        "  }"
+        "  function read($n) {"
+        "    $r = substr($this->buff, $this->pos, $n);"
+        "    $this->pos += $n;"
+        "    return $r;"
+        "  }"
+        "}"
+        "class CompactStruct {"
+        "  static $_TSPEC = array("
+        "    1 => array('var' => 'anInt', 'type' => 8),"
+        "    2 => array('var' => 'aBool', 'type' => 2),"
+        "    3 => array('var' => 'aString', 'type' => 11),"
+        "    4 => array('var' => 'aList', 'type' => 15, 'etype' => 10,"
+        "               'elem' => array('type' => 10)),"
+        "    20 => array('var' => 'aDouble', 'type' => 4));"
+        "  public $anInt = null;"
+        "  public $aBool = null;"
+        "  public $aString = null;"
+        "  public $aList = null;"
+        "  public $aDouble = null;"
+        "}"
+        "$p = new DummyProtocol();"
+        "$v = new CompactStruct();"
+        "$v->anInt = 1234;"
+        "$v->aBool = true;"
+        "$v->aString = 'abc';"
+        "$v->aList = array(-1, 300);"
+        "$v->aDouble = 1.5;"
+        "thrift_protocol_write_compact($p, 'foomethod', 1, $v, 20);"
+        "var_dump(bin2hex($p->getTransport()->buff));"
+        "$v = thrift_protocol_read_compact($p, 'CompactStruct');"
+        "var_dump($v->anInt, $v->aBool, $v->aString, $v->aList, $v->aDouble);",
+
+        "string(76) \"82211409666f6f6d6574686f6415a413111803616263192601d804"
+        "0728000000000000f83f00\"\n"
+        "int(1234)\n"
+        "bool(true)\n"
+        "string(3) \"abc\"\n"
+        "array(2) {\n"
+        "  [0]=>\n"
+        "  int(-1)\n"
+        "  [1]=>\n"
+        "  int(300)\n"
+        "}\n"
+        "float(1.5)\n");
   return true;
 }
 
@@ -13901,6 +14024,50 @@ bool TestCodeRun::TestAPC() {
   return true;
 }
 
+bool TestCodeRun::TestPerfectHashJumpTable() {
+  const char *code =
+    "<?php "
+    "class A { "
+    "  public $a = 'a'; protected $b = 'b'; private $c = 'c'; "
+    "  public $shadow = 'A'; public $n = 1; "
+    "  function one() { return 1;} function two() { return 2;} "
+    "  function three() { return 3;} function four() { return 4;} "
+    "  function getC() { $p = 'c'; return $this->$p;} "
+    "} "
+    "class B extends A { "
+    "  public $d = 'd'; public $shadow = 'B'; "
+    "  function five() { return 5;} function two() { return 22;} "
+    "  function getB() { $p = 'b'; return $this->$p;} "
+    "} "
+    "class C extends B { "
+    "  public $e = 'e'; private $c = 'C'; "
+    "  function six() { return 6;} function one() { return 11;} "
+    "  function getMine() { $p = 'c'; return $this->$p;} "
+    "} "
+    "$obj = new C(); "
+    "foreach (array('one', 'two', 'three', 'four', 'five', 'six') as $m) { "
+    "  var_dump($obj->$m()); "
+    "  var_dump(call_user_func(array($obj, $m))); "
+    "} "
+    "foreach (array('a', 'd', 'e', 'shadow', 'n', 'nope') as $p) { "
+    "  var_dump(isset($obj->$p)); "
+    "  var_dump(@$obj->$p); "
+    "} "
+    "$p = 'n'; $obj->$p += 10; $obj->$p++; var_dump($obj->n); "
+    "$p = 'a'; $r = &$obj->$p; $r = 'changed'; var_dump($obj->a); "
+    "$p = 'dyn'; $obj->$p = 'new'; var_dump($obj->dyn); "
+    "var_dump($obj->getB(), $obj->getC(), $obj->getMine()); "
+    "var_dump($obj);";
+
+  MVCR(code);
+
+  bool save = Option::PerfectHashJumpTable;
+  Option::PerfectHashJumpTable = true;
+  MVCR(code);
+  Option::PerfectHashJumpTable = save;
+  return true;
+}
+
 bool TestCodeRun::TestInlining() {
   bool save = Option::AutoInline;
   Option::AutoInline = true;
@@ -101,6 +101,7 @@ class TestCodeRun : public TestBase {
   bool TestDynamicProperties();
   bool TestDynamicFunctions();
   bool TestDynamicMethods();
+  bool TestPerfectHashJumpTable();
   bool TestVolatile();
   bool TestSuperGlobals();
   bool TestGlobalStatement();
@@ -181,6 +182,7 @@ class TestCodeRun : public TestBase {
   bool TestAdHoc();
 
   static bool FastMode;
+  static bool ByteCodeMode;
 
  protected:
   bool CleanUp();
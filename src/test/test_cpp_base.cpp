@@ -214,6 +214,32 @@ bool TestCppBase::TestString() {
     VS((const char *)s, "tez q");
   }
 
+  // interning
+  {
+    VERIFY(StaticString::Lookup("", 0) == empty_string.get());
+    VERIFY(StaticString::Lookup("no such literal", 15) == NULL);
+    String s = StaticString::Intern("", 0);
+    VERIFY(s.get() == empty_string.get());
+    s = StaticString::Intern("no such literal", 15);
+    VERIFY(!s->isStatic());
+    VS((const char *)s, "no such literal");
+  }
+
+  // cached hash codes
+  {
+    String s = "ab";
+    s += "c";
+    VERIFY(s->hash() == hash_string("abc", 3));
+    s.lvalAt(0) = "1";
+    VERIFY(s->hash() == hash_string("1bc", 3));
+    s.lvalAt(1) = "2";
+    s.lvalAt(2) = "3";
+    VERIFY(s->hash() == hash_string("123", 3));
+    Array arr;
+    arr.set(s, 1);
+    VERIFY(arr.exists(123));
+  }
+
   return Count(true);
 }
 
@@ -879,13 +905,17 @@ bool TestCppBase::TestMemoryManager() {
   // we do it twice, so to verify MemoryManager's rollback() is valid
   // we do it 3rd time, so to verify LinearAllocator works under rollback.
   // we do it 4th time, so to verify MySQL connection works under rollback.
+  // odd rounds free swept memory on the background reclaim thread.
   for (int i = 0; i < 4; i++) {
+    RuntimeOption::BackgroundReclaim = (i % 2 == 1);
+    int64 reclaimed = MemoryManager::DrainReclaimed();
 
     // Circular reference between two arrays. Without sweeping, these memory
     // will still be reachable after exit.
     {
       Variant arr = Array::Create();
       arr.append(arr);
+      arr.append(String("malloc") + "ed"); // freed by StringData::sweep()
     }
     {
       Variant arr = Array::Create();
@@ -945,7 +975,13 @@ bool TestCppBase::TestMemoryManager() {
     VS(globals->m_array["a"], "apple");
     VERIFY(!globals->m_array.exists("c"));
 
+    if (RuntimeOption::BackgroundReclaim) {
+      VERIFY(MemoryManager::DrainReclaimed() > reclaimed);
+    } else {
+      VS(MemoryManager::DrainReclaimed(), reclaimed);
+    }
   }
+  RuntimeOption::BackgroundReclaim = false;
   DELETE(TestGlobals)(globals);
   MemoryManager::TheMemoryManager().reset();
   return Count(true);
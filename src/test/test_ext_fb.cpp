@@ -16,6 +16,10 @@
 
 #include <test/test_ext_fb.h>
 #include <runtime/ext/ext_fb.h>
+#include <runtime/eval/runtime/code_coverage.h>
+#include <runtime/base/program_functions.h>
+#include <runtime/base/runtime_option.h>
+#include <util/async_func.h>
 
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -32,6 +36,7 @@ bool TestExtFb::RunTests(const std::string &which) {
   RUN_TEST(test_fb_load_local_databases);
   RUN_TEST(test_fb_parallel_query);
   RUN_TEST(test_fb_crossall_query);
+  RUN_TEST(test_fb_get_code_coverage);
 
   return ret;
 }
@@ -136,3 +141,51 @@ bool TestExtFb::test_fb_crossall_query() {
   // tested with PHP unit tests
   return Count(true);
 }
+
+/**
+ * One request on its own thread, hitting line i of a file (4 - i) times.
+ */
+class CoverageRequest {
+public:
+  void run() {
+    hphp_session_init();
+    ExecutionContext *context = hphp_context_init();
+    for (int i = 1; i <= 3; i++) {
+      Eval::CodeCoverage::Record("test_fb_get_code_coverage.php", 1, i);
+    }
+    hphp_context_exit(context, false);
+    hphp_session_exit();
+  }
+};
+
+bool TestExtFb::test_fb_get_code_coverage() {
+  bool recording = RuntimeOption::RecordCodeCoverage;
+  RuntimeOption::RecordCodeCoverage = true;
+
+  // each thread counts on its own, then adds to the totals at request end
+  const int count = 4;
+  CoverageRequest requests[count];
+  std::vector<AsyncFunc<CoverageRequest>*> threads;
+  for (int i = 0; i < count; i++) {
+    threads.push_back(new AsyncFunc<CoverageRequest>(&requests[i],
+                                                     &CoverageRequest::run));
+    threads.back()->start();
+  }
+  for (int i = 0; i < count; i++) {
+    threads[i]->waitForEnd();
+    delete threads[i];
+  }
+
+  // this request's counts are not flushed yet, but still reported
+  Eval::CodeCoverage::Record("test_fb_get_code_coverage.php", 2, 2);
+
+  Variant report = f_fb_get_code_coverage();
+  RuntimeOption::RecordCodeCoverage = recording;
+
+  Variant lines = report["test_fb_get_code_coverage.php"];
+  VS(lines[1], 3 * count);
+  VS(lines[2], 2 * count + 1);
+  VS(lines[3], count);
+  VERIFY(!lines.toArray().exists(4));
+  return Count(true);
+}
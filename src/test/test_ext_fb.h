@@ -37,6 +37,7 @@ class TestExtFb : public TestCppExt {
   bool test_fb_load_local_databases();
   bool test_fb_parallel_query();
   bool test_fb_crossall_query();
+  bool test_fb_get_code_coverage();
 };
 
 ///////////////////////////////////////////////////////////////////////////////
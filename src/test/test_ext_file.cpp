@@ -504,7 +504,31 @@ bool TestExtFile::test_parse_ini_string() {
 }
 
 bool TestExtFile::test_parse_hdf_file() {
-  // tested with test_parse_hdf_string()
+  f_unlink("test/test_ext_file.tmp");
+  f_file_put_contents("test/test_ext_file.tmp", "num = 12345\n");
+  VS(f_parse_hdf_file("test/test_ext_file.tmp"), CREATE_MAP1("num", 12345));
+  // served from the parsed file cache
+  VS(f_parse_hdf_file("test/test_ext_file.tmp"), CREATE_MAP1("num", 12345));
+
+  // a file moved over it has a new inode, so it's parsed again
+  f_file_put_contents("test/test_ext_file2.tmp", "num = 6789\n");
+  f_rename("test/test_ext_file2.tmp", "test/test_ext_file.tmp");
+  VS(f_parse_hdf_file("test/test_ext_file.tmp"), CREATE_MAP1("num", 6789));
+
+  // rewritten in place within the same second: only its size tells
+  f_file_put_contents("test/test_ext_file.tmp", "num = 67890\n");
+  VS(f_parse_hdf_file("test/test_ext_file.tmp"), CREATE_MAP1("num", 67890));
+
+  // with a full cache, new files evict old ones and are still parsed right
+  int size = RuntimeOption::ParsedFileCacheSize;
+  RuntimeOption::ParsedFileCacheSize = 1;
+  f_file_put_contents("test/test_ext_file2.tmp", "num = 1\n");
+  VS(f_parse_hdf_file("test/test_ext_file2.tmp"), CREATE_MAP1("num", 1));
+  VS(f_parse_hdf_file("test/test_ext_file.tmp"), CREATE_MAP1("num", 67890));
+  VS(f_parse_hdf_file("test/test_ext_file2.tmp"), CREATE_MAP1("num", 1));
+  RuntimeOption::ParsedFileCacheSize = size;
+  f_unlink("test/test_ext_file2.tmp");
+  f_unlink("test/test_ext_file.tmp");
   return Count(true);
 }
 
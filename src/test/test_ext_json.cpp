@@ -19,6 +19,8 @@
 
 ///////////////////////////////////////////////////////////////////////////////
 
+static StaticString s_json_key("json_key");
+
 bool TestExtJson::RunTests(const std::string &which) {
   bool ret = true;
 
@@ -60,6 +62,16 @@ bool TestExtJson::test_json_decode() {
   VS(f_json_decode("[\"a\",1,true,false,null]", true),
      CREATE_VECTOR5("a", 1, true, false, null));
 
+  // keys equal to a static string share it, others are new strings
+  {
+    Array arr = f_json_decode("{\"json_key\":1,\"not_a_literal\":2}", true);
+    ArrayIter iter(arr);
+    VERIFY(iter.first().toString().get() == s_json_key.get());
+    ++iter;
+    VS(iter.first(), "not_a_literal");
+    VERIFY(!iter.first().toString()->isStatic());
+  }
+
   Object obj = f_json_decode("{\"a\":1,\"b\":2.3,\"3\":\"test\"}");
   Object obj2((NEW(c_stdClass)())->create());
   obj2->o_set("a", 1);
@@ -29,6 +29,7 @@ bool TestExtMemcache::RunTests(const std::string &which) {
   RUN_TEST(test_memcache_set);
   RUN_TEST(test_memcache_replace);
   RUN_TEST(test_memcache_get);
+  RUN_TEST(test_memcache_get_multi);
   RUN_TEST(test_memcache_delete);
   RUN_TEST(test_memcache_increment);
   RUN_TEST(test_memcache_decrement);
@@ -73,6 +74,10 @@ bool TestExtMemcache::test_memcache_get() {
   return Count(true);
 }
 
+bool TestExtMemcache::test_memcache_get_multi() {
+  return Count(true);
+}
+
 bool TestExtMemcache::test_memcache_delete() {
   return Count(true);
 }
@@ -21,6 +21,9 @@
 
 ///////////////////////////////////////////////////////////////////////////////
 
+static StaticString s_id("id");
+static StaticString s_name("name");
+
 bool TestExtMysql::RunTests(const std::string &which) {
   bool ret = true;
   RuntimeOption::MySQLReadOnly = false;
@@ -64,6 +67,7 @@ bool TestExtMysql::RunTests(const std::string &which) {
   RUN_TEST(test_mysql_fetch_row);
   RUN_TEST(test_mysql_fetch_assoc);
   RUN_TEST(test_mysql_fetch_array);
+  RUN_TEST(test_mysql_fetch_all);
   RUN_TEST(test_mysql_fetch_lengths);
   RUN_TEST(test_mysql_fetch_object);
   RUN_TEST(test_mysql_result);
@@ -439,6 +443,19 @@ bool TestExtMysql::test_mysql_fetch_assoc() {
      "    [id] => 1\n"
      "    [name] => test\n"
      ")\n");
+
+  // column names are the static strings they are equal to
+  ArrayIter iter(row.toArray());
+  VERIFY(iter.first().toString().get() == s_id.get());
+  ++iter;
+  VERIFY(iter.first().toString().get() == s_name.get());
+
+  res = f_mysql_unbuffered_query("select * from test");
+  row = f_mysql_fetch_assoc(res);
+  ArrayIter iter2(row.toArray());
+  VERIFY(iter2.first().toString().get() == s_id.get());
+  ++iter2;
+  VERIFY(iter2.first().toString().get() == s_name.get());
   return Count(true);
 }
 
@@ -460,6 +477,97 @@ bool TestExtMysql::test_mysql_fetch_array() {
   return Count(true);
 }
 
+bool TestExtMysql::test_mysql_fetch_all() {
+  Variant conn = f_mysql_connect(TEST_HOSTNAME, TEST_USERNAME, TEST_PASSWORD);
+  VERIFY(CreateTestTable());
+  VS(f_mysql_query("insert into test (name) values ('test'),('test2')"), true);
+
+  Variant res = f_mysql_query("select * from test");
+  Variant rows = f_mysql_fetch_all(res);
+  VS(f_print_r(rows, true),
+     "Array\n"
+     "(\n"
+     "    [0] => Array\n"
+     "        (\n"
+     "            [id] => 1\n"
+     "            [name] => test\n"
+     "        )\n"
+     "\n"
+     "    [1] => Array\n"
+     "        (\n"
+     "            [id] => 2\n"
+     "            [name] => test2\n"
+     "        )\n"
+     "\n"
+     ")\n");
+  VS(f_mysql_fetch_assoc(res), false);
+
+  // unbuffered results have their values copied into the string arena
+  res = f_mysql_unbuffered_query("select * from test");
+  rows = f_mysql_fetch_all(res, 2);
+  VS(f_print_r(rows, true),
+     "Array\n"
+     "(\n"
+     "    [0] => Array\n"
+     "        (\n"
+     "            [0] => 1\n"
+     "            [1] => test\n"
+     "        )\n"
+     "\n"
+     "    [1] => Array\n"
+     "        (\n"
+     "            [0] => 2\n"
+     "            [1] => test2\n"
+     "        )\n"
+     "\n"
+     ")\n");
+
+  res = f_mysql_unbuffered_query("select * from test");
+  rows = f_mysql_fetch_all(res, 1, true);
+  VS(f_print_r(rows, true),
+     "Array\n"
+     "(\n"
+     "    [id] => Array\n"
+     "        (\n"
+     "            [0] => 1\n"
+     "            [1] => 2\n"
+     "        )\n"
+     "\n"
+     "    [name] => Array\n"
+     "        (\n"
+     "            [0] => test\n"
+     "            [1] => test2\n"
+     "        )\n"
+     "\n"
+     ")\n");
+
+  res = f_mysql_query("select name from test");
+  rows = f_mysql_fetch_all(res, 3, true);
+  VS(f_print_r(rows, true),
+     "Array\n"
+     "(\n"
+     "    [0] => Array\n"
+     "        (\n"
+     "            [0] => test\n"
+     "            [1] => test2\n"
+     "        )\n"
+     "\n"
+     "    [name] => Array\n"
+     "        (\n"
+     "            [0] => test\n"
+     "            [1] => test2\n"
+     "        )\n"
+     "\n"
+     ")\n");
+
+  res = f_mysql_query("select * from test where id > 2");
+  VS(f_mysql_fetch_all(res), Array::Create());
+  res = f_mysql_query("select * from test where id > 2");
+  VS(f_mysql_fetch_all(res, 1, true), CREATE_MAP2("id", Array::Create(),
+                                                  "name", Array::Create()));
+  return Count(true);
+}
+
 bool TestExtMysql::test_mysql_fetch_lengths() {
   Variant conn = f_mysql_connect(TEST_HOSTNAME, TEST_USERNAME, TEST_PASSWORD);
   VERIFY(CreateTestTable());
@@ -66,6 +66,7 @@ class TestExtMysql : public TestCppExt {
   bool test_mysql_fetch_row();
   bool test_mysql_fetch_assoc();
   bool test_mysql_fetch_array();
+  bool test_mysql_fetch_all();
   bool test_mysql_fetch_lengths();
   bool test_mysql_fetch_object();
   bool test_mysql_result();
@@ -111,6 +111,20 @@ bool TestExtOutput::test_ob_get_clean() {
   VS(f_ob_get_clean(), "test");
   VS(f_ob_get_clean(), "");
   VS(f_ob_get_clean(), "");
+
+  // spanning several chunks, and moved from one level to another
+  f_ob_start();
+  g_context->write("begin");
+  f_ob_start();
+  for (int i = 0; i < 10000; i++) {
+    g_context->write("0123456789");
+  }
+  f_ob_end_flush();
+  g_context->write("end");
+  String s = f_ob_get_clean();
+  VS(s.size(), 100008);
+  VS(s.substr(0, 10), "begin01234");
+  VS(s.substr(99995), "56789end");
   return Count(true);
 }
 
@@ -34,7 +34,9 @@ bool TestExtServer::RunTests(const std::string &which) {
   RUN_TEST(test_dangling_server_proxy_old_request);
   RUN_TEST(test_dangling_server_proxy_new_request);
   RUN_TEST(test_pagelet_server_task_start);
+  RUN_TEST(test_pagelet_server_task_start_multi);
   RUN_TEST(test_pagelet_server_task_status);
+  RUN_TEST(test_pagelet_server_task_wait);
   RUN_TEST(test_pagelet_server_task_result);
   RUN_TEST(test_xbox_send_message);
   RUN_TEST(test_xbox_post_message);
@@ -63,11 +65,70 @@ bool TestExtServer::test_pagelet_server_task_start() {
   return Count(true);
 }
 
+bool TestExtServer::test_pagelet_server_task_start_multi() {
+  const int TEST_SIZE = 20;
+
+  String baseurl("pageletserver?getparam=");
+  String basepost("postparam=");
+
+  Array urls, posts;
+  for (int i = 0; i < TEST_SIZE; ++i) {
+    urls.set(i * 2, baseurl + String(i));
+    if (i % 2 == 0) {
+      posts.set(i * 2, basepost + String(i));
+    }
+  }
+  Array tasks = f_pagelet_server_task_start_multi
+    (urls, CREATE_VECTOR1("MyHeader: multi"), posts);
+  VS(tasks.size(), TEST_SIZE);
+
+  for (int i = 0; i < TEST_SIZE; ++i)  {
+    String expected = "pagelet postparam: ";
+    if (i % 2 == 0) {
+      expected += basepost + String(i);
+    }
+    expected += "pagelet getparam: ";
+    expected += String(i);
+    expected += "pagelet header: multi";
+
+    Variant code, headers;
+    VS(expected, f_pagelet_server_task_result(tasks[i * 2], ref(headers),
+                                              ref(code)));
+    VS(code, 200);
+  }
+
+  return Count(true);
+}
+
 bool TestExtServer::test_pagelet_server_task_status() {
   // tested in test_pagelet_server_task_result()
   return Count(true);
 }
 
+bool TestExtServer::test_pagelet_server_task_wait() {
+  const int TEST_SIZE = 10;
+
+  Array urls;
+  for (int i = 0; i < TEST_SIZE; ++i) {
+    urls.set(String("task") + String(i),
+             String("pageletserver?getparam=") + String(i));
+  }
+  Array tasks = f_pagelet_server_task_start_multi(urls);
+
+  std::set<std::string> finished;
+  while (!tasks.empty()) {
+    Variant key = f_pagelet_server_task_wait(tasks);
+    VERIFY(key.isString());
+    VERIFY(f_pagelet_server_task_status(tasks[key]));
+    finished.insert(key.toString().data());
+    tasks.remove(key);
+  }
+  VS((int)finished.size(), TEST_SIZE);
+
+  VS(f_pagelet_server_task_wait(Array::Create(), 0), false);
+  return Count(true);
+}
+
 bool TestExtServer::test_pagelet_server_task_result() {
   const int TEST_SIZE = 20;
 
@@ -30,7 +30,9 @@ class TestExtServer : public TestCppExt {
   bool test_dangling_server_proxy_old_request();
   bool test_dangling_server_proxy_new_request();
   bool test_pagelet_server_task_start();
+  bool test_pagelet_server_task_start_multi();
   bool test_pagelet_server_task_status();
+  bool test_pagelet_server_task_wait();
   bool test_pagelet_server_task_result();
   bool test_xbox_send_message();
   bool test_xbox_post_message();
@@ -16,6 +16,8 @@
 
 #include <test/test_ext_session.h>
 #include <runtime/ext/ext_session.h>
+#include <runtime/ext/ext_options.h>
+#include <runtime/base/shared/shared_store.h>
 
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -71,6 +73,77 @@ bool TestExtSession::test_session_name() {
 }
 
 bool TestExtSession::test_session_module_name() {
+  VS(f_session_module_name("memory"), "files");
+
+  // the memory module keeps array(time written, data) in the APC store
+  SharedStore &store = s_apc_store[SHARED_STORE_SESSION_CACHE];
+  String key("memtest:id1");
+  Variant entry;
+  f_session_save_path("memtest");
+  f_session_id("id1");
+  f_session_start();
+  VS(f_session_encode(), "");
+  f_session_decode("a|i:1;");
+  f_session_write_close();
+  VERIFY(store.get(key, entry));
+  VS(entry[1], "a|i:1;");
+  int64 now = entry[0].toInt64();
+
+  f_session_id("id1");
+  f_session_start();
+  VS(f_session_encode(), "a|i:1;");
+  f_session_write_close();
+
+  // with lazy_write, unchanged data isn't written again while it's fresh
+  store.store(key, CREATE_VECTOR2(now - 10, "a|i:1;"), 3600);
+  f_session_id("id1");
+  f_session_start();
+  f_session_write_close();
+  VERIFY(store.get(key, entry));
+  VS(entry[0], now - 10);
+
+  // but it is once it's older than half its TTL, so it doesn't expire
+  int64 ttl = f_ini_get("session.gc_maxlifetime").toInt64() * 3 / 2;
+  store.store(key, CREATE_VECTOR2(now - ttl / 2 - 1, "a|i:1;"), 3600);
+  f_session_id("id1");
+  f_session_start();
+  f_session_write_close();
+  VERIFY(store.get(key, entry));
+  VERIFY(entry[0].toInt64() >= now);
+
+  // and changed data is always written
+  store.store(key, CREATE_VECTOR2(now - 10, "a|i:1;"), 3600);
+  f_session_id("id1");
+  f_session_start();
+  f_session_decode("a|i:2;");
+  f_session_write_close();
+  VERIFY(store.get(key, entry));
+  VS(entry[1], "a|i:2;");
+  VERIFY(entry[0].toInt64() >= now);
+
+  // so is unchanged data without lazy_write
+  f_ini_set("session.lazy_write", "0");
+  store.store(key, CREATE_VECTOR2(now - 10, "a|i:2;"), 3600);
+  f_session_id("id1");
+  f_session_start();
+  f_session_write_close();
+  VERIFY(store.get(key, entry));
+  VERIFY(entry[0].toInt64() >= now);
+  f_ini_set("session.lazy_write", "1");
+
+  f_session_id("id1");
+  f_session_start();
+  VS(f_session_encode(), "a|i:2;");
+  f_session_destroy();
+  VERIFY(!store.get(key, entry));
+
+  f_session_id("id1");
+  f_session_start();
+  VS(f_session_encode(), "");
+  f_session_destroy();
+
+  f_session_save_path("");
+  VS(f_session_module_name("files"), "memory");
   return Count(true);
 }
 
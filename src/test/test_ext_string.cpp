@@ -133,6 +133,17 @@ bool TestExtString::test_stripcslashes() {
 
 bool TestExtString::test_addslashes() {
   VS(f_addslashes("'\"\\\n"), "\\'\\\"\\\\\n");
+
+  // special bytes around the 16-byte blocks the scanner works on
+  VS(f_addslashes("aaaaaaaaaaaaaa'"), "aaaaaaaaaaaaaa\\'");
+  VS(f_addslashes("aaaaaaaaaaaaaaa'"), "aaaaaaaaaaaaaaa\\'");
+  VS(f_addslashes("aaaaaaaaaaaaaaaa'"), "aaaaaaaaaaaaaaaa\\'");
+  VS(f_addslashes("'aaaaaaaaaaaaaaa\"a"), "\\'aaaaaaaaaaaaaaa\\\"a");
+  VS(f_addslashes("aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa\\"),
+     "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa\\\\");
+  VS(f_addslashes(String("aaaaaaaaaaaaaaa\0a", 17, AttachLiteral)),
+     "aaaaaaaaaaaaaaa\\0a");
+  VS(f_addslashes("aaaaaaaaaaaaaaaa"), "aaaaaaaaaaaaaaaa");
   return Count(true);
 }
 
@@ -452,6 +463,12 @@ bool TestExtString::test_htmlentities() {
   VS(f_htmlentities("\xc2\xA0", k_ENT_COMPAT, ""), "&nbsp;");
   VS(f_htmlentities("\xc2\xA0", k_ENT_COMPAT, "UTF-8"), "&nbsp;");
 
+  // a two byte UTF-8 sequence split across 16-byte blocks
+  VS(f_htmlentities("aaaaaaaaaaaaaaa\xc2\xA0", k_ENT_COMPAT, "UTF-8"),
+     "aaaaaaaaaaaaaaa&nbsp;");
+  VS(f_htmlentities("aaaaaaaaaaaaaaaa\xc2", k_ENT_COMPAT, "UTF-8"),
+     "aaaaaaaaaaaaaaaa\xc2");
+
   return Count(true);
 }
 
@@ -473,6 +490,21 @@ bool TestExtString::test_htmlspecialchars() {
   VS(f_bin2hex(f_htmlspecialchars("\xc2\xA0", k_ENT_COMPAT, "")), "c2a0");
   VS(f_bin2hex(f_htmlspecialchars("\xc2\xA0", k_ENT_COMPAT, "UTF-8")), "c2a0");
 
+  // escapable bytes around the 16-byte blocks the scanner works on
+  VS(f_htmlspecialchars("aaaaaaaaaaaaaa<"), "aaaaaaaaaaaaaa&lt;");
+  VS(f_htmlspecialchars("aaaaaaaaaaaaaaa<"), "aaaaaaaaaaaaaaa&lt;");
+  VS(f_htmlspecialchars("aaaaaaaaaaaaaaaa<"), "aaaaaaaaaaaaaaaa&lt;");
+  VS(f_htmlspecialchars("&aaaaaaaaaaaaaa>a"), "&amp;aaaaaaaaaaaaaa&gt;a");
+  VS(f_htmlspecialchars("aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa\"", k_ENT_QUOTES),
+     "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa&quot;");
+  VS(f_htmlspecialchars("aaaaaaaaaaaaaaa'", k_ENT_NOQUOTES),
+     "aaaaaaaaaaaaaaa'");
+  VS(f_htmlspecialchars("aaaaaaaaaaaaaaaa"), "aaaaaaaaaaaaaaaa");
+
+  // input stops at the first NUL, even past a block boundary
+  VS(f_htmlspecialchars(String("aaaaaaaaaaaaaaaaa\0<", 19, AttachLiteral)),
+     "aaaaaaaaaaaaaaaaa");
+
   return Count(true);
 }
 
@@ -525,6 +557,11 @@ bool TestExtString::test_sha1() {
 bool TestExtString::test_strtr() {
   Array trans = CREATE_MAP2("hello", "hi", "hi", "hello");
   VS(f_strtr("hi all, I said hello", trans), "hello all, I said hi");
+  // longest match wins, overlapping keys
+  trans = CREATE_MAP3("a", "1", "ab", "2", "abc", "3");
+  VS(f_strtr("abcabxa", trans), "32x1");
+  VS(f_strtr("xxabcabxa", trans), "xx32x1");
+  VS(f_strtr("abc", Array::Create()), "abc");
   return Count(true);
 }
 
@@ -19,6 +19,8 @@
 
 ///////////////////////////////////////////////////////////////////////////////
 
+static StaticString s_unserialize_key("unserialize_key");
+
 bool TestExtVariable::RunTests(const std::string &which) {
   bool ret = true;
 
@@ -348,6 +350,18 @@ bool TestExtVariable::test_unserialize() {
     Variant v2 = f_unserialize("a:3:{s:1:\"a\";s:5:\"apple\";s:1:\"b\";i:2;s:1:\"c\";a:3:{i:0;i:1;i:1;s:1:\"y\";i:2;i:3;}}");
     VS(v1, v2);
   }
+  {
+    // strings equal to a static string share it, values and keys alike
+    Variant v = f_unserialize("s:15:\"unserialize_key\";");
+    VERIFY(v.toString().get() == s_unserialize_key.get());
+    v = f_unserialize("a:2:{s:15:\"unserialize_key\";i:1;"
+                      "s:13:\"not_a_literal\";i:2;}");
+    ArrayIter iter(v.toArray());
+    VERIFY(iter.first().toString().get() == s_unserialize_key.get());
+    ++iter;
+    VS(iter.first(), "not_a_literal");
+    VERIFY(!iter.first().toString()->isStatic());
+  }
   return Count(true);
 }
 
@@ -18,6 +18,8 @@
 #include <runtime/ext/ext_zlib.h>
 #include <runtime/ext/ext_file.h>
 #include <runtime/ext/ext_output.h>
+#include <runtime/ext/ext_string.h>
+#include <util/compression.h>
 
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -67,6 +69,14 @@ bool TestExtZlib::test_gzfile() {
 
 bool TestExtZlib::test_gzcompress() {
   VS(f_gzuncompress(f_gzcompress("testing gzcompress")), "testing gzcompress");
+
+  // big enough to be cut into blocks and compressed on worker threads
+  set_parallel_deflate(2, 0);
+  String big = f_str_repeat("testing parallel gzcompress\n", 20000);
+  VS(f_gzuncompress(f_gzcompress(big)), big);
+  VS(f_gzinflate(f_gzdeflate(big, 9)), big);
+  VS(f_gzdecode(f_gzencode(big, 1)), big);
+  set_parallel_deflate(0, 0);
   return Count(true);
 }
 
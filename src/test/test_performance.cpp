@@ -16,6 +16,7 @@
 
 #include <test/test_performance.h>
 #include <util/util.h>
+#include <util/process.h>
 
 using namespace std;
 
@@ -49,8 +50,10 @@ bool TestPerformance::RunTests(const std::string &which) {
   bool ret = true;
   RUN_TEST(TestBasicOperations);
   RUN_TEST(TestMemoryUsage);
+  RUN_TEST(TestStringFunctions);
   RUN_TEST(TestAdHocFile);
   RUN_TEST(TestAdHoc);
+  RUN_TEST(TestByteCode);
   return ret;
 }
 
@@ -147,6 +150,48 @@ bool TestPerformance::TestMemoryUsage() {
   return true;
 }
 
+#define PERF_TEXT                                               \
+  "$s = str_repeat('The quick brown fox jumps over the lazy dog. ', " \
+  "2000);\n"
+
+bool TestPerformance::TestStringFunctions() {
+  VCR(PERF_START
+      PERF_TEXT "$s .= '<b>';\n"
+      "for ($i = 0; $i < " PERF_LOOP_COUNT "; $i++) "
+      "{ $t = htmlspecialchars($s);}"
+      "\n\n/* Escaping mostly clean text for HTML */"
+      PERF_END);
+
+  VCR(PERF_START
+      PERF_TEXT "$s .= \"'\";\n"
+      "for ($i = 0; $i < " PERF_LOOP_COUNT "; $i++) { $t = addslashes($s);}"
+      "\n\n/* Adding slashes to mostly clean text */"
+      PERF_END);
+
+  VCR(PERF_START
+      PERF_TEXT
+      "for ($i = 0; $i < " PERF_LOOP_COUNT "; $i++) "
+      "{ $t = strpos($s, 'missing');}"
+      "\n\n/* Searching for a missing substring */"
+      PERF_END);
+
+  VCR(PERF_START
+      PERF_TEXT
+      "for ($i = 0; $i < " PERF_LOOP_COUNT "; $i++) "
+      "{ $t = str_replace('fox', 'cat', $s);}"
+      "\n\n/* Replacing a substring */"
+      PERF_END);
+
+  VCR(PERF_START
+      PERF_TEXT
+      "for ($i = 0; $i < " PERF_LOOP_COUNT "; $i++) "
+      "{ $t = str_ireplace('FOX', 'cat', $s);}"
+      "\n\n/* Replacing a substring case-insensitively */"
+      PERF_END);
+
+  return true;
+}
+
 bool TestPerformance::TestAdHocFile() {
   string input;
   FILE *f = fopen("test/perf_ad_hoc.php", "r");
@@ -189,3 +234,63 @@ bool TestPerformance::TestAdHoc() {
 
   return true;
 }
+
+///////////////////////////////////////////////////////////////////////////////
+// hphpi's tree walker vs. its bytecode interpreter
+
+static bool run_perf_byte_code(bool byteCode,
+                               vector<string> &names,
+                               vector<string> &results, vector<int> &times) {
+  const char *argv[] = {"", "--file=test/perf_byte_code.php",
+                        "--config=test/config.hdf",
+                        "-v Fiber.ThreadCount = 0",
+                        byteCode ? "-v Eval.BytecodeInterpreter = true" :
+                        "-v Eval.BytecodeInterpreter = false",
+                        NULL};
+  string out, err;
+  if (!Process::Exec("hphpi/hphpi", argv, NULL, out, &err)) {
+    printf("Failed to run hphpi: %s\n", err.c_str());
+    return false;
+  }
+  vector<string> lines;
+  Util::split('\n', out.c_str(), lines, true);
+  for (unsigned int i = 0; i < lines.size(); i++) {
+    vector<string> fields;
+    Util::split(' ', lines[i].c_str(), fields);
+    if (fields.size() != 3) {
+      printf("Unexpected output from hphpi: %s\n", lines[i].c_str());
+      return false;
+    }
+    names.push_back(fields[0]);
+    results.push_back(fields[1]);
+    times.push_back(atoi(fields[2].c_str()));
+  }
+  return true;
+}
+
+bool TestPerformance::TestByteCode() {
+  vector<string> names1, names2, results1, results2;
+  vector<int> times1, times2;
+  if (!run_perf_byte_code(false, names1, results1, times1) ||
+      !run_perf_byte_code(true, names2, results2, times2)) {
+    return Count(false);
+  }
+  VERIFY(names1 == names2);
+
+  printf("----------------------------------------------------------\n"
+         "  benchmark         tree   bytecode\n"
+         "===========================================\n");
+  bool ret = true;
+  for (unsigned int i = 0; i < names1.size(); i++) {
+    double x = times2[i] ? (double)times1[i] / times2[i] : 0.0;
+    printf("  %-12s %6d ms  %6d ms   =   %2.4gx\n",
+           names1[i].c_str(), times1[i], times2[i], x);
+    if (results1[i] != results2[i]) {
+      printf("  %s returned %s, but %s with bytecode\n", names1[i].c_str(),
+             results1[i].c_str(), results2[i].c_str());
+      ret = false;
+    }
+  }
+  printf("\n");
+  return Count(ret);
+}
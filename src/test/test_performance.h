@@ -32,8 +32,10 @@ class TestPerformance : public TestCodeRun {
 
   bool TestBasicOperations();
   bool TestMemoryUsage();
+  bool TestStringFunctions();
   bool TestAdHocFile();
   bool TestAdHoc();
+  bool TestByteCode();
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -23,6 +23,7 @@
 #include <util/process.h>
 #include <compiler/option.h>
 #include <util/async_func.h>
+#include <util/hdf.h>
 #include <runtime/ext/ext_curl.h>
 #include <runtime/ext/ext_options.h>
 #include <runtime/base/server/http_request_handler.h>
@@ -43,6 +44,7 @@ TestServer::TestServer() {
 }
 
 static int s_server_port = 0;
+static string s_server_option; // one more -v setting for the server
 
 bool TestServer::VerifyServerResponse(const char *input, const char *output,
                                       const char *url, const char *method,
@@ -88,6 +90,9 @@ bool TestServer::VerifyServerResponse(const char *input, const char *output,
       f_curl_setopt(c, k_CURLOPT_POSTFIELDS, postdata);
       f_curl_setopt(c, k_CURLOPT_POST, true);
     }
+    if (strcmp(method, "HEAD") == 0) {
+      f_curl_setopt(c, k_CURLOPT_NOBODY, true);
+    }
     if (header) {
       f_curl_setopt(c, k_CURLOPT_HTTPHEADER, CREATE_VECTOR1(header));
     }
@@ -130,16 +135,20 @@ bool TestServer::VerifyServerResponse(const char *input, const char *output,
 void TestServer::RunServer() {
   string out, err;
   string portConfig = "Server.Port=" + lexical_cast<string>(s_server_port);
+  const char *option = s_server_option.empty() ? NULL :
+    s_server_option.c_str();
   if (Option::EnableEval < Option::FullEval) {
     const char *argv[] = {"", "--mode=server",
                           "--config=test/config-server.hdf", "-v",
-                          portConfig.c_str(), NULL};
+                          portConfig.c_str(), option ? "-v" : NULL, option,
+                          NULL};
     Process::Exec("runtime/tmp/TestServer/test", argv, NULL, out, &err);
   } else {
     const char *argv[] = {"", "--file=/unittest/rootdoc/string",
                           "--mode=server", portConfig.c_str(), "-v",
                           "--config=test/config-eval.hdf",
-                          portConfig.c_str(), NULL};
+                          portConfig.c_str(), option ? "-v" : NULL, option,
+                          NULL};
     Process::Exec("hphpi/hphpi", argv, NULL, out, &err);
   }
 }
@@ -176,6 +185,8 @@ bool TestServer::RunTests(const std::string &which) {
   RUN_TEST(TestCookie);
   RUN_TEST(TestResponseHeader);
   RUN_TEST(TestSetCookie);
+  RUN_TEST(TestStaticContent);
+  RUN_TEST(TestReplayBenchmark);
   //RUN_TEST(TestRequestHandling);
   RUN_TEST(TestHttpClient);
   RUN_TEST(TestRPCServer);
@@ -282,6 +293,45 @@ bool TestServer::TestPost() {
   VSPOST("<?php print $HTTP_RAW_POST_DATA;",
          "name=value", "string", params);
 
+  // parsed while it arrives, with Upload.StreamMinSize in config-server.hdf
+  const char *upload =
+    "--XyZ\r\n"
+    "Content-Disposition: form-data; name=\"name\"\r\n"
+    "\r\n"
+    "value\r\n"
+    "--XyZ\r\n"
+    "Content-Disposition: form-data; name=\"f\"; filename=\"c:\\d\\x.txt\"\r\n"
+    "Content-Type: text/plain\r\n"
+    "\r\n"
+    "hello\nworld\r\n"
+    "--XyZ--\r\n";
+  VSRX("<?php $f = $_FILES['f'];"
+       "print $_POST['name'].' '.$f['name'].' '.$f['type'].' '.$f['size'].' '."
+       "$f['error'].' '.file_get_contents($f['tmp_name']);",
+       "value x.txt text/plain 11 0 hello\nworld", "string", "POST",
+       "Content-Type: multipart/form-data; boundary=XyZ", upload);
+
+  // read a piece at a time, each waiting for the disk to take the last one
+  string big = "--XyZ\r\n"
+    "Content-Disposition: form-data; name=\"f\"; filename=\"big.txt\"\r\n"
+    "\r\n";
+  for (int i = 0; i < 100000; i++) {
+    big += "0123456789";
+  }
+  big += "\r\n--XyZ--\r\n";
+  s_server_option = "Server.Upload.StreamBufferSize=1";
+  bool backlogged =
+    Count(VerifyServerResponse
+          ("<?php $f = $_FILES['f'];"
+           "print $f['size'].' '.$f['error'].' '.(int)"
+           "(file_get_contents($f['tmp_name']) ==="
+           " str_repeat('0123456789', 100000));",
+           "1000000 0 1", "string", "POST",
+           "Content-Type: multipart/form-data; boundary=XyZ", big.c_str(),
+           false, __FILE__, __LINE__));
+  s_server_option.clear();
+  if (!backlogged) return false;
+
   return true;
 }
 
@@ -397,6 +447,122 @@ bool TestServer::TestRequestHandling() {
   return Count(true);
 }
 
+#define VSSTATIC(output, header, responseHeader)                         \
+  if (!Count(VerifyServerResponse("<?php ", output, "static.txt", "GET", \
+                                  header, NULL, responseHeader,         \
+                                  __FILE__,__LINE__)))                  \
+    return false;
+
+bool TestServer::TestStaticContent() {
+  string fullPath = "/unittest/rootdoc/static.txt";
+  ofstream f(fullPath.c_str());
+  if (!f) {
+    printf("Unable to open %s for write.\n", fullPath.c_str());
+    return false;
+  }
+  f << "0123456789";
+  f.close();
+
+  VSSTATIC("0123456789", NULL, false);
+  VSSTATIC("ETag: \"", NULL, true);
+  VSSTATIC("2345", "Range: bytes=2-5", false);
+  VSSTATIC("789", "Range: bytes=-3", false);
+  VSSTATIC("Content-Range: bytes 7-9/10", "Range: bytes=7-", true);
+  VSSTATIC("416", "Range: bytes=20-", true);
+  VSSTATIC("0123456789", "Range: bytes=0-1,3-4", false);
+  VSSTATIC("304", "If-None-Match: *", true);
+  VSSTATIC("304", "If-Modified-Since: Fri, 31 Dec 2037 23:59:59 GMT", true);
+  VSSTATIC("0123456789", "If-Modified-Since: Thu, 01 Jan 1970 00:00:01 GMT",
+           false);
+
+  // headers only, with the length of what a GET would have sent
+  if (!Count(VerifyServerResponse("<?php ", "Content-Length: 10",
+                                  "static.txt", "HEAD", NULL, NULL, true,
+                                  __FILE__, __LINE__))) {
+    return false;
+  }
+
+  // bigger than Transport::SendFileChunkSize: sent with sendfile() and then
+  // a window at a time, or in chunks when it can't be sent directly
+  string bigPath = "/unittest/rootdoc/static_big.txt";
+  string big;
+  for (int i = 0; big.size() < 4 * 1024 * 1024; i++) {
+    big += lexical_cast<string>(i) + "\n";
+  }
+  ofstream fbig(bigPath.c_str());
+  fbig << big;
+  fbig.close();
+  if (!Count(VerifyServerResponse("<?php ", big.c_str(), "static_big.txt",
+                                  "GET", NULL, NULL, false,
+                                  __FILE__, __LINE__))) {
+    return false;
+  }
+  s_server_option = "Server.LibEventSyncSend=false";
+  bool chunked =
+    Count(VerifyServerResponse("<?php ", big.c_str(), "static_big.txt",
+                               "GET", NULL, NULL, false, __FILE__, __LINE__)) &&
+    Count(VerifyServerResponse("<?php ", "Transfer-Encoding: chunked",
+                               "static_big.txt", "GET", NULL, NULL, true,
+                               __FILE__, __LINE__));
+  s_server_option.clear();
+  unlink(bigPath.c_str());
+  if (!chunked) return false;
+
+  unlink(fullPath.c_str());
+  return true;
+}
+
+bool TestServer::TestReplayBenchmark() {
+  const char *input = "<?php print 'Hello, World!';";
+  if (!CleanUp()) return false;
+  if (Option::EnableEval < Option::FullEval) {
+    if (!GenerateFiles(input, "TestServer") || !CompileFiles()) {
+      return false;
+    }
+  } else {
+    ofstream f("/unittest/rootdoc/string");
+    f << input;
+    f.close();
+  }
+
+  // a request as ReplayTransport::recordInput() saves it, and a file that
+  // isn't one, which the loader has to skip
+  string dir = "/tmp/test_replay_benchmark";
+  mkdir(dir.c_str(), 0777);
+  Hdf hdf;
+  hdf["get"] = true;
+  hdf["url"] = "/string";
+  hdf["remote_host"] = "127.0.0.1";
+  hdf["post"] = "";
+  hdf.write((dir + "/request.hdf").c_str());
+  ofstream junk((dir + "/junk.txt").c_str());
+  junk << "junk";
+  junk.close();
+
+  string out, err;
+  if (Option::EnableEval < Option::FullEval) {
+    const char *argv[] = {"", "--mode=bench",
+                          "--config=test/config-server.hdf",
+                          "--threads=2", "--count=3", dir.c_str(), NULL};
+    Process::Exec("runtime/tmp/TestServer/test", argv, NULL, out, &err);
+  } else {
+    const char *argv[] = {"", "--mode=bench",
+                          "--config=test/config-eval.hdf",
+                          "--threads=2", "--count=3", dir.c_str(), NULL};
+    Process::Exec("hphpi/hphpi", argv, NULL, out, &err);
+  }
+  unlink((dir + "/request.hdf").c_str());
+  unlink((dir + "/junk.txt").c_str());
+  rmdir(dir.c_str());
+
+  VERIFY(out.find("inputs: 1\n") != string::npos);
+  VERIFY(out.find("threads: 2\n") != string::npos);
+  VERIFY(out.find("requests: 6\n") != string::npos);
+  VERIFY(out.find("code.200: 6\n") != string::npos);
+  VERIFY(out.find("latency_us.p50: ") != string::npos);
+  return Count(true);
+}
+
 class TestRequestHandler : public RequestHandler {
 public:
   // implementing RequestHandler
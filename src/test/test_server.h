@@ -44,6 +44,12 @@ public:
   bool TestResponseHeader();
   bool TestSetCookie();
 
+  // test conditional and partial GETs of static files
+  bool TestStaticContent();
+
+  // test bench mode replaying recorded requests
+  bool TestReplayBenchmark();
+
   // test multithreaded request processing
   bool TestRequestHandling();
   bool TestLibeventServer();
@@ -16,6 +16,7 @@
 
 #include <test/test_util.h>
 #include <util/lfu_table.h>
+#include <util/job_queue.h>
 #include <runtime/base/complex_types.h>
 #include <util/logger.h>
 #include <runtime/base/shared/shared_string.h>
@@ -43,6 +44,7 @@ bool TestUtil::RunTests(const std::string &which) {
   //RUN_TEST(TestLFUTable);
   RUN_TEST(TestSharedString);
   RUN_TEST(TestCanonicalize);
+  RUN_TEST(TestSharedThreadPool);
   return ret;
 }
 
@@ -260,3 +262,110 @@ bool TestUtil::TestCanonicalize() {
   VERIFY(Util::canonicalize("./../../") == "../../");
   return Count(true);
 }
+
+///////////////////////////////////////////////////////////////////////////////
+
+static const int POOL_JOBS = 40;
+static int s_pool_workers[POOL_JOBS];
+
+/**
+ * Holds jobs back until a given number of them are running at the same
+ * time, which takes that many threads. Gives up after 10 seconds, so a pool
+ * that doesn't lend enough threads fails the test instead of hanging it.
+ */
+class PoolTestGate : public Synchronizable {
+public:
+  PoolTestGate() : m_running(0), m_count(0), m_timedOut(false) {}
+
+  void reset(int count) {
+    Lock lock(this);
+    m_running = 0;
+    m_count = count;
+    m_timedOut = false;
+  }
+
+  void pass() {
+    Lock lock(this);
+    if (m_count == 0) return; // open
+    if (++m_running == m_count) {
+      m_count = 0;
+      notifyAll();
+      return;
+    }
+    while (m_count) {
+      if (!wait(10)) {
+        m_timedOut = true;
+        m_count = 0;
+        notifyAll();
+      }
+    }
+  }
+
+  bool timedOut() {
+    Lock lock(this);
+    return m_timedOut;
+  }
+
+private:
+  int m_running;
+  int m_count;
+  bool m_timedOut;
+};
+static PoolTestGate s_pool_gate;
+
+class PoolTestWorker : public JobQueueWorker<int> {
+public:
+  virtual void doJob(int job) {
+    s_pool_workers[job] = m_id;
+    s_pool_gate.pass();
+  }
+};
+
+bool TestUtil::TestSharedThreadPool() {
+  SharedThreadPool pool;
+  int a = pool.addPool("a", 2, 1, 0); // thread 0 never steals
+  int b = pool.addPool("b", 2, 0, 1); // threads 2 and 3 steal
+  VERIFY(pool.getThreadCount() == 4);
+
+  JobQueueDispatcher<int, PoolTestWorker> da(2, NULL);
+  JobQueueDispatcher<int, PoolTestWorker> db(2, NULL);
+  da.share(&pool, a);
+  db.share(&pool, b);
+  da.start();
+  db.start();
+
+  // a's jobs are stolen by b's idle threads: 4 of them only run at once
+  // on all 4 threads
+  memset(s_pool_workers, -1, sizeof(s_pool_workers));
+  s_pool_gate.reset(4);
+  for (int i = 0; i < POOL_JOBS; i++) da.enqueue(i);
+  da.stop();
+  VERIFY(!s_pool_gate.timedOut());
+  bool stolen = false;
+  for (int i = 0; i < POOL_JOBS; i++) {
+    VERIFY(s_pool_workers[i] >= 0);
+    if (s_pool_workers[i] >= 2) stolen = true;
+  }
+  VERIFY(stolen);
+
+  // but b's jobs never run on a's reserved thread, only on the 3 others
+  memset(s_pool_workers, -1, sizeof(s_pool_workers));
+  s_pool_gate.reset(3);
+  for (int i = 0; i < POOL_JOBS; i++) db.enqueue(i);
+  db.stop();
+  VERIFY(!s_pool_gate.timedOut());
+  stolen = false;
+  for (int i = 0; i < POOL_JOBS; i++) {
+    VERIFY(s_pool_workers[i] >= 1);
+    if (s_pool_workers[i] == 1) stolen = true;
+  }
+  VERIFY(stolen);
+
+  vector<SharedThreadPool::PoolStats> stats;
+  pool.getStats(stats);
+  VERIFY(stats.size() == 2);
+  VERIFY(stats[a].jobs == POOL_JOBS);
+  VERIFY(stats[b].jobs == POOL_JOBS);
+  VERIFY(stats[a].queued == 0 && stats[a].running == 0);
+  return Count(true);
+}
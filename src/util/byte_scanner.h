@@ -0,0 +1,81 @@
+/*
+   +----------------------------------------------------------------------+
+   | HipHop for PHP                                                       |
+   +----------------------------------------------------------------------+
+   | Copyright (c) 2010 Facebook, Inc. (http://www.facebook.com)          |
+   +----------------------------------------------------------------------+
+   | This source file is subject to version 3.01 of the PHP license,      |
+   | that is bundled with this package in the file LICENSE, and is        |
+   | available through the world-wide-web at the following url:           |
+   | http://www.php.net/license/3_01.txt                                  |
+   | If you did not receive a copy of the PHP license and are unable to   |
+   | obtain it through the world-wide-web, please send a note to          |
+   | license@php.net so we can mail you a copy immediately.               |
+   +----------------------------------------------------------------------+
+*/
+
+#ifndef __HPHP_BYTE_SCANNER_H__
+#define __HPHP_BYTE_SCANNER_H__
+
+#include "base.h"
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace HPHP {
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Finds the next occurrence of any byte from a small set, 16 bytes at a time
+ * when SSE2 is available. Escaping routines use it to copy the runs of bytes
+ * that need no escaping with one memcpy, instead of a switch on every byte.
+ */
+class ByteScanner {
+public:
+  static const int MaxBytes = 8;
+
+  ByteScanner(const char *bytes, int count) : m_count(count) {
+    ASSERT(count > 0 && count <= MaxBytes);
+    memset(m_table, 0, sizeof(m_table));
+    for (int i = 0; i < count; i++) {
+      m_table[(unsigned char)bytes[i]] = true;
+#ifdef __SSE2__
+      m_vectors[i] = _mm_set1_epi8(bytes[i]);
+#endif
+    }
+  }
+
+  bool contains(char c) const { return m_table[(unsigned char)c];}
+
+  /**
+   * Returns the first byte in [p, end) that is in the set, or end.
+   */
+  const char *find(const char *p, const char *end) const {
+#ifdef __SSE2__
+    while (end - p >= 16) {
+      __m128i v = _mm_loadu_si128((const __m128i *)p);
+      __m128i hits = _mm_cmpeq_epi8(v, m_vectors[0]);
+      for (int i = 1; i < m_count; i++) {
+        hits = _mm_or_si128(hits, _mm_cmpeq_epi8(v, m_vectors[i]));
+      }
+      int mask = _mm_movemask_epi8(hits);
+      if (mask) return p + __builtin_ctz(mask);
+      p += 16;
+    }
+#endif
+    while (p < end && !m_table[(unsigned char)*p]) p++;
+    return p;
+  }
+
+private:
+#ifdef __SSE2__
+  __m128i m_vectors[MaxBytes];
+#endif
+  int m_count;
+  bool m_table[256];
+};
+
+///////////////////////////////////////////////////////////////////////////////
+}
+
+#endif // __HPHP_BYTE_SCANNER_H__
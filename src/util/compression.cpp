@@ -18,6 +18,9 @@
 #include "compression.h"
 #include "logger.h"
 #include "exception.h"
+#include "async_func.h"
+#include "synchronizable.h"
+#include "lock.h"
 
 #define PHP_ZLIB_MODIFIER 1000
 #define GZIP_HEADER_LENGTH 10
@@ -272,6 +275,260 @@ char *StreamCompressor::compress(const char *data, int &len, bool trailer) {
   return NULL;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// parallel deflate
+
+/**
+ * Large inputs are cut into blocks that are deflated independently on worker
+ * threads, like pigz does. Each block is primed with the 32KB of input right
+ * before it, so matches can still reach back across block boundaries, and
+ * ends with a sync flush to land on a byte boundary. Then the raw deflate
+ * outputs concatenate into one valid stream, and per-block checksums are
+ * combined into the one gzip or zlib wants.
+ */
+#define PARALLEL_BLOCK_SIZE (128 * 1024)
+#define PARALLEL_DICT_SIZE  (32 * 1024)
+
+static int s_parallel_threads = 0;
+static int s_parallel_min_size = 1024 * 1024;
+
+void set_parallel_deflate(int threads, int minSize) {
+  s_parallel_threads = threads;
+  s_parallel_min_size = minSize < PARALLEL_BLOCK_SIZE * 2 ?
+    PARALLEL_BLOCK_SIZE * 2 : minSize;
+}
+
+enum DeflateFormat {
+  RawDeflate,
+  ZlibDeflate,
+  GzipDeflate,
+};
+
+class DeflateJob;
+class DeflateBlock {
+public:
+  DeflateJob *job;
+  const char *data;
+  int len;
+  int dictLen;   // bytes right before data to prime the dictionary with
+  bool last;
+
+  char *out;
+  int outLen;
+  uLong check;   // crc32 or adler32 of data
+
+  void deflate(int level, DeflateFormat format);
+};
+
+class DeflateJob : public Synchronizable {
+public:
+  DeflateJob(int count) : remaining(count) {}
+  int remaining;
+
+  void done() {
+    Lock lock(this);
+    if (--remaining == 0) {
+      notify();
+    }
+  }
+  void waitForAll() {
+    Lock lock(this);
+    while (remaining) {
+      wait();
+    }
+  }
+
+  int level;
+  DeflateFormat format;
+};
+
+void DeflateBlock::deflate(int level, DeflateFormat format) {
+  z_stream stream;
+  stream.zalloc = Z_NULL;
+  stream.zfree = Z_NULL;
+  stream.opaque = Z_NULL;
+
+  out = NULL;
+  outLen = -1;
+  int status = deflateInit2(&stream, level, Z_DEFLATED, -MAX_WBITS,
+                            MAX_MEM_LEVEL, Z_DEFAULT_STRATEGY);
+  if (status != Z_OK) return;
+  if (dictLen) {
+    deflateSetDictionary(&stream, (const Bytef *)data - dictLen, dictLen);
+  }
+
+  // room for the sync flush's empty stored block on top of the bound
+  uLong size = deflateBound(&stream, len) + 16;
+  out = (char *)malloc(size);
+  stream.next_in = (Bytef *)data;
+  stream.avail_in = len;
+  stream.next_out = (Bytef *)out;
+  stream.avail_out = size;
+  status = ::deflate(&stream, last ? Z_FINISH : Z_SYNC_FLUSH);
+  if (last ? status == Z_STREAM_END : (status == Z_OK && !stream.avail_in)) {
+    outLen = stream.total_out;
+  }
+  deflateEnd(&stream);
+
+  if (format == GzipDeflate) {
+    check = crc32(crc32(0L, Z_NULL, 0), (const Bytef *)data, len);
+  } else if (format == ZlibDeflate) {
+    check = adler32(adler32(0L, Z_NULL, 0), (const Bytef *)data, len);
+  }
+}
+
+/**
+ * Worker threads, started the first time a large enough input comes along.
+ */
+class DeflateWorkers : public Synchronizable {
+public:
+  static DeflateWorkers *Get() {
+    static Mutex s_mutex;
+    static DeflateWorkers * volatile s_workers = NULL;
+    if (s_workers == NULL) {
+      Lock lock(s_mutex);
+      if (s_workers == NULL) {
+        DeflateWorkers *workers = new DeflateWorkers();
+        for (int i = 0; i < s_parallel_threads; i++) {
+          AsyncFunc<DeflateWorkers> *thread =
+            new AsyncFunc<DeflateWorkers>(workers, &DeflateWorkers::run);
+          thread->start();
+        }
+        __sync_synchronize();
+        s_workers = workers;
+      }
+    }
+    return s_workers;
+  }
+
+  void enqueue(DeflateBlock *block) {
+    Lock lock(this);
+    m_blocks.push_back(block);
+    notify();
+  }
+
+  void run() {
+    while (true) {
+      DeflateBlock *block;
+      {
+        Lock lock(this);
+        while (m_blocks.empty()) {
+          wait();
+        }
+        block = m_blocks.front();
+        m_blocks.pop_front();
+      }
+      DeflateJob *job = block->job;
+      block->deflate(job->level, job->format);
+      job->done();
+    }
+  }
+
+private:
+  std::deque<DeflateBlock*> m_blocks;
+};
+
+static bool use_parallel_deflate(int len) {
+  return s_parallel_threads > 0 && len >= s_parallel_min_size;
+}
+
+/**
+ * Returns NULL if any block failed, so the caller can do it in one go.
+ */
+static char *parallel_deflate(const char *data, int &len, int level,
+                              DeflateFormat format) {
+  int count = (len + PARALLEL_BLOCK_SIZE - 1) / PARALLEL_BLOCK_SIZE;
+  std::vector<DeflateBlock> blocks(count);
+  DeflateJob job(count);
+  job.level = level;
+  job.format = format;
+
+  DeflateWorkers *workers = DeflateWorkers::Get();
+  for (int i = 0; i < count; i++) {
+    DeflateBlock &block = blocks[i];
+    int offset = i * PARALLEL_BLOCK_SIZE;
+    block.job = &job;
+    block.data = data + offset;
+    block.len = (i == count - 1) ? len - offset : PARALLEL_BLOCK_SIZE;
+    block.dictLen = offset < PARALLEL_DICT_SIZE ? offset : PARALLEL_DICT_SIZE;
+    block.last = (i == count - 1);
+    workers->enqueue(&block);
+  }
+  job.waitForAll();
+
+  bool ok = true;
+  int total = 0;
+  for (int i = 0; i < count; i++) {
+    if (blocks[i].outLen < 0) ok = false;
+    total += blocks[i].outLen;
+  }
+
+  char *s2 = NULL;
+  if (ok) {
+    int header = format == GzipDeflate ? GZIP_HEADER_LENGTH :
+      format == ZlibDeflate ? 2 : 0;
+    int footer = format == GzipDeflate ? GZIP_FOOTER_LENGTH :
+      format == ZlibDeflate ? 4 : 0;
+    s2 = (char *)malloc(header + total + footer + 1);
+
+    char *p = s2;
+    if (format == GzipDeflate) {
+      p[0] = gz_magic[0];
+      p[1] = gz_magic[1];
+      p[2] = Z_DEFLATED;
+      p[3] = p[4] = p[5] = p[6] = p[7] = p[8] = 0; /* time set to 0 */
+      p[9] = 0x03; // OS_CODE
+    } else if (format == ZlibDeflate) {
+      // same FLEVEL deflateInit() would pick, then the FCHECK bits
+      int flevel = (level == 1) ? 0 : (level >= 2 && level <= 5) ? 1 :
+        (level == 6 || level == -1) ? 2 : 3;
+      int cmf = 0x78, flg = flevel << 6;
+      flg += 31 - ((cmf * 256 + flg) % 31);
+      p[0] = cmf;
+      p[1] = flg;
+    }
+    p += header;
+
+    uLong check = format == GzipDeflate ? crc32(0L, Z_NULL, 0) :
+      adler32(0L, Z_NULL, 0);
+    for (int i = 0; i < count; i++) {
+      DeflateBlock &block = blocks[i];
+      memcpy(p, block.out, block.outLen);
+      p += block.outLen;
+      if (format == GzipDeflate) {
+        check = crc32_combine(check, block.check, block.len);
+      } else if (format == ZlibDeflate) {
+        check = adler32_combine(check, block.check, block.len);
+      }
+    }
+
+    if (format == GzipDeflate) {
+      /* write crc & total input length in LSB order */
+      p[0] = (char) check & 0xFF;
+      p[1] = (char) (check >> 8) & 0xFF;
+      p[2] = (char) (check >> 16) & 0xFF;
+      p[3] = (char) (check >> 24) & 0xFF;
+      p[4] = (char) len & 0xFF;
+      p[5] = (char) (len >> 8) & 0xFF;
+      p[6] = (char) (len >> 16) & 0xFF;
+      p[7] = (char) (len >> 24) & 0xFF;
+    } else if (format == ZlibDeflate) {
+      /* adler32 goes in MSB order */
+      p[0] = (char) (check >> 24) & 0xFF;
+      p[1] = (char) (check >> 16) & 0xFF;
+      p[2] = (char) (check >> 8) & 0xFF;
+      p[3] = (char) check & 0xFF;
+    }
+    len = header + total + footer;
+    s2[len] = '\0';
+  }
+
+  for (int i = 0; i < count; i++) {
+    free(blocks[i].out);
+  }
+  return s2;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 char *gzencode(const char *data, int &len, int level, int encoding_mode) {
@@ -285,6 +542,11 @@ char *gzencode(const char *data, int &len, int level, int encoding_mode) {
     return NULL;
   }
 
+  if (encoding_mode == CODING_GZIP && use_parallel_deflate(len)) {
+    char *ret = parallel_deflate(data, len, level, GzipDeflate);
+    if (ret) return ret;
+  }
+
   z_stream stream;
   stream.zalloc = Z_NULL;
   stream.zfree = Z_NULL;
@@ -440,6 +702,11 @@ char *gzcompress(const char *data, int &len, int level /* = -1 */) {
     return NULL;
   }
 
+  if (use_parallel_deflate(len)) {
+    char *ret = parallel_deflate(data, len, level, ZlibDeflate);
+    if (ret) return ret;
+  }
+
   unsigned long l2 = len + (len / PHP_ZLIB_MODIFIER) + 15 + 1;
   char *s2 = (char *)malloc(l2);
   if (!s2) {
@@ -509,6 +776,11 @@ char *gzdeflate(const char *data, int &len, int level /* = -1 */) {
     return NULL;
   }
 
+  if (use_parallel_deflate(len)) {
+    char *ret = parallel_deflate(data, len, level, RawDeflate);
+    if (ret) return ret;
+  }
+
   z_stream stream;
   stream.data_type = Z_ASCII;
   stream.zalloc = (alloc_func) Z_NULL;
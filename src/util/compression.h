@@ -37,6 +37,13 @@ char *gzuncompress(const char *data, int &len, int limit = 0);
 char *gzdeflate(const char *data, int &len, int level = -1);
 char *gzinflate(const char *data, int &len, int limit = 0);
 
+/**
+ * gzencode(), gzcompress() and gzdeflate() split inputs of at least minSize
+ * bytes into blocks and compress them on this many worker threads. Off when
+ * threads is 0.
+ */
+void set_parallel_deflate(int threads, int minSize);
+
 ///////////////////////////////////////////////////////////////////////////////
 
 class StreamCompressor {
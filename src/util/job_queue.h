@@ -20,8 +20,10 @@
 #include "async_func.h"
 #include <vector>
 #include "synchronizable.h"
+#include "shared_thread_pool.h"
 #include "lock.h"
 #include "atomic.h"
+#include <sys/time.h>
 
 namespace HPHP {
 ///////////////////////////////////////////////////////////////////////////////
@@ -60,6 +62,10 @@ namespace HPHP {
  * store prepared jobs. With JobQueueDispatcher, job queue is normally empty
  * initially and new jobs are pushed into the queue over time. Also, workers
  * can be stopped individually.
+ *
+ * Instead of running its own threads, a dispatcher can hand its jobs to a
+ * SharedThreadPool by calling share() before start(). It then has one worker
+ * per pool thread, and each worker only sees jobs of this dispatcher.
  */
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -217,7 +223,8 @@ public:
   /**
    * Constructor.
    */
-  JobQueueDispatcher(int threadCount, void *opaque) : m_stopped(true) {
+  JobQueueDispatcher(int threadCount, void *opaque)
+    : m_stopped(true), m_opaque(opaque), m_shared(this) {
     ASSERT(threadCount >= 1);
     m_workers.resize(threadCount);
     m_funcs.resize(threadCount);
@@ -239,13 +246,41 @@ public:
     return m_workers;
   }
   int getActiveWorker() {
+    if (m_shared.m_pool) {
+      return m_shared.m_pool->getActiveWorker(m_shared.m_poolId);
+    }
     return m_queue.getActiveWorker();
   }
 
+  /**
+   * Runs jobs on threads of a shared pool, instead of our own ones. Must be
+   * called before start().
+   */
+  void share(SharedThreadPool *pool, int poolId) {
+    ASSERT(pool);
+    ASSERT(m_stopped);
+    for (unsigned int i = 0; i < m_funcs.size(); i++) {
+      delete m_funcs[i];
+    }
+    m_funcs.clear();
+
+    int threadCount = pool->getThreadCount();
+    m_workers.clear();
+    m_workers.resize(threadCount);
+    for (int i = 0; i < threadCount; i++) {
+      m_workers[i].create(i, &m_queue, m_opaque);
+    }
+    m_shared.m_pool = pool;
+    m_shared.m_poolId = poolId;
+  }
+
   /**
    * Creates worker threads and start running them. This is non-blocking.
    */
   void start() {
+    if (m_shared.m_pool) {
+      m_shared.m_pool->attach(m_shared.m_poolId, &m_shared);
+    }
     for (unsigned int i = 0; i < m_funcs.size(); i++) {
       m_funcs[i]->start();
     }
@@ -256,6 +291,10 @@ public:
    * Enqueue a new job.
    */
   void enqueue(TJob job) {
+    if (m_shared.m_pool) {
+      m_shared.enqueue(job);
+      return;
+    }
     m_queue.enqueue(job);
   }
 
@@ -267,6 +306,11 @@ public:
     if (m_stopped) return;
     m_stopped = true;
 
+    if (m_shared.m_pool) {
+      m_shared.m_pool->detach(m_shared.m_poolId);
+      return;
+    }
+
     m_queue.stop();
     bool exceptioned = false;
     std::exception exception;
@@ -284,10 +328,65 @@ public:
   }
 
 private:
+  /**
+   * Our jobs as a SharedThreadPool sees them, each of them running on the
+   * worker with the same id as the pool thread.
+   */
+  class SharedQueue : public SharedJobQueue {
+  public:
+    SharedQueue(JobQueueDispatcher *dispatcher)
+      : m_pool(NULL), m_poolId(-1), m_dispatcher(dispatcher) {}
+
+    void enqueue(TJob job) {
+      {
+        Lock lock(m_mutex);
+        m_jobs.push_back(std::pair<TJob, int64>(job, now()));
+      }
+      m_pool->onEnqueue(m_poolId);
+    }
+
+    virtual int64 runOne(int thread) {
+      TJob job;
+      int64 wait;
+      {
+        Lock lock(m_mutex);
+        ASSERT(!m_jobs.empty());
+        job = m_jobs.front().first;
+        wait = now() - m_jobs.front().second;
+        m_jobs.pop_front();
+      }
+      m_pool->logWait(m_poolId, wait);
+      m_dispatcher->m_workers[thread].doJob(job);
+      return wait;
+    }
+    virtual void onThreadEnter(int thread) {
+      m_dispatcher->m_workers[thread].onThreadEnter();
+    }
+    virtual void onThreadExit(int thread) {
+      m_dispatcher->m_workers[thread].onThreadExit();
+    }
+
+    SharedThreadPool *m_pool;
+    int m_poolId;
+
+  private:
+    JobQueueDispatcher *m_dispatcher;
+    Mutex m_mutex;
+    std::deque<std::pair<TJob, int64> > m_jobs;
+
+    static int64 now() {
+      struct timeval tv;
+      gettimeofday(&tv, NULL);
+      return (int64)tv.tv_sec * 1000000 + tv.tv_usec;
+    }
+  };
+
   bool m_stopped;
+  void *m_opaque;
   JobQueue<TJob> m_queue;
   std::vector<TWorker> m_workers;
   std::vector<AsyncFunc<TWorker> *> m_funcs;
+  SharedQueue m_shared;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,336 @@
+/*
+   +----------------------------------------------------------------------+
+   | HipHop for PHP                                                       |
+   +----------------------------------------------------------------------+
+   | Copyright (c) 2010 Facebook, Inc. (http://www.facebook.com)          |
+   +----------------------------------------------------------------------+
+   | This source file is subject to version 3.01 of the PHP license,      |
+   | that is bundled with this package in the file LICENSE, and is        |
+   | available through the world-wide-web at the following url:           |
+   | http://www.php.net/license/3_01.txt                                  |
+   | If you did not receive a copy of the PHP license and are unable to   |
+   | obtain it through the world-wide-web, please send a note to          |
+   | license@php.net so we can mail you a copy immediately.               |
+   +----------------------------------------------------------------------+
+*/
+
+#include "shared_thread_pool.h"
+
+using namespace std;
+
+namespace HPHP {
+///////////////////////////////////////////////////////////////////////////////
+
+SharedThreadPool::PFUNC_LOG_WAIT SharedThreadPool::s_pfunc_log_wait = NULL;
+
+SharedThreadPool::Thread::Thread(SharedThreadPool *owner, int id, int pool,
+                                 bool stealer)
+  : m_owner(owner), m_id(id), m_pool(pool), m_stealer(stealer),
+    m_woken(false) {
+  pthread_cond_init(&m_cond, NULL);
+}
+
+SharedThreadPool::Thread::~Thread() {
+  pthread_cond_destroy(&m_cond);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+SharedThreadPool::SharedThreadPool()
+  : m_threadCount(0), m_attached(0), m_stopping(false) {
+  pthread_cond_init(&m_changed, NULL);
+}
+
+SharedThreadPool::~SharedThreadPool() {
+  m_mutex.lock();
+  if (!m_threads.empty()) {
+    stopThreads();
+  }
+  m_mutex.unlock();
+  pthread_cond_destroy(&m_changed);
+}
+
+int SharedThreadPool::addPool(const std::string &name, int threadCount,
+                              int reservedCount, int priority) {
+  Lock lock(m_mutex);
+  ASSERT(m_threads.empty());
+  ASSERT(threadCount >= 0);
+
+  Pool p;
+  p.name = name;
+  p.threadCount = threadCount;
+  p.reservedCount = reservedCount < threadCount ? reservedCount : threadCount;
+  p.priority = priority;
+  p.queue = NULL;
+  p.detaching = false;
+  p.entered = 0;
+  p.queued = 0;
+  p.running = 0;
+  p.maxQueued = 0;
+  p.jobs = 0;
+  p.waitUs = 0;
+  p.maxWaitUs = 0;
+  m_pools.push_back(p);
+
+  m_threadCount += threadCount;
+  return m_pools.size() - 1;
+}
+
+void SharedThreadPool::attach(int pool, SharedJobQueue *queue) {
+  ASSERT(queue);
+  Lock lock(m_mutex);
+  Pool &p = m_pools[pool];
+  ASSERT(p.queue == NULL);
+  p.queue = queue;
+  p.detaching = false;
+  if (m_attached++ == 0 && m_threads.empty()) {
+    startThreads();
+  } else {
+    wakeAll(); // so they enter the new queue
+  }
+}
+
+void SharedThreadPool::detach(int pool) {
+  m_mutex.lock();
+  Pool &p = m_pools[pool];
+  if (p.queue == NULL || p.detaching) {
+    m_mutex.unlock();
+    return;
+  }
+  p.detaching = true;
+  wakeAll(); // so they exit the queue, once it's drained
+  while (p.queued || p.running || p.entered) {
+    pthread_cond_wait(&m_changed, &m_mutex.getRaw());
+  }
+  p.queue = NULL;
+  p.detaching = false;
+  if (--m_attached == 0) {
+    stopThreads();
+  }
+  m_mutex.unlock();
+}
+
+void SharedThreadPool::onEnqueue(int pool) {
+  Lock lock(m_mutex);
+  Pool &p = m_pools[pool];
+  if (++p.queued > p.maxQueued) {
+    p.maxQueued = p.queued;
+  }
+  wakeOne(pool);
+}
+
+void SharedThreadPool::logWait(int pool, int64 wait_us) {
+  if (s_pfunc_log_wait) {
+    s_pfunc_log_wait(m_pools[pool].name, wait_us);
+  }
+}
+
+int SharedThreadPool::getActiveWorker(int pool) {
+  Lock lock(m_mutex);
+  return m_pools[pool].running;
+}
+
+void SharedThreadPool::getStats(std::vector<PoolStats> &stats) {
+  Lock lock(m_mutex);
+  stats.resize(m_pools.size());
+  for (unsigned int i = 0; i < m_pools.size(); i++) {
+    const Pool &p = m_pools[i];
+    PoolStats &ps = stats[i];
+    ps.name = p.name;
+    ps.threadCount = p.threadCount;
+    ps.reservedCount = p.reservedCount;
+    ps.priority = p.priority;
+    ps.queued = p.queued;
+    ps.running = p.running;
+    ps.maxQueued = p.maxQueued;
+    ps.jobs = p.jobs;
+    ps.waitUs = p.waitUs;
+    ps.maxWaitUs = p.maxWaitUs;
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// called with m_mutex locked
+
+void SharedThreadPool::startThreads() {
+  int id = 0;
+  for (unsigned int i = 0; i < m_pools.size(); i++) {
+    const Pool &p = m_pools[i];
+    for (int j = 0; j < p.threadCount; j++) {
+      Thread *thread = new Thread(this, id++, i, j >= p.reservedCount);
+      thread->m_entered.resize(m_pools.size());
+      m_threads.push_back(thread);
+      m_funcs.push_back(new AsyncFunc<Thread>(thread, &Thread::run));
+    }
+  }
+  for (unsigned int i = 0; i < m_funcs.size(); i++) {
+    m_funcs[i]->start();
+  }
+}
+
+void SharedThreadPool::stopThreads() {
+  m_stopping = true;
+  wakeAll();
+
+  vector<Thread*> threads;
+  vector<AsyncFunc<Thread>*> funcs;
+  threads.swap(m_threads);
+  funcs.swap(m_funcs);
+
+  m_mutex.unlock();
+  for (unsigned int i = 0; i < funcs.size(); i++) {
+    funcs[i]->waitForEnd();
+    delete funcs[i];
+  }
+  for (unsigned int i = 0; i < threads.size(); i++) {
+    delete threads[i];
+  }
+  m_mutex.lock();
+
+  m_stopping = false;
+}
+
+void SharedThreadPool::work(Thread *thread) {
+  m_mutex.lock();
+  while (true) {
+    if (syncQueues(thread)) continue;
+    if (m_stopping) break;
+
+    int pool = pickPool(thread);
+    if (pool < 0) {
+      idle(thread);
+      continue;
+    }
+
+    Pool &p = m_pools[pool];
+    SharedJobQueue *queue = p.queue;
+    p.queued--;
+    p.running++;
+    m_mutex.unlock();
+    int64 wait = queue->runOne(thread->m_id);
+    m_mutex.lock();
+    p.running--;
+    p.jobs++;
+    p.waitUs += wait;
+    if (wait > p.maxWaitUs) {
+      p.maxWaitUs = wait;
+    }
+    if (p.detaching) {
+      if (p.queued == 0) wakeAll();
+      pthread_cond_broadcast(&m_changed);
+    }
+  }
+  m_mutex.unlock();
+}
+
+/**
+ * Enters a newly attached queue, or exits one being detached. Returns true
+ * if it did either, with m_mutex unlocked in between, so the caller has to
+ * look at everything again.
+ */
+bool SharedThreadPool::syncQueues(Thread *thread) {
+  for (unsigned int i = 0; i < m_pools.size(); i++) {
+    Pool &p = m_pools[i];
+    SharedJobQueue *entered = thread->m_entered[i];
+    bool drained = p.detaching && p.queued == 0;
+    if (entered && drained) {
+      m_mutex.unlock();
+      entered->onThreadExit(thread->m_id);
+      m_mutex.lock();
+      thread->m_entered[i] = NULL;
+      p.entered--;
+      pthread_cond_broadcast(&m_changed);
+      return true;
+    }
+    if (!entered && p.queue && !drained) {
+      // counted before calling out, so detach() waits for us
+      entered = thread->m_entered[i] = p.queue;
+      p.entered++;
+      m_mutex.unlock();
+      entered->onThreadEnter(thread->m_id);
+      m_mutex.lock();
+      return true;
+    }
+  }
+  return false;
+}
+
+int SharedThreadPool::pickPool(Thread *thread) {
+  int home = thread->m_pool;
+  const Pool &p = m_pools[home];
+  if (p.queued > 0 && p.queue && thread->m_entered[home] == p.queue) {
+    return home;
+  }
+  if (!thread->m_stealer) {
+    return -1;
+  }
+  int best = -1;
+  for (unsigned int i = 0; i < m_pools.size(); i++) {
+    const Pool &victim = m_pools[i];
+    if ((int)i != home && victim.queued > 0 && victim.queue &&
+        thread->m_entered[i] == victim.queue &&
+        (best < 0 || victim.priority > m_pools[best].priority)) {
+      best = i;
+    }
+  }
+  return best;
+}
+
+void SharedThreadPool::idle(Thread *thread) {
+  Pool &p = m_pools[thread->m_pool];
+  if (thread->m_stealer) {
+    p.idleStealers.push_back(thread);
+  } else {
+    p.idleReserved.push_back(thread);
+  }
+  thread->m_woken = false;
+  while (!thread->m_woken) {
+    pthread_cond_wait(&thread->m_cond, &m_mutex.getRaw());
+  }
+}
+
+/**
+ * Wakes up one idle thread for a new job of this pool: one of its own
+ * threads if there is any, otherwise a stealer from another pool.
+ */
+void SharedThreadPool::wakeOne(int pool) {
+  Thread *thread = NULL;
+  Pool &p = m_pools[pool];
+  if (!p.idleReserved.empty()) {
+    thread = p.idleReserved.back();
+    p.idleReserved.pop_back();
+  } else if (!p.idleStealers.empty()) {
+    thread = p.idleStealers.back();
+    p.idleStealers.pop_back();
+  } else {
+    for (unsigned int i = 0; i < m_pools.size(); i++) {
+      Pool &other = m_pools[i];
+      if (!other.idleStealers.empty()) {
+        thread = other.idleStealers.back();
+        other.idleStealers.pop_back();
+        break;
+      }
+    }
+  }
+  if (thread) {
+    thread->m_woken = true;
+    pthread_cond_signal(&thread->m_cond);
+  }
+}
+
+void SharedThreadPool::wakeAll() {
+  for (unsigned int i = 0; i < m_pools.size(); i++) {
+    Pool &p = m_pools[i];
+    for (int j = 0; j < 2; j++) {
+      vector<Thread*> &threads = j ? p.idleStealers : p.idleReserved;
+      for (unsigned int k = 0; k < threads.size(); k++) {
+        threads[k]->m_woken = true;
+        pthread_cond_signal(&threads[k]->m_cond);
+      }
+      threads.clear();
+    }
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+}
@@ -0,0 +1,195 @@
+/*
+   +----------------------------------------------------------------------+
+   | HipHop for PHP                                                       |
+   +----------------------------------------------------------------------+
+   | Copyright (c) 2010 Facebook, Inc. (http://www.facebook.com)          |
+   +----------------------------------------------------------------------+
+   | This source file is subject to version 3.01 of the PHP license,      |
+   | that is bundled with this package in the file LICENSE, and is        |
+   | available through the world-wide-web at the following url:           |
+   | http://www.php.net/license/3_01.txt                                  |
+   | If you did not receive a copy of the PHP license and are unable to   |
+   | obtain it through the world-wide-web, please send a note to          |
+   | license@php.net so we can mail you a copy immediately.               |
+   +----------------------------------------------------------------------+
+*/
+
+#ifndef __CONCURRENCY_SHARED_THREAD_POOL_H__
+#define __CONCURRENCY_SHARED_THREAD_POOL_H__
+
+#include "base.h"
+#include "async_func.h"
+#include "mutex.h"
+
+namespace HPHP {
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * One kind of jobs, as SharedThreadPool sees them. JobQueueDispatcher
+ * implements this for its own job and worker types, when it's shared.
+ */
+class SharedJobQueue {
+public:
+  virtual ~SharedJobQueue() {}
+
+  /**
+   * Pops the oldest job and processes it on pool thread "thread". There is
+   * always one to pop, since the pool calls this once per onEnqueue().
+   * Returns how many microseconds the job had been waiting.
+   */
+  virtual int64 runOne(int thread) = 0;
+
+  /**
+   * Called on each pool thread, before it runs the first job of this queue
+   * and after it has run the last one.
+   */
+  virtual void onThreadEnter(int thread) = 0;
+  virtual void onThreadExit(int thread) = 0;
+};
+
+/**
+ * Threads shared by several job queues, so capacity isn't partitioned among
+ * them. Each queue is given a pool, whose thread count is added to the total.
+ * A thread looks at its own pool's jobs first. If there is none, it steals
+ * the oldest job of another pool, those with higher priority first, unless
+ * it's one of the pool's reserved threads, which never leave their pool.
+ *
+ *   SharedThreadPool pool;
+ *   int pages = pool.addPool("page", 40, 30, 1);
+ *   int pagelets = pool.addPool("pagelet", 10, 0, 0);
+ *
+ *   JobQueueDispatcher<MyJob*, MyWorker> dispatcher(40, NULL);
+ *   dispatcher.share(&pool, pages);
+ *   dispatcher.start(); // attaches to the pool
+ */
+class SharedThreadPool {
+public:
+  /**
+   * For logging how long jobs wait in a queue, on the thread that's about to
+   * process them.
+   */
+  typedef void (*PFUNC_LOG_WAIT)(const std::string &pool, int64 wait_us);
+  static PFUNC_LOG_WAIT s_pfunc_log_wait;
+
+  struct PoolStats {
+    std::string name;
+    int threadCount;
+    int reservedCount;
+    int priority;
+    int queued;    // jobs waiting right now
+    int running;   // jobs being processed right now
+    int maxQueued; // the most jobs ever waiting at the same time
+    int64 jobs;    // jobs processed so far
+    int64 waitUs;  // total time they waited, in microseconds
+    int64 maxWaitUs;
+  };
+
+public:
+  SharedThreadPool();
+  ~SharedThreadPool();
+
+  /**
+   * Declares a pool before any queue is attached. Returns its id.
+   */
+  int addPool(const std::string &name, int threadCount, int reservedCount,
+              int priority);
+
+  /**
+   * Total number of threads. Thread ids passed to SharedJobQueue go from 0
+   * to this number minus 1.
+   */
+  int getThreadCount() const { return m_threadCount;}
+
+  /**
+   * Starts taking jobs of a pool from the queue. Threads start with the
+   * first queue attached.
+   */
+  void attach(int pool, SharedJobQueue *queue);
+
+  /**
+   * Blocks until all jobs of the pool are processed and every thread is done
+   * with its queue. Threads stop with the last queue detached.
+   */
+  void detach(int pool);
+
+  /**
+   * A queue has just pushed one job.
+   */
+  void onEnqueue(int pool);
+
+  /**
+   * A queue has just popped a job that waited this long.
+   */
+  void logWait(int pool, int64 wait_us);
+
+  /**
+   * How many jobs of a pool are being processed.
+   */
+  int getActiveWorker(int pool);
+
+  void getStats(std::vector<PoolStats> &stats);
+
+private:
+  class Thread {
+  public:
+    Thread(SharedThreadPool *owner, int id, int pool, bool stealer);
+    ~Thread();
+
+    void run() { m_owner->work(this);}
+
+    SharedThreadPool *m_owner;
+    int m_id;
+    int m_pool;
+    bool m_stealer;
+
+    pthread_cond_t m_cond;
+    bool m_woken;
+
+    // what queue of each pool this thread has entered, or NULL
+    std::vector<SharedJobQueue*> m_entered;
+  };
+
+  struct Pool {
+    std::string name;
+    int threadCount;
+    int reservedCount;
+    int priority;
+
+    SharedJobQueue *queue;
+    bool detaching;
+    int entered; // threads that entered queue
+
+    int queued;
+    int running;
+    int maxQueued;
+    int64 jobs;
+    int64 waitUs;
+    int64 maxWaitUs;
+
+    std::vector<Thread*> idleReserved;
+    std::vector<Thread*> idleStealers;
+  };
+
+  Mutex m_mutex;
+  pthread_cond_t m_changed; // for detach() to wait on
+  std::vector<Pool> m_pools;
+  int m_threadCount;
+  int m_attached;
+  bool m_stopping;
+  std::vector<Thread*> m_threads;
+  std::vector<AsyncFunc<Thread>*> m_funcs;
+
+  void startThreads();
+  void stopThreads();
+  void work(Thread *thread);
+  bool syncQueues(Thread *thread);
+  int pickPool(Thread *thread);
+  void idle(Thread *thread);
+  void wakeOne(int pool);
+  void wakeAll();
+};
+
+///////////////////////////////////////////////////////////////////////////////
+}
+
+#endif // __CONCURRENCY_SHARED_THREAD_POOL_H__